@@ -5,6 +5,9 @@
 #include <bench/bench.h>
 #include <random.h>
 #include <bls/bls_worker.h>
+#include <version.h>
+
+#include <list>
 
 extern CBLSWorker blsWorker;
 
@@ -25,6 +28,10 @@ struct DKG
 
     BLSVerificationVectorPtr quorumVvec;
 
+    // operator key of the member we're benchmarking the full session for and the contributions encrypted to it
+    CBLSSecretKey operatorKey;
+    std::vector<std::shared_ptr<CBLSIESMultiRecipientObjects<CBLSSecretKey>>> encryptedContributions;
+
     DKG(int quorumSize)
     {
         members.reserve(quorumSize);
@@ -111,6 +118,82 @@ struct DKG
             memberIdx = (memberIdx + 1) % members.size();
         }
     }
+
+    void EncryptContributions(size_t whoAmI)
+    {
+        if (!encryptedContributions.empty()) {
+            return;
+        }
+        operatorKey.MakeNewKey();
+        // only our own blob is filled, the others are never decrypted here
+        for (size_t i = 0; i < members.size(); i++) {
+            auto contributions = std::make_shared<CBLSIESMultiRecipientObjects<CBLSSecretKey>>();
+            contributions->InitEncrypt(members.size());
+            contributions->Encrypt(whoAmI, operatorKey.GetPublicKey(), members[i].skShares[whoAmI], PROTOCOL_VERSION);
+            encryptedContributions.emplace_back(contributions);
+        }
+    }
+
+    // Everything a member does with the contributions of a session: decrypt its shares, verify them in batches of
+    // 32 (as CDKGSession does) and build the quorum vvec and its secret key share from them
+    void Bench_FullSession(benchmark::State& state, bool pipelined)
+    {
+        const size_t whoAmI = 0;
+        const size_t batchSize = 32;
+        EncryptContributions(whoAmI);
+        ReceiveVvecs();
+
+        while (state.KeepRunning()) {
+            receivedSkShares.assign(members.size(), CBLSSecretKey());
+
+            if (pipelined) {
+                // decryption runs on the worker pool and batches are verified while the following ones still decrypt
+                std::vector<std::future<CBLSSecretKey>> decrypted;
+                for (size_t i = 0; i < members.size(); i++) {
+                    decrypted.emplace_back(blsWorker.AsyncDecryptContribution(encryptedContributions[i], whoAmI, operatorKey, PROTOCOL_VERSION));
+                }
+
+                struct VerifyBatch {
+                    std::vector<BLSVerificationVectorPtr> vvecs;
+                    BLSSecretKeyVector skShares;
+                    std::future<std::vector<bool>> result;
+                };
+                std::list<VerifyBatch> batches;
+                for (size_t start = 0; start < members.size(); start += batchSize) {
+                    batches.emplace_back();
+                    auto& batch = batches.back();
+                    for (size_t i = start; i < std::min(start + batchSize, members.size()); i++) {
+                        receivedSkShares[i] = decrypted[i].get();
+                        batch.vvecs.emplace_back(receivedVvecs[i]);
+                        batch.skShares.emplace_back(receivedSkShares[i]);
+                    }
+                    batch.result = blsWorker.AsyncVerifyContributionShares(members[whoAmI].id, batch.vvecs, batch.skShares, true, true);
+                }
+                for (auto& batch : batches) {
+                    for (bool valid : batch.result.get()) {
+                        assert(valid);
+                    }
+                }
+            } else {
+                for (size_t i = 0; i < members.size(); i++) {
+                    bool decrypted = encryptedContributions[i]->Decrypt(whoAmI, operatorKey, receivedSkShares[i], PROTOCOL_VERSION);
+                    assert(decrypted);
+                }
+                for (size_t start = 0; start < members.size(); start += batchSize) {
+                    const size_t end = std::min(start + batchSize, members.size());
+                    std::vector<BLSVerificationVectorPtr> vvecs(receivedVvecs.begin() + start, receivedVvecs.begin() + end);
+                    BLSSecretKeyVector skShares(receivedSkShares.begin() + start, receivedSkShares.begin() + end);
+                    for (bool valid : blsWorker.VerifyContributionShares(members[whoAmI].id, vvecs, skShares)) {
+                        assert(valid);
+                    }
+                }
+            }
+
+            BuildQuorumVerificationVector(true);
+            CBLSSecretKey skShare = blsWorker.AggregateSecretKeys(receivedSkShares);
+            assert(skShare.IsValid());
+        }
+    }
 };
 
 std::shared_ptr<DKG> dkg10;
@@ -181,3 +264,20 @@ BENCH_VerifyContributionShares(parallel, 400, 5, true, false, 1)
 BENCH_VerifyContributionShares(parallel_aggregated, 10, 5, true, true, 150)
 BENCH_VerifyContributionShares(parallel_aggregated, 100, 5, true, true, 4)
 BENCH_VerifyContributionShares(parallel_aggregated, 400, 5, true, true, 1)
+
+///////////////////////////////
+
+
+
+#define BENCH_FullSession(name, quorumSize, pipelined, num_iters_for_one_second) \
+    static void BLSDKG_FullSession_##name##_##quorumSize(benchmark::State& state) \
+    { \
+        InitIfNeeded(); \
+        dkg##quorumSize->Bench_FullSession(state, pipelined); \
+    } \
+    BENCHMARK(BLSDKG_FullSession_##name##_##quorumSize, num_iters_for_one_second)
+
+BENCH_FullSession(simple, 100, false, 1)
+BENCH_FullSession(simple, 400, false, 1)
+BENCH_FullSession(pipelined, 100, true, 2)
+BENCH_FullSession(pipelined, 400, true, 1)
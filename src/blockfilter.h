@@ -7,6 +7,7 @@
 
 #include <set>
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include <primitives/block.h>
@@ -79,8 +80,21 @@ constexpr uint32_t BASIC_FILTER_M = 784931;
 enum BlockFilterType : uint8_t
 {
     BASIC_FILTER = 0,
+    INVALID_FILTER = 255,
 };
 
+/** Get the human-readable name for a filter type. Returns empty string for unknown types. */
+const std::string& BlockFilterTypeName(BlockFilterType filter_type);
+
+/** Find a filter type by its human-readable name. */
+bool BlockFilterTypeByName(const std::string& name, BlockFilterType& filter_type);
+
+/** Get a list of known filter types. */
+const std::vector<BlockFilterType>& AllBlockFilterTypes();
+
+/** Get a comma-separated list of known filter type names. */
+const std::string& ListBlockFilterTypes();
+
 /**
  * Complete block filter struct as defined in BIP 157. Serialization matches
  * payload of "cfilter" messages.
@@ -88,17 +102,25 @@ enum BlockFilterType : uint8_t
 class BlockFilter
 {
 private:
-    BlockFilterType m_filter_type;
+    BlockFilterType m_filter_type = BlockFilterType::INVALID_FILTER;
     uint256 m_block_hash;
     GCSFilter m_filter;
 
 public:
 
+    BlockFilter() = default;
+
+    // Reconstruct a BlockFilter from parts.
+    BlockFilter(BlockFilterType filter_type, const uint256& block_hash,
+                std::vector<unsigned char> filter);
+
     // Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock& block, const CBlockUndo& block_undo);
 
     BlockFilterType GetFilterType() const { return m_filter_type; }
 
+    const uint256& GetBlockHash() const { return m_block_hash; }
+
     const GCSFilter& GetFilter() const { return m_filter; }
 
     const std::vector<unsigned char>& GetEncodedFilter() const
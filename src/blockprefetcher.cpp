@@ -0,0 +1,121 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockprefetcher.h>
+
+#include <chain.h>
+#include <consensus/validation.h>
+#include <util.h>
+#include <validation.h>
+
+#include <vector>
+
+CBlockPrefetcher blockPrefetcher;
+
+static std::shared_ptr<const CBlock> ReadAndCheckBlock(const CDiskBlockPos& pos, const uint256& hash, const Consensus::Params& consensusParams)
+{
+    auto pblock = std::make_shared<CBlock>();
+    if (!ReadBlockFromDisk(*pblock, pos, consensusParams) || pblock->GetHash() != hash) {
+        return nullptr;
+    }
+    // Sets fChecked on success so that ConnectBlock can skip the merkle root and transaction
+    // sanity checks. Failures are left for ConnectBlock to report with the proper state.
+    CValidationState state;
+    CheckBlock(*pblock, state, consensusParams);
+    return pblock;
+}
+
+CBlockPrefetcher::~CBlockPrefetcher()
+{
+    Stop();
+}
+
+void CBlockPrefetcher::Start(int nMaxBlocksIn, int nThreads)
+{
+    LOCK(cs);
+    nMaxBlocks = nMaxBlocksIn;
+    if (nMaxBlocks > 0) {
+        workerPool.resize(nThreads);
+        RenameThreadPool(workerPool, "dash-prefetch");
+    }
+}
+
+void CBlockPrefetcher::Stop()
+{
+    {
+        LOCK(cs);
+        nMaxBlocks = 0;
+    }
+    workerPool.clear_queue();
+    workerPool.stop(true);
+
+    LOCK(cs);
+    mapPending.clear();
+}
+
+void CBlockPrefetcher::Prefetch(const CBlockIndex* pindexTip, const CBlockIndex* pindexLast, const Consensus::Params& consensusParams)
+{
+    AssertLockHeld(cs_main);
+    LOCK(cs);
+    if (nMaxBlocks <= 0) {
+        return;
+    }
+
+    std::vector<const CBlockIndex*> vWindow;
+    int nTipHeight = pindexTip ? pindexTip->nHeight : -1;
+    if (pindexLast && pindexLast->nHeight > nTipHeight) {
+        int nEndHeight = std::min(pindexLast->nHeight, nTipHeight + nMaxBlocks);
+        for (const CBlockIndex* pindex = pindexLast->GetAncestor(nEndHeight); pindex && pindex->nHeight > nTipHeight; pindex = pindex->pprev) {
+            vWindow.push_back(pindex);
+        }
+    }
+
+    // Schedule in connection order so that the next block to connect is read first
+    std::map<const CBlockIndex*, BlockFuture> mapNew;
+    for (auto it = vWindow.rbegin(); it != vWindow.rend(); ++it) {
+        const CBlockIndex* pindex = *it;
+        auto jt = mapPending.find(pindex);
+        if (jt != mapPending.end()) {
+            mapNew.emplace(pindex, std::move(jt->second));
+            continue;
+        }
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            continue;
+        }
+        CDiskBlockPos pos = pindex->GetBlockPos();
+        uint256 hash = pindex->GetBlockHash();
+        mapNew.emplace(pindex, workerPool.push([pos, hash, &consensusParams](int threadId) {
+            return ReadAndCheckBlock(pos, hash, consensusParams);
+        }).share());
+    }
+    mapPending.swap(mapNew);
+}
+
+std::shared_ptr<const CBlock> CBlockPrefetcher::Take(const CBlockIndex* pindex)
+{
+    BlockFuture future;
+    {
+        LOCK(cs);
+        auto it = mapPending.find(pindex);
+        if (it == mapPending.end()) {
+            if (nMaxBlocks > 0) nMisses++;
+            return nullptr;
+        }
+        future = std::move(it->second);
+        mapPending.erase(it);
+    }
+
+    std::shared_ptr<const CBlock> pblock;
+    try {
+        pblock = future.get();
+    } catch (const std::future_error&) {
+        // The read was dropped from the queue while shutting down
+    }
+    if (pblock) {
+        nHits++;
+    } else {
+        nMisses++;
+    }
+    return pblock;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKPREFETCHER_H
+#define BITCOIN_BLOCKPREFETCHER_H
+
+#include <primitives/block.h>
+#include <sync.h>
+
+#include <ctpl.h>
+
+#include <atomic>
+#include <future>
+#include <map>
+#include <memory>
+
+class CBlockIndex;
+
+namespace Consensus {
+struct Params;
+}
+
+/** Default for -blockprefetch, the number of blocks read ahead of the block being connected */
+static const int DEFAULT_BLOCK_PREFETCH = 16;
+/** Maximum for -blockprefetch */
+static const int MAX_BLOCK_PREFETCH = 256;
+
+/**
+ * Reads, deserializes and runs the context-free CheckBlock() on the blocks that
+ * ActivateBestChain is about to connect, on a small pool of worker threads, so that
+ * ConnectTip only has to wait for disk I/O when the pipeline runs dry (e.g. while
+ * reindexing the chainstate or catching up on blocks that were stored out of order).
+ *
+ * Blocks that fail to load or fail CheckBlock() are handed out unchecked (or not at
+ * all) so that ConnectTip reports the failure exactly as it would have without the
+ * prefetcher.
+ */
+class CBlockPrefetcher
+{
+private:
+    typedef std::shared_future<std::shared_ptr<const CBlock>> BlockFuture;
+
+    ctpl::thread_pool workerPool;
+
+    mutable CCriticalSection cs;
+    std::map<const CBlockIndex*, BlockFuture> mapPending GUARDED_BY(cs);
+    int nMaxBlocks GUARDED_BY(cs){0};
+
+    std::atomic<uint64_t> nHits{0};
+    std::atomic<uint64_t> nMisses{0};
+
+public:
+    ~CBlockPrefetcher();
+
+    void Start(int nMaxBlocksIn, int nThreads);
+    void Stop();
+
+    /**
+     * Schedule the successors of pindexTip up to pindexLast (at most nMaxBlocks of them)
+     * to be read in the background. Previously scheduled blocks outside this window are
+     * dropped.
+     */
+    void Prefetch(const CBlockIndex* pindexTip, const CBlockIndex* pindexLast, const Consensus::Params& consensusParams);
+
+    /**
+     * Return the prefetched block for pindex, waiting for the read if it is still in
+     * progress. Returns nullptr if the block was not scheduled or could not be read,
+     * in which case the caller has to read it itself.
+     */
+    std::shared_ptr<const CBlock> Take(const CBlockIndex* pindex);
+
+    uint64_t GetHits() const { return nHits; }
+    uint64_t GetMisses() const { return nMisses; }
+};
+
+extern CBlockPrefetcher blockPrefetcher;
+
+#endif // BITCOIN_BLOCKPREFETCHER_H
@@ -8,6 +8,7 @@
 #include <bls/bls.h>
 
 #include <map>
+#include <set>
 #include <vector>
 
 template<typename SourceId, typename MessageId>
@@ -24,6 +25,9 @@ private:
     typedef std::map<MessageId, Message> MessageMap;
     typedef typename MessageMap::iterator MessageMapIterator;
     typedef std::map<SourceId, std::vector<MessageMapIterator>> MessagesBySourceMap;
+    typedef typename MessagesBySourceMap::iterator MessagesBySourceMapIterator;
+    typedef typename std::vector<MessagesBySourceMapIterator>::iterator SourceRangeIterator;
+    typedef typename std::vector<MessageMapIterator>::iterator MessageRangeIterator;
 
     bool secureVerification;
     bool perMessageFallback;
@@ -70,56 +74,80 @@ public:
 
     void Verify()
     {
-        std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+        std::vector<MessagesBySourceMapIterator> sources;
+        sources.reserve(messagesBySource.size());
+        for (auto it = messagesBySource.begin(); it != messagesBySource.end(); ++it) {
+            sources.emplace_back(it);
+        }
+        VerifySources(sources.begin(), sources.end(), false);
+    }
 
-        for (auto it = messages.begin(); it != messages.end(); ++it) {
-            byMessageHash[it->second.msgHash].emplace_back(it);
+private:
+    // When a batch fails, it is split in two halves which are verified independently, down to the single sources
+    // which are then marked as bad. The messages of bad sources are bisected the same way if perMessageFallback is set.
+    // With k invalid entries out of n, this needs O(k * log(n)) batch verifications instead of one per source/message.
+    // knownInvalid is set when the caller already knows that the range fails to verify
+    void VerifySources(SourceRangeIterator begin, SourceRangeIterator end, bool knownInvalid)
+    {
+        if (begin == end) {
+            return;
+        }
+        if (!knownInvalid) {
+            std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+            for (auto it = begin; it != end; ++it) {
+                for (const auto& msgIt : (*it)->second) {
+                    byMessageHash[msgIt->second.msgHash].emplace_back(msgIt);
+                }
+            }
+            if (VerifyBatch(byMessageHash)) {
+                return;
+            }
         }
 
-        if (VerifyBatch(byMessageHash)) {
-            // full batch is valid
+        if (end - begin == 1) {
+            badSources.emplace((*begin)->first);
+            if (perMessageFallback) {
+                auto& msgIts = (*begin)->second;
+                // no need to verify it again if there was just one message
+                VerifyMessages(msgIts.begin(), msgIts.end(), msgIts.size() == 1);
+            }
             return;
         }
 
-        // revert to per-source verification
-        for (const auto& p : messagesBySource) {
-            bool batchValid = false;
+        auto middle = begin + (end - begin) / 2;
+        VerifySources(begin, middle, false);
+        VerifySources(middle, end, false);
+    }
 
-            // no need to verify it again if there was just one source
-            if (messagesBySource.size() != 1) {
-                byMessageHash.clear();
-                for (auto it = p.second.begin(); it != p.second.end(); ++it) {
-                    byMessageHash[(*it)->second.msgHash].emplace_back(*it);
-                }
-                batchValid = VerifyBatch(byMessageHash);
+    void VerifyMessages(MessageRangeIterator begin, MessageRangeIterator end, bool knownInvalid)
+    {
+        if (begin == end) {
+            return;
+        }
+        if (end - begin == 1 && badMessages.count((*begin)->first)) {
+            // same message might be invalid from different source, so no need to re-verify it
+            return;
+        }
+        if (!knownInvalid) {
+            std::map<uint256, std::vector<MessageMapIterator>> byMessageHash;
+            for (auto it = begin; it != end; ++it) {
+                byMessageHash[(*it)->second.msgHash].emplace_back(*it);
             }
-            if (!batchValid) {
-                badSources.emplace(p.first);
-
-                if (perMessageFallback) {
-                    // revert to per-message verification
-                    if (p.second.size() == 1) {
-                        // no need to re-verify a single message
-                        badMessages.emplace(p.second[0]->second.msgId);
-                    } else {
-                        for (const auto& msgIt : p.second) {
-                            if (badMessages.count(msgIt->first)) {
-                                // same message might be invalid from different source, so no need to re-verify it
-                                continue;
-                            }
-
-                            const auto& msg = msgIt->second;
-                            if (!msg.sig.VerifyInsecure(msg.pubKey, msg.msgHash)) {
-                                badMessages.emplace(msg.msgId);
-                            }
-                        }
-                    }
-                }
+            if (VerifyBatch(byMessageHash)) {
+                return;
             }
         }
+
+        if (end - begin == 1) {
+            badMessages.emplace((*begin)->first);
+            return;
+        }
+
+        auto middle = begin + (end - begin) / 2;
+        VerifyMessages(begin, middle, false);
+        VerifyMessages(middle, end, false);
     }
 
-private:
     // All Verify methods take ownership of the passed byMessageHash map and thus might modify the map. This is to avoid
     // unnecessary copies
 
@@ -773,6 +773,20 @@ std::future<bool> CBLSWorker::AsyncVerifyContributionShare(const CBLSId& forId,
     return workerPool.push(f);
 }
 
+std::future<CBLSSecretKey> CBLSWorker::AsyncDecryptContribution(const std::shared_ptr<CBLSIESMultiRecipientObjects<CBLSSecretKey>>& encryptedContributions,
+                                                                size_t idx, const CBLSSecretKey& secretKey, int nVersion)
+{
+    // everything is captured by value, the caller might not wait for the result
+    auto f = [encryptedContributions, idx, secretKey, nVersion](int threadId) {
+        CBLSSecretKey skContribution;
+        if (!encryptedContributions->Decrypt(idx, secretKey, skContribution, nVersion)) {
+            return CBLSSecretKey();
+        }
+        return skContribution;
+    };
+    return workerPool.push(f);
+}
+
 bool CBLSWorker::VerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec,
                                          const CBLSSecretKey& skContribution)
 {
@@ -6,6 +6,8 @@
 #define DASH_CRYPTO_BLS_WORKER_H
 
 #include <bls/bls.h>
+#include <bls/bls_batchverifier.h>
+#include <bls/bls_ies.h>
 
 #include <ctpl.h>
 
@@ -123,6 +125,11 @@ public:
 
     std::future<bool> AsyncVerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec, const CBLSSecretKey& skContribution);
 
+    // Decrypts the contribution at idx on the worker pool, so that contributions from different members are decrypted
+    // in parallel. The resulting secret key is invalid if decryption failed
+    std::future<CBLSSecretKey> AsyncDecryptContribution(const std::shared_ptr<CBLSIESMultiRecipientObjects<CBLSSecretKey>>& encryptedContributions,
+                                                        size_t idx, const CBLSSecretKey& secretKey, int nVersion);
+
     // Non paralellized verification of a single contribution
     bool VerifyContributionShare(const CBLSId& forId, const BLSVerificationVectorPtr& vvec, const CBLSSecretKey& skContribution);
 
@@ -139,6 +146,16 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Runs batchVerifier.Verify() on the worker pool, so that independent batches can be verified in parallel
+    // The batch verifier must be kept alive until the returned future is ready
+    template <typename SourceId, typename MessageId>
+    std::future<void> AsyncVerifyBatch(CBLSBatchVerifier<SourceId, MessageId>& batchVerifier)
+    {
+        return workerPool.push([&batchVerifier](int threadId) {
+            batchVerifier.Verify();
+        });
+    }
+
 private:
     void PushSigVerifyBatch();
 };
@@ -66,6 +66,33 @@ CBlockIndex* CChain::FindEarliestAtLeast(int64_t nTime) const
     return (lower == vChain.end() ? nullptr : *lower);
 }
 
+CChainSnapshot::CChainSnapshot(const CChain& chain, const CChainSnapshot* prev, std::shared_ptr<const void> ownerIn) :
+    nHeight(chain.Height()), owner(std::move(ownerIn))
+{
+    const int nSize = nHeight + 1;
+    vChunks.reserve((nSize + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    for (int nStart = 0; nStart < nSize; nStart += CHUNK_SIZE) {
+        const int nEnd = std::min(nStart + CHUNK_SIZE, nSize);
+        const size_t nChunk = vChunks.size();
+        if (prev && nChunk < prev->vChunks.size()) {
+            // Chunks are only ever filled from the front, so a chunk of the same size ending
+            // in the same block (which commits to all its ancestors) holds the same entries, and
+            // their copied fields can only have changed by pruning.
+            const std::shared_ptr<const Chunk>& prevChunk = prev->vChunks[nChunk];
+            if ((int)prevChunk->size() == nEnd - nStart && prevChunk->back().pindex == chain[nEnd - 1]) {
+                vChunks.push_back(prevChunk);
+                continue;
+            }
+        }
+        auto chunk = std::make_shared<Chunk>();
+        chunk->reserve(nEnd - nStart);
+        for (int i = nStart; i < nEnd; i++) {
+            chunk->emplace_back(chain[i]);
+        }
+        vChunks.push_back(std::move(chunk));
+    }
+}
+
 /** Turn the lowest '1' bit in the binary representation of a number into a '0'. */
 int static inline InvertLowestOne(int n) { return n & (n - 1); }
 
@@ -12,6 +12,7 @@
 #include <tinyformat.h>
 #include <uint256.h>
 
+#include <memory>
 #include <vector>
 
 /**
@@ -498,4 +499,120 @@ public:
     CBlockIndex* FindEarliestAtLeast(int64_t nTime) const;
 };
 
+/**
+ * An immutable copy of an active chain, which can be read without holding cs_main.
+ * The block pointers are kept in fixed size chunks; a snapshot of an extended chain
+ * shares all unchanged chunks with the snapshot it was created from, so creating one
+ * per tip update only copies the last chunk.
+ *
+ * Besides the header and tree fields, which never change once an index entry is
+ * published, the fields of a CBlockIndex may only be read under cs_main. The ones
+ * readers need are therefore copied into the snapshot when a chunk is created. They
+ * only change for blocks of the active chain when their files are pruned, so the
+ * copies must not be used in prune mode.
+ */
+class CChainSnapshot {
+public:
+    static const int CHUNK_SIZE = 4096;
+
+    /** A block of the chain together with a copy of its mutable index fields. */
+    struct Entry {
+        const CBlockIndex* pindex;
+        unsigned int nTx;
+        uint32_t nStatus;
+        int nFile;
+        unsigned int nDataPos;
+        unsigned int nUndoPos;
+
+        explicit Entry(const CBlockIndex* pindexIn) :
+            pindex(pindexIn), nTx(pindexIn->nTx), nStatus(pindexIn->nStatus),
+            nFile(pindexIn->nFile), nDataPos(pindexIn->nDataPos), nUndoPos(pindexIn->nUndoPos) {}
+
+        CDiskBlockPos GetBlockPos() const {
+            CDiskBlockPos ret;
+            if (nStatus & BLOCK_HAVE_DATA) {
+                ret.nFile = nFile;
+                ret.nPos  = nDataPos;
+            }
+            return ret;
+        }
+
+        CDiskBlockPos GetUndoPos() const {
+            CDiskBlockPos ret;
+            if (nStatus & BLOCK_HAVE_UNDO) {
+                ret.nFile = nFile;
+                ret.nPos  = nUndoPos;
+            }
+            return ret;
+        }
+    };
+
+private:
+    typedef std::vector<Entry> Chunk;
+    std::vector<std::shared_ptr<const Chunk>> vChunks;
+    int nHeight{-1};
+    /** Keeps the index entries this snapshot points to from being freed (see UnloadBlockIndex). */
+    std::shared_ptr<const void> owner;
+
+public:
+    CChainSnapshot() {}
+    /**
+     * Create a snapshot of chain, reusing the chunks of prev (may be nullptr) which are still part of it.
+     * Must be called with cs_main held. ownerIn is kept alive as long as the snapshot exists.
+     */
+    CChainSnapshot(const CChain& chain, const CChainSnapshot* prev, std::shared_ptr<const void> ownerIn = nullptr);
+
+    /** Returns the index entry for the genesis block of this chain, or nullptr if none. */
+    const CBlockIndex* Genesis() const {
+        return (*this)[0];
+    }
+
+    /** Returns the index entry for the tip of this chain, or nullptr if none. */
+    const CBlockIndex* Tip() const {
+        return (*this)[nHeight];
+    }
+
+    /** Returns the index entry at a particular height in this chain, or nullptr if no such height exists. */
+    const CBlockIndex* operator[](int nIndexHeight) const {
+        const Entry* entry = GetEntry(nIndexHeight);
+        return entry ? entry->pindex : nullptr;
+    }
+
+    /** Returns the entry at a particular height in this chain, or nullptr if no such height exists. */
+    const Entry* GetEntry(int nIndexHeight) const {
+        if (nIndexHeight < 0 || nIndexHeight > nHeight)
+            return nullptr;
+        return &(*vChunks[nIndexHeight / CHUNK_SIZE])[nIndexHeight % CHUNK_SIZE];
+    }
+
+    /** Returns the entry of a block in this chain, or nullptr if the chain does not contain it. */
+    const Entry* GetEntry(const CBlockIndex* pindex) const {
+        const Entry* entry = GetEntry(pindex->nHeight);
+        return entry && entry->pindex == pindex ? entry : nullptr;
+    }
+
+    /** Efficiently check whether a block is present in this chain. */
+    bool Contains(const CBlockIndex* pindex) const {
+        return (*this)[pindex->nHeight] == pindex;
+    }
+
+    /** Find the successor of a block in this chain, or nullptr if the given index is not found or is the tip. */
+    const CBlockIndex* Next(const CBlockIndex* pindex) const {
+        if (Contains(pindex))
+            return (*this)[pindex->nHeight + 1];
+        else
+            return nullptr;
+    }
+
+    /** Return the maximal height in the chain. Is equal to chain.Tip() ? chain.Tip()->nHeight : -1. */
+    int Height() const {
+        return nHeight;
+    }
+
+    /** Returns true if the chunk at position nChunk is shared with other. Used by tests. */
+    bool SharesChunk(const CChainSnapshot& other, size_t nChunk) const {
+        return nChunk < vChunks.size() && nChunk < other.vChunks.size() && vChunks[nChunk] == other.vChunks[nChunk];
+    }
+};
+
 #endif // BITCOIN_CHAIN_H
@@ -0,0 +1,203 @@
+// Copyright (c) 2017-2020 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <crypto/muhash.h>
+
+#include <crypto/chacha20.h>
+#include <crypto/common.h>
+#include <crypto/sha256.h>
+
+#include <assert.h>
+#include <limits>
+
+namespace {
+
+using limb_t = Num3072::limb_t;
+using double_limb_t = Num3072::double_limb_t;
+constexpr int LIMB_SIZE = Num3072::LIMB_SIZE;
+constexpr int LIMBS = Num3072::LIMBS;
+/** 2^3072 - 1103717 is the largest 3072-bit safe prime number, is used as the order of the group. */
+constexpr limb_t MAX_PRIME_DIFF = 1103717;
+
+/** Add a to the LIMBS limbs at r, returning the carry out of the top limb */
+limb_t AddSmall(limb_t* r, double_limb_t a)
+{
+    for (int i = 0; i < LIMBS && a != 0; ++i) {
+        a += r[i];
+        r[i] = (limb_t)a;
+        a >>= LIMB_SIZE;
+    }
+    return (limb_t)a;
+}
+
+} // namespace
+
+bool Num3072::IsOverflow() const
+{
+    if (this->limbs[0] <= std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF) return false;
+    for (int i = 1; i < LIMBS; ++i) {
+        if (this->limbs[i] != std::numeric_limits<limb_t>::max()) return false;
+    }
+    return true;
+}
+
+void Num3072::FullReduce()
+{
+    // Subtracting the modulus is the same as adding MAX_PRIME_DIFF and dropping the carry
+    AddSmall(this->limbs, MAX_PRIME_DIFF);
+}
+
+void Num3072::Multiply(const Num3072& a)
+{
+    // Schoolbook multiplication into a 6144-bit product
+    limb_t prod[2 * LIMBS] = {0};
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t carry = 0;
+        for (int j = 0; j < LIMBS; ++j) {
+            double_limb_t t = (double_limb_t)this->limbs[i] * a.limbs[j] + prod[i + j] + carry;
+            prod[i + j] = (limb_t)t;
+            carry = t >> LIMB_SIZE;
+        }
+        prod[i + LIMBS] = (limb_t)carry;
+    }
+
+    // Since 2^3072 = MAX_PRIME_DIFF (mod p), the high half is folded into the low half
+    // after multiplying it by MAX_PRIME_DIFF
+    double_limb_t carry = 0;
+    for (int i = 0; i < LIMBS; ++i) {
+        double_limb_t t = (double_limb_t)prod[LIMBS + i] * MAX_PRIME_DIFF + prod[i] + carry;
+        this->limbs[i] = (limb_t)t;
+        carry = t >> LIMB_SIZE;
+    }
+    // The remaining carry is folded in the same way. This can overflow at most once more,
+    // after which the value is small enough for the next fold not to overflow.
+    if (AddSmall(this->limbs, carry * MAX_PRIME_DIFF)) {
+        AddSmall(this->limbs, MAX_PRIME_DIFF);
+    }
+
+    // The value is now below 2^3072 < 2p
+    if (this->IsOverflow()) this->FullReduce();
+}
+
+void Num3072::SetToOne()
+{
+    this->limbs[0] = 1;
+    for (int i = 1; i < LIMBS; ++i) {
+        this->limbs[i] = 0;
+    }
+}
+
+Num3072 Num3072::GetInverse() const
+{
+    // Fermat's little theorem: a^(p-2) is the inverse of a. All bits of p-2 are set
+    // except for some in the lowest limb, so square-and-multiply is used on its limbs
+    // from the top.
+    limb_t exponent[LIMBS];
+    exponent[0] = std::numeric_limits<limb_t>::max() - MAX_PRIME_DIFF - 1;
+    for (int i = 1; i < LIMBS; ++i) {
+        exponent[i] = std::numeric_limits<limb_t>::max();
+    }
+
+    Num3072 out;
+    for (int i = LIMBS - 1; i >= 0; --i) {
+        for (int j = LIMB_SIZE - 1; j >= 0; --j) {
+            out.Multiply(out);
+            if ((exponent[i] >> j) & 1) {
+                out.Multiply(*this);
+            }
+        }
+    }
+    return out;
+}
+
+void Num3072::Divide(const Num3072& a)
+{
+    if (this->IsOverflow()) this->FullReduce();
+
+    Num3072 inv{};
+    if (a.IsOverflow()) {
+        Num3072 b = a;
+        b.FullReduce();
+        inv = b.GetInverse();
+    } else {
+        inv = a.GetInverse();
+    }
+
+    this->Multiply(inv);
+    if (this->IsOverflow()) this->FullReduce();
+}
+
+Num3072::Num3072(const unsigned char (&data)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (sizeof(limb_t) == 4) {
+            this->limbs[i] = ReadLE32(data + 4 * i);
+        } else if (sizeof(limb_t) == 8) {
+            this->limbs[i] = ReadLE64(data + 8 * i);
+        }
+    }
+}
+
+void Num3072::ToBytes(unsigned char (&out)[BYTE_SIZE])
+{
+    for (int i = 0; i < LIMBS; ++i) {
+        if (sizeof(limb_t) == 4) {
+            WriteLE32(out + i * 4, this->limbs[i]);
+        } else if (sizeof(limb_t) == 8) {
+            WriteLE64(out + i * 8, this->limbs[i]);
+        }
+    }
+}
+
+Num3072 MuHash3072::ToNum3072(Span<const unsigned char> in)
+{
+    unsigned char tmp[Num3072::BYTE_SIZE];
+
+    unsigned char hashed_in[CSHA256::OUTPUT_SIZE];
+    CSHA256().Write(in.data(), in.size()).Finalize(hashed_in);
+    ChaCha20(hashed_in, sizeof(hashed_in)).Keystream(tmp, Num3072::BYTE_SIZE);
+    Num3072 out{tmp};
+
+    return out;
+}
+
+MuHash3072::MuHash3072(Span<const unsigned char> in) noexcept
+{
+    m_numerator = ToNum3072(in);
+}
+
+void MuHash3072::Finalize(uint256& out) noexcept
+{
+    m_numerator.Divide(m_denominator);
+    m_denominator.SetToOne();  // Needed to keep the MuHash object valid
+
+    unsigned char data[Num3072::BYTE_SIZE];
+    m_numerator.ToBytes(data);
+
+    CSHA256().Write(data, sizeof(data)).Finalize(out.begin());
+}
+
+MuHash3072& MuHash3072::operator*=(const MuHash3072& mul) noexcept
+{
+    m_numerator.Multiply(mul.m_numerator);
+    m_denominator.Multiply(mul.m_denominator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::operator/=(const MuHash3072& div) noexcept
+{
+    m_numerator.Multiply(div.m_denominator);
+    m_denominator.Multiply(div.m_numerator);
+    return *this;
+}
+
+MuHash3072& MuHash3072::Insert(Span<const unsigned char> in) noexcept {
+    m_numerator.Multiply(ToNum3072(in));
+    return *this;
+}
+
+MuHash3072& MuHash3072::Remove(Span<const unsigned char> in) noexcept {
+    m_denominator.Multiply(ToNum3072(in));
+    return *this;
+}
@@ -728,3 +728,31 @@ void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
         --blocks;
     }
 }
+
+void SHA256_64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    // The second block of a 64 byte message is always the same: the padding and a length of 512 bits
+    static const unsigned char padding[64] = {
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0
+    };
+    uint32_t s[8];
+    while (blocks) {
+        sha256::Initialize(s);
+        Transform(s, in, 1);
+        Transform(s, padding, 1);
+        WriteBE32(out + 0, s[0]);
+        WriteBE32(out + 4, s[1]);
+        WriteBE32(out + 8, s[2]);
+        WriteBE32(out + 12, s[3]);
+        WriteBE32(out + 16, s[4]);
+        WriteBE32(out + 20, s[5]);
+        WriteBE32(out + 24, s[6]);
+        WriteBE32(out + 28, s[7]);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
@@ -98,12 +98,52 @@ bool CheckCbTxMerkleRoots(const CBlock& block, const CBlockIndex* pindex, CValid
     return true;
 }
 
+/**
+ * Keeps the SML merkle tree of the last list it was updated to. Consecutive blocks (and block templates) only change
+ * a few entries of the list, so only these are hashed again instead of building the whole SML for every block.
+ */
+class CSimplifiedMNListMerkleCache
+{
+private:
+    CDeterministicMNList dmnList;
+    CSortedMerkleTree tree;
+
+public:
+    uint256 Update(const CDeterministicMNList& newList, bool* pmutated)
+    {
+        std::map<uint256, uint256> mapLeaves;
+        std::set<uint256> setRemoved;
+        size_t nAdded = 0;
+
+        newList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            auto oldDmn = dmnList.GetMN(dmn->proTxHash);
+            if (oldDmn && oldDmn->pdmnState == dmn->pdmnState) {
+                return;
+            }
+            if (!oldDmn) {
+                nAdded++;
+            }
+            mapLeaves.emplace(dmn->proTxHash, CSimplifiedMNListEntry(*dmn).CalcHash());
+        });
+        if (dmnList.GetAllMNsCount() + nAdded != newList.GetAllMNsCount()) {
+            dmnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+                if (!newList.HasMN(dmn->proTxHash)) {
+                    setRemoved.emplace(dmn->proTxHash);
+                }
+            });
+        }
+
+        tree.Update(mapLeaves, setRemoved);
+        dmnList = newList;
+        return tree.GetRoot(pmutated);
+    }
+};
+
 bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev, uint256& merkleRootRet, CValidationState& state, const CCoinsViewCache& view)
 {
     LOCK(deterministicMNManager->cs);
 
     static int64_t nTimeDMN = 0;
-    static int64_t nTimeSMNL = 0;
     static int64_t nTimeMerkle = 0;
 
     int64_t nTime1 = GetTimeMicros();
@@ -118,32 +158,13 @@ bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev
         int64_t nTime2 = GetTimeMicros(); nTimeDMN += nTime2 - nTime1;
         LogPrint(BCLog::BENCHMARK, "            - BuildNewListFromBlock: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeDMN * 0.000001);
 
-        CSimplifiedMNList sml(tmpMNList);
-
-        int64_t nTime3 = GetTimeMicros(); nTimeSMNL += nTime3 - nTime2;
-        LogPrint(BCLog::BENCHMARK, "            - CSimplifiedMNList: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeSMNL * 0.000001);
-
-        static CSimplifiedMNList smlCached;
-        static uint256 merkleRootCached;
-        static bool mutatedCached{false};
-
-        if (sml.mnList == smlCached.mnList) {
-            merkleRootRet = merkleRootCached;
-            if (mutatedCached) {
-                return state.DoS(100, false, REJECT_INVALID, "mutated-cached-calc-cb-mnmerkleroot");
-            }
-            return true;
-        }
+        static CSimplifiedMNListMerkleCache merkleCache;
 
         bool mutated = false;
-        merkleRootRet = sml.CalcMerkleRoot(&mutated);
-
-        int64_t nTime4 = GetTimeMicros(); nTimeMerkle += nTime4 - nTime3;
-        LogPrint(BCLog::BENCHMARK, "            - CalcMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeMerkle * 0.000001);
+        merkleRootRet = merkleCache.Update(tmpMNList, &mutated);
 
-        smlCached = std::move(sml);
-        merkleRootCached = merkleRootRet;
-        mutatedCached = mutated;
+        int64_t nTime3 = GetTimeMicros(); nTimeMerkle += nTime3 - nTime2;
+        LogPrint(BCLog::BENCHMARK, "            - CalcMerkleRoot: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeMerkle * 0.000001);
 
         if (mutated) {
             return state.DoS(100, false, REJECT_INVALID, "mutated-calc-cb-mnmerkleroot");
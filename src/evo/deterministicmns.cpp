@@ -8,8 +8,11 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <core_io.h>
+#include <crypto/sha256.h>
+#include <hash.h>
 #include <script/standard.h>
 #include <ui_interface.h>
+#include <unordered_lru_cache.h>
 #include <validation.h>
 #include <validationinterface.h>
 
@@ -18,6 +21,9 @@
 
 #include <univalue.h>
 
+/** Number of recent CalculateQuorum results kept in memory */
+static const size_t QUORUM_MEMBERS_CACHE_SIZE = 256;
+
 static const std::string DB_LIST_SNAPSHOT = "dmn_S";
 static const std::string DB_LIST_DIFF = "dmn_D";
 
@@ -235,12 +241,13 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int
     }
 
     std::vector<CDeterministicMNCPtr> result;
-    result.reserve(nCount);
+    result.reserve(GetValidMNsCount());
 
     ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
         result.emplace_back(dmn);
     });
-    std::sort(result.begin(), result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
+    // only the first nCount payees need to be in order
+    std::partial_sort(result.begin(), result.begin() + nCount, result.end(), [&](const CDeterministicMNCPtr& a, const CDeterministicMNCPtr& b) {
         return CompareByLastPaid(a, b);
     });
 
@@ -251,49 +258,86 @@ std::vector<CDeterministicMNCPtr> CDeterministicMNList::GetProjectedMNPayees(int
 
 std::vector<CDeterministicMNCPtr> CDeterministicMNList::CalculateQuorum(size_t maxSize, const uint256& modifier) const
 {
+    // Quorum members are requested over and over for the same lists, e.g. for every LLMQ type of a block
+    // and by "quorum" RPCs for older quorums, so keep the recent results around. Lists which are still
+    // being built have no block hash yet and are never cached.
+    static CCriticalSection cs_quorums;
+    static unordered_lru_cache<uint256, std::vector<CDeterministicMNCPtr>, StaticSaltedHasher> quorumsCache(QUORUM_MEMBERS_CACHE_SIZE);
+
+    uint256 cacheKey;
+    if (!blockHash.IsNull()) {
+        CHashWriter hw(SER_GETHASH, 0);
+        hw << blockHash << modifier << (uint64_t)maxSize;
+        cacheKey = hw.GetHash();
+        std::vector<CDeterministicMNCPtr> result;
+        LOCK(cs_quorums);
+        if (quorumsCache.get(cacheKey, result)) {
+            return result;
+        }
+    }
+
     auto scores = CalculateScores(modifier);
 
-    // sort is descending order
-    std::sort(scores.rbegin(), scores.rend(), [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
+    // highest score first
+    auto cmp = [](const std::pair<arith_uint256, CDeterministicMNCPtr>& a, const std::pair<arith_uint256, CDeterministicMNCPtr>& b) {
         if (a.first == b.first) {
             // this should actually never happen, but we should stay compatible with how the non deterministic MNs did the sorting
-            return a.second->collateralOutpoint < b.second->collateralOutpoint;
+            return b.second->collateralOutpoint < a.second->collateralOutpoint;
         }
-        return a.first < b.first;
-    });
+        return b.first < a.first;
+    };
+    // only the top maxSize entries are needed, no need to sort the whole list
+    size_t resultSize = std::min(maxSize, scores.size());
+    std::partial_sort(scores.begin(), scores.begin() + resultSize, scores.end(), cmp);
 
     // take top maxSize entries and return it
     std::vector<CDeterministicMNCPtr> result;
-    result.resize(std::min(maxSize, scores.size()));
+    result.resize(resultSize);
     for (size_t i = 0; i < result.size(); i++) {
         result[i] = std::move(scores[i].second);
     }
+
+    if (!blockHash.IsNull()) {
+        LOCK(cs_quorums);
+        quorumsCache.insert(cacheKey, result);
+    }
     return result;
 }
 
 std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> CDeterministicMNList::CalculateScores(const uint256& modifier) const
 {
-    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
-    scores.reserve(GetAllMNsCount());
+    std::vector<CDeterministicMNCPtr> dmns;
+    dmns.reserve(GetAllMNsCount());
     ForEachMN(true, [&](const CDeterministicMNCPtr& dmn) {
         if (dmn->pdmnState->confirmedHash.IsNull()) {
             // we only take confirmed MNs into account to avoid hash grinding on the ProRegTxHash to sneak MNs into a
             // future quorums
             return;
         }
-        // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
-        // Please note that this is not a double-sha256 but a single-sha256
-        // The first part is already precalculated (confirmedHashWithProRegTxHash)
-        // TODO When https://github.com/bitcoin/bitcoin/pull/13191 gets backported, implement something that is similar but for single-sha256
-        uint256 h;
-        CSHA256 sha256;
-        sha256.Write(dmn->pdmnState->confirmedHashWithProRegTxHash.begin(), dmn->pdmnState->confirmedHashWithProRegTxHash.size());
-        sha256.Write(modifier.begin(), modifier.size());
-        sha256.Finalize(h.begin());
-
-        scores.emplace_back(UintToArith256(h), dmn);
+        dmns.emplace_back(dmn);
     });
 
+    // calculate sha256(sha256(proTxHash, confirmedHash), modifier) per MN
+    // Please note that this is not a double-sha256 but a single-sha256
+    // The first part is already precalculated (confirmedHashWithProRegTxHash)
+    // All inputs are exactly 64 bytes long, so hash them in one batch
+    std::vector<unsigned char> input(dmns.size() * 64);
+    for (size_t i = 0; i < dmns.size(); i++) {
+        const uint256& h = dmns[i]->pdmnState->confirmedHashWithProRegTxHash;
+        memcpy(input.data() + i * 64, h.begin(), 32);
+        memcpy(input.data() + i * 64 + 32, modifier.begin(), 32);
+    }
+    std::vector<unsigned char> output(dmns.size() * 32);
+    SHA256_64(output.data(), input.data(), dmns.size());
+
+    std::vector<std::pair<arith_uint256, CDeterministicMNCPtr>> scores;
+    scores.reserve(dmns.size());
+    for (size_t i = 0; i < dmns.size(); i++) {
+        uint256 h;
+        memcpy(h.begin(), output.data() + i * 32, 32);
+        scores.emplace_back(UintToArith256(h), std::move(dmns[i]));
+    }
+
     return scores;
 }
 
@@ -566,8 +610,23 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
     mnInternalIdMap = mnInternalIdMap.erase(dmn->GetInternalId());
 }
 
-CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb) :
-    evoDb(_evoDb)
+size_t CDeterministicMNList::EstimateEntriesUsage(size_t nEntries)
+{
+    // An immer map node stores a pointer per child on top of the values, so count two pointers
+    // of overhead per map entry. Each masternode has up to 4 unique properties (collateral,
+    // address, owner key and operator key).
+    static const size_t nMapEntryOverhead = 2 * sizeof(void*);
+    static const size_t nEntryUsage =
+        sizeof(CDeterministicMN) + sizeof(CDeterministicMNState) +
+        sizeof(uint256) + sizeof(CDeterministicMNCPtr) + nMapEntryOverhead +
+        sizeof(uint64_t) + sizeof(uint256) + nMapEntryOverhead +
+        4 * (sizeof(uint256) + sizeof(std::pair<uint256, uint32_t>) + nMapEntryOverhead);
+    return sizeof(CDeterministicMNList) + nEntries * nEntryUsage;
+}
+
+CDeterministicMNManager::CDeterministicMNManager(CEvoDB& _evoDb, size_t _nListsCacheLimit) :
+    evoDb(_evoDb),
+    nListsCacheLimit(_nListsCacheLimit)
 {
 }
 
@@ -608,9 +667,10 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
         diff = oldList.BuildDiff(newList);
 
         evoDb.Write(std::make_pair(DB_LIST_DIFF, newList.GetBlockHash()), diff);
+        // The next block needs this list, and it only differs from oldList by the diff
+        AddCachedList(newList, oldList.GetBlockHash(), diff.GetChangesCount());
         if ((nHeight % DISK_SNAPSHOT_PERIOD) == 0 || oldList.GetHeight() == -1) {
             evoDb.Write(std::make_pair(DB_LIST_SNAPSHOT, newList.GetBlockHash()), newList);
-            mnListsCache.emplace(newList.GetBlockHash(), newList);
             LogPrintf("CDeterministicMNManager::%s -- Wrote snapshot. nHeight=%d, mapCurMNs.allMNsCount=%d\n",
                 __func__, nHeight, newList.GetAllMNsCount());
         }
@@ -661,7 +721,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
             prevList = GetListForBlock(pindex->pprev);
         }
 
-        mnListsCache.erase(blockHash);
+        EraseCachedList(blockHash);
         mnListDiffsCache.erase(blockHash);
     }
 
@@ -963,14 +1023,12 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
 
     while (true) {
         // try using cache before reading from disk
-        auto itLists = mnListsCache.find(pindex->GetBlockHash());
-        if (itLists != mnListsCache.end()) {
-            snapshot = itLists->second;
+        if (GetCachedList(pindex->GetBlockHash(), snapshot)) {
             break;
         }
 
         if (evoDb.Read(std::make_pair(DB_LIST_SNAPSHOT, pindex->GetBlockHash()), snapshot)) {
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            AddCachedList(snapshot);
             break;
         }
 
@@ -986,7 +1044,7 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
         if (!evoDb.Read(std::make_pair(DB_LIST_DIFF, pindex->GetBlockHash()), diff)) {
             // no snapshot and no diff on disk means that it's the initial snapshot
             snapshot = CDeterministicMNList(pindex->GetBlockHash(), -1, 0);
-            mnListsCache.emplace(pindex->GetBlockHash(), snapshot);
+            AddCachedList(snapshot);
             break;
         }
 
@@ -996,30 +1054,30 @@ CDeterministicMNList CDeterministicMNManager::GetListForBlock(const CBlockIndex*
         pindex = pindex->pprev;
     }
 
+    if (listDiffIndexes.empty()) {
+        nCacheHits++;
+        return snapshot;
+    }
+
+    nCacheMisses++;
+    nDiffsReplayed += listDiffIndexes.size();
+    nMaxReplayLength = std::max<uint64_t>(nMaxReplayLength, listDiffIndexes.size());
+
+    const uint256 baseHash = snapshot.GetBlockHash();
+    size_t nChanges{0};
     for (const auto& diffIndex : listDiffIndexes) {
         const auto& diff = mnListDiffsCache.at(diffIndex->GetBlockHash());
         if (diff.HasChanges()) {
             snapshot = snapshot.ApplyDiff(diffIndex, diff);
+            nChanges += diff.GetChangesCount();
         } else {
             snapshot.SetBlockHash(diffIndex->GetBlockHash());
             snapshot.SetHeight(diffIndex->nHeight);
         }
     }
 
-    if (tipIndex) {
-        // always keep a snapshot for the tip
-        if (snapshot.GetBlockHash() == tipIndex->GetBlockHash()) {
-            mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
-        } else {
-            // keep snapshots for yet alive quorums
-            for (auto& p_llmq : Params().GetConsensus().llmqs) {
-                if ((snapshot.GetHeight() % p_llmq.second.dkgInterval == 0) && (snapshot.GetHeight() + p_llmq.second.dkgInterval * (p_llmq.second.keepOldConnections + 1) >= tipIndex->nHeight)) {
-                    mnListsCache.emplace(snapshot.GetBlockHash(), snapshot);
-                    break;
-                }
-            }
-        }
-    }
+    // The replayed list shares everything but the changed masternodes with the list it was built from
+    AddCachedList(snapshot, baseHash, nChanges);
 
     return snapshot;
 }
@@ -1066,43 +1124,121 @@ bool CDeterministicMNManager::IsDIP3Enforced(int nHeight)
     return nHeight >= Params().GetConsensus().DIP0003EnforcementHeight;
 }
 
-void CDeterministicMNManager::CleanupCache(int nHeight)
+CDeterministicMNManager::CacheStats CDeterministicMNManager::GetCacheStats()
+{
+    LOCK(cs);
+
+    CacheStats stats;
+    stats.nLists = mnListsCache.size();
+    stats.nUsage = nListsCacheUsage;
+    stats.nLimit = nListsCacheLimit;
+    stats.nHits = nCacheHits;
+    stats.nMisses = nCacheMisses;
+    stats.nDiffsReplayed = nDiffsReplayed;
+    stats.nMaxReplayLength = nMaxReplayLength;
+    return stats;
+}
+
+bool CDeterministicMNManager::GetCachedList(const uint256& blockHash, CDeterministicMNList& list)
 {
     AssertLockHeld(cs);
 
-    std::vector<uint256> toDeleteLists;
-    std::vector<uint256> toDeleteDiffs;
-    for (const auto& p : mnListsCache) {
-        if (p.second.GetHeight() + LIST_DIFFS_CACHE_SIZE < nHeight) {
-            toDeleteLists.emplace_back(p.first);
-            continue;
+    auto it = mnListsCache.find(blockHash);
+    if (it == mnListsCache.end()) {
+        return false;
+    }
+    mnListsLRU.splice(mnListsLRU.begin(), mnListsLRU, it->second.itLRU);
+    list = it->second.list;
+    return true;
+}
+
+void CDeterministicMNManager::AddCachedList(const CDeterministicMNList& list, const uint256& baseHash, size_t nChanges)
+{
+    AssertLockHeld(cs);
+
+    auto it = mnListsCache.find(list.GetBlockHash());
+    if (it != mnListsCache.end()) {
+        mnListsLRU.splice(mnListsLRU.begin(), mnListsLRU, it->second.itLRU);
+        return;
+    }
+
+    // Only a list whose base is still cached shares its unchanged entries with another cached list
+    size_t nUsage;
+    uint256 cachedBaseHash;
+    if (!baseHash.IsNull() && mnListsCache.count(baseHash)) {
+        nUsage = CDeterministicMNList::EstimateEntriesUsage(std::min(nChanges, list.GetAllMNsCount()));
+        cachedBaseHash = baseHash;
+        mnListsDependents[baseHash].emplace_back(list.GetBlockHash());
+    } else {
+        nUsage = CDeterministicMNList::EstimateEntriesUsage(list.GetAllMNsCount());
+    }
+
+    mnListsLRU.emplace_front(list.GetBlockHash());
+    mnListsCache.emplace(list.GetBlockHash(), CachedList{list, nUsage, cachedBaseHash, mnListsLRU.begin()});
+    nListsCacheUsage += nUsage;
+
+    // Evict the least recently used lists, but never the one we just added or the one for the tip.
+    // Evicting a base list raises the usage of its dependents, which the loop takes into account.
+    auto itLRU = std::prev(mnListsLRU.end());
+    while (nListsCacheUsage > nListsCacheLimit && itLRU != mnListsLRU.begin()) {
+        auto itPrev = std::prev(itLRU);
+        if (!tipIndex || *itLRU != tipIndex->GetBlockHash()) {
+            EraseCachedList(*itLRU);
         }
-        bool fQuorumCache{false};
-        for (auto& p_llmq : Params().GetConsensus().llmqs) {
-            if ((p.second.GetHeight() % p_llmq.second.dkgInterval == 0) && (p.second.GetHeight() + p_llmq.second.dkgInterval * (p_llmq.second.keepOldConnections + 1) >= nHeight)) {
-                fQuorumCache = true;
-                break;
+        itLRU = itPrev;
+    }
+}
+
+void CDeterministicMNManager::EraseCachedList(const uint256& blockHash)
+{
+    AssertLockHeld(cs);
+
+    auto it = mnListsCache.find(blockHash);
+    if (it == mnListsCache.end()) {
+        return;
+    }
+
+    if (!it->second.baseHash.IsNull()) {
+        auto itBase = mnListsDependents.find(it->second.baseHash);
+        if (itBase != mnListsDependents.end()) {
+            auto& dependents = itBase->second;
+            dependents.erase(std::remove(dependents.begin(), dependents.end(), blockHash), dependents.end());
+            if (dependents.empty()) {
+                mnListsDependents.erase(itBase);
             }
         }
-        if (fQuorumCache) {
-            // at least one quorum could be using it, keep it
-            continue;
-        }
-        // no alive quorums using it, see if it was a cache for the tip or for a now outdated quorum
-        if (tipIndex && tipIndex->pprev && (p.first == tipIndex->pprev->GetBlockHash())) {
-            toDeleteLists.emplace_back(p.first);
-        } else {
-            for (auto& p_llmq : Params().GetConsensus().llmqs) {
-                if (p.second.GetHeight() % p_llmq.second.dkgInterval == 0) {
-                    toDeleteLists.emplace_back(p.first);
-                    break;
-                }
+    }
+
+    // Lists derived from this one now hold the shared entries on their own
+    auto itDependents = mnListsDependents.find(blockHash);
+    if (itDependents != mnListsDependents.end()) {
+        for (const auto& dependentHash : itDependents->second) {
+            auto itDependent = mnListsCache.find(dependentHash);
+            if (itDependent == mnListsCache.end()) {
+                continue;
+            }
+            CachedList& dependent = itDependent->second;
+            const size_t nFullUsage = CDeterministicMNList::EstimateEntriesUsage(dependent.list.GetAllMNsCount());
+            if (nFullUsage > dependent.nUsage) {
+                nListsCacheUsage += nFullUsage - dependent.nUsage;
+                dependent.nUsage = nFullUsage;
             }
+            dependent.baseHash.SetNull();
         }
+        mnListsDependents.erase(itDependents);
     }
-    for (const auto& h : toDeleteLists) {
-        mnListsCache.erase(h);
-    }
+
+    nListsCacheUsage -= it->second.nUsage;
+    mnListsLRU.erase(it->second.itLRU);
+    mnListsCache.erase(it);
+}
+
+void CDeterministicMNManager::CleanupCache(int nHeight)
+{
+    AssertLockHeld(cs);
+
+    // Lists are bounded by the LRU, only diffs which are too old to be useful need to be dropped here
+    std::vector<uint256> toDeleteDiffs;
     for (const auto& p : mnListDiffsCache) {
         if (p.second.nHeight + LIST_DIFFS_CACHE_SIZE < nHeight) {
             toDeleteDiffs.emplace_back(p.first);
@@ -17,6 +17,7 @@
 #include <immer/map.hpp>
 #include <immer/map_transient.hpp>
 
+#include <list>
 #include <unordered_map>
 
 class CBlock;
@@ -369,6 +370,13 @@ public:
         return mnMap.size();
     }
 
+    /**
+     * Estimated heap usage of nEntries masternodes which are not shared with any other list. This
+     * covers the masternode and its state as well as its entries in the internal id and unique
+     * property maps.
+     */
+    static size_t EstimateEntriesUsage(size_t nEntries);
+
     size_t GetValidMNsCount() const
     {
         size_t count = 0;
@@ -584,6 +592,11 @@ public:
     std::set<uint64_t> removedMns;
 
 public:
+    size_t GetChangesCount() const
+    {
+        return addedMNs.size() + updatedMNs.size() + removedMns.size();
+    }
+
     template<typename Stream>
     void Serialize(Stream& s) const
     {
@@ -663,6 +676,9 @@ public:
     }
 };
 
+/** Default for -mnlistcache, the memory budget in MiB for masternode lists kept in memory */
+static const int64_t DEFAULT_MNLIST_CACHE_SIZE = 64;
+
 class CDeterministicMNManager
 {
     static const int DISK_SNAPSHOT_PERIOD = 576; // once per day
@@ -672,15 +688,48 @@ class CDeterministicMNManager
 public:
     CCriticalSection cs;
 
+    struct CacheStats {
+        size_t nLists{0};
+        size_t nUsage{0};
+        size_t nLimit{0};
+        uint64_t nHits{0};
+        uint64_t nMisses{0};
+        uint64_t nDiffsReplayed{0};
+        uint64_t nMaxReplayLength{0};
+    };
+
 private:
     CEvoDB& evoDb;
 
-    std::unordered_map<uint256, CDeterministicMNList, StaticSaltedHasher> mnListsCache;
+    struct CachedList {
+        CDeterministicMNList list;
+        size_t nUsage;
+        // The cached list this one was derived from and shares its unchanged entries with, or null
+        uint256 baseHash;
+        std::list<uint256>::iterator itLRU;
+    };
+
+    // Lists are kept in an LRU bounded by their estimated memory usage. Lists derived from another
+    // cached list share all untouched nodes of the immer maps with it, so they are only charged for
+    // the masternodes which changed on the way. Once the base list is evicted, its dependent lists
+    // keep the shared nodes alive on their own and are charged for all their masternodes. The list
+    // for the current tip is never evicted.
+    std::unordered_map<uint256, CachedList, StaticSaltedHasher> mnListsCache;
+    std::unordered_map<uint256, std::vector<uint256>, StaticSaltedHasher> mnListsDependents;
+    std::list<uint256> mnListsLRU;
+    size_t nListsCacheUsage{0};
+    const size_t nListsCacheLimit;
+
     std::unordered_map<uint256, CDeterministicMNListDiff, StaticSaltedHasher> mnListDiffsCache;
     const CBlockIndex* tipIndex{nullptr};
 
+    uint64_t nCacheHits{0};
+    uint64_t nCacheMisses{0};
+    uint64_t nDiffsReplayed{0};
+    uint64_t nMaxReplayLength{0};
+
 public:
-    explicit CDeterministicMNManager(CEvoDB& _evoDb);
+    explicit CDeterministicMNManager(CEvoDB& _evoDb, size_t _nListsCacheLimit = DEFAULT_MNLIST_CACHE_SIZE << 20);
 
     bool ProcessBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, const CCoinsViewCache& view, bool fJustCheck);
     bool UndoBlock(const CBlock& block, const CBlockIndex* pindex);
@@ -700,12 +749,17 @@ public:
 
     bool IsDIP3Enforced(int nHeight = -1);
 
+    CacheStats GetCacheStats();
+
 public:
     // TODO these can all be removed in a future version
     void UpgradeDiff(CDBBatch& batch, const CBlockIndex* pindexNext, const CDeterministicMNList& curMNList, CDeterministicMNList& newMNList);
     bool UpgradeDBIfNeeded();
 
 private:
+    bool GetCachedList(const uint256& blockHash, CDeterministicMNList& list);
+    void AddCachedList(const CDeterministicMNList& list, const uint256& baseHash = uint256(), size_t nChanges = 0);
+    void EraseCachedList(const uint256& blockHash);
     void CleanupCache(int nHeight);
 };
 
@@ -13,9 +13,14 @@
 #include <base58.h>
 #include <chainparams.h>
 #include <consensus/merkle.h>
+#include <crypto/sha256.h>
+#include <saltedhasher.h>
 #include <univalue.h>
+#include <unordered_lru_cache.h>
 #include <validation.h>
 
+#include <limits>
+
 CSimplifiedMNListEntry::CSimplifiedMNListEntry(const CDeterministicMN& dmn) :
     proRegTxHash(dmn.proTxHash),
     confirmedHash(dmn.pdmnState->confirmedHash),
@@ -87,6 +92,113 @@ uint256 CSimplifiedMNList::CalcMerkleRoot(bool* pmutated) const
     return ComputeMerkleRoot(leaves, pmutated);
 }
 
+static void HashMerklePair(std::vector<uint256>& parents, const std::vector<uint256>& children, size_t nParent)
+{
+    if (2 * nParent + 1 < children.size()) {
+        SHA256D64(parents[nParent].begin(), children[2 * nParent].begin(), 1);
+    } else {
+        // odd number of children, the last one is paired with itself
+        unsigned char buf[64];
+        memcpy(buf, children[2 * nParent].begin(), 32);
+        memcpy(buf + 32, children[2 * nParent].begin(), 32);
+        SHA256D64(parents[nParent].begin(), buf, 1);
+    }
+}
+
+void CSortedMerkleTree::Update(const std::map<uint256, uint256>& mapLeaves, const std::set<uint256>& setRemoved)
+{
+    static const size_t NONE = std::numeric_limits<size_t>::max();
+
+    // Merge the changes into the sorted leaves. Leaves left of the first insertion/removal keep their position, so
+    // only the changed ones among them need their branches rehashed. Everything right of it is rehashed.
+    const std::vector<uint256>& vOldLeaves = vLevels[0];
+    std::vector<uint256> vNewKeys, vNewLeaves;
+    vNewKeys.reserve(vKeys.size() + mapLeaves.size());
+    vNewLeaves.reserve(vKeys.size() + mapLeaves.size());
+    std::vector<size_t> vDirty;
+    size_t nFirstShifted = NONE;
+
+    auto it = mapLeaves.begin();
+    size_t i = 0;
+    while (i < vKeys.size() || it != mapLeaves.end()) {
+        if (it != mapLeaves.end() && (i == vKeys.size() || it->first < vKeys[i])) {
+            nFirstShifted = std::min(nFirstShifted, vNewKeys.size());
+            vNewKeys.emplace_back(it->first);
+            vNewLeaves.emplace_back(it->second);
+            ++it;
+            continue;
+        }
+        if (setRemoved.count(vKeys[i])) {
+            nFirstShifted = std::min(nFirstShifted, vNewKeys.size());
+            ++i;
+            continue;
+        }
+        if (it != mapLeaves.end() && it->first == vKeys[i]) {
+            if (it->second != vOldLeaves[i] && nFirstShifted == NONE) {
+                vDirty.emplace_back(vNewKeys.size());
+            }
+            vNewLeaves.emplace_back(it->second);
+            ++it;
+        } else {
+            vNewLeaves.emplace_back(vOldLeaves[i]);
+        }
+        vNewKeys.emplace_back(vKeys[i]);
+        ++i;
+    }
+    vKeys = std::move(vNewKeys);
+    vLevels[0] = std::move(vNewLeaves);
+
+    size_t nLevel = 0;
+    for (; vLevels[nLevel].size() > 1; nLevel++) {
+        if (nLevel + 1 == vLevels.size()) {
+            // the tree got higher, the new level needs to be calculated completely
+            vLevels.emplace_back();
+            nFirstShifted = 0;
+        }
+        const std::vector<uint256>& children = vLevels[nLevel];
+        std::vector<uint256>& parents = vLevels[nLevel + 1];
+        const size_t nParents = (children.size() + 1) / 2;
+        const size_t nParentsShifted = nFirstShifted == NONE ? NONE : nFirstShifted / 2;
+        parents.resize(nParents);
+
+        std::vector<size_t> vParentsDirty;
+        for (size_t nChild : vDirty) {
+            const size_t nParent = nChild / 2;
+            if (nParent < nParentsShifted && (vParentsDirty.empty() || vParentsDirty.back() != nParent)) {
+                HashMerklePair(parents, children, nParent);
+                vParentsDirty.emplace_back(nParent);
+            }
+        }
+        if (nParentsShifted < nParents) {
+            const size_t nFullPairs = children.size() / 2;
+            if (nParentsShifted < nFullPairs) {
+                SHA256D64(parents[nParentsShifted].begin(), children[2 * nParentsShifted].begin(), nFullPairs - nParentsShifted);
+            }
+            if (nFullPairs < nParents) {
+                HashMerklePair(parents, children, nFullPairs);
+            }
+        }
+        vDirty = std::move(vParentsDirty);
+        nFirstShifted = nParentsShifted;
+    }
+    vLevels.resize(nLevel + 1);
+}
+
+uint256 CSortedMerkleTree::GetRoot(bool* pmutated) const
+{
+    if (pmutated) {
+        // Same as ComputeMerkleRoot: two identical siblings on any level (not counting the duplicated last one of odd
+        // levels) allow a different list to have the same root
+        *pmutated = false;
+        for (const auto& level : vLevels) {
+            for (size_t pos = 0; pos + 1 < level.size() && !*pmutated; pos += 2) {
+                *pmutated = level[pos] == level[pos + 1];
+            }
+        }
+    }
+    return vLevels.back().empty() ? uint256() : vLevels.back()[0];
+}
+
 CSimplifiedMNListDiff::CSimplifiedMNListDiff() = default;
 
 CSimplifiedMNListDiff::~CSimplifiedMNListDiff() = default;
@@ -181,9 +293,23 @@ void CSimplifiedMNListDiff::ToJson(UniValue& obj) const
 }
 
 bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet)
+{
+    std::shared_ptr<const CSimplifiedMNListDiff> mnListDiff;
+    if (!GetSimplifiedMNListDiff(baseBlockHash, blockHash, mnListDiff, errorRet)) {
+        return false;
+    }
+    mnListDiffRet = *mnListDiff;
+    return true;
+}
+
+// Mostly serves SPV clients asking for the diff from their last known list (or from genesis) to the tip. A diff is
+// deterministic for a pair of blocks, so cached ones never need to be invalidated.
+static const size_t MNLISTDIFF_CACHE_SIZE = 32;
+static unordered_lru_cache<uint256, std::shared_ptr<const CSimplifiedMNListDiff>, StaticSaltedHasher, MNLISTDIFF_CACHE_SIZE> mnListDiffCache GUARDED_BY(cs_main);
+
+bool GetSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, std::shared_ptr<const CSimplifiedMNListDiff>& mnListDiffRet, std::string& errorRet)
 {
     AssertLockHeld(cs_main);
-    mnListDiffRet = CSimplifiedMNListDiff();
 
     const CBlockIndex* baseBlockIndex = chainActive.Genesis();
     if (!baseBlockHash.IsNull()) {
@@ -209,18 +335,24 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
         return false;
     }
 
+    // The requested base hash is part of the key, as a null hash and the genesis hash give slightly different results
+    const uint256 cacheKey = ::SerializeHash(std::make_pair(baseBlockHash, blockHash));
+    if (mnListDiffCache.get(cacheKey, mnListDiffRet)) {
+        return true;
+    }
+
     LOCK(deterministicMNManager->cs);
 
     auto baseDmnList = deterministicMNManager->GetListForBlock(baseBlockIndex);
     auto dmnList = deterministicMNManager->GetListForBlock(blockIndex);
-    mnListDiffRet = baseDmnList.BuildSimplifiedDiff(dmnList);
+    auto mnListDiff = std::make_shared<CSimplifiedMNListDiff>(baseDmnList.BuildSimplifiedDiff(dmnList));
 
     // We need to return the value that was provided by the other peer as it otherwise won't be able to recognize the
     // response. This will usually be identical to the block found in baseBlockIndex. The only difference is when a
     // null block hash was provided to get the diff from the genesis block.
-    mnListDiffRet.baseBlockHash = baseBlockHash;
+    mnListDiff->baseBlockHash = baseBlockHash;
 
-    if (!mnListDiffRet.BuildQuorumsDiff(baseBlockIndex, blockIndex)) {
+    if (!mnListDiff->BuildQuorumsDiff(baseBlockIndex, blockIndex)) {
         errorRet = strprintf("failed to build quorums diff");
         return false;
     }
@@ -232,7 +364,7 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
         return false;
     }
 
-    mnListDiffRet.cbTx = block.vtx[0];
+    mnListDiff->cbTx = block.vtx[0];
 
     std::vector<uint256> vHashes;
     std::vector<bool> vMatch(block.vtx.size(), false);
@@ -240,7 +372,9 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
         vHashes.emplace_back(tx->GetHash());
     }
     vMatch[0] = true; // only coinbase matches
-    mnListDiffRet.cbTxMerkleTree = CPartialMerkleTree(vHashes, vMatch);
+    mnListDiff->cbTxMerkleTree = CPartialMerkleTree(vHashes, vMatch);
 
+    mnListDiffCache.insert(cacheKey, mnListDiff);
+    mnListDiffRet = std::move(mnListDiff);
     return true;
 }
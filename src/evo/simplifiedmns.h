@@ -12,6 +12,10 @@
 #include <serialize.h>
 #include <version.h>
 
+#include <map>
+#include <memory>
+#include <set>
+
 class UniValue;
 class CDeterministicMNList;
 class CDeterministicMN;
@@ -84,6 +88,26 @@ public:
     uint256 CalcMerkleRoot(bool* pmutated = nullptr) const;
 };
 
+/**
+ * A merkle tree over leaves which are sorted by a key, as used for the SML merkle root. Changing a leaf only rehashes
+ * the branch above it, while inserting or removing leaves rehashes everything right of the first inserted or removed
+ * leaf. The root and mutation flag are the same as ComputeMerkleRoot() returns for the sorted leaves.
+ */
+class CSortedMerkleTree
+{
+private:
+    std::vector<uint256> vKeys;
+    //! vLevels[0] holds the leaves and the last level holds the root (if there are any leaves)
+    std::vector<std::vector<uint256>> vLevels{1};
+
+public:
+    /** Insert or change the leaves in mapLeaves and remove the leaves with the keys in setRemoved */
+    void Update(const std::map<uint256, uint256>& mapLeaves, const std::set<uint256>& setRemoved);
+
+    size_t size() const { return vKeys.size(); }
+    uint256 GetRoot(bool* pmutated = nullptr) const;
+};
+
 /// P2P messages
 
 class CGetSimplifiedMNListDiff
@@ -146,5 +170,7 @@ public:
 };
 
 bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet);
+/** Like BuildSimplifiedMNListDiff, but returns a shared diff which is memoized for repeated requests of the same range */
+bool GetSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, std::shared_ptr<const CSimplifiedMNListDiff>& mnListDiffRet, std::string& errorRet);
 
 #endif // BITCOIN_EVO_SIMPLIFIEDMNS_H
@@ -0,0 +1,210 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <governance/governance-db.h>
+
+#include <governance/governance.h>
+#include <governance/governance-object.h>
+#include <governance/governance-vote.h>
+#include <util.h>
+
+#include <tuple>
+
+std::unique_ptr<CGovernanceDB> governanceDb;
+
+static const std::string DB_VERSION = "gov_ver";
+static const std::string DB_MANAGER_STATE = "gov_state";
+static const std::string DB_OBJECT = "gov_o";
+static const std::string DB_VOTE = "gov_v";
+static const std::string DB_VOTE_INDEX = "gov_vi";
+static const std::string DB_MN_VOTES = "gov_mv";
+
+template <typename K>
+static void ErasePrefix(CDBWrapper& db, CDBBatch& batch, const K& start)
+{
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        K k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != std::get<0>(start)) {
+            break;
+        }
+        batch.Erase(k);
+        pcursor->Next();
+    }
+}
+
+CGovernanceDB::CGovernanceDB(size_t nCacheSize, bool fMemory, bool fWipe) :
+    db(fMemory ? "" : (GetDataDir() / "governance"), nCacheSize, fMemory, fWipe)
+{
+}
+
+bool CGovernanceDB::CheckVersion(const std::string& strVersion)
+{
+    std::string strDbVersion;
+    if (db.Read(DB_VERSION, strDbVersion) && strDbVersion == strVersion) {
+        return true;
+    }
+
+    if (!db.IsEmpty()) {
+        LogPrintf("CGovernanceDB::%s -- version mismatch (db %s, expected %s), erasing governance db\n", __func__, strDbVersion, strVersion);
+    }
+
+    CDBBatch batch(db);
+    ErasePrefix(db, batch, std::make_tuple(DB_OBJECT, uint256()));
+    ErasePrefix(db, batch, std::make_tuple(DB_VOTE, uint256(), uint256()));
+    ErasePrefix(db, batch, std::make_tuple(DB_VOTE_INDEX, uint256()));
+    ErasePrefix(db, batch, std::make_tuple(DB_MN_VOTES, uint256(), COutPoint()));
+    batch.Erase(DB_MANAGER_STATE);
+    batch.Write(DB_VERSION, strVersion);
+    db.WriteBatch(batch, true);
+    return false;
+}
+
+bool CGovernanceDB::ReadManagerState(CGovernanceManager& govman)
+{
+    return db.Read(DB_MANAGER_STATE, govman);
+}
+
+bool CGovernanceDB::WriteManagerState(const CGovernanceManager& govman)
+{
+    return db.Write(DB_MANAGER_STATE, govman);
+}
+
+bool CGovernanceDB::WriteObject(const CGovernanceObject& govobj)
+{
+    return db.Write(std::make_tuple(DB_OBJECT, govobj.GetHash()), govobj);
+}
+
+bool CGovernanceDB::EraseObject(const uint256& nHash)
+{
+    CDBBatch batch(db);
+    batch.Erase(std::make_tuple(DB_OBJECT, nHash));
+
+    auto start = std::make_tuple(DB_VOTE, nHash, uint256());
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        decltype(start) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_VOTE || std::get<1>(k) != nHash) {
+            break;
+        }
+        batch.Erase(k);
+        batch.Erase(std::make_tuple(DB_VOTE_INDEX, std::get<2>(k)));
+        pcursor->Next();
+    }
+
+    auto start2 = std::make_tuple(DB_MN_VOTES, nHash, COutPoint());
+    pcursor->Seek(start2);
+
+    while (pcursor->Valid()) {
+        decltype(start2) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_MN_VOTES || std::get<1>(k) != nHash) {
+            break;
+        }
+        batch.Erase(k);
+        pcursor->Next();
+    }
+    pcursor.reset();
+
+    return db.WriteBatch(batch);
+}
+
+void CGovernanceDB::ForEachObject(std::function<bool(const uint256& nHash, CGovernanceObject& govobj)> func)
+{
+    auto start = std::make_tuple(DB_OBJECT, uint256());
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        decltype(start) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_OBJECT) {
+            break;
+        }
+        CGovernanceObject govobj;
+        if (!pcursor->GetValue(govobj)) {
+            LogPrintf("CGovernanceDB::%s -- failed to read object %s\n", __func__, std::get<1>(k).ToString());
+        } else if (!func(std::get<1>(k), govobj)) {
+            break;
+        }
+        pcursor->Next();
+    }
+}
+
+bool CGovernanceDB::WriteVote(const CGovernanceVote& vote)
+{
+    uint256 nHash = vote.GetHash();
+    CDBBatch batch(db);
+    batch.Write(std::make_tuple(DB_VOTE, vote.GetParentHash(), nHash), vote);
+    batch.Write(std::make_tuple(DB_VOTE_INDEX, nHash), vote.GetParentHash());
+    return db.WriteBatch(batch);
+}
+
+bool CGovernanceDB::EraseVote(const CGovernanceVote& vote)
+{
+    uint256 nHash = vote.GetHash();
+    CDBBatch batch(db);
+    batch.Erase(std::make_tuple(DB_VOTE, vote.GetParentHash(), nHash));
+    batch.Erase(std::make_tuple(DB_VOTE_INDEX, nHash));
+    return db.WriteBatch(batch);
+}
+
+bool CGovernanceDB::ReadVotes(const uint256& nParentHash, std::vector<CGovernanceVote>& vecVotes)
+{
+    auto start = std::make_tuple(DB_VOTE, nParentHash, uint256());
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        decltype(start) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_VOTE || std::get<1>(k) != nParentHash) {
+            break;
+        }
+        CGovernanceVote vote;
+        if (!pcursor->GetValue(vote)) {
+            return error("CGovernanceDB::%s -- failed to read vote %s for object %s", __func__, std::get<2>(k).ToString(), nParentHash.ToString());
+        }
+        vecVotes.emplace_back(std::move(vote));
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool CGovernanceDB::ReadVoteParent(const uint256& nVoteHash, uint256& nParentHashRet)
+{
+    return db.Read(std::make_tuple(DB_VOTE_INDEX, nVoteHash), nParentHashRet);
+}
+
+bool CGovernanceDB::WriteMNVotes(const uint256& nParentHash, const COutPoint& mnOutpoint, const vote_rec_t& voteRecord)
+{
+    return db.Write(std::make_tuple(DB_MN_VOTES, nParentHash, mnOutpoint), voteRecord);
+}
+
+bool CGovernanceDB::EraseMNVotes(const uint256& nParentHash, const COutPoint& mnOutpoint)
+{
+    return db.Erase(std::make_tuple(DB_MN_VOTES, nParentHash, mnOutpoint));
+}
+
+bool CGovernanceDB::ReadMNVotes(const uint256& nParentHash, std::map<COutPoint, vote_rec_t>& mapVotes)
+{
+    auto start = std::make_tuple(DB_MN_VOTES, nParentHash, COutPoint());
+    std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+    pcursor->Seek(start);
+
+    while (pcursor->Valid()) {
+        decltype(start) k;
+        if (!pcursor->GetKey(k) || std::get<0>(k) != DB_MN_VOTES || std::get<1>(k) != nParentHash) {
+            break;
+        }
+        vote_rec_t voteRecord;
+        if (!pcursor->GetValue(voteRecord)) {
+            return error("CGovernanceDB::%s -- failed to read votes of masternode %s for object %s", __func__, std::get<2>(k).ToStringShort(), nParentHash.ToString());
+        }
+        mapVotes.emplace(std::get<2>(k), std::move(voteRecord));
+        pcursor->Next();
+    }
+    return true;
+}
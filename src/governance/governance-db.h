@@ -0,0 +1,72 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_GOVERNANCE_GOVERNANCE_DB_H
+#define BITCOIN_GOVERNANCE_GOVERNANCE_DB_H
+
+#include <dbwrapper.h>
+#include <primitives/transaction.h>
+#include <uint256.h>
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+class CGovernanceManager;
+class CGovernanceObject;
+class CGovernanceVote;
+struct vote_rec_t;
+
+/** Size of the leveldb cache of the governance db */
+static const size_t GOVERNANCE_DB_CACHE_SIZE = 8 << 20;
+
+/**
+ * Persistent store for the governance manager, located in the "governance" directory.
+ *
+ * Objects are stored without their votes. Votes are stored one entry per vote, keyed by
+ * the hash of their object, so that they can be added and removed one at a time and only
+ * have to be loaded for objects which are actually used (see CGovernanceObjectVoteFile).
+ * The current votes of a masternode on an object, which are needed to tally the votes,
+ * are stored in one entry per masternode and object and updated together with the votes.
+ * An index from vote hash to object hash allows answering inventory requests for votes
+ * without loading any of them. The remaining manager state (erased objects, orphan and
+ * invalid votes, ...) is small and stored as a single entry.
+ */
+class CGovernanceDB
+{
+private:
+    CDBWrapper db;
+
+public:
+    explicit CGovernanceDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+
+    /**
+     * Make sure the db was written with the given serialization version. If it was not,
+     * everything in it is erased and the version is updated. Returns false in that case.
+     */
+    bool CheckVersion(const std::string& strVersion);
+
+    bool ReadManagerState(CGovernanceManager& govman);
+    bool WriteManagerState(const CGovernanceManager& govman);
+
+    bool WriteObject(const CGovernanceObject& govobj);
+    /** Erase the object, all of its votes and their index entries */
+    bool EraseObject(const uint256& nHash);
+    /** Call func for every stored object until it returns false */
+    void ForEachObject(std::function<bool(const uint256& nHash, CGovernanceObject& govobj)> func);
+
+    bool WriteVote(const CGovernanceVote& vote);
+    bool EraseVote(const CGovernanceVote& vote);
+    bool ReadVotes(const uint256& nParentHash, std::vector<CGovernanceVote>& vecVotes);
+    bool ReadVoteParent(const uint256& nVoteHash, uint256& nParentHashRet);
+
+    bool WriteMNVotes(const uint256& nParentHash, const COutPoint& mnOutpoint, const vote_rec_t& voteRecord);
+    bool EraseMNVotes(const uint256& nParentHash, const COutPoint& mnOutpoint);
+    bool ReadMNVotes(const uint256& nParentHash, std::map<COutPoint, vote_rec_t>& mapVotes);
+};
+
+extern std::unique_ptr<CGovernanceDB> governanceDb;
+
+#endif // BITCOIN_GOVERNANCE_GOVERNANCE_DB_H
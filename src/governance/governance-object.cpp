@@ -4,6 +4,7 @@
 
 #include <governance/governance-object.h>
 #include <core_io.h>
+#include <governance/governance-db.h>
 #include <governance/governance-validators.h>
 #include <governance/governance.h>
 #include <masternode/masternode-meta.h>
@@ -34,6 +35,7 @@ CGovernanceObject::CGovernanceObject() :
     fCachedEndorsed(false),
     fDirtyCache(true),
     fExpired(false),
+    fDirtyDb(true),
     fUnparsable(false),
     mapCurrentMNVotes(),
     fileVotes()
@@ -61,6 +63,7 @@ CGovernanceObject::CGovernanceObject(const uint256& nHashParentIn, int nRevision
     fCachedEndorsed(false),
     fDirtyCache(true),
     fExpired(false),
+    fDirtyDb(true),
     fUnparsable(false),
     mapCurrentMNVotes(),
     fileVotes()
@@ -88,6 +91,7 @@ CGovernanceObject::CGovernanceObject(const CGovernanceObject& other) :
     fCachedEndorsed(other.fCachedEndorsed),
     fDirtyCache(other.fDirtyCache),
     fExpired(other.fExpired),
+    fDirtyDb(other.fDirtyDb),
     fUnparsable(other.fUnparsable),
     mapCurrentMNVotes(other.mapCurrentMNVotes),
     fileVotes(other.fileVotes)
@@ -209,7 +213,11 @@ bool CGovernanceObject::ProcessVote(CNode* pfrom,
 
     voteInstanceRef = vote_instance_t(vote.GetOutcome(), nVoteTimeUpdate, vote.GetTimestamp());
     fileVotes.AddVote(vote);
+    if (governanceDb) {
+        governanceDb->WriteMNVotes(GetHash(), vote.GetMasternodeOutpoint(), voteRecordRef);
+    }
     fDirtyCache = true;
+    fDirtyDb = true;
     // SEND NOTIFICATION TO SCRIPT/ZMQ
     GetMainSignals().NotifyGovernanceVote(std::make_shared<const CGovernanceVote>(vote));
     return true;
@@ -225,8 +233,12 @@ void CGovernanceObject::ClearMasternodeVotes()
     while (it != mapCurrentMNVotes.end()) {
         if (!mnList.HasMNByCollateral(it->first)) {
             fileVotes.RemoveVotesFromMasternode(it->first);
+            if (governanceDb) {
+                governanceDb->EraseMNVotes(GetHash(), it->first);
+            }
             mapCurrentMNVotes.erase(it++);
             fDirtyCache = true;
+            fDirtyDb = true;
         } else {
             ++it;
         }
@@ -259,7 +271,12 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
         }
     }
     if (it->second.mapInstances.empty()) {
+        if (governanceDb) {
+            governanceDb->EraseMNVotes(nParentHash, mnOutpoint);
+        }
         mapCurrentMNVotes.erase(it);
+    } else if (governanceDb) {
+        governanceDb->WriteMNVotes(nParentHash, mnOutpoint, it->second);
     }
 
     if (!removedVotes.empty()) {
@@ -269,6 +286,7 @@ std::set<uint256> CGovernanceObject::RemoveInvalidVotes(const COutPoint& mnOutpo
         }
         LogPrintf("CGovernanceObject::%s -- Removed %d invalid votes for %s from MN %s:\n%s", __func__, removedVotes.size(), nParentHash.ToString(), mnOutpoint.ToString(), removedStr); /* Continued */
         fDirtyCache = true;
+        fDirtyDb = true;
     }
 
     return removedVotes;
@@ -662,6 +680,14 @@ bool CGovernanceObject::GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint,
     return true;
 }
 
+bool CGovernanceObject::LoadCurrentMNVotes()
+{
+    LOCK(cs);
+
+    mapCurrentMNVotes.clear();
+    return governanceDb && governanceDb->ReadMNVotes(GetHash(), mapCurrentMNVotes);
+}
+
 void CGovernanceObject::Relay(CConnman& connman)
 {
     // Do not relay until fully synced
@@ -701,6 +727,7 @@ void CGovernanceObject::UpdateSentinelVariables()
         fCachedDelete = true;
         if (nDeletionTime == 0) {
             nDeletionTime = GetAdjustedTime();
+            fDirtyDb = true;
         }
     }
     if (GetAbsoluteYesCount(VOTE_SIGNAL_ENDORSED) >= nAbsVoteReq) fCachedEndorsed = true;
@@ -156,6 +156,9 @@ private:
     /// Object is no longer of interest
     bool fExpired;
 
+    /// Object was changed since it was last written to the governance db
+    bool fDirtyDb;
+
     /// Failed to parse object data
     bool fUnparsable;
 
@@ -230,6 +233,17 @@ public:
     void SetExpired()
     {
         fExpired = true;
+        fDirtyDb = true;
+    }
+
+    bool IsSetDirtyDb() const
+    {
+        return fDirtyDb;
+    }
+
+    void ClearDirtyDb()
+    {
+        fDirtyDb = false;
     }
 
     const CGovernanceObjectVoteFile& GetVoteFile() const
@@ -263,6 +277,7 @@ public:
         fCachedDelete = true;
         if (nDeletionTime == 0) {
             nDeletionTime = nDeletionTime_;
+            fDirtyDb = true;
         }
     }
 
@@ -286,6 +301,9 @@ public:
 
     bool GetCurrentMNVotes(const COutPoint& mnCollateralOutpoint, vote_rec_t& voteRecord) const;
 
+    /// Read the current votes of all masternodes after the object was read from the governance db
+    bool LoadCurrentMNVotes();
+
     // FUNCTIONS FOR DEALING WITH DATA STRING
 
     std::string GetDataAsHexString() const;
@@ -314,8 +332,11 @@ public:
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp Reading/writing votes from/to disk\n");
             READWRITE(nDeletionTime);
             READWRITE(fExpired);
-            READWRITE(mapCurrentMNVotes);
+            // The votes and the current votes of each masternode are stored separately in the governance db
             READWRITE(fileVotes);
+            if (ser_action.ForRead()) {
+                fileVotes.SetParentHash(GetHash());
+            }
             LogPrint(BCLog::GOBJECT, "CGovernanceObject::SerializationOp hash = %s, vote count = %d\n", GetHash().ToString(), fileVotes.GetVoteCount());
         }
 
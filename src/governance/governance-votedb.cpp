@@ -4,8 +4,19 @@
 
 #include <governance/governance-votedb.h>
 
+#include <governance/governance-db.h>
+#include <util.h>
+
+std::atomic<size_t> CGovernanceObjectVoteFile::nLoadedVotes{0};
+
+/// Orders vote files by their last use
+static std::atomic<int64_t> nVoteFileUseCounter{0};
+
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
     nMemoryVotes(0),
+    nParentHash(),
+    fLoaded(true),
+    nLastUsed(0),
     listVotes(),
     mapVoteIndex()
 {
@@ -13,10 +24,54 @@ CGovernanceObjectVoteFile::CGovernanceObjectVoteFile() :
 
 CGovernanceObjectVoteFile::CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other) :
     nMemoryVotes(other.nMemoryVotes),
+    nParentHash(other.nParentHash),
+    fLoaded(other.fLoaded),
+    nLastUsed(other.nLastUsed),
     listVotes(other.listVotes),
     mapVoteIndex()
 {
-    RebuildIndex();
+    nLoadedVotes += listVotes.size();
+    if (fLoaded) {
+        RebuildIndex();
+    }
+}
+
+CGovernanceObjectVoteFile::~CGovernanceObjectVoteFile()
+{
+    nLoadedVotes -= listVotes.size();
+}
+
+void CGovernanceObjectVoteFile::EnsureLoaded() const
+{
+    nLastUsed = ++nVoteFileUseCounter;
+    if (fLoaded) {
+        return;
+    }
+    fLoaded = true;
+
+    std::vector<CGovernanceVote> vecVotes;
+    if (!governanceDb || !governanceDb->ReadVotes(nParentHash, vecVotes)) {
+        LogPrintf("CGovernanceObjectVoteFile::%s -- failed to load votes for object %s\n", __func__, nParentHash.ToString());
+    }
+    for (auto& vote : vecVotes) {
+        uint256 nHash = vote.GetHash();
+        listVotes.push_front(std::move(vote));
+        mapVoteIndex.emplace(nHash, listVotes.begin());
+    }
+    nLoadedVotes += listVotes.size();
+    // The number of votes is written with the object and might be behind after a crash
+    nMemoryVotes = listVotes.size();
+}
+
+void CGovernanceObjectVoteFile::Unload() const
+{
+    if (!fLoaded || !governanceDb) {
+        return;
+    }
+    nLoadedVotes -= listVotes.size();
+    listVotes.clear();
+    mapVoteIndex.clear();
+    fLoaded = false;
 }
 
 void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
@@ -25,19 +80,28 @@ void CGovernanceObjectVoteFile::AddVote(const CGovernanceVote& vote)
     // make sure to never add/update already known votes
     if (HasVote(nHash))
         return;
+    if (nParentHash.IsNull()) {
+        nParentHash = vote.GetParentHash();
+    }
     listVotes.push_front(vote);
     mapVoteIndex.emplace(nHash, listVotes.begin());
     ++nMemoryVotes;
+    ++nLoadedVotes;
+    if (governanceDb) {
+        governanceDb->WriteVote(vote);
+    }
     RemoveOldVotes(vote);
 }
 
 bool CGovernanceObjectVoteFile::HasVote(const uint256& nHash) const
 {
+    EnsureLoaded();
     return mapVoteIndex.find(nHash) != mapVoteIndex.end();
 }
 
 bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const
 {
+    EnsureLoaded();
     auto it = mapVoteIndex.find(nHash);
     if (it == mapVoteIndex.end()) {
         return false;
@@ -48,6 +112,7 @@ bool CGovernanceObjectVoteFile::SerializeVoteToStream(const uint256& nHash, CDat
 
 std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 {
+    EnsureLoaded();
     std::vector<CGovernanceVote> vecResult;
     for (auto it = listVotes.begin(); it != listVotes.end(); ++it) {
         vecResult.push_back(*it);
@@ -57,12 +122,11 @@ std::vector<CGovernanceVote> CGovernanceObjectVoteFile::GetVotes() const
 
 void CGovernanceObjectVoteFile::RemoveVotesFromMasternode(const COutPoint& outpointMasternode)
 {
+    EnsureLoaded();
     auto it = listVotes.begin();
     while (it != listVotes.end()) {
         if (it->GetMasternodeOutpoint() == outpointMasternode) {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
+            EraseVote(it++);
         } else {
             ++it;
         }
@@ -73,15 +137,14 @@ std::set<uint256> CGovernanceObjectVoteFile::RemoveInvalidVotes(const COutPoint&
 {
     std::set<uint256> removedVotes;
 
+    EnsureLoaded();
     auto it = listVotes.begin();
     while (it != listVotes.end()) {
         if (it->GetMasternodeOutpoint() == outpointMasternode) {
             bool useVotingKey = fProposal && (it->GetSignal() == VOTE_SIGNAL_FUNDING);
             if (!it->IsValid(useVotingKey)) {
                 removedVotes.emplace(it->GetHash());
-                --nMemoryVotes;
-                mapVoteIndex.erase(it->GetHash());
-                listVotes.erase(it++);
+                EraseVote(it++);
                 continue;
             }
         }
@@ -100,15 +163,24 @@ void CGovernanceObjectVoteFile::RemoveOldVotes(const CGovernanceVote& vote)
             && it->GetSignal() == vote.GetSignal() // same signal (e.g. "funding", "delete", etc.)
             && it->GetTimestamp() < vote.GetTimestamp()) // older than new vote
         {
-            --nMemoryVotes;
-            mapVoteIndex.erase(it->GetHash());
-            listVotes.erase(it++);
+            EraseVote(it++);
         } else {
             ++it;
         }
     }
 }
 
+void CGovernanceObjectVoteFile::EraseVote(vote_l_t::iterator it)
+{
+    if (governanceDb) {
+        governanceDb->EraseVote(*it);
+    }
+    --nMemoryVotes;
+    --nLoadedVotes;
+    mapVoteIndex.erase(it->GetHash());
+    listVotes.erase(it);
+}
+
 void CGovernanceObjectVoteFile::RebuildIndex()
 {
     mapVoteIndex.clear();
@@ -122,6 +194,7 @@ void CGovernanceObjectVoteFile::RebuildIndex()
             ++nMemoryVotes;
             ++it;
         } else {
+            --nLoadedVotes;
             listVotes.erase(it++);
         }
     }
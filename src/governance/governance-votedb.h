@@ -5,6 +5,7 @@
 #ifndef BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 #define BITCOIN_GOVERNANCE_GOVERNANCE_VOTEDB_H
 
+#include <atomic>
 #include <list>
 #include <map>
 
@@ -13,13 +14,15 @@
 #include <streams.h>
 #include <uint256.h>
 
+/** Number of votes kept in memory before CGovernanceManager starts unloading vote files */
+static const size_t MAX_LOADED_GOVERNANCE_VOTES = 100000;
+
 /**
  * Represents the collection of votes associated with a given CGovernanceObject
- * Recently received votes are held in memory until a maximum size is reached after
- * which older votes a flushed to a disk file.
- *
- * Note: This is a stub implementation that doesn't limit the number of votes held
- * in memory and doesn't flush to disk.
+ * Every vote is written to the governance db (if there is one) when it is added. Files
+ * read back from disk only contain the number of votes and load the votes themselves
+ * on first use. CGovernanceManager unloads the least recently used files again once
+ * more than MAX_LOADED_GOVERNANCE_VOTES votes are held in memory.
  */
 class CGovernanceObjectVoteFile
 {
@@ -29,29 +32,44 @@ public: // Types
     typedef std::map<uint256, vote_l_t::iterator> vote_m_t;
 
 private:
-    int nMemoryVotes;
+    /// Number of votes in the file, whether they are loaded or not
+    mutable int nMemoryVotes;
+
+    /// Hash of the object the votes belong to, needed to load them
+    uint256 nParentHash;
+
+    mutable bool fLoaded;
+
+    mutable int64_t nLastUsed;
 
-    vote_l_t listVotes;
+    mutable vote_l_t listVotes;
 
-    vote_m_t mapVoteIndex;
+    mutable vote_m_t mapVoteIndex;
+
+    /// Number of votes held in memory by all vote files
+    static std::atomic<size_t> nLoadedVotes;
 
 public:
     CGovernanceObjectVoteFile();
 
     CGovernanceObjectVoteFile(const CGovernanceObjectVoteFile& other);
 
+    CGovernanceObjectVoteFile& operator=(const CGovernanceObjectVoteFile&) = delete;
+
+    ~CGovernanceObjectVoteFile();
+
     /**
      * Add a vote to the file
      */
     void AddVote(const CGovernanceVote& vote);
 
     /**
-     * Return true if the vote with this hash is currently cached in memory
+     * Return true if the file contains the vote with this hash
      */
     bool HasVote(const uint256& nHash) const;
 
     /**
-     * Retrieve a vote cached in memory
+     * Retrieve a vote from the file
      */
     bool SerializeVoteToStream(const uint256& nHash, CDataStream& ss) const;
 
@@ -65,22 +83,43 @@ public:
     void RemoveVotesFromMasternode(const COutPoint& outpointMasternode);
     std::set<uint256> RemoveInvalidVotes(const COutPoint& outpointMasternode, bool fProposal);
 
+    void SetParentHash(const uint256& nParentHashIn) { nParentHash = nParentHashIn; }
+
+    bool IsLoaded() const { return fLoaded; }
+    int64_t GetLastUsed() const { return nLastUsed; }
+
+    /**
+     * Drop the votes from memory, they are loaded from the governance db again when needed.
+     * Does nothing if there is no governance db.
+     */
+    void Unload() const;
+
+    static size_t GetLoadedVoteCount() { return nLoadedVotes; }
+
     ADD_SERIALIZE_METHODS;
 
+    /** Only the number of votes is serialized, the votes are stored in the governance db */
     template <typename Stream, typename Operation>
     inline void SerializationOp(Stream& s, Operation ser_action)
     {
         READWRITE(nMemoryVotes);
-        READWRITE(listVotes);
         if (ser_action.ForRead()) {
-            RebuildIndex();
+            nLoadedVotes -= listVotes.size();
+            listVotes.clear();
+            mapVoteIndex.clear();
+            fLoaded = false;
         }
     }
 
 private:
+    /// Load the votes from the governance db if that did not happen yet
+    void EnsureLoaded() const;
+
     // Drop older votes for the same gobject from the same masternode
     void RemoveOldVotes(const CGovernanceVote& vote);
 
+    void EraseVote(vote_l_t::iterator it);
+
     void RebuildIndex();
 };
 
@@ -5,6 +5,7 @@
 #include <governance/governance.h>
 #include <consensus/validation.h>
 #include <governance/governance-classes.h>
+#include <governance/governance-db.h>
 #include <governance/governance-validators.h>
 #include <init.h>
 #include <masternode/masternode-meta.h>
@@ -20,7 +21,7 @@ CGovernanceManager governance;
 
 int nSubmittedFinalBudget;
 
-const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-15";
+const std::string CGovernanceManager::SERIALIZATION_VERSION_STRING = "CGovernanceManager-Version-16";
 const int CGovernanceManager::MAX_TIME_FUTURE_DEVIATION = 60 * 60;
 const int CGovernanceManager::RELIABLE_PROPAGATION_TIME = 60;
 
@@ -59,26 +60,53 @@ bool CGovernanceManager::SerializeObjectForHash(const uint256& nHash, CDataStrea
     return true;
 }
 
-bool CGovernanceManager::HaveVoteForHash(const uint256& nHash) const
+bool CGovernanceManager::HaveVoteForHash(const uint256& nHash)
 {
     LOCK(cs);
 
-    CGovernanceObject* pGovobj = nullptr;
-    return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().HasVote(nHash);
+    CGovernanceObject* pGovobj = FindObjectForVote(nHash);
+    return pGovobj && pGovobj->GetVoteFile().HasVote(nHash);
 }
 
 int CGovernanceManager::GetVoteCount() const
 {
     LOCK(cs);
-    return (int)cmapVoteToObject.GetSize();
+
+    int nCount = 0;
+    for (const auto& objPair : mapObjects) {
+        nCount += objPair.second.GetVoteFile().GetVoteCount();
+    }
+    return nCount;
 }
 
-bool CGovernanceManager::SerializeVoteForHash(const uint256& nHash, CDataStream& ss) const
+bool CGovernanceManager::SerializeVoteForHash(const uint256& nHash, CDataStream& ss)
 {
     LOCK(cs);
 
+    CGovernanceObject* pGovobj = FindObjectForVote(nHash);
+    return pGovobj && pGovobj->GetVoteFile().SerializeVoteToStream(nHash, ss);
+}
+
+CGovernanceObject* CGovernanceManager::FindObjectForVote(const uint256& nVoteHash)
+{
+    AssertLockHeld(cs);
+
     CGovernanceObject* pGovobj = nullptr;
-    return cmapVoteToObject.Get(nHash, pGovobj) && pGovobj->GetVoteFile().SerializeVoteToStream(nHash, ss);
+    if (cmapVoteToObject.Get(nVoteHash, pGovobj)) {
+        return pGovobj;
+    }
+
+    uint256 nParentHash;
+    if (!governanceDb || !governanceDb->ReadVoteParent(nVoteHash, nParentHash)) {
+        return nullptr;
+    }
+    auto it = mapObjects.find(nParentHash);
+    if (it == mapObjects.end()) {
+        return nullptr;
+    }
+    pGovobj = &it->second;
+    cmapVoteToObject.Insert(nVoteHash, pGovobj);
+    return pGovobj;
 }
 
 void CGovernanceManager::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman, bool enable_bip61)
@@ -308,6 +336,12 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
         return;
     }
 
+    // Votes for the object are written as they arrive, so it must be found on disk already
+    if (governanceDb) {
+        governanceDb->WriteObject(objpair.first->second);
+        objpair.first->second.ClearDirtyDb();
+    }
+
     // SHOULD WE ADD THIS OBJECT TO ANY OTHER MANAGERS?
 
     LogPrint(BCLog::GOBJECT, "CGovernanceManager::AddGovernanceObject -- Before trigger block, GetDataAsPlainString = %s, nObjectType = %d\n",
@@ -332,7 +366,7 @@ void CGovernanceManager::AddGovernanceObject(CGovernanceObject& govobj, CConnman
     // WE MIGHT HAVE PENDING/ORPHAN VOTES FOR THIS OBJECT
 
     CGovernanceException exception;
-    CheckOrphanVotes(govobj, exception, connman);
+    CheckOrphanVotes(objpair.first->second, exception, connman);
 
     // SEND NOTIFICATION TO SCRIPT/ZMQ
     GetMainSignals().NotifyGovernanceObject(std::make_shared<const CGovernanceObject>(govobj));
@@ -398,6 +432,9 @@ void CGovernanceManager::UpdateCachesAndClean()
             (nTimeSinceDeletion >= GOVERNANCE_DELETION_DELAY)) {
             LogPrintf("CGovernanceManager::UpdateCachesAndClean -- erase obj %s\n", (*it).first.ToString());
             mmetaman.RemoveGovernanceObject(pObj->GetHash());
+            if (governanceDb) {
+                governanceDb->EraseObject(nHash);
+            }
 
             // Remove vote references
             const object_ref_cm_t::list_t& listItems = cmapVoteToObject.GetItemList();
@@ -547,6 +584,12 @@ void CGovernanceManager::DoMaintenance(CConnman& connman)
     // CHECK AND REMOVE - REPROCESS GOVERNANCE OBJECTS
 
     UpdateCachesAndClean();
+
+    {
+        LOCK(cs);
+        UnloadVoteFiles();
+    }
+    FlushToDb();
 }
 
 bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
@@ -568,7 +611,7 @@ bool CGovernanceManager::ConfirmInventoryRequest(const CInv& inv)
         break;
     }
     case MSG_GOVERNANCE_OBJECT_VOTE: {
-        if (cmapVoteToObject.HasKey(inv.hash)) {
+        if (FindObjectForVote(inv.hash)) {
             LogPrint(BCLog::GOBJECT, "CGovernanceManager::ConfirmInventoryRequest already have governance vote, returning false\n");
             return false;
         }
@@ -632,9 +675,7 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
         return;
     }
 
-    auto fileVotes = govobj.GetVoteFile();
-
-    for (const auto& vote : fileVotes.GetVotes()) {
+    for (const auto& vote : govobj.GetVoteFile().GetVotes()) {
         uint256 nVoteHash = vote.GetHash();
 
         bool onlyVotingKeyAllowed = govobj.GetObjectType() == GOVERNANCE_OBJECT_PROPOSAL && vote.GetSignal() == VOTE_SIGNAL_FUNDING;
@@ -646,6 +687,8 @@ void CGovernanceManager::SyncSingleObjVotes(CNode* pnode, const uint256& nProp,
         ++nVoteCount;
     }
 
+    UnloadVoteFiles();
+
     CNetMsgMaker msgMaker(pnode->GetSendVersion());
     connman.PushMessage(pnode, msgMaker.Make(NetMsgType::SYNCSTATUSCOUNT, MASTERNODE_SYNC_GOVOBJ_VOTE, nVoteCount));
     LogPrintf("CGovernanceManager::%s -- sent %d votes to peer=%d\n", __func__, nVoteCount, pnode->GetId());
@@ -796,7 +839,7 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
     uint256 nHashVote = vote.GetHash();
     uint256 nHashGovobj = vote.GetParentHash();
 
-    if (cmapVoteToObject.HasKey(nHashVote)) {
+    if (FindObjectForVote(nHashVote)) {
         LogPrint(BCLog::GOBJECT, "CGovernanceObject::ProcessVote -- skipping known valid vote %s for object %s\n", nHashVote.ToString(), nHashGovobj.ToString());
         LEAVE_CRITICAL_SECTION(cs);
         return false;
@@ -840,6 +883,7 @@ bool CGovernanceManager::ProcessVote(CNode* pfrom, const CGovernanceVote& vote,
     }
 
     bool fOk = govobj.ProcessVote(pfrom, vote, exception, connman) && cmapVoteToObject.Insert(nHashVote, &govobj);
+    UnloadVoteFiles();
     LEAVE_CRITICAL_SECTION(cs);
     return fOk;
 }
@@ -934,6 +978,7 @@ void CGovernanceManager::RequestGovernanceObject(CNode* pfrom, const uint256& nH
             for (const auto& vote : vecVotes) {
                 filter.insert(vote.GetHash());
             }
+            UnloadVoteFiles();
         }
     }
 
@@ -1077,18 +1122,33 @@ bool CGovernanceManager::AcceptMessage(const uint256& nHash, hash_s_t& setHash)
     return true;
 }
 
-void CGovernanceManager::RebuildIndexes()
+void CGovernanceManager::UnloadVoteFiles()
 {
-    LOCK(cs);
+    AssertLockHeld(cs);
 
-    cmapVoteToObject.Clear();
-    for (auto& objPair : mapObjects) {
-        CGovernanceObject& govobj = objPair.second;
-        std::vector<CGovernanceVote> vecVotes = govobj.GetVoteFile().GetVotes();
-        for (size_t i = 0; i < vecVotes.size(); ++i) {
-            cmapVoteToObject.Insert(vecVotes[i].GetHash(), &govobj);
+    if (CGovernanceObjectVoteFile::GetLoadedVoteCount() <= MAX_LOADED_GOVERNANCE_VOTES) {
+        return;
+    }
+
+    std::vector<std::pair<int64_t, const CGovernanceObjectVoteFile*>> vecFiles;
+    for (const auto& objPair : mapObjects) {
+        const CGovernanceObjectVoteFile& fileVotes = objPair.second.GetVoteFile();
+        if (fileVotes.IsLoaded()) {
+            vecFiles.emplace_back(fileVotes.GetLastUsed(), &fileVotes);
         }
     }
+    std::sort(vecFiles.begin(), vecFiles.end());
+
+    // Go a bit below the limit so that this does not run again for every new vote
+    size_t nUnloaded = 0;
+    for (const auto& p : vecFiles) {
+        if (CGovernanceObjectVoteFile::GetLoadedVoteCount() <= MAX_LOADED_GOVERNANCE_VOTES * 3 / 4) {
+            break;
+        }
+        p.second->Unload();
+        nUnloaded++;
+    }
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- unloaded %d vote files, %d votes loaded\n", __func__, nUnloaded, CGovernanceObjectVoteFile::GetLoadedVoteCount());
 }
 
 void CGovernanceManager::AddCachedTriggers()
@@ -1108,14 +1168,55 @@ void CGovernanceManager::AddCachedTriggers()
     }
 }
 
+void CGovernanceManager::LoadFromDb()
+{
+    LOCK(cs);
+
+    if (!governanceDb->CheckVersion(SERIALIZATION_VERSION_STRING)) {
+        Clear();
+        return;
+    }
+
+    governanceDb->ReadManagerState(*this);
+    governanceDb->ForEachObject([this](const uint256& nHash, CGovernanceObject& govobj) {
+        CGovernanceObject& obj = mapObjects.emplace(nHash, govobj).first->second;
+        if (!obj.LoadCurrentMNVotes()) {
+            LogPrintf("CGovernanceManager::LoadFromDb -- failed to load votes of object %s\n", nHash.ToString());
+        }
+        obj.ClearDirtyDb();
+        return true;
+    });
+}
+
+void CGovernanceManager::FlushToDb()
+{
+    if (!governanceDb) {
+        return;
+    }
+
+    LOCK(cs);
+
+    int nWritten = 0;
+    for (auto& objPair : mapObjects) {
+        if (!objPair.second.IsSetDirtyDb()) {
+            continue;
+        }
+        governanceDb->WriteObject(objPair.second);
+        objPair.second.ClearDirtyDb();
+        nWritten++;
+    }
+    governanceDb->WriteManagerState(*this);
+
+    LogPrint(BCLog::GOBJECT, "CGovernanceManager::%s -- wrote %d changed objects\n", __func__, nWritten);
+}
+
 void CGovernanceManager::InitOnLoad()
 {
     LOCK(cs);
     int64_t nStart = GetTimeMillis();
-    LogPrintf("Preparing masternode indexes and governance triggers...\n");
-    RebuildIndexes();
+    LogPrintf("Preparing governance triggers...\n");
     AddCachedTriggers();
-    LogPrintf("Masternode indexes and governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
+    LogPrintf("Governance triggers prepared  %dms\n", GetTimeMillis() - nStart);
     LogPrintf("     %s\n", ToString());
 }
 
@@ -1141,10 +1242,10 @@ std::string CGovernanceManager::ToString() const
         }
     }
 
-    return strprintf("Governance Objects: %d (Proposals: %d, Triggers: %d, Other: %d; Erased: %d), Votes: %d",
+    return strprintf("Governance Objects: %d (Proposals: %d, Triggers: %d, Other: %d; Erased: %d), Votes: %d (loaded: %d)",
         (int)mapObjects.size(),
         nProposalCount, nTriggerCount, nOtherCount, (int)mapErasedGovernanceObjects.size(),
-        (int)cmapVoteToObject.GetSize());
+        GetVoteCount(), (int)CGovernanceObjectVoteFile::GetLoadedVoteCount());
 }
 
 UniValue CGovernanceManager::ToJson() const
@@ -1175,7 +1276,7 @@ UniValue CGovernanceManager::ToJson() const
     jsonObj.pushKV("triggers", nTriggerCount);
     jsonObj.pushKV("other", nOtherCount);
     jsonObj.pushKV("erased", (int)mapErasedGovernanceObjects.size());
-    jsonObj.pushKV("votes", (int)cmapVoteToObject.GetSize());
+    jsonObj.pushKV("votes", GetVoteCount());
     return jsonObj;
 }
 
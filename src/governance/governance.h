@@ -297,10 +297,10 @@ public:
             READWRITE(strVersion);
         }
 
+        // Objects and votes are stored separately, see CGovernanceDB
         READWRITE(mapErasedGovernanceObjects);
         READWRITE(cmapInvalidVotes);
         READWRITE(cmmapOrphanVotes);
-        READWRITE(mapObjects);
         READWRITE(mapLastMasternodeObject);
         READWRITE(lastMNListForVotingKeys);
     }
@@ -314,13 +314,13 @@ public:
     // Accessors for thread-safe access to maps
     bool HaveObjectForHash(const uint256& nHash) const;
 
-    bool HaveVoteForHash(const uint256& nHash) const;
+    bool HaveVoteForHash(const uint256& nHash);
 
     int GetVoteCount() const;
 
     bool SerializeObjectForHash(const uint256& nHash, CDataStream& ss) const;
 
-    bool SerializeVoteForHash(const uint256& nHash, CDataStream& ss) const;
+    bool SerializeVoteForHash(const uint256& nHash, CDataStream& ss);
 
     void AddPostponedObject(const CGovernanceObject& govobj)
     {
@@ -351,6 +351,11 @@ public:
         return fRateChecksEnabled;
     }
 
+    /** Read the manager state and all objects from the governance db */
+    void LoadFromDb();
+    /** Write changed objects and the manager state to the governance db */
+    void FlushToDb();
+
     void InitOnLoad();
 
     int RequestGovernanceObjectVotes(CNode* pnode, CConnman& connman);
@@ -376,7 +381,11 @@ private:
 
     void CheckOrphanVotes(CGovernanceObject& govobj, CGovernanceException& exception, CConnman& connman);
 
-    void RebuildIndexes();
+    /// Find the object a known vote belongs to, cmapVoteToObject caches the governance db index
+    CGovernanceObject* FindObjectForVote(const uint256& nVoteHash);
+
+    /// Drop the least recently used vote files from memory once too many votes are loaded
+    void UnloadVoteFiles();
 
     void AddCachedTriggers();
 
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <httpserver.h>
 #include <key_io.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
 #include <random.h>
@@ -65,6 +66,8 @@ private:
 static std::string strRPCUserColonPass;
 /* Stored RPC timer interface (for unregistration) */
 static std::unique_ptr<HTTPRPCTimerInterface> httpRPCTimerInterface;
+/* Number of elements of a JSON-RPC batch which are executed at the same time */
+static int nBatchParallel = DEFAULT_HTTP_BATCH_PARALLEL;
 
 static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const UniValue& id)
 {
@@ -82,6 +85,8 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
 
     std::string strReply = JSONRPCReply(NullUniValue, objError, id);
 
+    // Drop what was already written of a streamed result
+    req->ClearReplyBody();
     req->WriteHeader("Content-Type", "application/json");
     req->WriteReply(nStatus, strReply);
 }
@@ -191,14 +196,31 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
 
+            // Handlers of large results may write them straight into the reply body,
+            // which then gets wrapped the same way JSONRPCReply would wrap the result
+            bool fStreamStarted = false;
+            CJSONStreamWriter stream([req, &fStreamStarted](const std::string& data) {
+                if (!fStreamStarted) {
+                    req->AppendReplyBody("{\"result\":");
+                    fStreamStarted = true;
+                }
+                req->AppendReplyBody(data);
+            });
+            jreq.stream = &stream;
+
             UniValue result = tableRPC.execute(jreq);
 
             // Send reply
-            strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            if (stream.IsComplete()) {
+                strReply = ",\"error\":null,\"id\":" + jreq.id.write() + "}\n";
+            } else {
+                strReply = JSONRPCReply(result, NullUniValue, jreq.id);
+            }
+            jreq.stream = nullptr;
 
         // array of requests
         } else if (valRequest.isArray())
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), HTTPEnqueueWork, nBatchParallel);
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
@@ -242,6 +264,8 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
+    nBatchParallel = std::max((int)gArgs.GetArg("-rpcbatchparallel", DEFAULT_HTTP_BATCH_PARALLEL), 1);
+
     RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
 #ifdef ENABLE_WALLET
     // ifdef can be removed once we switch to better endpoint support and API versioning
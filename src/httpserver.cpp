@@ -29,6 +29,7 @@
 #include <event2/bufferevent.h>
 #include <event2/util.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 
 #include <support/events.h>
 
@@ -45,6 +46,22 @@
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
+/** Maximum number of bytes of a chunked reply queued for sending */
+static const size_t MAX_CHUNKED_REPLY_IN_FLIGHT = 4 * 1024 * 1024;
+
+/** Work item running an arbitrary function, see HTTPEnqueueWork */
+class HTTPWorkFunction final : public HTTPClosure
+{
+public:
+    explicit HTTPWorkFunction(std::function<void()> _func) : func(std::move(_func)) {}
+    void operator()() override
+    {
+        func();
+    }
+
+private:
+    std::function<void()> func;
+};
 
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure
@@ -139,20 +156,28 @@ struct HTTPPathHandler
     HTTPRequestHandler handler;
 };
 
+/** libevent event loop with its own HTTP server and listening sockets */
+struct HTTPEventLoop
+{
+    struct event_base* base{nullptr};
+    struct evhttp* http{nullptr};
+    //! Bound listening sockets
+    std::vector<evhttp_bound_socket*> boundSockets;
+    std::thread thread;
+};
+
 /** HTTP module state */
 
-//! libevent event loop
-static struct event_base* eventBase = nullptr;
-//! HTTP server
-struct evhttp* eventHTTP = nullptr;
+//! Event loops accepting and parsing requests. The first one is returned by EventBase(). When
+//! there are several, they all listen on the same addresses with SO_REUSEPORT and the kernel
+//! spreads the connections over them.
+static std::vector<std::unique_ptr<HTTPEventLoop>> eventLoops;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
 //! Work queue for handling longer requests off the event loop thread
 static WorkQueue<HTTPClosure>* workQueue = nullptr;
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
-//! Bound listening sockets
-std::vector<evhttp_bound_socket *> boundSockets;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr& netaddr)
@@ -284,7 +309,7 @@ static void http_reject_request_cb(struct evhttp_request* req, void*)
 }
 
 /** Event dispatcher thread */
-static bool ThreadHTTP(struct event_base* base, struct evhttp* http)
+static bool ThreadHTTP(struct event_base* base)
 {
     RenameThread("dash-http");
     LogPrint(BCLog::HTTP, "Entering http event loop\n");
@@ -294,8 +319,32 @@ static bool ThreadHTTP(struct event_base* base, struct evhttp* http)
     return event_base_got_break(base) == 0;
 }
 
-/** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp* http)
+/** Bind a listening socket which shares its address with the sockets of the other event loops */
+static evhttp_bound_socket* HTTPBindReusePort(HTTPEventLoop& loop, const std::string& host, uint16_t port)
+{
+#ifdef LEV_OPT_REUSEABLE_PORT
+    CService addrBind;
+    if (!Lookup(host.empty() ? "0.0.0.0" : host.c_str(), addrBind, port, false)) {
+        return nullptr;
+    }
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!addrBind.GetSockAddr((struct sockaddr*)&sockaddr, &len)) {
+        return nullptr;
+    }
+    const unsigned int flags = LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC | LEV_OPT_REUSEABLE | LEV_OPT_REUSEABLE_PORT;
+    struct evconnlistener* listener = evconnlistener_new_bind(loop.base, nullptr, nullptr, flags, -1, (struct sockaddr*)&sockaddr, len);
+    if (!listener) {
+        return nullptr;
+    }
+    return evhttp_bind_listener(loop.http, listener);
+#else
+    return nullptr;
+#endif
+}
+
+/** Bind HTTP server to specified addresses, warnings are only logged for the first event loop */
+static bool HTTPBindAddresses(HTTPEventLoop& loop, bool fReusePort, bool fLogWarnings)
 {
     int defaultPort = gArgs.GetArg("-rpcport", BaseParams().RPCPort());
     std::vector<std::pair<std::string, uint16_t> > endpoints;
@@ -304,10 +353,10 @@ static bool HTTPBindAddresses(struct evhttp* http)
     if (!(gArgs.IsArgSet("-rpcallowip") && gArgs.IsArgSet("-rpcbind"))) { // Default to loopback if not allowing external IPs
         endpoints.push_back(std::make_pair("::1", defaultPort));
         endpoints.push_back(std::make_pair("127.0.0.1", defaultPort));
-        if (gArgs.IsArgSet("-rpcallowip")) {
+        if (gArgs.IsArgSet("-rpcallowip") && fLogWarnings) {
             LogPrintf("WARNING: option -rpcallowip was specified without -rpcbind; this doesn't usually make sense\n");
         }
-        if (gArgs.IsArgSet("-rpcbind")) {
+        if (gArgs.IsArgSet("-rpcbind") && fLogWarnings) {
             LogPrintf("WARNING: option -rpcbind was ignored because -rpcallowip was not specified, refusing to allow everyone to connect\n");
         }
     } else if (gArgs.IsArgSet("-rpcbind")) { // Specific bind address
@@ -322,18 +371,23 @@ static bool HTTPBindAddresses(struct evhttp* http)
     // Bind addresses
     for (std::vector<std::pair<std::string, uint16_t> >::iterator i = endpoints.begin(); i != endpoints.end(); ++i) {
         LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", i->first, i->second);
-        evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+        evhttp_bound_socket *bind_handle;
+        if (fReusePort) {
+            bind_handle = HTTPBindReusePort(loop, i->first, i->second);
+        } else {
+            bind_handle = evhttp_bind_socket_with_handle(loop.http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
+        }
         if (bind_handle) {
             CNetAddr addr;
-            if (i->first.empty() || (LookupHost(i->first.c_str(), addr, false) && addr.IsBindAny())) {
+            if (fLogWarnings && (i->first.empty() || (LookupHost(i->first.c_str(), addr, false) && addr.IsBindAny()))) {
                 LogPrintf("WARNING: the RPC server is not safe to expose to untrusted networks such as the public internet\n");
             }
-            boundSockets.push_back(bind_handle);
+            loop.boundSockets.push_back(bind_handle);
         } else {
             LogPrintf("Binding RPC on address %s port %i failed.\n", i->first, i->second);
         }
     }
-    return !boundSockets.empty();
+    return !loop.boundSockets.empty();
 }
 
 /** Simple wrapper to set thread name and run work queue */
@@ -384,24 +438,55 @@ bool InitHTTPServer()
     evthread_use_pthreads();
 #endif
 
-    raii_event_base base_ctr = obtain_event_base();
-
-    /* Create a new evhttp object to handle requests. */
-    raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
-    struct evhttp* http = http_ctr.get();
-    if (!http) {
-        LogPrintf("couldn't create evhttp. Exiting.\n");
-        return false;
+    int nEventLoops = std::max((long)gArgs.GetArg("-rpceventthreads", DEFAULT_HTTP_EVENT_THREADS), 1L);
+#ifndef LEV_OPT_REUSEABLE_PORT
+    if (nEventLoops > 1) {
+        LogPrintf("WARNING: -rpceventthreads needs libevent 2.1.1 or newer, using a single event loop\n");
+        nEventLoops = 1;
     }
+#endif
+    const bool fReusePort = nEventLoops > 1;
 
-    evhttp_set_timeout(http, gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, MAX_SIZE);
-    evhttp_set_gencb(http, http_request_cb, nullptr);
+    for (int i = 0; i < nEventLoops; i++) {
+        raii_event_base base_ctr = obtain_event_base();
 
-    if (!HTTPBindAddresses(http)) {
-        LogPrintf("Unable to bind any endpoint for RPC server\n");
-        return false;
+        /* Create a new evhttp object to handle requests. */
+        raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
+        struct evhttp* http = http_ctr.get();
+        if (!http) {
+            LogPrintf("couldn't create evhttp. Exiting.\n");
+            return false;
+        }
+
+        evhttp_set_timeout(http, gArgs.GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(http, MAX_SIZE);
+        evhttp_set_gencb(http, http_request_cb, nullptr);
+
+        std::unique_ptr<HTTPEventLoop> loop(new HTTPEventLoop());
+        // transfer ownership to the event loop via .release()
+        loop->base = base_ctr.release();
+        loop->http = http_ctr.release();
+
+        bool fBound = HTTPBindAddresses(*loop, fReusePort, i == 0);
+        if (fBound && i > 0 && loop->boundSockets.size() < eventLoops[0]->boundSockets.size()) {
+            // The platform does not allow sharing the addresses, the loops created so far have to do
+            fBound = false;
+        }
+        if (!fBound) {
+            for (evhttp_bound_socket* socket : loop->boundSockets) {
+                evhttp_del_accept_socket(loop->http, socket);
+            }
+            evhttp_free(loop->http);
+            event_base_free(loop->base);
+            if (i == 0) {
+                LogPrintf("Unable to bind any endpoint for RPC server\n");
+                return false;
+            }
+            LogPrintf("WARNING: could not share the RPC endpoints between event loops, using %d of them\n", i);
+            break;
+        }
+        eventLoops.emplace_back(std::move(loop));
     }
 
     LogPrint(BCLog::HTTP, "Initialized HTTP server\n");
@@ -409,9 +494,6 @@ bool InitHTTPServer()
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
     workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
-    // transfer ownership to eventBase/HTTP via .release()
-    eventBase = base_ctr.release();
-    eventHTTP = http_ctr.release();
     return true;
 }
 
@@ -429,15 +511,16 @@ bool UpdateHTTPServerLogging(bool enable) {
 #endif
 }
 
-std::thread threadHTTP;
 static std::vector<std::thread> g_thread_http_workers;
 
 bool StartHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
     int rpcThreads = std::max((long)gArgs.GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
-    threadHTTP = std::thread(ThreadHTTP, eventBase, eventHTTP);
+    LogPrintf("HTTP: starting %d event loops and %d worker threads\n", eventLoops.size(), rpcThreads);
+    for (auto& loop : eventLoops) {
+        loop->thread = std::thread(ThreadHTTP, loop->base);
+    }
 
     for (int i = 0; i < rpcThreads; i++) {
         g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue);
@@ -448,9 +531,9 @@ bool StartHTTPServer()
 void InterruptHTTPServer()
 {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP) {
+    for (auto& loop : eventLoops) {
         // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
+        evhttp_set_gencb(loop->http, http_reject_request_cb, nullptr);
     }
     if (workQueue)
         workQueue->Interrupt();
@@ -468,30 +551,42 @@ void StopHTTPServer()
         delete workQueue;
         workQueue = nullptr;
     }
-    // Unlisten sockets, these are what make the event loop running, which means
-    // that after this and all connections are closed the event loop will quit.
-    for (evhttp_bound_socket *socket : boundSockets) {
-        evhttp_del_accept_socket(eventHTTP, socket);
-    }
-    boundSockets.clear();
-    if (eventBase) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
-        threadHTTP.join();
-    }
-    if (eventHTTP) {
-        evhttp_free(eventHTTP);
-        eventHTTP = nullptr;
+    // Unlisten sockets, these are what make the event loops running, which means
+    // that after this and all connections are closed the event loops will quit.
+    for (auto& loop : eventLoops) {
+        for (evhttp_bound_socket *socket : loop->boundSockets) {
+            evhttp_del_accept_socket(loop->http, socket);
+        }
+        loop->boundSockets.clear();
     }
-    if (eventBase) {
-        event_base_free(eventBase);
-        eventBase = nullptr;
+    LogPrint(BCLog::HTTP, "Waiting for HTTP event threads to exit\n");
+    for (auto& loop : eventLoops) {
+        if (loop->thread.joinable()) {
+            loop->thread.join();
+        }
+        evhttp_free(loop->http);
+        event_base_free(loop->base);
     }
+    eventLoops.clear();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
 struct event_base* EventBase()
 {
-    return eventBase;
+    return eventLoops.empty() ? nullptr : eventLoops[0]->base;
+}
+
+bool HTTPEnqueueWork(std::function<void()> func)
+{
+    if (!workQueue) {
+        return false;
+    }
+    std::unique_ptr<HTTPWorkFunction> item(new HTTPWorkFunction(std::move(func)));
+    if (!workQueue->Enqueue(item.get())) {
+        return false;
+    }
+    item.release(); /* queue took ownership */
+    return true;
 }
 
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
@@ -523,10 +618,18 @@ void HTTPEvent::trigger(struct timeval* tv)
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
                                                        replySent(false)
 {
+    // The reply has to be sent from the event loop which owns the connection
+    evhttp_connection* conn = evhttp_request_get_connection(req);
+    base = conn ? evhttp_connection_get_base(conn) : EventBase();
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && chunked) {
+        // A chunked reply can't be turned into an error reply anymore, and ending it
+        // normally would make a partial reply look complete
+        LogPrintf("%s: Unfinished chunked reply, closing connection\n", __func__);
+        AbortChunkedReply();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -572,6 +675,36 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+void HTTPRequest::AppendReplyBody(const std::string& data)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, data.data(), data.size());
+}
+
+void HTTPRequest::ClearReplyBody()
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_drain(evb, evbuffer_get_length(evb));
+}
+
+/** Re-enable reading from the socket. This is the second part of the libevent workaround in http_request_cb. */
+static void HTTPReenableReading(struct evhttp_request* req)
+{
+    if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+        evhttp_connection* conn = evhttp_request_get_connection(req);
+        if (conn) {
+            bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /** Closure sent to main thread to request a reply to be sent to
  * a HTTP request.
  * Replies must be sent in the main loop in the main http thread,
@@ -579,7 +712,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && req && !chunked);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -588,19 +721,145 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     assert(evb);
     evbuffer_add(evb, strReply.data(), strReply.size());
     auto req_copy = req;
-    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus]{
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, nStatus]{
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the libevent
-        // workaround above.
-        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
-            evhttp_connection* conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
+        HTTPReenableReading(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+/** Progress of a chunked reply, shared between the worker writing it and the event loop sending it. */
+struct HTTPChunkedReplyState
+{
+    CWaitableCriticalSection cs;
+    CConditionVariable cond;
+    //! Bytes handed to the event loop which were not yet written to the socket
+    size_t nBytesInFlight{0};
+    //! Event loop only: bytes given to evhttp since its output buffer was last drained
+    size_t nBytesUndrained{0};
+    //! Set by the event loop when the connection went away
+    bool fClosed{false};
+};
+
+static void http_chunked_reply_closed_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPChunkedReplyState* state = static_cast<HTTPChunkedReplyState*>(arg);
+    WaitableLock lock(state->cs);
+    state->fClosed = true;
+    state->cond.notify_all();
+}
+
+static void http_chunked_reply_drained_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPChunkedReplyState* state = static_cast<HTTPChunkedReplyState*>(arg);
+    WaitableLock lock(state->cs);
+    state->nBytesInFlight -= state->nBytesUndrained;
+    state->nBytesUndrained = 0;
+    state->cond.notify_all();
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && req && !chunked);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    chunked = std::make_shared<HTTPChunkedReplyState>();
+    auto req_copy = req;
+    auto state = chunked;
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, nStatus, state]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            WaitableLock lock(state->cs);
+            state->fClosed = true;
+            state->cond.notify_all();
+            return;
+        }
+        evhttp_connection_set_closecb(conn, http_chunked_reply_closed_cb, state.get());
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& data)
+{
+    assert(!replySent && req && chunked);
+    if (data.empty()) {
+        return true;
+    }
+    {
+        // Don't queue up more than a few chunks for clients which read slower than we write
+        WaitableLock lock(chunked->cs);
+        while (!chunked->fClosed && chunked->nBytesInFlight >= MAX_CHUNKED_REPLY_IN_FLIGHT) {
+            if (ShutdownRequested()) {
+                return false;
             }
+            chunked->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if (chunked->fClosed) {
+            return false;
+        }
+        chunked->nBytesInFlight += data.size();
+    }
+    auto req_copy = req;
+    auto state = chunked;
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, state, data]{
+        struct evbuffer* evb = evbuffer_new();
+        evbuffer_add(evb, data.data(), data.size());
+        // Sending to a closed connection is a no-op, the request stays alive until the reply is ended
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+        state->nBytesUndrained += data.size();
+        evhttp_send_reply_chunk_with_cb(req_copy, evb, http_chunked_reply_drained_cb, state.get());
+#else
+        evhttp_send_reply_chunk(req_copy, evb);
+        {
+            WaitableLock lock(state->cs);
+            state->nBytesInFlight -= data.size();
+            state->cond.notify_all();
+        }
+#endif
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+    return true;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(!replySent && req && chunked);
+    auto req_copy = req;
+    auto state = chunked;
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, state]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, nullptr, nullptr);
+        }
+        HTTPReenableReading(req_copy);
+        // Also frees the request if the connection was closed in the meantime
+        evhttp_send_reply_end(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
+void HTTPRequest::AbortChunkedReply()
+{
+    assert(!replySent && req && chunked);
+    auto req_copy = req;
+    auto state = chunked;
+    HTTPEvent* ev = new HTTPEvent(base, true, [req_copy, state]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (!conn) {
+            // The connection is gone already, this only frees the request
+            evhttp_send_reply_end(req_copy);
+            return;
         }
+        evhttp_connection_set_closecb(conn, nullptr, nullptr);
+        // Also frees the request. The client never receives the terminating chunk.
+        evhttp_connection_free(conn);
     });
     ev->trigger(nullptr);
     replySent = true;
@@ -8,15 +8,19 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+static const int DEFAULT_HTTP_EVENT_THREADS=1;
+static const int DEFAULT_HTTP_BATCH_PARALLEL=4;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPChunkedReplyState;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -51,6 +55,11 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** Run func on one of the HTTP worker threads.
+ * Returns false if the work queue is full or the HTTP server is not running.
+ */
+bool HTTPEnqueueWork(std::function<void()> func);
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -58,7 +67,11 @@ class HTTPRequest
 {
 private:
     struct evhttp_request* req;
+    //! Event loop of the connection the request came in on
+    struct event_base* base;
     bool replySent;
+    //! Set once a chunked reply was started
+    std::shared_ptr<HTTPChunkedReplyState> chunked;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req);
@@ -105,6 +118,15 @@ public:
      */
     void WriteHeader(const std::string& hdr, const std::string& value);
 
+    /**
+     * Append data to the reply body while the reply is still being generated.
+     * It is sent ahead of the body passed to WriteReply.
+     */
+    void AppendReplyBody(const std::string& data);
+
+    /** Discard all data appended with AppendReplyBody. */
+    void ClearReplyBody();
+
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
@@ -114,6 +136,41 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply whose body is sent in pieces, using chunked transfer encoding
+     * for HTTP/1.1 clients. Use this instead of WriteReply for bodies which are too
+     * large to be generated in memory at once.
+     *
+     * @note Write output headers before calling this.
+     */
+    void StartChunkedReply(int nStatus);
+
+    /**
+     * Send the next piece of a chunked reply. Blocks while the client is too far
+     * behind in reading the reply.
+     *
+     * @return false if the client went away, further data is discarded then.
+     */
+    bool WriteReplyChunk(const std::string& data);
+
+    /**
+     * Finish a chunked reply.
+     *
+     * @note As this will give the request back to the main thread, do not call
+     * any other HTTPRequest methods after calling this.
+     */
+    void EndChunkedReply();
+
+    /**
+     * Abort a chunked reply by closing the connection without sending the final
+     * chunk, so the client sees the reply as failed rather than as complete.
+     * Use this when an error occurs after the reply was started.
+     *
+     * @note As this will give the request back to the main thread, do not call
+     * any other HTTPRequest methods after calling this.
+     */
+    void AbortChunkedReply();
 };
 
 /** Event handler closure.
@@ -0,0 +1,353 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chainparams.h>
+#include <hash.h>
+#include <script/script.h>
+#include <undo.h>
+#include <util.h>
+#include <utilmemory.h>
+#include <validation.h>
+
+#include <set>
+
+#include <boost/thread.hpp>
+
+constexpr char DB_ADDRESSINDEX = 'a';
+constexpr char DB_ADDRESSUNSPENTINDEX = 'u';
+constexpr char DB_ADDRESSBALANCE = 'b';
+// 'B' holds the best block locator of BaseIndex
+constexpr char DB_ADDRESSBALANCE_BUILT = 'A';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+int GetAddressIndexType(const CScript& script, uint160& hash_bytes)
+{
+    if (script.IsPayToScriptHash()) {
+        hash_bytes = uint160(std::vector<unsigned char>(script.begin() + 2, script.begin() + 22));
+        return 2;
+    }
+    if (script.IsPayToPublicKeyHash()) {
+        hash_bytes = uint160(std::vector<unsigned char>(script.begin() + 3, script.begin() + 23));
+        return 1;
+    }
+    if (script.IsPayToPublicKey()) {
+        hash_bytes = Hash160(script.begin() + 1, script.end() - 1);
+        return 1;
+    }
+    hash_bytes.SetNull();
+    return 0;
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe))
+{}
+
+/**
+ * Add the entries of a block to the batch, or remove them again if undo is set. Transactions are
+ * visited in reverse order when undoing so that outputs created and spent within the same block
+ * end up erased from the unspent index in both directions. The balance changes are accumulated
+ * in balance_deltas, negated if undo is set.
+ */
+bool AddressIndex::ApplyBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo,
+                              const CBlockIndex* pindex, bool undo, BalanceDeltas& balance_deltas) const
+{
+    const int sign = undo ? -1 : 1;
+
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block %s and its undo data do not match", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        const size_t i = undo ? block.vtx.size() - 1 - n : n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+        std::set<std::pair<unsigned int, uint160> > touched;
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+            if (txundo.vprevout.size() != tx.vin.size()) {
+                return error("%s: transaction %s and its undo data do not match", __func__, txhash.ToString());
+            }
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const CTxIn& input = tx.vin[j];
+                const Coin& coin = txundo.vprevout[j];
+                uint160 hashBytes;
+                int addressType = GetAddressIndexType(coin.out.scriptPubKey, hashBytes);
+                if (addressType == 0) {
+                    continue;
+                }
+
+                const CAddressIndexKey key(addressType, hashBytes, pindex->nHeight, i, txhash, j, true);
+                const CAddressUnspentKey unspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n);
+                if (undo) {
+                    batch.Erase(std::make_pair(DB_ADDRESSINDEX, key));
+                    batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey),
+                                CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight));
+                } else {
+                    // record spending activity and remove the output from the unspent index
+                    batch.Write(std::make_pair(DB_ADDRESSINDEX, key), coin.out.nValue * -1);
+                    batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey));
+                }
+                balance_deltas[std::make_pair(addressType, hashBytes)].balance -= sign * coin.out.nValue;
+                touched.emplace(addressType, hashBytes);
+            }
+        }
+
+        for (size_t k = 0; k < tx.vout.size(); k++) {
+            const CTxOut& out = tx.vout[k];
+            uint160 hashBytes;
+            int addressType = GetAddressIndexType(out.scriptPubKey, hashBytes);
+            if (addressType == 0) {
+                continue;
+            }
+
+            const CAddressIndexKey key(addressType, hashBytes, pindex->nHeight, i, txhash, k, false);
+            const CAddressUnspentKey unspentKey(addressType, hashBytes, txhash, k);
+            if (undo) {
+                batch.Erase(std::make_pair(DB_ADDRESSINDEX, key));
+                batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey));
+            } else {
+                // record receiving activity and the new unspent output
+                batch.Write(std::make_pair(DB_ADDRESSINDEX, key), out.nValue);
+                batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey),
+                            CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight));
+            }
+            CAddressBalanceValue& balance = balance_deltas[std::make_pair(addressType, hashBytes)];
+            balance.balance += sign * out.nValue;
+            balance.received += sign * out.nValue;
+            touched.emplace(addressType, hashBytes);
+        }
+
+        for (const auto& address : touched) {
+            balance_deltas[address].txCount += sign;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::WriteBalances(CDBBatch& batch, const BalanceDeltas& balance_deltas) const
+{
+    for (const auto& p : balance_deltas) {
+        const auto key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(p.first.first, p.first.second));
+        CAddressBalanceValue balance;
+        if (!m_db->Read(key, balance) && m_db->Exists(key)) {
+            return error("%s: Cannot read balance of address %s", __func__, p.first.second.ToString());
+        }
+        balance += p.second;
+        if (balance.IsNull()) {
+            batch.Erase(key);
+        } else {
+            batch.Write(key, balance);
+        }
+    }
+    return true;
+}
+
+bool AddressIndex::BuildBalances()
+{
+    LogPrintf("%s: Building address balances from the existing %s entries\n", __func__, GetName());
+
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey()));
+
+    CDBBatch batch(*m_db);
+    std::pair<unsigned int, uint160> address;
+    CAddressBalanceValue balance;
+    uint256 prevTxHash;
+    size_t nAddresses = 0;
+
+    // Deltas are ordered by address and then by position in the chain, so all deltas of an
+    // address and of one of its transactions are next to each other.
+    while (pcursor->Valid()) {
+        std::pair<char, CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX) {
+            break;
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue)) {
+            return error("%s: failed to get address index value", __func__);
+        }
+
+        const auto keyAddress = std::make_pair(key.second.type, key.second.hashBytes);
+        if (keyAddress != address) {
+            if (!balance.IsNull()) {
+                batch.Write(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second)), balance);
+                nAddresses++;
+            }
+            address = keyAddress;
+            balance.SetNull();
+            prevTxHash.SetNull();
+        }
+        balance.balance += nValue;
+        if (nValue > 0) {
+            balance.received += nValue;
+        }
+        if (key.second.txhash != prevTxHash) {
+            balance.txCount++;
+            prevTxHash = key.second.txhash;
+        }
+
+        if (batch.SizeEstimate() > 16 * 1024 * 1024) {
+            if (!m_db->WriteBatch(batch)) {
+                return false;
+            }
+            batch.Clear();
+        }
+        pcursor->Next();
+    }
+    if (!balance.IsNull()) {
+        batch.Write(std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(address.first, address.second)), balance);
+        nAddresses++;
+    }
+    batch.Write(DB_ADDRESSBALANCE_BUILT, true);
+
+    LogPrintf("%s: Built balances of %d addresses\n", __func__, nAddresses);
+    return m_db->WriteBatch(batch, true);
+}
+
+bool AddressIndex::Init()
+{
+    if (!m_db->Exists(DB_ADDRESSBALANCE_BUILT) && !BuildBalances()) {
+        return error("%s: Cannot build the balances of %s", __func__, GetName());
+    }
+    return BaseIndex::Init();
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block is never connected, so its outputs are not indexed either.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    BalanceDeltas balance_deltas;
+    if (!ApplyBlock(batch, block, blockundo, pindex, false, balance_deltas) ||
+        !WriteBalances(batch, balance_deltas)) {
+        return false;
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+
+    CDBBatch batch(*m_db);
+    BalanceDeltas balance_deltas;
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo blockundo;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!UndoReadFromDisk(blockundo, pindex)) {
+            return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (!ApplyBlock(batch, block, blockundo, pindex, true, balance_deltas)) {
+            return false;
+        }
+    }
+    if (!WriteBalances(batch, balance_deltas)) return false;
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+/** Whether two deltas are at the same position in the chain, regardless of their address */
+static bool IsSamePosition(const CAddressIndexKey& a, const CAddressIndexKey& b)
+{
+    return a.blockHeight == b.blockHeight && a.txindex == b.txindex && a.txhash == b.txhash &&
+           a.index == b.index && a.spending == b.spending;
+}
+
+bool AddressIndex::ReadAddressIndex(uint160 addressHash, int type,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                    int start, int end, size_t limit, const CAddressIndexKey* after) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    if (after && (start <= 0 || end <= 0 || after->blockHeight >= start)) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(type, addressHash, after->blockHeight, after->txindex,
+                                                                       after->txhash, after->index, after->spending)));
+    } else if (start > 0 && end > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    size_t nRead = 0;
+    while (pcursor->Valid() && (limit == 0 || nRead < limit)) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            if (after && IsSamePosition(key.second, *after)) {
+                pcursor->Next();
+                continue;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second, nValue));
+                nRead++;
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressBalance(uint160 addressHash, int type, CAddressBalanceValue& balance) const
+{
+    const auto key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash));
+    if (!m_db->Read(key, balance)) {
+        if (m_db->Exists(key)) {
+            return error("failed to get address balance value");
+        }
+        balance.SetNull();
+    }
+    return true;
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(uint160 addressHash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,83 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_ADDRESSINDEX_H
+#define BITCOIN_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <index/base.h>
+#include <spentindex.h>
+
+#include <map>
+
+class CScript;
+class CBlockUndo;
+
+/**
+ * Classify a scriptPubKey for the address and spent indexes. Returns the address type
+ * (1 for P2PKH/P2PK, 2 for P2SH) and fills hash_bytes, or returns 0 for scripts that are
+ * not indexed.
+ */
+int GetAddressIndexType(const CScript& script, uint160& hash_bytes);
+
+/**
+ * AddressIndex records every credit and debit of P2PKH, P2PK and P2SH outputs per address
+ * (the "deltas") together with the set of outputs currently unspent for each address and a
+ * running balance aggregate per address. All of them live in the same database so they are
+ * always committed atomically.
+ */
+class AddressIndex final : public BaseIndex
+{
+private:
+    /// Changes of the balance aggregates, keyed by address type and hash
+    typedef std::map<std::pair<unsigned int, uint160>, CAddressBalanceValue> BalanceDeltas;
+
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+    bool ApplyBlock(CDBBatch& batch, const CBlock& block, const CBlockUndo& blockundo,
+                    const CBlockIndex* pindex, bool undo, BalanceDeltas& balance_deltas) const;
+
+    /// Add the accumulated balance changes to the stored aggregates.
+    bool WriteBalances(CDBBatch& batch, const BalanceDeltas& balance_deltas) const;
+
+    /// Compute the balance aggregates of an index which was created before they existed.
+    bool BuildBalances();
+
+protected:
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /**
+     * Read the deltas of an address in chain order, optionally restricted to the block height
+     * range [start, end]. If after is given, only deltas ordered after its position in the chain
+     * (its type and hash are ignored) are read. At most limit deltas are read unless it is 0.
+     */
+    bool ReadAddressIndex(uint160 addressHash, int type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                          int start = 0, int end = 0, size_t limit = 0,
+                          const CAddressIndexKey* after = nullptr) const;
+
+    /// Read the balance aggregate of an address. Addresses which were never used have a null aggregate.
+    bool ReadAddressBalance(uint160 addressHash, int type, CAddressBalanceValue& balance) const;
+
+    /// Read the outputs currently unspent for an address.
+    bool ReadAddressUnspentIndex(uint160 addressHash, int type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >& unspentOutputs) const;
+};
+
+/// The global address index, used in GetAddressIndex and GetAddressUnspent. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // BITCOIN_INDEX_ADDRESSINDEX_H
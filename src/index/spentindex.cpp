@@ -0,0 +1,86 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/spentindex.h>
+
+#include <chainparams.h>
+#include <index/addressindex.h>
+#include <undo.h>
+#include <util.h>
+#include <utilmemory.h>
+#include <validation.h>
+
+constexpr char DB_SPENTINDEX = 'p';
+
+std::unique_ptr<SpentIndex> g_spentindex;
+
+SpentIndex::SpentIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "spentindex", n_cache_size, f_memory, f_wipe))
+{}
+
+bool SpentIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // The genesis block is never connected and has nothing to spend.
+    if (pindex->nHeight == 0) return true;
+
+    CBlockUndo blockundo;
+    if (!UndoReadFromDisk(blockundo, pindex)) {
+        return error("%s: Failed to read undo data for block %s", __func__, pindex->GetBlockHash().ToString());
+    }
+    if (blockundo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block %s and its undo data do not match", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    CDBBatch batch(*m_db);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        const CTransaction& tx = *block.vtx[i];
+        const CTxUndo& txundo = blockundo.vtxundo[i - 1];
+        if (txundo.vprevout.size() != tx.vin.size()) {
+            return error("%s: transaction %s and its undo data do not match", __func__, tx.GetHash().ToString());
+        }
+        for (size_t j = 0; j < tx.vin.size(); j++) {
+            const CTxIn& input = tx.vin[j];
+            const CTxOut& prevout = txundo.vprevout[j].out;
+            uint160 hashBytes;
+            int addressType = GetAddressIndexType(prevout.scriptPubKey, hashBytes);
+
+            // add the spent index to determine the txid and input that spent an output
+            // and to find the amount and address from an input
+            batch.Write(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(input.prevout.hash, input.prevout.n)),
+                        CSpentIndexValue(tx.GetHash(), j, pindex->nHeight, prevout.nValue, addressType, hashBytes));
+        }
+    }
+    return m_db->WriteBatch(batch);
+}
+
+bool SpentIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+
+    // Only the spending side is recorded, so the inputs of the disconnected blocks are all we
+    // need; no undo data is required to unwind them.
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: Failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        for (const auto& tx : block.vtx) {
+            if (tx->IsCoinBase()) continue;
+            for (const auto& input : tx->vin) {
+                batch.Erase(std::make_pair(DB_SPENTINDEX, CSpentIndexKey(input.prevout.hash, input.prevout.n)));
+            }
+        }
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool SpentIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_db->Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
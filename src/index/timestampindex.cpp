@@ -0,0 +1,60 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/timestampindex.h>
+
+#include <chain.h>
+#include <spentindex.h>
+#include <util.h>
+#include <utilmemory.h>
+
+#include <boost/thread.hpp>
+
+constexpr char DB_TIMESTAMPINDEX = 's';
+
+std::unique_ptr<TimestampIndex> g_timestampindex;
+
+TimestampIndex::TimestampIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<BaseIndex::DB>(GetDataDir() / "indexes" / "timestampindex", n_cache_size, f_memory, f_wipe))
+{}
+
+bool TimestampIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    if (pindex->nHeight == 0) return true;
+
+    return m_db->Write(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())), 0);
+}
+
+bool TimestampIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    CDBBatch batch(*m_db);
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        batch.Erase(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())));
+    }
+    if (!m_db->WriteBatch(batch)) return false;
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool TimestampIndex::ReadTimestampIndex(const unsigned int& high, const unsigned int& low, std::vector<uint256>& hashes) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CTimestampIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
+            hashes.push_back(key.second.blockHash);
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
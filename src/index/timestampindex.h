@@ -0,0 +1,39 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TIMESTAMPINDEX_H
+#define BITCOIN_INDEX_TIMESTAMPINDEX_H
+
+#include <index/base.h>
+
+/**
+ * TimestampIndex records the hashes of the blocks in the active chain ordered by block time,
+ * so that blocks can be looked up by a range of timestamps.
+ */
+class TimestampIndex final : public BaseIndex
+{
+private:
+    std::unique_ptr<BaseIndex::DB> m_db;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override { return *m_db; }
+
+    const char* GetName() const override { return "timestampindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit TimestampIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the hashes of all blocks with low <= timestamp <= high.
+    bool ReadTimestampIndex(const unsigned int& high, const unsigned int& low, std::vector<uint256>& hashes) const;
+};
+
+/// The global timestamp index, used in GetTimestampIndex. May be null.
+extern std::unique_ptr<TimestampIndex> g_timestampindex;
+
+#endif // BITCOIN_INDEX_TIMESTAMPINDEX_H
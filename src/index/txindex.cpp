@@ -0,0 +1,135 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/txindex.h>
+#include <txdb.h>
+#include <util.h>
+#include <utilmemory.h>
+#include <validation.h>
+
+constexpr char DB_TXINDEX = 't';
+
+std::unique_ptr<TxIndex> g_txindex;
+
+/** Access to the txindex database (indexes/txindex/) */
+class TxIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Read the disk location of the transaction data with the given hash. Returns false if the
+    /// transaction hash is not indexed.
+    bool ReadTxPos(const uint256& txid, CDiskTxPos& pos) const;
+
+    /// Check whether the transaction hash is indexed.
+    bool HasTxPos(const uint256& txid) const;
+
+    /// Write a batch of transaction positions to the DB.
+    bool WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos);
+};
+
+TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "txindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool TxIndex::DB::ReadTxPos(const uint256 &txid, CDiskTxPos& pos) const
+{
+    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+}
+
+bool TxIndex::DB::HasTxPos(const uint256& txid) const
+{
+    return Exists(std::make_pair(DB_TXINDEX, txid));
+}
+
+bool TxIndex::DB::WriteTxs(const std::vector<std::pair<uint256, CDiskTxPos>>& v_pos)
+{
+    CDBBatch batch(*this);
+    for (const auto& tuple : v_pos) {
+        batch.Write(std::make_pair(DB_TXINDEX, tuple.first), tuple.second);
+    }
+    return WriteBatch(batch);
+}
+
+TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<TxIndex::DB>(n_cache_size, f_memory, f_wipe)), m_has_tx_cache(10000, 20000)
+{}
+
+TxIndex::~TxIndex() {}
+
+bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    // Exclude genesis block transaction because outputs are not spendable.
+    if (pindex->nHeight == 0) return true;
+
+    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+    std::vector<std::pair<uint256, CDiskTxPos>> vPos;
+    vPos.reserve(block.vtx.size());
+    for (const auto& tx : block.vtx) {
+        vPos.emplace_back(tx->GetHash(), pos);
+        pos.nTxOffset += ::GetSerializeSize(*tx, SER_DISK, CLIENT_VERSION);
+    }
+    if (!m_db->WriteTxs(vPos)) {
+        return false;
+    }
+
+    LOCK(m_cs_has_tx_cache);
+    for (const auto& p : vPos) {
+        m_has_tx_cache.insert_or_update(std::make_pair(p.first, true));
+    }
+    return true;
+}
+
+BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
+
+void TxIndex::OnSynced()
+{
+    if (!pblocktree->EraseLegacyTxIndex()) {
+        LogPrintf("%s: Failed to erase the legacy transaction index entries, retrying on next start\n", __func__);
+    }
+}
+
+bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
+{
+    CDiskTxPos postx;
+    if (!m_db->ReadTxPos(tx_hash, postx) &&
+        (IsSynced() || !pblocktree->ReadLegacyTxIndex(tx_hash, postx))) {
+        return false;
+    }
+
+    CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
+    if (file.IsNull()) {
+        return error("%s: OpenBlockFile failed", __func__);
+    }
+    CBlockHeader header;
+    try {
+        file >> header;
+        if (fseek(file.Get(), postx.nTxOffset, SEEK_CUR)) {
+            return error("%s: fseek(...) failed", __func__);
+        }
+        file >> tx;
+    } catch (const std::exception& e) {
+        return error("%s: Deserialize or I/O error - %s", __func__, e.what());
+    }
+    if (tx->GetHash() != tx_hash) {
+        return error("%s: txid mismatch", __func__);
+    }
+    block_hash = header.GetHash();
+    return true;
+}
+
+bool TxIndex::HasTx(const uint256& tx_hash) const
+{
+    {
+        LOCK(m_cs_has_tx_cache);
+        auto it = m_has_tx_cache.find(tx_hash);
+        if (it != m_has_tx_cache.end()) {
+            return it->second;
+        }
+    }
+    bool r = m_db->HasTxPos(tx_hash) || (!IsSynced() && pblocktree->HasLegacyTxIndex(tx_hash));
+    LOCK(m_cs_has_tx_cache);
+    m_has_tx_cache.insert(std::make_pair(tx_hash, r));
+    return r;
+}
@@ -0,0 +1,64 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_INDEX_TXINDEX_H
+#define BITCOIN_INDEX_TXINDEX_H
+
+#include <chain.h>
+#include <index/base.h>
+#include <limitedmap.h>
+#include <sync.h>
+#include <txdb.h>
+
+/**
+ * TxIndex is used to look up transactions included in the blockchain by hash.
+ * The index is written to a LevelDB database and records the filesystem
+ * location of each transaction by transaction hash.
+ */
+class TxIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /** Caches the result of HasTx lookups, which are done for every tx inv we receive. */
+    mutable CCriticalSection m_cs_has_tx_cache;
+    mutable unordered_limitedmap<uint256, bool> m_has_tx_cache;
+
+protected:
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    /// Erase the legacy transaction index entries, which are not needed anymore.
+    void OnSynced() override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "txindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit TxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~TxIndex() override;
+
+    /// Look up a transaction by hash. Until the index is synced, transactions it has not
+    /// reached yet are looked up in the legacy entries of the block index database.
+    ///
+    /// @param[in]   tx_hash  The hash of the transaction to be returned.
+    /// @param[out]  block_hash  The hash of the block the transaction is found in.
+    /// @param[out]  tx  The transaction itself.
+    /// @return  true if transaction is found, false otherwise
+    bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
+
+    /// Check whether a transaction is in the index without reading it from disk.
+    bool HasTx(const uint256& tx_hash) const;
+};
+
+/// The global transaction index, used in GetTransaction. May be null.
+extern std::unique_ptr<TxIndex> g_txindex;
+
+#endif // BITCOIN_INDEX_TXINDEX_H
@@ -13,6 +13,8 @@
 #include <addrman.h>
 #include <amount.h>
 #include <base58.h>
+#include <blockfilter.h>
+#include <blockprefetcher.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
@@ -22,6 +24,11 @@
 #include <fs.h>
 #include <httpserver.h>
 #include <httprpc.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/spentindex.h>
+#include <index/timestampindex.h>
+#include <index/txindex.h>
 #include <key.h>
 #include <validation.h>
 #include <miner.h>
@@ -43,6 +50,7 @@
 #include <torcontrol.h>
 #include <ui_interface.h>
 #include <util.h>
+#include <utilmemory.h>
 #include <utilmoneystr.h>
 #include <validationinterface.h>
 
@@ -51,11 +59,13 @@
 #include <dsnotificationinterface.h>
 #include <flat-database.h>
 #include <governance/governance.h>
+#include <governance/governance-db.h>
 #include <masternode/masternode-meta.h>
 #include <masternode/masternode-payments.h>
 #include <masternode/masternode-sync.h>
 #include <masternode/masternode-utils.h>
 #include <messagesigner.h>
+#include <metrics.h>
 #include <netfulfilledman.h>
 #include <spork.h>
 #include <warnings.h>
@@ -126,6 +136,8 @@ const WalletInitInterface& g_wallet_init_interface = DummyWalletInit();
 
 static CDSNotificationInterface* pdsNotificationInterface = nullptr;
 
+static std::vector<BlockFilterType> g_enabled_filter_types;
+
 #ifdef WIN32
 // Win32 LevelDB doesn't use filedescriptors, and the ones used for
 // accessing block files don't count towards the fd_set size limit
@@ -220,6 +232,22 @@ void Interrupt()
     InterruptMapPort();
     if (g_connman)
         g_connman->Interrupt();
+    if (g_txindex) {
+        g_txindex->Interrupt();
+    }
+    if (g_addressindex) {
+        g_addressindex->Interrupt();
+    }
+    if (g_spentindex) {
+        g_spentindex->Interrupt();
+    }
+    if (g_timestampindex) {
+        g_timestampindex->Interrupt();
+    }
+    ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Interrupt(); });
+    if (g_block_template_cache) {
+        g_block_template_cache->Interrupt();
+    }
 }
 
 /** Preparing steps before shutting down or restarting the wallet */
@@ -241,6 +269,11 @@ void PrepareShutdown()
     StopREST();
     StopRPC();
     StopHTTPServer();
+    if (g_block_template_cache) {
+        UnregisterValidationInterface(g_block_template_cache.get());
+        g_block_template_cache->Stop();
+        g_block_template_cache.reset();
+    }
     llmq::StopLLMQSystem();
 
     // fRPCInWarmup should be `false` if we completed the loading sequence
@@ -255,7 +288,11 @@ void PrepareShutdown()
     // using the other before destroying them.
     if (peerLogic) UnregisterValidationInterface(peerLogic.get());
     if (g_connman) g_connman->Stop();
-    // if (g_txindex) g_txindex->Stop(); //TODO watch out when backporting bitcoin#13033 (don't accidently put the reset here, as we've already backported bitcoin#13894)
+    if (g_txindex) g_txindex->Stop();
+    if (g_addressindex) g_addressindex->Stop();
+    if (g_spentindex) g_spentindex->Stop();
+    if (g_timestampindex) g_timestampindex->Stop();
+    ForEachBlockFilterIndex([](BlockFilterIndex& index) { index.Stop(); });
 
     StopTorControl();
 
@@ -263,6 +300,7 @@ void PrepareShutdown()
     // CScheduler/checkqueue threadGroup
     threadGroup.interrupt_all();
     threadGroup.join_all();
+    blockPrefetcher.Stop();
 
     // After there are no more peers/RPC left to give us new data which may generate
     // CValidationInterface callbacks, flush them...
@@ -277,8 +315,7 @@ void PrepareShutdown()
         CFlatDB<CSporkManager> flatdb6("sporks.dat", "magicSporkCache");
         flatdb6.Dump(sporkManager);
         if (!fDisableGovernance) {
-            CFlatDB<CGovernanceManager> flatdb3("governance.dat", "magicGovernanceCache");
-            flatdb3.Dump(governance);
+            governance.FlushToDb();
         }
     }
 
@@ -286,7 +323,11 @@ void PrepareShutdown()
     // destruct and reset all to nullptr.
     peerLogic.reset();
     g_connman.reset();
-    //g_txindex.reset(); //TODO watch out when backporting bitcoin#13033 (re-enable this, was backported via bitcoin#13894)
+    g_txindex.reset();
+    g_addressindex.reset();
+    g_spentindex.reset();
+    g_timestampindex.reset();
+    DestroyAllBlockFilterIndexes();
 
     if (g_is_mempool_loaded && gArgs.GetArg("-persistmempool", DEFAULT_PERSIST_MEMPOOL)) {
         DumpMempool();
@@ -332,6 +373,7 @@ void PrepareShutdown()
         deterministicMNManager.reset();
         evoDb.reset();
     }
+    governanceDb.reset();
     g_wallet_init_interface.Stop();
 
 #if ENABLE_ZMQ
@@ -472,6 +514,7 @@ void SetupServerArgs()
     gArgs.AddArg("-assumevalid=<hex>", strprintf("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)", defaultChainParams->GetConsensus().defaultAssumeValid.GetHex(), testnetChainParams->GetConsensus().defaultAssumeValid.GetHex()), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocksdir=<dir>", "Specify blocks directory (default: <datadir>/blocks)", false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocknotify=<cmd>", "Execute command when the best block changes (%s in cmd is replaced by block hash)", false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blockprefetch=<n>", strprintf("Number of blocks to read and check in the background ahead of the block being connected (0 to %d, 0 = disable, default: %d)", MAX_BLOCK_PREFETCH, DEFAULT_BLOCK_PREFETCH), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blockreconstructionextratxn=<n>", strprintf("Extra transactions to keep in memory for compact block reconstructions (default: %u)", DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-blocksonly", strprintf("Whether to operate in a blocks only mode (default: %u)", DEFAULT_BLOCKSONLY), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-conf=<file>", strprintf("Specify configuration file. Relative paths will be prefixed by datadir location. (default: %s)", BITCOIN_CONF_FILENAME), false, OptionsCategory::OPTIONS);
@@ -484,6 +527,7 @@ void SetupServerArgs()
     gArgs.AddArg("-maxorphantxsize=<n>", strprintf("Maximum total size of all orphan transactions in megabytes (default: %u)", DEFAULT_MAX_ORPHAN_TRANSACTIONS_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-maxrecsigsage=<n>", strprintf("Number of seconds to keep LLMQ recovery sigs (default: %u)", llmq::DEFAULT_MAX_RECOVERED_SIGS_AGE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-mempoolexpiry=<n>", strprintf("Do not keep transactions in the mempool longer than <n> hours (default: %u)", DEFAULT_MEMPOOL_EXPIRY), false, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-mnlistcache=<n>", strprintf("Keep masternode lists of past blocks in memory up to <n> megabytes (default: %u)", DEFAULT_MNLIST_CACHE_SIZE), false, OptionsCategory::OPTIONS);
     gArgs.AddArg("-minimumchainwork=<hex>", strprintf("Minimum work assumed to exist on a valid chain in hex (default: %s, testnet: %s)", defaultChainParams->GetConsensus().nMinimumChainWork.GetHex(), testnetChainParams->GetConsensus().nMinimumChainWork.GetHex()), true, OptionsCategory::OPTIONS);
     gArgs.AddArg("-par=<n>", strprintf("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)",
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS), false, OptionsCategory::OPTIONS);
@@ -501,6 +545,10 @@ void SetupServerArgs()
     gArgs.AddArg("-version", "Print version and exit", false, OptionsCategory::OPTIONS);
 
     gArgs.AddArg("-addressindex", strprintf("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)", DEFAULT_ADDRESSINDEX), false, OptionsCategory::INDEXING);
+    gArgs.AddArg("-blockfilterindex=<type>",
+                 strprintf("Maintain an index of compact filters by block (default: %s, values: %s).", DEFAULT_BLOCKFILTERINDEX, ListBlockFilterTypes()) +
+                 " If <type> is not supplied or if <type> = 1, indexes for all known types are enabled.",
+                 false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex", "Rebuild chain state and block index from the blk*.dat files on disk", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-reindex-chainstate", "Rebuild chain state from the currently indexed blocks", false, OptionsCategory::INDEXING);
     gArgs.AddArg("-spentindex", strprintf("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)", DEFAULT_SPENTINDEX), false, OptionsCategory::INDEXING);
@@ -526,6 +574,7 @@ void SetupServerArgs()
     gArgs.AddArg("-maxsendbuffer=<n>", strprintf("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)", DEFAULT_MAXSENDBUFFER), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxtimeadjustment", strprintf("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)", DEFAULT_MAX_TIME_ADJUSTMENT), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-maxuploadtarget=<n>", strprintf("Tries to keep outbound traffic under the given target (in MiB per 24h), 0 = no limit (default: %d)", DEFAULT_MAX_UPLOAD_TARGET), false, OptionsCategory::CONNECTION);
+    gArgs.AddArg("-msghandworkers=<n>", strprintf("Number of threads processing quorum messages next to the main message handler thread (0 to %d, default: %d)", MAX_MSGHAND_WORKERS, DEFAULT_MSGHAND_WORKERS), false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-onion=<ip:port>", "Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: -proxy)", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-onlynet=<net>", "Make outgoing connections only through network <net> (ipv4, ipv6 or onion). Incoming connections are not affected by this option. This option can be specified multiple times to allow multiple networks.", false, OptionsCategory::CONNECTION);
     gArgs.AddArg("-peerbloomfilters", strprintf("Support filtering of blocks and transaction with bloom filters (default: %u)", DEFAULT_PEERBLOOMFILTERS), false, OptionsCategory::CONNECTION);
@@ -553,6 +602,7 @@ void SetupServerArgs()
     g_wallet_init_interface.AddWalletOptions();
 
 #if ENABLE_ZMQ
+    gArgs.AddArg("-zmqpubblocktemplate=<address>", "Enable publish block template (header, coinbase and txids) in <address> whenever the tip changes or its fees improve by -blocktemplatenotifyfee", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashblock=<address>", "Enable publish hash block in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashgovernanceobject=<address>", "Enable publish hash of governance objects (like proposals) in <address>", false, OptionsCategory::ZMQ);
     gArgs.AddArg("-zmqpubhashgovernancevote=<address>", "Enable publish hash of governance votes in <address>", false, OptionsCategory::ZMQ);
@@ -578,6 +628,7 @@ void SetupServerArgs()
     gArgs.AddArg("-limitancestorsize=<n>", strprintf("Do not accept transactions whose size with all in-mempool ancestors exceeds <n> kilobytes (default: %u)", DEFAULT_ANCESTOR_SIZE_LIMIT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-limitdescendantcount=<n>", strprintf("Do not accept transactions if any ancestor would have <n> or more in-mempool descendants (default: %u)", DEFAULT_DESCENDANT_LIMIT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-limitdescendantsize=<n>", strprintf("Do not accept transactions if any ancestor would have more than <n> kilobytes of in-mempool descendants (default: %u).", DEFAULT_DESCENDANT_SIZE_LIMIT), true, OptionsCategory::DEBUG_TEST);
+    gArgs.AddArg("-lockstats=<n>", strprintf("Profile lock contention for the getlockstats RPC, sampling the hold time of one in <n> locks per thread (0 to disable, default: %u)", DEFAULT_LOCK_STATS_INTERVAL), false, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-stopafterblockimport", strprintf("Stop running after importing blocks from disk (default: %u)", DEFAULT_STOPAFTERBLOCKIMPORT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-stopatheight", strprintf("Stop running after reaching the given height in the main chain (default: %u)", DEFAULT_STOPATHEIGHT), true, OptionsCategory::DEBUG_TEST);
     gArgs.AddArg("-vbparams=<deployment>:<start>:<end>(:<window>:<threshold>)", "Use given start/end times for specified version bits deployment (regtest-only). Specifying window and threshold is optional.", true, OptionsCategory::DEBUG_TEST);
@@ -634,13 +685,17 @@ void SetupServerArgs()
 
     gArgs.AddArg("-blockmaxsize=<n>", strprintf("Set maximum block size in bytes (default: %d)", DEFAULT_BLOCK_MAX_SIZE), false, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockmintxfee=<amt>", strprintf("Set lowest fee rate (in %s/kB) for transactions to be included in block creation. (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_MIN_TX_FEE)), false, OptionsCategory::BLOCK_CREATION);
+    gArgs.AddArg("-blocktemplatenotifyfee=<amt>", strprintf("Fee increase (in %s) for which a new block template on the same tip is announced to longpolling getblocktemplate calls and -zmqpubblocktemplate (default: %s)", CURRENCY_UNIT, FormatMoney(DEFAULT_BLOCK_TEMPLATE_NOTIFY_FEE)), true, OptionsCategory::BLOCK_CREATION);
+    gArgs.AddArg("-blocktemplaterefresh=<n>", strprintf("Minimum interval in milliseconds between rebuilds of the cached block template served by getblocktemplate while the mempool changes (default: %d)", DEFAULT_BLOCK_TEMPLATE_REFRESH), true, OptionsCategory::BLOCK_CREATION);
     gArgs.AddArg("-blockversion=<n>", "Override block version to test forking scenarios", true, OptionsCategory::BLOCK_CREATION);
 
     gArgs.AddArg("-rest", strprintf("Accept public REST requests (default: %u)", DEFAULT_REST_ENABLE), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcallowip=<ip>", "Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcauth=<userpw>", "Username and hashed password for JSON-RPC connections. The field <userpw> comes in the format: <USERNAME>:<SALT>$<HASH>. A canonical python script is included in share/rpcuser. The client then connects normally using the rpcuser=<USERNAME>/rpcpassword=<PASSWORD> pair of arguments. This option can be specified multiple times", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpcbatchparallel=<n>", strprintf("Execute up to <n> elements of a JSON-RPC batch request at the same time on the RPC threads, replies keep the request order (default: %d)", DEFAULT_HTTP_BATCH_PARALLEL), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcbind=<addr>[:port]", "Bind to given address to listen for JSON-RPC connections. Do not expose the RPC server to untrusted networks such as the public internet! This option is ignored unless -rpcallowip is also passed. Port is optional and overrides -rpcport. Use [host]:port notation for IPv6. This option can be specified multiple times (default: 127.0.0.1 and ::1 i.e., localhost, or if -rpcallowip has been specified, 0.0.0.0 and :: i.e., all addresses)", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpccookiefile=<loc>", "Location of the auth cookie. Relative paths will be prefixed by a net-specific datadir location. (default: data dir)", false, OptionsCategory::RPC);
+    gArgs.AddArg("-rpceventthreads=<n>", strprintf("Set the number of event loops accepting and parsing RPC connections, more than one needs SO_REUSEPORT support (default: %d)", DEFAULT_HTTP_EVENT_THREADS), true, OptionsCategory::RPC);
     gArgs.AddArg("-rpcpassword=<pw>", "Password for JSON-RPC connections", false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcport=<port>", strprintf("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)", defaultBaseParams->RPCPort(), testnetBaseParams->RPCPort()), false, OptionsCategory::RPC);
     gArgs.AddArg("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT), true, OptionsCategory::RPC);
@@ -874,7 +929,8 @@ void PeriodicStats()
     assert(gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE));
     CCoinsStats stats;
     FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
+    // No hash is reported, so the UTXO set can be walked in parallel
+    if (GetUTXOStats(pcoinsdbview.get(), stats, CoinStatsHashType::NONE, std::max(1, std::min(GetNumCores(), 8)))) {
         statsClient.gauge("utxoset.tx", stats.nTransactions, 1.0f);
         statsClient.gauge("utxoset.txOutputs", stats.nTransactionOutputs, 1.0f);
         statsClient.gauge("utxoset.dbSizeBytes", stats.nDiskSize, 1.0f);
@@ -921,6 +977,30 @@ void PeriodicStats()
     statsClient.gauge("transactions.mempool.minFeePerKb", mempool.GetMinFee(gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000).GetFeePerK(), 1.0f);
 }
 
+/** Publishes the latency histograms collected since the previous call */
+void PeriodicMetrics()
+{
+    static std::map<std::string, CLatencyHistogramSnapshot> mapLastSent;
+
+    for (const auto& p : g_metrics.GetSnapshots()) {
+        CLatencyHistogramSnapshot& lastSent = mapLastSent[p.first];
+        const CLatencyHistogramSnapshot interval = p.second.Since(lastSent);
+        lastSent = p.second;
+        if (interval.nCount == 0) {
+            continue;
+        }
+
+        const std::string strKey = "metrics." + p.first;
+        statsClient.count(strKey + ".count", interval.nCount, 1.0f);
+        statsClient.gaugeDouble(strKey + ".mean_us", interval.GetMean());
+        statsClient.gauge(strKey + ".p50_us", interval.GetPercentile(0.5), 1.0f);
+        statsClient.gauge(strKey + ".p90_us", interval.GetPercentile(0.9), 1.0f);
+        statsClient.gauge(strKey + ".p99_us", interval.GetPercentile(0.99), 1.0f);
+        statsClient.gauge(strKey + ".p999_us", interval.GetPercentile(0.999), 1.0f);
+        statsClient.gauge(strKey + ".max_us", interval.nMax, 1.0f);
+    }
+}
+
 /** Sanity checks
  *  Ensure that Dash Core is running in a usable environment with all
  *  necessary library support.
@@ -1043,18 +1123,6 @@ void InitParameterInteraction()
         }
     }
 
-    // Make sure additional indexes are recalculated correctly in VerifyDB
-    // (we must reconnect blocks whenever we disconnect them for these indexes to work)
-    bool fAdditionalIndexes =
-        gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ||
-        gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ||
-        gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
-
-    if (fAdditionalIndexes && gArgs.GetArg("-checklevel", DEFAULT_CHECKLEVEL) < 4) {
-        gArgs.ForceSetArg("-checklevel", "4");
-        LogPrintf("%s: parameter interaction: additional indexes -> setting -checklevel=4\n", __func__);
-    }
-
     if (gArgs.IsArgSet("-masternodeblsprivkey") && gArgs.SoftSetBoolArg("-disablewallet", true)) {
         LogPrintf("%s: parameter interaction: -masternodeblsprivkey set -> setting -disablewallet=1\n", __func__);
     }
@@ -1173,10 +1241,37 @@ bool AppInitParameterInteraction()
         return InitError(strprintf(_("Specified blocks directory \"%s\" does not exist."), gArgs.GetArg("-blocksdir", "").c_str()));
     }
 
-    // if using block pruning, then disallow txindex and require disabling governance validation
+    // parse and validate enabled filter types
+    std::string blockfilterindex_value = gArgs.GetArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
+    if (blockfilterindex_value == "" || blockfilterindex_value == "1") {
+        g_enabled_filter_types = AllBlockFilterTypes();
+    } else if (blockfilterindex_value != "0") {
+        const std::vector<std::string> names = gArgs.GetArgs("-blockfilterindex");
+        g_enabled_filter_types.reserve(names.size());
+        for (const auto& name : names) {
+            BlockFilterType filter_type;
+            if (!BlockFilterTypeByName(name, filter_type)) {
+                return InitError(strprintf(_("Unknown -blockfilterindex value %s."), name));
+            }
+            g_enabled_filter_types.push_back(filter_type);
+        }
+    }
+
+    fTxIndex = gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX);
+    fAddressIndex = gArgs.GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+    fSpentIndex = gArgs.GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+    fTimestampIndex = gArgs.GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+
+    // if using block pruning, then disallow txindex and block filter indexes and require disabling governance validation
     if (gArgs.GetArg("-prune", 0)) {
-        if (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX))
+        if (fTxIndex)
             return InitError(_("Prune mode is incompatible with -txindex."));
+        if (fAddressIndex || fSpentIndex || fTimestampIndex) {
+            return InitError(_("Prune mode is incompatible with -addressindex, -spentindex and -timestampindex."));
+        }
+        if (!g_enabled_filter_types.empty()) {
+            return InitError(_("Prune mode is incompatible with -blockfilterindex."));
+        }
         if (!gArgs.GetBoolArg("-disablegovernance", false)) {
             return InitError(_("Prune mode is incompatible with -disablegovernance=false."));
         }
@@ -1378,6 +1473,13 @@ bool AppInitParameterInteraction()
             return InitError(AmountErrMsg("blockmintxfee", gArgs.GetArg("-blockmintxfee", "")));
     }
 
+    if (gArgs.IsArgSet("-blocktemplatenotifyfee"))
+    {
+        CAmount n = 0;
+        if (!ParseMoney(gArgs.GetArg("-blocktemplatenotifyfee", ""), n))
+            return InitError(AmountErrMsg("blocktemplatenotifyfee", gArgs.GetArg("-blocktemplatenotifyfee", "")));
+    }
+
     // Feerate used to define dust.  Shouldn't be changed lightly as old
     // implementations may inadvertently create non-standard transactions
     if (gArgs.IsArgSet("-dustrelayfee"))
@@ -1399,6 +1501,8 @@ bool AppInitParameterInteraction()
     fAcceptDatacarrier = gArgs.GetBoolArg("-datacarrier", DEFAULT_ACCEPT_DATACARRIER);
     nMaxDatacarrierBytes = gArgs.GetArg("-datacarriersize", nMaxDatacarrierBytes);
 
+    SetLockStatsInterval(gArgs.GetArg("-lockstats", DEFAULT_LOCK_STATS_INTERVAL));
+
     // Option to startup with mocktime set (used for regression testing):
     SetMockTime(gArgs.GetArg("-mocktime", 0)); // SetMockTime(0) is a no-op
 
@@ -1722,6 +1826,13 @@ bool AppInitMain()
             threadGroup.create_thread(&ThreadScriptCheck);
     }
 
+    int nBlockPrefetch = std::max(0, std::min(MAX_BLOCK_PREFETCH, (int)gArgs.GetArg("-blockprefetch", DEFAULT_BLOCK_PREFETCH)));
+    if (nBlockPrefetch > 0) {
+        int nPrefetchThreads = std::max(1, std::min(nBlockPrefetch, GetNumCores() / 4));
+        LogPrintf("Prefetching up to %d blocks using %d threads\n", nBlockPrefetch, nPrefetchThreads);
+        blockPrefetcher.Start(nBlockPrefetch, nPrefetchThreads);
+    }
+
     std::vector<std::string> vSporkAddresses;
     if (gArgs.IsArgSet("-sporkaddr")) {
         vSporkAddresses = gArgs.GetArgs("-sporkaddr");
@@ -1923,19 +2034,46 @@ bool AppInitMain()
     int64_t nTotalCache = (gArgs.GetArg("-dbcache", nDefaultDbCache) << 20);
     nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
-    int64_t nBlockTreeDBCache = nTotalCache / 8;
-    nBlockTreeDBCache = std::min(nBlockTreeDBCache, (gArgs.GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
+    int64_t nBlockTreeDBCache = std::min(nTotalCache / 8, nMaxBlockDBCache << 20);
     nTotalCache -= nBlockTreeDBCache;
+    int64_t nTxIndexCache = std::min(nTotalCache / 8, fTxIndex ? nMaxTxIndexCache << 20 : 0);
+    nTotalCache -= nTxIndexCache;
+    int64_t extra_index_cache = 0;
+    const int n_extra_indexes = (fAddressIndex ? 1 : 0) + (fSpentIndex ? 1 : 0) + (fTimestampIndex ? 1 : 0);
+    if (n_extra_indexes > 0) {
+        int64_t max_cache = std::min(nTotalCache / 8, max_extra_index_cache << 20);
+        extra_index_cache = max_cache / n_extra_indexes;
+        nTotalCache -= extra_index_cache * n_extra_indexes;
+    }
+    int64_t filter_index_cache = 0;
+    if (!g_enabled_filter_types.empty()) {
+        size_t n_indexes = g_enabled_filter_types.size();
+        int64_t max_cache = std::min(nTotalCache / 8, max_filter_index_cache << 20);
+        filter_index_cache = max_cache / n_indexes;
+        nTotalCache -= filter_index_cache * n_indexes;
+    }
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     int64_t nMempoolSizeMax = gArgs.GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
+    int64_t nMNListCacheSize = std::max<int64_t>(0, gArgs.GetArg("-mnlistcache", DEFAULT_MNLIST_CACHE_SIZE)) << 20;
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    if (fTxIndex) {
+        LogPrintf("* Using %.1fMiB for transaction index database\n", nTxIndexCache * (1.0 / 1024 / 1024));
+    }
+    if (n_extra_indexes > 0) {
+        LogPrintf("* Using %.1fMiB for each enabled address, spent and timestamp index database\n", extra_index_cache * (1.0 / 1024 / 1024));
+    }
+    for (BlockFilterType filter_type : g_enabled_filter_types) {
+        LogPrintf("* Using %.1fMiB for %s block filter index database\n",
+                  filter_index_cache * (1.0 / 1024 / 1024), BlockFilterTypeName(filter_type));
+    }
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for in-memory masternode lists\n", nMNListCacheSize * (1.0 / 1024 / 1024));
 
     bool fLoaded = false;
     int64_t nStart = GetTimeMillis();
@@ -1964,7 +2102,7 @@ bool AppInitMain()
                 evoDb.reset();
                 evoDb.reset(new CEvoDB(nEvoDbCache, false, fReset || fReindexChainState));
                 deterministicMNManager.reset();
-                deterministicMNManager.reset(new CDeterministicMNManager(*evoDb));
+                deterministicMNManager.reset(new CDeterministicMNManager(*evoDb, nMNListCacheSize));
 
                 llmq::InitLLMQSystem(*evoDb, false, fReset || fReindexChainState);
 
@@ -2025,6 +2163,15 @@ bool AppInitMain()
                     break;
                 }
 
+                // The indexes used to be stored in the block index database. Their entries are
+                // not read anymore since the indexes are rebuilt in indexes/, so drop them. The
+                // transaction index entries are used until g_txindex has caught up and are
+                // erased by it then.
+                if (!pblocktree->EraseLegacyIndexes()) {
+                    strLoadError = _("Error erasing legacy index entries from the block index database");
+                    break;
+                }
+
                 // Check for changed -prune state.  What we are concerned about is a user who has pruned blocks
                 // in the past, but is now trying to run unpruned.
                 if (fHavePruned && !fPruneMode) {
@@ -2160,6 +2307,33 @@ bool AppInitMain()
         ::feeEstimator.Read(est_filein);
     fFeeEstimatesInitialized = true;
 
+    // ********************************************************* Step 7c: start indexers
+
+    if (fTxIndex) {
+        g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, fReindex);
+        g_txindex->Start();
+    }
+
+    if (fAddressIndex) {
+        g_addressindex = MakeUnique<AddressIndex>(extra_index_cache, false, fReindex);
+        g_addressindex->Start();
+    }
+
+    if (fSpentIndex) {
+        g_spentindex = MakeUnique<SpentIndex>(extra_index_cache, false, fReindex);
+        g_spentindex->Start();
+    }
+
+    if (fTimestampIndex) {
+        g_timestampindex = MakeUnique<TimestampIndex>(extra_index_cache, false, fReindex);
+        g_timestampindex->Start();
+    }
+
+    for (const auto& filter_type : g_enabled_filter_types) {
+        InitBlockFilterIndex(filter_type, filter_index_cache, false, fReindex);
+        GetBlockFilterIndex(filter_type)->Start();
+    }
+
     // ********************************************************* Step 8: load wallet
     if (!g_wallet_init_interface.Open()) return false;
 
@@ -2255,19 +2429,26 @@ bool AppInitMain()
         }
     }
 
-    strDBName = "governance.dat";
+    // governance.dat was replaced by the governance db
+    if (fs::exists(pathDB / "governance.dat")) {
+        LogPrintf("Removing obsolete governance.dat\n");
+        fs::remove(pathDB / "governance.dat");
+    }
     uiInterface.InitMessage(_("Loading governance cache..."));
-    CFlatDB<CGovernanceManager> flatdb3(strDBName, "magicGovernanceCache");
-    if (fLoadCacheFiles && !fDisableGovernance) {
-        if(!flatdb3.Load(governance)) {
-            return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / strDBName).string());
+    try {
+        // Like the cache files, the governance db is cleared while governance is disabled
+        governanceDb.reset(new CGovernanceDB(GOVERNANCE_DB_CACHE_SIZE, false, !fLoadCacheFiles || fDisableGovernance));
+        if (fDisableGovernance) {
+            governanceDb.reset();
+        } else {
+            governance.LoadFromDb();
         }
+    } catch (const std::exception& e) {
+        LogPrintf("%s\n", e.what());
+        return InitError(_("Failed to load governance cache from") + "\n" + (pathDB / "governance").string());
+    }
+    if (!fDisableGovernance) {
         governance.InitOnLoad();
-    } else {
-        CGovernanceManager governanceTmp;
-        if(!flatdb3.Dump(governanceTmp)) {
-            return InitError(_("Failed to clear governance cache at") + "\n" + (pathDB / strDBName).string());
-        }
     }
 
     strDBName = "netfulfilled.dat";
@@ -2301,7 +2482,22 @@ bool AppInitMain()
     if (gArgs.GetBoolArg("-statsenabled", DEFAULT_STATSD_ENABLE)) {
         int nStatsPeriod = std::min(std::max((int)gArgs.GetArg("-statsperiod", DEFAULT_STATSD_PERIOD), MIN_STATSD_PERIOD), MAX_STATSD_PERIOD);
         scheduler.scheduleEvery(PeriodicStats, nStatsPeriod * 1000);
+        scheduler.scheduleEvery(PeriodicMetrics, nStatsPeriod * 1000);
+    }
+
+    CAmount nBlockTemplateNotifyFee = DEFAULT_BLOCK_TEMPLATE_NOTIFY_FEE;
+    if (gArgs.IsArgSet("-blocktemplatenotifyfee")) {
+        ParseMoney(gArgs.GetArg("-blocktemplatenotifyfee", ""), nBlockTemplateNotifyFee);
     }
+    g_block_template_cache = MakeUnique<CBlockTemplateCache>(chainparams, gArgs.GetArg("-blocktemplaterefresh", DEFAULT_BLOCK_TEMPLATE_REFRESH), nBlockTemplateNotifyFee);
+    RegisterValidationInterface(g_block_template_cache.get());
+#if ENABLE_ZMQ
+    if (g_zmq_notification_interface && g_zmq_notification_interface->HasNotifier("pubblocktemplate")) {
+        // Templates are pushed, so they have to be built without anyone asking for them
+        g_block_template_cache->SetAlwaysActive(true);
+    }
+#endif
+    g_block_template_cache->Start();
 
     llmq::StartLLMQSystem();
 
@@ -2384,6 +2580,7 @@ bool AppInitMain()
     connOptions.nMaxOutboundTimeframe = nMaxOutboundTimeframe;
     connOptions.nMaxOutboundLimit = nMaxOutboundLimit;
     connOptions.m_peer_connect_timeout = peer_connect_timeout;
+    connOptions.nMessageHandlerWorkers = std::max(0, std::min((int)gArgs.GetArg("-msghandworkers", DEFAULT_MSGHAND_WORKERS), MAX_MSGHAND_WORKERS));
 
     for (const std::string& strBind : gArgs.GetArgs("-bind")) {
         CService addrBind;
@@ -19,6 +19,8 @@
 #include <univalue.h>
 #include <validation.h>
 
+#include <memusage.h>
+
 #include <cxxtimer.hpp>
 
 namespace llmq
@@ -26,6 +28,12 @@ namespace llmq
 
 static const std::string DB_QUORUM_SK_SHARE = "q_Qsk";
 static const std::string DB_QUORUM_QUORUM_VVEC = "q_Qqvvec";
+static const std::string DB_QUORUM_PK_SHARES = "q_Qpks";
+
+// Enough for the public key shares of all active quorums of all LLMQ types
+static const size_t PUBKEY_SHARE_CACHE_BYTES = 16 * 1024 * 1024;
+// Public key shares of quorums which are too old to connect to are deleted from evoDB every this many blocks
+static const int PUBKEY_SHARES_CLEANUP_INTERVAL = 576;
 
 CQuorumManager* quorumManager;
 
@@ -43,7 +51,36 @@ static uint256 MakeQuorumKey(const CQuorum& q)
     return hw.GetHash();
 }
 
-CQuorum::CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker) : params(_params), blsCache(_blsWorker)
+static CQuorumPubKeyShareCache pubKeyShareCache(PUBKEY_SHARE_CACHE_BYTES);
+
+CQuorumPubKeyShareCache::CQuorumPubKeyShareCache(size_t nMaxBytes) : cache(GetMaxEntries(nMaxBytes))
+{
+}
+
+size_t CQuorumPubKeyShareCache::GetMaxEntries(size_t nMaxBytes)
+{
+    // the cache only truncates when it holds twice its size
+    const size_t nEntryBytes = memusage::MallocUsage(sizeof(memusage::unordered_node<std::pair<const Key, std::pair<CBLSPublicKey, int64_t>>>)) + sizeof(void*);
+    return std::max<size_t>(nMaxBytes / nEntryBytes / 2, 1);
+}
+
+bool CQuorumPubKeyShareCache::Get(const uint256& quorumKey, size_t memberIdx, CBLSPublicKey& pubKeyShareRet)
+{
+    LOCK(cs);
+    return cache.get(std::make_pair(quorumKey, (uint16_t)memberIdx), pubKeyShareRet);
+}
+
+void CQuorumPubKeyShareCache::Insert(const uint256& quorumKey, const std::vector<CBLSPublicKey>& vecPubKeyShares)
+{
+    LOCK(cs);
+    for (size_t i = 0; i < vecPubKeyShares.size(); i++) {
+        if (vecPubKeyShares[i].IsValid()) {
+            cache.insert(std::make_pair(quorumKey, (uint16_t)i), vecPubKeyShares[i]);
+        }
+    }
+}
+
+CQuorum::CQuorum(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker) : params(_params), blsWorker(_blsWorker)
 {
 }
 
@@ -55,6 +92,7 @@ void CQuorum::Init(const CFinalCommitment& _qc, const CBlockIndex* _pindexQuorum
     pindexQuorum = _pindexQuorum;
     members = _members;
     minedBlockHash = _minedBlockHash;
+    quorumKey = MakeQuorumKey(*this);
 }
 
 bool CQuorum::SetVerificationVector(const BLSVerificationVector& quorumVecIn)
@@ -101,7 +139,9 @@ CBLSPublicKey CQuorum::GetPubKeyShare(size_t memberIdx) const
         return CBLSPublicKey();
     }
     auto& m = members[memberIdx];
-    return blsCache.BuildPubKeyShare(m->proTxHash, quorumVvec, CBLSId(m->proTxHash));
+    return pubKeyShareCache.GetOrBuild(quorumKey, memberIdx, [&]() {
+        return blsWorker.BuildPubKeyShare(quorumVvec, CBLSId(m->proTxHash));
+    });
 }
 
 const CBLSSecretKey& CQuorum::GetSkShare() const
@@ -121,22 +161,18 @@ int CQuorum::GetMemberIndex(const uint256& proTxHash) const
 
 void CQuorum::WriteContributions(CEvoDB& evoDb)
 {
-    uint256 dbKey = MakeQuorumKey(*this);
-
     if (quorumVvec != nullptr) {
-        evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_QUORUM_VVEC, dbKey), *quorumVvec);
+        evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_QUORUM_VVEC, quorumKey), *quorumVvec);
     }
     if (skShare.IsValid()) {
-        evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_SK_SHARE, dbKey), skShare);
+        evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_SK_SHARE, quorumKey), skShare);
     }
 }
 
 bool CQuorum::ReadContributions(CEvoDB& evoDb)
 {
-    uint256 dbKey = MakeQuorumKey(*this);
-
     BLSVerificationVector qv;
-    if (evoDb.Read(std::make_pair(DB_QUORUM_QUORUM_VVEC, dbKey), qv)) {
+    if (evoDb.Read(std::make_pair(DB_QUORUM_QUORUM_VVEC, quorumKey), qv)) {
         quorumVvec = std::make_shared<BLSVerificationVector>(std::move(qv));
     } else {
         return false;
@@ -144,11 +180,63 @@ bool CQuorum::ReadContributions(CEvoDB& evoDb)
 
     // We ignore the return value here as it is ok if this fails. If it fails, it usually means that we are not a
     // member of the quorum but observed the whole DKG process to have the quorum verification vector.
-    evoDb.Read(std::make_pair(DB_QUORUM_SK_SHARE, dbKey), skShare);
+    evoDb.Read(std::make_pair(DB_QUORUM_SK_SHARE, quorumKey), skShare);
+
+    return true;
+}
+
+void CQuorum::WritePubKeyShares(CEvoDB& evoDb) const
+{
+    std::vector<CBLSPublicKey> vecShares(members.size());
+    for (size_t i = 0; i < members.size(); i++) {
+        if (qc.validMembers[i]) {
+            vecShares[i] = GetPubKeyShare(i);
+            if (!vecShares[i].IsValid()) {
+                return;
+            }
+        }
+    }
+    evoDb.GetRawDB().Write(std::make_pair(DB_QUORUM_PK_SHARES, quorumKey), vecShares);
+}
 
+bool CQuorum::ReadPubKeyShares(CEvoDB& evoDb) const
+{
+    std::vector<CBLSPublicKey> vecShares;
+    if (!evoDb.Read(std::make_pair(DB_QUORUM_PK_SHARES, quorumKey), vecShares)) {
+        return false;
+    }
+    if (!CheckPubKeyShares(vecShares)) {
+        LogPrintf("CQuorum::%s -- invalid public key shares for quorum %s, recovering them again\n", __func__, qc.quorumHash.ToString());
+        evoDb.GetRawDB().Erase(std::make_pair(DB_QUORUM_PK_SHARES, quorumKey));
+        return false;
+    }
+    pubKeyShareCache.Insert(quorumKey, vecShares);
     return true;
 }
 
+bool CQuorum::CheckPubKeyShares(const std::vector<CBLSPublicKey>& vecShares) const
+{
+    if (quorumVvec == nullptr || vecShares.size() != members.size()) {
+        return false;
+    }
+    // There must be a share for every valid member and none for the others
+    std::vector<size_t> vecValidIdxs;
+    for (size_t i = 0; i < members.size(); i++) {
+        if (vecShares[i].IsValid() != (bool)qc.validMembers[i]) {
+            return false;
+        }
+        if (qc.validMembers[i]) {
+            vecValidIdxs.emplace_back(i);
+        }
+    }
+    if (vecValidIdxs.empty()) {
+        return true;
+    }
+    // Recovering all shares is what we want to avoid here, so only recover a random one and compare it
+    const size_t idx = vecValidIdxs[GetRandInt(vecValidIdxs.size())];
+    return blsWorker.BuildPubKeyShare(quorumVvec, CBLSId(members[idx]->proTxHash)) == vecShares[idx];
+}
+
 CQuorumManager::CQuorumManager(CEvoDB& _evoDb, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager) :
     evoDb(_evoDb),
     blsWorker(_blsWorker),
@@ -258,6 +346,8 @@ void CQuorumManager::UpdatedBlockTip(const CBlockIndex* pindexNew, bool fInitial
     }
 
     TriggerQuorumDataRecoveryThreads(pindexNew);
+
+    CleanupOldPubKeyShares(pindexNew);
 }
 
 void CQuorumManager::EnsureQuorumConnections(Consensus::LLMQType llmqType, const CBlockIndex* pindexNew) const
@@ -315,7 +405,7 @@ CQuorumPtr CQuorumManager::BuildQuorumFromCommitment(const Consensus::LLMQType l
         }
     }
 
-    if (hasValidVvec) {
+    if (hasValidVvec && !quorum->ReadPubKeyShares(evoDb)) {
         // pre-populate caches in the background
         // recovering public key shares is quite expensive and would result in serious lags for the first few signing
         // sessions if the shares would be calculated on-demand
@@ -724,16 +814,75 @@ void CQuorumManager::StartCachePopulatorThread(const CQuorumCPtr pQuorum) const
     LogPrint(BCLog::LLMQ, "CQuorumManager::StartCachePopulatorThread -- start\n");
 
     // when then later some other thread tries to get keys, it will be much faster
+    // the shares are also persisted, so that they don't have to be recovered again after a restart
     workerPool.push([pQuorum, t, this](int threadId) {
         for (size_t i = 0; i < pQuorum->members.size() && !quorumThreadInterrupt; i++) {
             if (pQuorum->qc.validMembers[i]) {
                 pQuorum->GetPubKeyShare(i);
             }
         }
+        if (!quorumThreadInterrupt) {
+            pQuorum->WritePubKeyShares(evoDb);
+        }
         LogPrint(BCLog::LLMQ, "CQuorumManager::StartCachePopulatorThread -- done. time=%d\n", t.count());
     });
 }
 
+void CQuorumManager::CleanupOldPubKeyShares(const CBlockIndex* pIndex) const
+{
+    if (pIndex == nullptr || (pIndex->nHeight % PUBKEY_SHARES_CLEANUP_INTERVAL) != 0) {
+        return;
+    }
+
+    workerPool.push([this](int threadId) {
+        // The iterator only sees shares written before it was created. Those all belong to quorums
+        // mined up to the tip read below, so none of them is missing from setKeep.
+        CDBWrapper& db = evoDb.GetRawDB();
+        std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+
+        const CBlockIndex* pindexTip;
+        {
+            LOCK(cs_main);
+            pindexTip = chainActive.Tip();
+        }
+
+        // Keep the shares of all quorums which can still sign or which we still keep connections to
+        std::set<uint256> setKeep;
+        for (const auto& p : Params().GetConsensus().llmqs) {
+            const auto& params = p.second;
+            const size_t nKeep = (size_t)std::max(params.keepOldConnections, params.signingActiveQuorumCount);
+            for (const auto& pQuorum : ScanQuorums(params.type, pindexTip, nKeep)) {
+                if (quorumThreadInterrupt) {
+                    return;
+                }
+                setKeep.emplace(pQuorum->quorumKey);
+            }
+        }
+
+        auto start = std::make_pair(DB_QUORUM_PK_SHARES, uint256());
+        pcursor->Seek(start);
+
+        CDBBatch batch(db);
+        size_t cnt = 0;
+        while (pcursor->Valid() && !quorumThreadInterrupt) {
+            decltype(start) k;
+            if (!pcursor->GetKey(k) || k.first != DB_QUORUM_PK_SHARES) {
+                break;
+            }
+            if (!setKeep.count(k.second)) {
+                batch.Erase(k);
+                cnt++;
+            }
+            pcursor->Next();
+        }
+        pcursor.reset();
+
+        db.WriteBatch(batch);
+
+        LogPrint(BCLog::LLMQ, "CQuorumManager::%s -- deleted public key shares of %d old quorums\n", __func__, cnt);
+    });
+}
+
 void CQuorumManager::StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMaskIn) const
 {
     if (pQuorum->fQuorumDataRecoveryThreadRunning) {
@@ -130,6 +130,80 @@ public:
     }
 };
 
+/**
+ * Public key shares of the members of all quorums. Shares are looked up by every sig share verification, so they are
+ * recovered in a batch when a quorum is built (or loaded from evoDB) instead of when they are needed. The cache is
+ * shared between all quorums and bounded by the memory it uses instead of by the number of quorums.
+ *
+ * A share which is not cached is recovered by the first thread looking it up, concurrent lookups of the same share
+ * wait for that thread instead of recovering it again.
+ */
+class CQuorumPubKeyShareCache
+{
+private:
+    typedef std::pair<uint256, uint16_t> Key;
+    typedef unordered_lru_cache<Key, CBLSPublicKey, StaticSaltedHasher> CacheType;
+
+    CCriticalSection cs;
+    CacheType cache GUARDED_BY(cs);
+    // Shares which are being recovered right now
+    std::map<Key, std::shared_future<CBLSPublicKey>> mapInFlight GUARDED_BY(cs);
+
+    static size_t GetMaxEntries(size_t nMaxBytes);
+
+public:
+    explicit CQuorumPubKeyShareCache(size_t nMaxBytes);
+
+    bool Get(const uint256& quorumKey, size_t memberIdx, CBLSPublicKey& pubKeyShareRet);
+    void Insert(const uint256& quorumKey, const std::vector<CBLSPublicKey>& vecPubKeyShares);
+
+    template <typename Builder>
+    CBLSPublicKey GetOrBuild(const uint256& quorumKey, size_t memberIdx, Builder&& builder)
+    {
+        const Key key = std::make_pair(quorumKey, (uint16_t)memberIdx);
+        std::shared_future<CBLSPublicKey> inFlight;
+        std::promise<CBLSPublicKey> promise;
+        {
+            LOCK(cs);
+            CBLSPublicKey pubKeyShare;
+            if (cache.get(key, pubKeyShare)) {
+                return pubKeyShare;
+            }
+            auto it = mapInFlight.find(key);
+            if (it != mapInFlight.end()) {
+                inFlight = it->second;
+            } else {
+                mapInFlight.emplace(key, promise.get_future());
+            }
+        }
+        if (inFlight.valid()) {
+            return inFlight.get();
+        }
+
+        CBLSPublicKey pubKeyShare;
+        try {
+            pubKeyShare = builder();
+        } catch (...) {
+            // Hand the failure to the waiting threads and let later callers build it again
+            {
+                LOCK(cs);
+                mapInFlight.erase(key);
+            }
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        {
+            LOCK(cs);
+            if (pubKeyShare.IsValid()) {
+                cache.insert(key, pubKeyShare);
+            }
+            mapInFlight.erase(key);
+        }
+        promise.set_value(pubKeyShare);
+        return pubKeyShare;
+    }
+};
+
 /**
  * An object of this class represents a quorum which was mined on-chain (through a quorum commitment)
  * It at least contains information about the members and the quorum public key which is needed to verify recovered
@@ -159,9 +233,11 @@ public:
     CBLSSecretKey skShare;
 
 private:
-    // Recovery of public key shares is very slow, so we start a background thread that pre-populates a cache so that
-    // the public key shares are ready when needed later
-    mutable CBLSWorkerCache blsCache;
+    // Recovery of public key shares is very slow, so we start a background thread that pre-populates the shared
+    // public key share cache so that the public key shares are ready when needed later
+    CBLSWorker& blsWorker;
+    // Identifies the quorum in evoDB and in the public key share cache
+    uint256 quorumKey;
     mutable std::atomic<bool> fQuorumDataRecoveryThreadRunning{false};
 
 public:
@@ -179,9 +255,15 @@ public:
     CBLSPublicKey GetPubKeyShare(size_t memberIdx) const;
     const CBLSSecretKey& GetSkShare() const;
 
+    // Persist the recovered public key shares so that they don't have to be recovered again after a restart. Reading
+    // them back checks them against the members and the quorum vvec and puts them into the shared cache.
+    void WritePubKeyShares(CEvoDB& evoDb) const;
+    bool ReadPubKeyShares(CEvoDB& evoDb) const;
+
 private:
     void WriteContributions(CEvoDB& evoDb);
     bool ReadContributions(CEvoDB& evoDb);
+    bool CheckPubKeyShares(const std::vector<CBLSPublicKey>& vecShares) const;
 };
 
 /**
@@ -243,6 +325,7 @@ private:
 
     void StartCachePopulatorThread(const CQuorumCPtr pQuorum) const;
     void StartQuorumDataRecoveryThread(const CQuorumCPtr pQuorum, const CBlockIndex* pIndex, uint16_t nDataMask) const;
+    void CleanupOldPubKeyShares(const CBlockIndex* pIndex) const;
 };
 
 extern CQuorumManager* quorumManager;
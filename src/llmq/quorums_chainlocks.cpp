@@ -8,6 +8,7 @@
 
 #include <chain.h>
 #include <masternode/masternode-sync.h>
+#include <metrics.h>
 #include <net_processing.h>
 #include <scheduler.h>
 #include <spork.h>
@@ -359,6 +360,7 @@ void CChainLocksHandler::TrySignChainTip()
         lastSignedHeight = pindex->nHeight;
         lastSignedRequestId = requestId;
         lastSignedMsgHash = msgHash;
+        lastSignedTime = GetLatencyTimeMicros();
     }
 
     quorumSigningManager->AsyncSignIfMember(Params().GetConsensus().llmqTypeChainLocks, requestId, msgHash);
@@ -594,6 +596,9 @@ void CChainLocksHandler::HandleNewRecoveredSig(const llmq::CRecoveredSig& recove
         clsig.nHeight = lastSignedHeight;
         clsig.blockHash = lastSignedMsgHash;
         clsig.sig = recoveredSig.sig.Get();
+
+        static CLatencyHistogram& histSign = g_metrics.GetHistogram("llmq.chainlocks.sign");
+        histSign.Record(GetLatencyTimeMicros() - lastSignedTime);
     }
     ProcessNewChainLock(-1, clsig, ::SerializeHash(clsig));
 }
@@ -72,6 +72,8 @@ private:
     int32_t lastSignedHeight{-1};
     uint256 lastSignedRequestId;
     uint256 lastSignedMsgHash;
+    //! When we started signing lastSignedMsgHash, in GetLatencyTimeMicros()
+    int64_t lastSignedTime{0};
 
     // We keep track of txids from recently received blocks so that we can check if all TXs got islocked
     typedef std::unordered_map<uint256, std::shared_ptr<std::unordered_set<uint256, StaticSaltedHasher>>> BlockTxs;
@@ -89,6 +89,15 @@ CDKGMember::CDKGMember(CDeterministicMNCPtr _dmn, size_t _idx) :
 
 }
 
+CDKGSession::~CDKGSession()
+{
+    // the worker pool still references the vvecs and contributions of unfinished verifications
+    LOCK(cs_pending);
+    for (auto& batch : verifyingContributions) {
+        batch.result.wait();
+    }
+}
+
 bool CDKGSession::Init(const CBlockIndex* _pindexQuorum, const std::vector<CDeterministicMNCPtr>& mns, const uint256& _myProTxHash)
 {
     pindexQuorum = _pindexQuorum;
@@ -312,8 +321,6 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 
     logger.Batch("received and relayed contribution. received=%d/%d, time=%d", receivedCount, members.size(), t1.count());
 
-    cxxtimer::Timer t2(true);
-
     if (!AreWeMember()) {
         // can't further validate
         return;
@@ -321,17 +328,8 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 
     dkgManager.WriteVerifiedVvecContribution(params.type, pindexQuorum, qc.proTxHash, qc.vvec);
 
-    bool complain = false;
-    CBLSSecretKey skContribution;
-    if (!qc.contributions->Decrypt(myIdx, *activeMasternodeInfo.blsKeyOperator, skContribution, PROTOCOL_VERSION)) {
-        logger.Batch("contribution from %s could not be decrypted", member->dmn->proTxHash.ToString());
-        complain = true;
-    } else if (member->idx != myIdx && ShouldSimulateError("complain-lie")) {
+    if (member->idx != myIdx && ShouldSimulateError("complain-lie")) {
         logger.Batch("lying/complaining for %s", member->dmn->proTxHash.ToString());
-        complain = true;
-    }
-
-    if (complain) {
         member->weComplain = true;
         quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, member->idx, [&](CDKGDebugMemberStatus& status) {
             status.weComplain = true;
@@ -340,17 +338,10 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
         return;
     }
 
-    logger.Batch("decrypted our contribution share. time=%d", t2.count());
-
-    bool verifyPending = false;
-    receivedSkContributions[member->idx] = skContribution;
+    // our share is decrypted on the worker pool while we continue with the next messages
     vecEncryptedContributions[member->idx] = qc.contributions;
-    pendingContributionVerifications.emplace_back(member->idx);
+    pendingContributionVerifications.emplace_back(member->idx, blsWorker.AsyncDecryptContribution(qc.contributions, myIdx, *activeMasternodeInfo.blsKeyOperator, PROTOCOL_VERSION));
     if (pendingContributionVerifications.size() >= 32) {
-        verifyPending = true;
-    }
-
-    if (verifyPending) {
         VerifyPendingContributions();
     }
 }
@@ -360,6 +351,8 @@ void CDKGSession::ReceiveMessage(const CDKGContribution& qc, bool& retBan)
 // The resulting aggregated vvec is then used to recover a public key share
 // The public key share must match the public key belonging to the aggregated secret key contributions
 // See CBLSWorker::VerifyContributionShares for more details.
+// The verification runs on the worker pool, so that multiple batches are verified in parallel while new contributions
+// are still received and decrypted. The results are handled in ProcessVerifiedContributions
 void CDKGSession::VerifyPendingContributions()
 {
     AssertLockHeld(cs_pending);
@@ -368,50 +361,88 @@ void CDKGSession::VerifyPendingContributions()
 
     cxxtimer::Timer t1(true);
 
-    std::vector<size_t> pend = std::move(pendingContributionVerifications);
+    auto pend = std::move(pendingContributionVerifications);
+    pendingContributionVerifications.clear();
     if (pend.empty()) {
+        ProcessVerifiedContributions(false);
         return;
     }
 
-    std::vector<size_t> memberIndexes;
-    std::vector<BLSVerificationVectorPtr> vvecs;
-    BLSSecretKeyVector skContributions;
-
-    for (const auto& idx : pend) {
+    ContributionVerificationBatch batch;
+    for (auto& p : pend) {
+        const size_t idx = p.first;
         auto& m = members[idx];
+        CBLSSecretKey skContribution = p.second.get();
+        if (!skContribution.IsValid()) {
+            logger.Batch("contribution from %s could not be decrypted", m->dmn->proTxHash.ToString());
+            m->weComplain = true;
+            quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
+                status.weComplain = true;
+                return true;
+            });
+            continue;
+        }
+        receivedSkContributions[idx] = skContribution;
+
         if (m->bad || m->weComplain) {
             continue;
         }
-        memberIndexes.emplace_back(idx);
-        vvecs.emplace_back(receivedVvecs[idx]);
-        skContributions.emplace_back(receivedSkContributions[idx]);
+        batch.memberIndexes.emplace_back(idx);
+        batch.vvecs.emplace_back(receivedVvecs[idx]);
+        batch.skContributions.emplace_back(skContribution);
         // Write here to definitely store one contribution for each member no matter if
         // our share is valid or not, could be that others are still correct
         dkgManager.WriteEncryptedContributions(params.type, pindexQuorum, m->dmn->proTxHash, *vecEncryptedContributions[idx]);
     }
 
-    auto result = blsWorker.VerifyContributionShares(myId, vvecs, skContributions);
-    if (result.size() != memberIndexes.size()) {
-        logger.Batch("VerifyContributionShares returned result of size %d but size %d was expected, something is wrong", result.size(), memberIndexes.size());
-        return;
+    logger.Batch("decrypted %d pending contributions, verifying %d. time=%d", pend.size(), batch.memberIndexes.size(), t1.count());
+
+    if (!batch.memberIndexes.empty()) {
+        verifyingContributions.emplace_back(std::move(batch));
+        auto& b = verifyingContributions.back();
+        b.result = blsWorker.AsyncVerifyContributionShares(myId, b.vvecs, b.skContributions, true, true);
     }
 
-    for (size_t i = 0; i < memberIndexes.size(); i++) {
-        if (!result[i]) {
-            auto& m = members[memberIndexes[i]];
-            logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
-            m->weComplain = true;
-            quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
-                status.weComplain = true;
-                return true;
-            });
-        } else {
-            size_t memberIdx = memberIndexes[i];
-            dkgManager.WriteVerifiedSkContribution(params.type, pindexQuorum, members[memberIdx]->dmn->proTxHash, skContributions[i]);
+    ProcessVerifiedContributions(false);
+}
+
+// Handles the results of finished batches from VerifyPendingContributions. Waits for all batches if fWait is set
+void CDKGSession::ProcessVerifiedContributions(bool fWait)
+{
+    AssertLockHeld(cs_pending);
+
+    CDKGLogger logger(*this, __func__);
+
+    while (!verifyingContributions.empty()) {
+        auto& batch = verifyingContributions.front();
+        if (!fWait && batch.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            break;
         }
-    }
 
-    logger.Batch("verified %d pending contributions. time=%d", pend.size(), t1.count());
+        auto result = batch.result.get();
+        if (result.size() != batch.memberIndexes.size()) {
+            logger.Batch("VerifyContributionShares returned result of size %d but size %d was expected, something is wrong", result.size(), batch.memberIndexes.size());
+            verifyingContributions.pop_front();
+            continue;
+        }
+
+        for (size_t i = 0; i < batch.memberIndexes.size(); i++) {
+            auto& m = members[batch.memberIndexes[i]];
+            if (!result[i]) {
+                logger.Batch("invalid contribution from %s. will complain later", m->dmn->proTxHash.ToString());
+                m->weComplain = true;
+                quorumDKGDebugManager->UpdateLocalMemberStatus(params.type, m->idx, [&](CDKGDebugMemberStatus& status) {
+                    status.weComplain = true;
+                    return true;
+                });
+            } else {
+                dkgManager.WriteVerifiedSkContribution(params.type, pindexQuorum, m->dmn->proTxHash, batch.skContributions[i]);
+            }
+        }
+
+        logger.Batch("verified %d pending contributions", batch.memberIndexes.size());
+        verifyingContributions.pop_front();
+    }
 }
 
 void CDKGSession::VerifyAndComplain(CDKGPendingMessages& pendingMessages)
@@ -423,6 +454,7 @@ void CDKGSession::VerifyAndComplain(CDKGPendingMessages& pendingMessages)
     {
         LOCK(cs_pending);
         VerifyPendingContributions();
+        ProcessVerifiedContributions(true);
     }
 
     CDKGLogger logger(*this, __func__);
@@ -279,8 +279,19 @@ private:
     std::map<uint256, CDKGJustification> justifications;
     std::map<uint256, CDKGPrematureCommitment> prematureCommitments;
 
+    // A batch of contributions which is being verified on the worker pool. The worker references the vvecs and
+    // contributions while verifying, so these must stay alive until the result is ready
+    struct ContributionVerificationBatch {
+        std::vector<size_t> memberIndexes;
+        std::vector<BLSVerificationVectorPtr> vvecs;
+        BLSSecretKeyVector skContributions;
+        std::future<std::vector<bool>> result;
+    };
+
     mutable CCriticalSection cs_pending;
-    std::vector<size_t> pendingContributionVerifications;
+    // member index and our (still decrypting) contribution share
+    std::vector<std::pair<size_t, std::future<CBLSSecretKey>>> pendingContributionVerifications;
+    std::list<ContributionVerificationBatch> verifyingContributions;
 
     // filled by ReceivePrematureCommitment and used by FinalizeCommitments
     std::set<uint256> validCommitments;
@@ -288,6 +299,7 @@ private:
 public:
     CDKGSession(const Consensus::LLMQParams& _params, CBLSWorker& _blsWorker, CDKGSessionManager& _dkgManager) :
         params(_params), blsWorker(_blsWorker), cache(_blsWorker), dkgManager(_dkgManager) {}
+    ~CDKGSession();
 
     bool Init(const CBlockIndex* pindexQuorum, const std::vector<CDeterministicMNCPtr>& mns, const uint256& _myProTxHash);
 
@@ -312,6 +324,7 @@ public:
     bool PreVerifyMessage(const CDKGContribution& qc, bool& retBan) const;
     void ReceiveMessage(const CDKGContribution& qc, bool& retBan);
     void VerifyPendingContributions();
+    void ProcessVerifiedContributions(bool fWait);
 
     // Phase 2: complaint
     void VerifyAndComplain(CDKGPendingMessages& pendingMessages);
@@ -10,6 +10,7 @@
 
 #include <masternode/activemasternode.h>
 #include <chainparams.h>
+#include <metrics.h>
 #include <net_processing.h>
 #include <spork.h>
 
@@ -309,6 +310,18 @@ void CDKGSessionHandler::SleepBeforePhase(QuorumPhase curPhase,
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s - done, curPhase=%d\n", __func__, params.name, curPhase);
 }
 
+static const char* GetPhaseMetricName(QuorumPhase phase)
+{
+    switch (phase) {
+    case QuorumPhase_Contribute: return "contribute";
+    case QuorumPhase_Complain: return "complain";
+    case QuorumPhase_Justify: return "justify";
+    case QuorumPhase_Commit: return "commit";
+    case QuorumPhase_Finalize: return "finalize";
+    default: return "other";
+    }
+}
+
 void CDKGSessionHandler::HandlePhase(QuorumPhase curPhase,
                                      QuorumPhase nextPhase,
                                      const uint256& expectedQuorumHash,
@@ -319,7 +332,10 @@ void CDKGSessionHandler::HandlePhase(QuorumPhase curPhase,
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s - starting, curPhase=%d, nextPhase=%d\n", __func__, params.name, curPhase, nextPhase);
 
     SleepBeforePhase(curPhase, expectedQuorumHash, randomSleepFactor, runWhileWaiting);
-    startPhaseFunc();
+    {
+        CLatencyTimer timer(g_metrics.GetHistogram(strprintf("llmq.dkg.%s.%s", params.name, GetPhaseMetricName(curPhase))));
+        startPhaseFunc();
+    }
     WaitForNextPhase(curPhase, nextPhase, expectedQuorumHash, runWhileWaiting);
 
     LogPrint(BCLog::LLMQ_DKG, "CDKGSessionManager::%s -- %s - done, curPhase=%d, nextPhase=%d\n", __func__, params.name, curPhase, nextPhase);
@@ -564,6 +580,7 @@ void CDKGSessionHandler::HandleDKGRound()
     };
     HandlePhase(QuorumPhase_Commit, QuorumPhase_Finalize, curQuorumHash, 0.1, fCommitStart, fCommitWait);
 
+    CLatencyTimer finalizeTimer(g_metrics.GetHistogram(strprintf("llmq.dkg.%s.%s", params.name, GetPhaseMetricName(QuorumPhase_Finalize))));
     auto finalCommitments = curSession->FinalizeCommitments();
     for (const auto& fqc : finalCommitments) {
         quorumBlockProcessor->AddMinableCommitment(fqc);
@@ -10,6 +10,7 @@
 #include <chainparams.h>
 #include <txmempool.h>
 #include <masternode/masternode-sync.h>
+#include <metrics.h>
 #include <net_processing.h>
 #include <spork.h>
 #include <validation.h>
@@ -86,21 +87,29 @@ void CInstantSendDb::Upgrade()
     }
 }
 
-void CInstantSendDb::WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock)
+// Only adds the lock to the batch, it becomes visible through CommitNewInstantSendLocks
+void CInstantSendDb::WriteNewInstantSendLock(CDBBatch& batch, const uint256& hash, const CInstantSendLockPtr& islock)
 {
-    CDBBatch batch(db);
-    batch.Write(std::make_tuple(std::string(DB_ISLOCK_BY_HASH), hash), islock);
-    batch.Write(std::make_tuple(std::string(DB_HASH_BY_TXID), islock.txid), hash);
-    for (auto& in : islock.inputs) {
+    batch.Write(std::make_tuple(std::string(DB_ISLOCK_BY_HASH), hash), *islock);
+    batch.Write(std::make_tuple(std::string(DB_HASH_BY_TXID), islock->txid), hash);
+    for (auto& in : islock->inputs) {
         batch.Write(std::make_tuple(std::string(DB_HASH_BY_OUTPOINT), in), hash);
     }
+}
+
+void CInstantSendDb::CommitNewInstantSendLocks(CDBBatch& batch, const std::vector<std::pair<uint256, CInstantSendLockPtr>>& vecLocks)
+{
+    // WriteBatch throws if the write fails, so the caches never contain locks which are not on disk
     db.WriteBatch(batch);
 
-    auto p = std::make_shared<CInstantSendLock>(islock);
-    islockCache.insert(hash, p);
-    txidCache.insert(islock.txid, hash);
-    for (auto& in : islock.inputs) {
-        outpointCache.insert(in, hash);
+    for (const auto& p : vecLocks) {
+        auto& hash = p.first;
+        auto& islock = p.second;
+        islockCache.insert(hash, islock);
+        txidCache.insert(islock->txid, hash);
+        for (auto& in : islock->inputs) {
+            outpointCache.insert(in, hash);
+        }
     }
 }
 
@@ -133,13 +142,6 @@ static std::tuple<std::string, uint32_t, uint256> BuildInversedISLockKey(const s
     return std::make_tuple(k, htobe32(std::numeric_limits<uint32_t>::max() - nHeight), islockHash);
 }
 
-void CInstantSendDb::WriteInstantSendLockMined(const uint256& hash, int nHeight)
-{
-    CDBBatch batch(db);
-    WriteInstantSendLockMined(batch, hash, nHeight);
-    db.WriteBatch(batch);
-}
-
 void CInstantSendDb::WriteInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight)
 {
     batch.Write(BuildInversedISLockKey(DB_MINED_BY_HEIGHT_AND_HASH, nHeight, hash), true);
@@ -773,7 +775,7 @@ void CInstantSendManager::ProcessMessageInstantSendLock(CNode* pfrom, const llmq
     LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: received islock, peer=%d\n", __func__,
             islock->txid.ToString(), hash.ToString(), pfrom->GetId());
 
-    pendingInstantSendLocks.emplace(hash, std::make_pair(pfrom->GetId(), islock));
+    pendingInstantSendLocks.emplace(hash, PendingInstantSendLock{pfrom->GetId(), islock, GetLatencyTimeMicros()});
 }
 
 /**
@@ -851,7 +853,7 @@ bool CInstantSendManager::ProcessPendingInstantSendLocks()
     return fMoreWork;
 }
 
-std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(int signOffset, const std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher>& pend, bool ban)
+std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(int signOffset, const PendingInstantSendLocks& pend, bool ban)
 {
     auto llmqType = Params().GetConsensus().llmqTypeInstantSend;
 
@@ -862,8 +864,8 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
     size_t alreadyVerified = 0;
     for (const auto& p : pend) {
         auto& hash = p.first;
-        auto nodeId = p.second.first;
-        auto& islock = p.second.second;
+        auto nodeId = p.second.nodeId;
+        auto& islock = p.second.islock;
 
         if (batchVerifier.badSources.count(nodeId)) {
             continue;
@@ -905,14 +907,19 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
         }
     }
 
+    static CLatencyHistogram& histVerify = g_metrics.GetHistogram("llmq.islock.verify");
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    {
+        CLatencyTimer timer(histVerify);
+        batchVerifier.Verify();
+    }
     verifyTimer.stop();
 
     LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- verified locks. count=%d, alreadyVerified=%d, vt=%d, nodes=%d\n", __func__,
             verifyCount, alreadyVerified, verifyTimer.count(), batchVerifier.GetUniqueSourceCount());
 
     std::unordered_set<uint256> badISLocks;
+    std::vector<std::pair<uint256, PendingInstantSendLock>> vecValidLocks;
 
     if (ban && !batchVerifier.badSources.empty()) {
         LOCK(cs_main);
@@ -924,8 +931,8 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
     }
     for (const auto& p : pend) {
         auto& hash = p.first;
-        auto nodeId = p.second.first;
-        auto& islock = p.second.second;
+        auto nodeId = p.second.nodeId;
+        auto& islock = p.second.islock;
 
         if (batchVerifier.badMessages.count(hash)) {
             LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: invalid sig in islock, peer=%d\n", __func__,
@@ -934,7 +941,15 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
             continue;
         }
 
-        ProcessInstantSendLock(nodeId, hash, islock);
+        vecValidLocks.emplace_back(p);
+    }
+
+    ProcessInstantSendLocks(vecValidLocks);
+
+    for (const auto& p : vecValidLocks) {
+        auto& hash = p.first;
+        auto nodeId = p.second.nodeId;
+        auto& islock = p.second.islock;
 
         // See comment further on top. We pass a reconstructed recovered sig to the signing manager to avoid
         // double-verification of the sig.
@@ -955,84 +970,138 @@ std::unordered_set<uint256> CInstantSendManager::ProcessPendingInstantSendLocks(
 
 void CInstantSendManager::ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock)
 {
-    {
-        LOCK(cs);
-
-        LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: processsing islock, peer=%d\n", __func__,
-                 islock->txid.ToString(), hash.ToString(), from);
+    ProcessInstantSendLocks({{hash, PendingInstantSendLock{from, islock, 0}}});
+}
 
-        creatingInstantSendLocks.erase(islock->GetRequestId());
-        txToCreatingInstantSendLocks.erase(islock->txid);
+/**
+ * Processes verified islocks in stages, so that a burst of islocks doesn't take cs and write to the DB for each of them:
+ * 1. Drop locks which are already known or ChainLocked, without holding cs
+ * 2. Write all remaining locks in a single DB batch and update the non-locked TXs while holding cs once. The locks
+ *    are only added to the DB caches after the batch was written
+ * 3. Relay the locks and resolve conflicts in the mempool and blocks
+ */
+void CInstantSendManager::ProcessInstantSendLocks(const std::vector<std::pair<uint256, PendingInstantSendLock>>& vecLocks)
+{
+    struct AcceptedLock {
+        const uint256& hash;
+        const PendingInstantSendLock& pending;
+        CTransactionRef tx;
+        const CBlockIndex* pindexMined;
+    };
+    std::vector<AcceptedLock> vecAccepted;
 
-        if (db.KnownInstantSendLock(hash)) {
-            return;
-        }
-    }
+    for (const auto& p : vecLocks) {
+        auto& hash = p.first;
+        auto from = p.second.nodeId;
+        auto& islock = p.second.islock;
 
-    CTransactionRef tx;
-    uint256 hashBlock;
-    const CBlockIndex* pindexMined{nullptr};
-    // we ignore failure here as we must be able to propagate the lock even if we don't have the TX locally
-    if (GetTransaction(islock->txid, tx, Params().GetConsensus(), hashBlock) && !hashBlock.IsNull()) {
         {
-            LOCK(cs_main);
-            pindexMined = LookupBlockIndex(hashBlock);
+            LOCK(cs);
+
+            LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txid=%s, islock=%s: processsing islock, peer=%d\n", __func__,
+                     islock->txid.ToString(), hash.ToString(), from);
+
+            creatingInstantSendLocks.erase(islock->GetRequestId());
+            txToCreatingInstantSendLocks.erase(islock->txid);
+
+            if (db.KnownInstantSendLock(hash)) {
+                continue;
+            }
         }
 
-        // Let's see if the TX that was locked by this islock is already mined in a ChainLocked block. If yes,
-        // we can simply ignore the islock, as the ChainLock implies locking of all TXs in that chain
-        if (pindexMined != nullptr && llmq::chainLocksHandler->HasChainLock(pindexMined->nHeight, pindexMined->GetBlockHash())) {
-            LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n", __func__,
-                     islock->txid.ToString(), hash.ToString(), hashBlock.ToString(), from);
-            return;
+        CTransactionRef tx;
+        uint256 hashBlock;
+        const CBlockIndex* pindexMined{nullptr};
+        // we ignore failure here as we must be able to propagate the lock even if we don't have the TX locally
+        if (GetTransaction(islock->txid, tx, Params().GetConsensus(), hashBlock) && !hashBlock.IsNull()) {
+            {
+                LOCK(cs_main);
+                pindexMined = LookupBlockIndex(hashBlock);
+            }
+
+            // Let's see if the TX that was locked by this islock is already mined in a ChainLocked block. If yes,
+            // we can simply ignore the islock, as the ChainLock implies locking of all TXs in that chain
+            if (pindexMined != nullptr && llmq::chainLocksHandler->HasChainLock(pindexMined->nHeight, pindexMined->GetBlockHash())) {
+                LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- txlock=%s, islock=%s: dropping islock as it already got a ChainLock in block %s, peer=%d\n", __func__,
+                         islock->txid.ToString(), hash.ToString(), hashBlock.ToString(), from);
+                continue;
+            }
         }
+
+        vecAccepted.push_back(AcceptedLock{hash, p.second, tx, pindexMined});
+    }
+
+    if (vecAccepted.empty()) {
+        return;
     }
 
     {
         LOCK(cs);
-        CInstantSendLockPtr otherIsLock = db.GetInstantSendLockByTxid(islock->txid);
-        if (otherIsLock != nullptr) {
-            LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: duplicate islock, other islock=%s, peer=%d\n", __func__,
-                     islock->txid.ToString(), hash.ToString(), ::SerializeHash(*otherIsLock).ToString(), from);
-        }
-        for (auto& in : islock->inputs) {
-            otherIsLock = db.GetInstantSendLockByInput(in);
+        CDBBatch batch(db.GetRawDB());
+        std::vector<std::pair<uint256, CInstantSendLockPtr>> vecNewLocks;
+        vecNewLocks.reserve(vecAccepted.size());
+        for (const auto& l : vecAccepted) {
+            auto& islock = l.pending.islock;
+
+            CInstantSendLockPtr otherIsLock = db.GetInstantSendLockByTxid(islock->txid);
             if (otherIsLock != nullptr) {
-                LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: conflicting input in islock. input=%s, other islock=%s, peer=%d\n", __func__,
-                         islock->txid.ToString(), hash.ToString(), in.ToStringShort(), ::SerializeHash(*otherIsLock).ToString(), from);
+                LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: duplicate islock, other islock=%s, peer=%d\n", __func__,
+                         islock->txid.ToString(), l.hash.ToString(), ::SerializeHash(*otherIsLock).ToString(), l.pending.nodeId);
+            }
+            for (auto& in : islock->inputs) {
+                otherIsLock = db.GetInstantSendLockByInput(in);
+                if (otherIsLock != nullptr) {
+                    LogPrintf("CInstantSendManager::%s -- txid=%s, islock=%s: conflicting input in islock. input=%s, other islock=%s, peer=%d\n", __func__,
+                             islock->txid.ToString(), l.hash.ToString(), in.ToStringShort(), ::SerializeHash(*otherIsLock).ToString(), l.pending.nodeId);
+                }
             }
-        }
 
-        db.WriteNewInstantSendLock(hash, *islock);
-        if (pindexMined) {
-            db.WriteInstantSendLockMined(hash, pindexMined->nHeight);
+            db.WriteNewInstantSendLock(batch, l.hash, islock);
+            if (l.pindexMined) {
+                db.WriteInstantSendLockMined(batch, l.hash, l.pindexMined->nHeight);
+            }
+            vecNewLocks.emplace_back(l.hash, islock);
         }
+        db.CommitNewInstantSendLocks(batch, vecNewLocks);
 
-        // This will also add children TXs to pendingRetryTxs
-        RemoveNonLockedTx(islock->txid, true);
+        for (const auto& l : vecAccepted) {
+            // This will also add children TXs to pendingRetryTxs
+            RemoveNonLockedTx(l.pending.islock->txid, true);
 
-        // We don't need the recovered sigs for the inputs anymore. This prevents unnecessary propagation of these sigs.
-        // We only need the ISLOCK from now on to detect conflicts
-        TruncateRecoveredSigsForInputs(*islock);
+            // We don't need the recovered sigs for the inputs anymore. This prevents unnecessary propagation of these sigs.
+            // We only need the ISLOCK from now on to detect conflicts
+            TruncateRecoveredSigsForInputs(*l.pending.islock);
+        }
     }
 
-    CInv inv(MSG_ISLOCK, hash);
-    if (tx != nullptr) {
-        g_connman->RelayInvFiltered(inv, *tx, LLMQS_PROTO_VERSION);
-    } else {
-        // we don't have the TX yet, so we only filter based on txid. Later when that TX arrives, we will re-announce
-        // with the TX taken into account.
-        g_connman->RelayInvFiltered(inv, islock->txid, LLMQS_PROTO_VERSION);
-    }
+    static CLatencyHistogram& histLatency = g_metrics.GetHistogram("llmq.islock.latency");
+    const int64_t nTimeLocked = GetLatencyTimeMicros();
 
-    ResolveBlockConflicts(hash, *islock);
-    RemoveMempoolConflictsForLock(hash, *islock);
+    for (const auto& l : vecAccepted) {
+        auto& islock = l.pending.islock;
 
-    if (tx != nullptr) {
-        LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- notify about an in-time lock for tx %s\n", __func__, tx->GetHash().ToString());
-        GetMainSignals().NotifyTransactionLock(tx, islock);
-        // bump mempool counter to make sure newly locked txes are picked up by getblocktemplate
-        mempool.AddTransactionsUpdated(1);
+        if (l.pending.nTimeReceived != 0) {
+            histLatency.Record(nTimeLocked - l.pending.nTimeReceived);
+        }
+
+        CInv inv(MSG_ISLOCK, l.hash);
+        if (l.tx != nullptr) {
+            g_connman->RelayInvFiltered(inv, *l.tx, LLMQS_PROTO_VERSION);
+        } else {
+            // we don't have the TX yet, so we only filter based on txid. Later when that TX arrives, we will re-announce
+            // with the TX taken into account.
+            g_connman->RelayInvFiltered(inv, islock->txid, LLMQS_PROTO_VERSION);
+        }
+
+        ResolveBlockConflicts(l.hash, *islock);
+        RemoveMempoolConflictsForLock(l.hash, *islock);
+
+        if (l.tx != nullptr) {
+            LogPrint(BCLog::INSTANTSEND, "CInstantSendManager::%s -- notify about an in-time lock for tx %s\n", __func__, l.tx->GetHash().ToString());
+            GetMainSignals().NotifyTransactionLock(l.tx, islock);
+            // bump mempool counter to make sure newly locked txes are picked up by getblocktemplate
+            mempool.AddTransactionsUpdated(1);
+        }
     }
 }
 
@@ -51,18 +51,20 @@ private:
     mutable unordered_lru_cache<uint256, uint256, StaticSaltedHasher, 10000> txidCache;
     mutable unordered_lru_cache<COutPoint, uint256, SaltedOutpointHasher, 10000> outpointCache;
 
-    void WriteInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight);
     void RemoveInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight);
 
 public:
     explicit CInstantSendDb(CDBWrapper& _db);
 
+    CDBWrapper& GetRawDB() { return db; }
+
     void Upgrade();
 
-    void WriteNewInstantSendLock(const uint256& hash, const CInstantSendLock& islock);
+    void WriteNewInstantSendLock(CDBBatch& batch, const uint256& hash, const CInstantSendLockPtr& islock);
+    void CommitNewInstantSendLocks(CDBBatch& batch, const std::vector<std::pair<uint256, CInstantSendLockPtr>>& vecLocks);
     void RemoveInstantSendLock(CDBBatch& batch, const uint256& hash, CInstantSendLockPtr islock, bool keep_cache = true);
 
-    void WriteInstantSendLockMined(const uint256& hash, int nHeight);
+    void WriteInstantSendLockMined(CDBBatch& batch, const uint256& hash, int nHeight);
     static void WriteInstantSendLockArchived(CDBBatch& batch, const uint256& hash, int nHeight);
     std::unordered_map<uint256, CInstantSendLockPtr> RemoveConfirmedInstantSendLocks(int nUntilHeight);
     void RemoveArchivedInstantSendLocks(int nUntilHeight);
@@ -106,8 +108,16 @@ private:
     // maps from txid to the in-progress islock
     std::unordered_map<uint256, CInstantSendLock*, StaticSaltedHasher> txToCreatingInstantSendLocks;
 
+    struct PendingInstantSendLock {
+        NodeId nodeId;
+        CInstantSendLockPtr islock;
+        // GetLatencyTimeMicros() when the islock was received, 0 for our own islocks
+        int64_t nTimeReceived;
+    };
+    typedef std::unordered_map<uint256, PendingInstantSendLock, StaticSaltedHasher> PendingInstantSendLocks;
+
     // Incoming and not verified yet
-    std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher> pendingInstantSendLocks;
+    PendingInstantSendLocks pendingInstantSendLocks;
 
     // TXs which are neither IS locked nor ChainLocked. We use this to determine for which TXs we need to retry IS locking
     // of child TXs
@@ -148,8 +158,9 @@ public:
     void ProcessMessageInstantSendLock(CNode* pfrom, const CInstantSendLockPtr& islock);
     static bool PreVerifyInstantSendLock(const CInstantSendLock& islock);
     bool ProcessPendingInstantSendLocks();
-    std::unordered_set<uint256> ProcessPendingInstantSendLocks(int signOffset, const std::unordered_map<uint256, std::pair<NodeId, CInstantSendLockPtr>, StaticSaltedHasher>& pend, bool ban);
+    std::unordered_set<uint256> ProcessPendingInstantSendLocks(int signOffset, const PendingInstantSendLocks& pend, bool ban);
     void ProcessInstantSendLock(NodeId from, const uint256& hash, const CInstantSendLockPtr& islock);
+    void ProcessInstantSendLocks(const std::vector<std::pair<uint256, PendingInstantSendLock>>& vecLocks);
 
     void TransactionAddedToMempool(const CTransactionRef& tx);
     void TransactionRemovedFromMempool(const CTransactionRef& tx);
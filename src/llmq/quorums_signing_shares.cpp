@@ -8,7 +8,9 @@
 
 #include <masternode/activemasternode.h>
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_worker.h>
 #include <init.h>
+#include <metrics.h>
 #include <net_processing.h>
 #include <netmessagemaker.h>
 #include <spork.h>
@@ -182,7 +184,8 @@ void CSigSharesNodeState::RemoveSession(const uint256& signHash)
 
 //////////////////////
 
-CSigSharesManager::CSigSharesManager()
+CSigSharesManager::CSigSharesManager(CBLSWorker& _blsWorker) :
+    blsWorker(_blsWorker)
 {
     workInterrupt.reset();
 }
@@ -572,8 +575,29 @@ bool CSigSharesManager::PreVerifyBatchedSigShares(const CSigSharesNodeState::Ses
     return true;
 }
 
+size_t CSigSharesManager::GetPendingSigSharesCount()
+{
+    LOCK(cs);
+    size_t count = 0;
+    for (const auto& p : nodeStates) {
+        count += p.second.pendingIncomingSigShares.Size();
+    }
+    return count;
+}
+
+size_t CSigSharesManager::GetSigSharesVerifyBatchSize(size_t pendingCount) const
+{
+    size_t maxBatchSize = MAX_SIG_SHARES_VERIFY_BATCH;
+    if (verifyMicrosPerShare > 0) {
+        maxBatchSize = (size_t)(SIG_SHARES_VERIFY_TARGET_LATENCY * 1000 / verifyMicrosPerShare);
+    }
+    // small queues are verified in one go, large ones in batches which still finish within the target latency
+    maxBatchSize = std::max(MIN_SIG_SHARES_VERIFY_BATCH, std::min(maxBatchSize, MAX_SIG_SHARES_VERIFY_BATCH));
+    return std::min(std::max(pendingCount, MIN_SIG_SHARES_VERIFY_BATCH), maxBatchSize);
+}
+
 void CSigSharesManager::CollectPendingSigSharesToVerify(
-        size_t maxUniqueSessions,
+        size_t maxSigShares,
         std::unordered_map<NodeId, std::vector<CSigShare>>& retSigShares,
         std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& retQuorums)
 {
@@ -589,9 +613,9 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
         // invalid, making batch verification fail and revert to per-share verification, which in turn would slow down
         // the whole verification process
 
-        std::unordered_set<std::pair<NodeId, uint256>, StaticSaltedHasher> uniqueSignHashes;
+        size_t sigSharesCount = 0;
         CLLMQUtils::IterateNodesRandom(nodeStates, [&]() {
-            return uniqueSignHashes.size() < maxUniqueSessions;
+            return sigSharesCount < maxSigShares;
         }, [&](NodeId nodeId, CSigSharesNodeState& ns) {
             if (ns.pendingIncomingSigShares.Empty()) {
                 return false;
@@ -600,7 +624,7 @@ void CSigSharesManager::CollectPendingSigSharesToVerify(
 
             bool alreadyHave = this->sigShares.Has(sigShare.GetKey());
             if (!alreadyHave) {
-                uniqueSignHashes.emplace(nodeId, sigShare.GetSignHash());
+                sigSharesCount++;
                 retSigShares[nodeId].emplace_back(sigShare);
             }
             ns.pendingIncomingSigShares.Erase(sigShare.GetKey());
@@ -639,15 +663,20 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
     std::unordered_map<NodeId, std::vector<CSigShare>> sigSharesByNodes;
     std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher> quorums;
 
-    const size_t nMaxBatchSize{32};
+    const size_t pendingCount = GetPendingSigSharesCount();
+    const size_t nMaxBatchSize = GetSigSharesVerifyBatchSize(pendingCount);
     CollectPendingSigSharesToVerify(nMaxBatchSize, sigSharesByNodes, quorums);
     if (sigSharesByNodes.empty()) {
         return false;
     }
 
+    // Shares are verified in jobs per quorum, which run in parallel on the BLS worker pool. A failing job is
+    // bisected by the batch verifier, so a few invalid shares do not cause per-share re-verification of all others.
     // It's ok to perform insecure batched verification here as we verify against the quorum public key shares,
     // which are not craftable by individual entities, making the rogue public key attack impossible
-    CBLSBatchVerifier<NodeId, SigShareKey> batchVerifier(false, true);
+    typedef CBLSBatchVerifier<NodeId, SigShareKey> BatchVerifier;
+    std::vector<std::unique_ptr<BatchVerifier>> batchVerifiers;
+    std::unordered_map<std::pair<Consensus::LLMQType, uint256>, std::pair<BatchVerifier*, size_t>, StaticSaltedHasher> verifierByQuorum;
 
     cxxtimer::Timer prepareTimer(true);
     size_t verifyCount = 0;
@@ -668,7 +697,8 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
                 break;
             }
 
-            auto quorum = quorums.at(std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash));
+            auto quorumKey = std::make_pair((Consensus::LLMQType)sigShare.llmqType, sigShare.quorumHash);
+            auto quorum = quorums.at(quorumKey);
             auto pubKeyShare = quorum->GetPubKeyShare(sigShare.quorumMember);
 
             if (!pubKeyShare.IsValid()) {
@@ -678,23 +708,56 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
                 assert(false);
             }
 
-            batchVerifier.PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
+            auto& job = verifierByQuorum[quorumKey];
+            if (job.first == nullptr || job.second >= MAX_SIG_SHARES_VERIFY_JOB) {
+                batchVerifiers.emplace_back(std::make_unique<BatchVerifier>(false, true));
+                job = std::make_pair(batchVerifiers.back().get(), 0);
+            }
+            job.first->PushMessage(nodeId, sigShare.GetKey(), sigShare.GetSignHash(), sigShare.sigShare.Get(), pubKeyShare);
+            job.second++;
             verifyCount++;
         }
     }
     prepareTimer.stop();
 
     cxxtimer::Timer verifyTimer(true);
-    batchVerifier.Verify();
+    std::set<NodeId> badSources;
+    if (batchVerifiers.size() == 1) {
+        // not worth the round trip through the worker pool
+        batchVerifiers[0]->Verify();
+    } else if (!batchVerifiers.empty()) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(batchVerifiers.size());
+        for (auto& batchVerifier : batchVerifiers) {
+            futures.emplace_back(blsWorker.AsyncVerifyBatch(*batchVerifier));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    }
+    for (auto& batchVerifier : batchVerifiers) {
+        badSources.insert(batchVerifier->badSources.begin(), batchVerifier->badSources.end());
+    }
     verifyTimer.stop();
 
-    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, pt=%d, vt=%d, nodes=%d\n", __func__, verifyCount, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
+    if (verifyCount != 0) {
+        double micros = (double)verifyTimer.count<std::chrono::microseconds>() / verifyCount;
+        verifyMicrosPerShare = verifyMicrosPerShare == 0 ? micros : (verifyMicrosPerShare * 7 + micros) / 8;
+
+        static CLatencyHistogram& histVerifyBatch = g_metrics.GetHistogram("llmq.sigshares.verify");
+        static CLatencyHistogram& histVerifyPerShare = g_metrics.GetHistogram("llmq.sigshares.verify_per_share");
+        histVerifyBatch.Record(verifyTimer.count<std::chrono::microseconds>());
+        histVerifyPerShare.Record((int64_t)micros);
+    }
+
+    LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- verified sig shares. count=%d, jobs=%d, pending=%d, maxBatch=%d, pt=%d, vt=%d, nodes=%d\n", __func__,
+             verifyCount, batchVerifiers.size(), pendingCount, nMaxBatchSize, prepareTimer.count(), verifyTimer.count(), sigSharesByNodes.size());
 
     for (auto& p : sigSharesByNodes) {
         auto nodeId = p.first;
         auto& v = p.second;
 
-        if (batchVerifier.badSources.count(nodeId)) {
+        if (badSources.count(nodeId)) {
             LogPrint(BCLog::LLMQ_SIGS, "CSigSharesManager::%s -- invalid sig shares from other node, banning peer=%d\n",
                      __func__, nodeId);
             // this will also cause re-requesting of the shares that were sent by this node
@@ -705,7 +768,7 @@ bool CSigSharesManager::ProcessPendingSigShares(CConnman& connman)
         ProcessPendingSigShares(v, quorums, connman);
     }
 
-    return sigSharesByNodes.size() >= nMaxBatchSize;
+    return pendingCount > nMaxBatchSize;
 }
 
 // It's ensured that no duplicates are passed to this method
@@ -22,6 +22,7 @@
 #include <unordered_map>
 #include <unordered_set>
 
+class CBLSWorker;
 class CEvoDB;
 class CScheduler;
 
@@ -368,9 +369,19 @@ class CSigSharesManager : public CRecoveredSigsListener
     const int64_t MAX_SEND_FOR_RECOVERY_TIMEOUT = 10000;
     const size_t MAX_MSGS_SIG_SHARES = 32;
 
+    // incoming sig shares are verified in batches which are sized by the number of pending shares and the measured
+    // verification time, so that a batch takes about SIG_SHARES_VERIFY_TARGET_LATENCY milliseconds
+    const int64_t SIG_SHARES_VERIFY_TARGET_LATENCY = 100;
+    const size_t MIN_SIG_SHARES_VERIFY_BATCH = 32;
+    const size_t MAX_SIG_SHARES_VERIFY_BATCH = 1024;
+    // batches are split per quorum into jobs of at most this many shares, which are verified in parallel
+    const size_t MAX_SIG_SHARES_VERIFY_JOB = 64;
+
 private:
     CCriticalSection cs;
 
+    CBLSWorker& blsWorker;
+
     std::thread workThread;
     CThreadInterrupt workInterrupt;
 
@@ -392,8 +403,11 @@ private:
     int64_t lastCleanupTime{0};
     std::atomic<uint32_t> recoveredSigsCounter{0};
 
+    // moving average of the time it took to verify a single sig share, only accessed by the worker thread
+    double verifyMicrosPerShare{0};
+
 public:
-    CSigSharesManager();
+    explicit CSigSharesManager(CBLSWorker& _blsWorker);
     ~CSigSharesManager();
 
     void StartWorkerThread();
@@ -424,7 +438,9 @@ private:
     static bool VerifySigSharesInv(Consensus::LLMQType llmqType, const CSigSharesInv& inv);
     static bool PreVerifyBatchedSigShares(const CSigSharesNodeState::SessionInfo& session, const CBatchedSigShares& batchedSigShares, bool& retBan);
 
-    void CollectPendingSigSharesToVerify(size_t maxUniqueSessions,
+    size_t GetPendingSigSharesCount();
+    size_t GetSigSharesVerifyBatchSize(size_t pendingCount) const;
+    void CollectPendingSigSharesToVerify(size_t maxSigShares,
             std::unordered_map<NodeId, std::vector<CSigShare>>& retSigShares,
             std::unordered_map<std::pair<Consensus::LLMQType, uint256>, CQuorumCPtr, StaticSaltedHasher>& retQuorums);
     bool ProcessPendingSigShares(CConnman& connman);
@@ -0,0 +1,168 @@
+// Copyright (c) 2022 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+CMetricsRegistry g_metrics;
+
+int64_t GetLatencyTimeMicros()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int CLatencyHistogram::GetBucket(int64_t nValue)
+{
+    if (nValue < 2 * SUB_BUCKETS) {
+        return std::max<int64_t>(nValue, 0);
+    }
+    int nBits = 0;
+    for (uint64_t v = nValue; v > 1; v >>= 1) {
+        nBits++;
+    }
+    if (nBits >= MAX_VALUE_BITS) {
+        return BUCKETS - 1;
+    }
+    const int nSubBucket = (nValue >> (nBits - SUB_BUCKETS_BITS)) & (SUB_BUCKETS - 1);
+    return 2 * SUB_BUCKETS + (nBits - SUB_BUCKETS_BITS - 1) * SUB_BUCKETS + nSubBucket;
+}
+
+int64_t CLatencyHistogram::GetBucketUpperBound(int nBucket)
+{
+    if (nBucket < 2 * SUB_BUCKETS) {
+        return nBucket;
+    }
+    if (nBucket >= BUCKETS - 1) {
+        return std::numeric_limits<int64_t>::max();
+    }
+    const int nBits = (nBucket - 2 * SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKETS_BITS + 1;
+    const int64_t nSubBucket = (nBucket - 2 * SUB_BUCKETS) % SUB_BUCKETS;
+    const int nShift = nBits - SUB_BUCKETS_BITS;
+    return ((SUB_BUCKETS + nSubBucket + 1) << nShift) - 1;
+}
+
+CLatencyHistogram::Shard::Shard()
+{
+    for (auto& n : vBuckets) {
+        n.store(0, std::memory_order_relaxed);
+    }
+}
+
+void CLatencyHistogram::Record(int64_t nMicros)
+{
+    static std::atomic<unsigned int> nNextShard{0};
+    static thread_local unsigned int nShard = nNextShard++ % SHARDS;
+
+    nMicros = std::max<int64_t>(nMicros, 0);
+    Shard& shard = shards[nShard];
+    shard.vBuckets[GetBucket(nMicros)].fetch_add(1, std::memory_order_relaxed);
+    shard.nCount.fetch_add(1, std::memory_order_relaxed);
+    shard.nSum.fetch_add(nMicros, std::memory_order_relaxed);
+    // Shards are mostly written by a single thread, so these rarely loop
+    int64_t nMin = shard.nMin.load(std::memory_order_relaxed);
+    while (nMicros < nMin && !shard.nMin.compare_exchange_weak(nMin, nMicros, std::memory_order_relaxed)) {}
+    int64_t nMax = shard.nMax.load(std::memory_order_relaxed);
+    while (nMicros > nMax && !shard.nMax.compare_exchange_weak(nMax, nMicros, std::memory_order_relaxed)) {}
+}
+
+CLatencyHistogramSnapshot CLatencyHistogram::GetSnapshot() const
+{
+    CLatencyHistogramSnapshot snapshot;
+    snapshot.vBuckets.assign(BUCKETS, 0);
+    int64_t nMin = std::numeric_limits<int64_t>::max();
+    for (const Shard& shard : shards) {
+        for (int i = 0; i < BUCKETS; i++) {
+            snapshot.vBuckets[i] += shard.vBuckets[i].load(std::memory_order_relaxed);
+        }
+        snapshot.nCount += shard.nCount.load(std::memory_order_relaxed);
+        snapshot.nSum += shard.nSum.load(std::memory_order_relaxed);
+        nMin = std::min(nMin, shard.nMin.load(std::memory_order_relaxed));
+        snapshot.nMax = std::max(snapshot.nMax, shard.nMax.load(std::memory_order_relaxed));
+    }
+    snapshot.nMin = snapshot.nCount ? nMin : 0;
+    return snapshot;
+}
+
+int64_t CLatencyHistogramSnapshot::GetPercentile(double dFraction) const
+{
+    if (nCount == 0) {
+        return 0;
+    }
+    // The buckets are summed up independently of nCount, so don't rely on them being equal
+    uint64_t nTotal = 0;
+    for (uint64_t n : vBuckets) {
+        nTotal += n;
+    }
+    const uint64_t nRank = std::max<uint64_t>(1, std::ceil(std::min(std::max(dFraction, 0.0), 1.0) * nTotal));
+    uint64_t nSeen = 0;
+    for (size_t i = 0; i < vBuckets.size(); i++) {
+        nSeen += vBuckets[i];
+        if (nSeen >= nRank) {
+            return std::max(nMin, std::min(nMax, CLatencyHistogram::GetBucketUpperBound(i)));
+        }
+    }
+    return nMax;
+}
+
+CLatencyHistogramSnapshot CLatencyHistogramSnapshot::Since(const CLatencyHistogramSnapshot& prev) const
+{
+    CLatencyHistogramSnapshot result;
+    result.vBuckets.assign(vBuckets.size(), 0);
+    int nFirst = -1, nLast = -1;
+    for (size_t i = 0; i < vBuckets.size(); i++) {
+        result.vBuckets[i] = vBuckets[i] - (i < prev.vBuckets.size() ? prev.vBuckets[i] : 0);
+        if (result.vBuckets[i] != 0) {
+            if (nFirst < 0) nFirst = i;
+            nLast = i;
+        }
+    }
+    result.nCount = nCount - prev.nCount;
+    result.nSum = nSum - prev.nSum;
+    if (nFirst >= 0) {
+        result.nMin = std::max(nMin, nFirst > 0 ? CLatencyHistogram::GetBucketUpperBound(nFirst - 1) + 1 : 0);
+        result.nMax = std::min(nMax, CLatencyHistogram::GetBucketUpperBound(nLast));
+    }
+    return result;
+}
+
+CLatencyHistogram& CMetricsRegistry::GetHistogram(const std::string& strName)
+{
+    WaitableLock lock(cs);
+    std::unique_ptr<CLatencyHistogram>& histogram = mapHistograms[strName];
+    if (!histogram) {
+        histogram.reset(new CLatencyHistogram());
+    }
+    return *histogram;
+}
+
+std::map<std::string, CLatencyHistogramSnapshot> CMetricsRegistry::GetSnapshots(const std::string& strPrefix) const
+{
+    std::vector<std::pair<std::string, const CLatencyHistogram*>> vHistograms;
+    {
+        WaitableLock lock(cs);
+        for (auto it = mapHistograms.lower_bound(strPrefix); it != mapHistograms.end() && it->first.compare(0, strPrefix.size(), strPrefix) == 0; ++it) {
+            vHistograms.emplace_back(it->first, it->second.get());
+        }
+    }
+
+    std::map<std::string, CLatencyHistogramSnapshot> result;
+    for (const auto& p : vHistograms) {
+        result.emplace(p.first, p.second->GetSnapshot());
+    }
+    return result;
+}
+
+CLatencyTimer::CLatencyTimer(CLatencyHistogram& histogramIn) :
+    histogram(histogramIn),
+    nStart(GetLatencyTimeMicros())
+{
+}
+
+CLatencyTimer::~CLatencyTimer()
+{
+    histogram.Record(GetLatencyTimeMicros() - nStart);
+}
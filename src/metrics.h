@@ -0,0 +1,109 @@
+// Copyright (c) 2022 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_METRICS_H
+#define BITCOIN_METRICS_H
+
+#include <sync.h>
+
+#include <atomic>
+#include <limits>
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A point-in-time copy of a CLatencyHistogram. Values are in microseconds.
+ */
+struct CLatencyHistogramSnapshot
+{
+    std::vector<uint64_t> vBuckets;
+    uint64_t nCount{0};
+    uint64_t nSum{0};
+    int64_t nMin{0};
+    int64_t nMax{0};
+
+    double GetMean() const { return nCount ? (double)nSum / nCount : 0; }
+    /** The value below which the given fraction (0..1) of all samples lie, with a relative error of at most 1/8 */
+    int64_t GetPercentile(double dFraction) const;
+    /** The samples recorded after prev was taken. Min and max are only known up to bucket precision */
+    CLatencyHistogramSnapshot Since(const CLatencyHistogramSnapshot& prev) const;
+};
+
+/**
+ * A log-linear (HDR-style) latency histogram. Each power of two range is split into 8 buckets,
+ * so any recorded value is known with a relative error of at most 1/8.
+ *
+ * Recording is lock-free: every thread writes to one of a few shards using relaxed atomics, so
+ * threads that record into the same histogram concurrently rarely share a cache line. Shards are
+ * merged only when a snapshot is taken.
+ */
+class CLatencyHistogram
+{
+public:
+    static const int SUB_BUCKETS_BITS = 3;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKETS_BITS;
+    //! Values up to 2^36us (about 19 hours) are bucketed, larger values end up in the last bucket
+    static const int MAX_VALUE_BITS = 36;
+    static const int BUCKETS = 2 * SUB_BUCKETS + (MAX_VALUE_BITS - SUB_BUCKETS_BITS - 1) * SUB_BUCKETS;
+    static const int SHARDS = 8;
+
+    static int GetBucket(int64_t nValue);
+    /** The largest value that falls into the given bucket */
+    static int64_t GetBucketUpperBound(int nBucket);
+
+    void Record(int64_t nMicros);
+    CLatencyHistogramSnapshot GetSnapshot() const;
+
+private:
+    struct Shard
+    {
+        std::atomic<uint64_t> vBuckets[BUCKETS];
+        std::atomic<uint64_t> nCount{0};
+        std::atomic<uint64_t> nSum{0};
+        std::atomic<int64_t> nMin{std::numeric_limits<int64_t>::max()};
+        std::atomic<int64_t> nMax{0};
+
+        Shard();
+    };
+    Shard shards[SHARDS];
+};
+
+/**
+ * Named latency histograms of hot code paths, exported via statsd and the getmetrics RPC.
+ * Histograms are never removed, so references returned by GetHistogram stay valid and should be
+ * kept around (e.g. in a function-local static) by callers on hot paths.
+ */
+class CMetricsRegistry
+{
+private:
+    mutable CWaitableCriticalSection cs;
+    std::map<std::string, std::unique_ptr<CLatencyHistogram>> mapHistograms;
+
+public:
+    CLatencyHistogram& GetHistogram(const std::string& strName);
+    /** Snapshots of all histograms whose name starts with strPrefix */
+    std::map<std::string, CLatencyHistogramSnapshot> GetSnapshots(const std::string& strPrefix = "") const;
+};
+
+extern CMetricsRegistry g_metrics;
+
+/** Records the lifetime of the timer into a histogram */
+class CLatencyTimer
+{
+private:
+    CLatencyHistogram& histogram;
+    const int64_t nStart;
+
+public:
+    explicit CLatencyTimer(CLatencyHistogram& histogramIn);
+    ~CLatencyTimer();
+};
+
+/** Monotonic time in microseconds, for measuring latencies */
+int64_t GetLatencyTimeMicros();
+
+#endif // BITCOIN_METRICS_H
@@ -37,6 +37,8 @@
 #include <llmq/quorums_chainlocks.h>
 
 #include <algorithm>
+#include <chrono>
+#include <functional>
 #include <queue>
 #include <utility>
 
@@ -505,3 +507,216 @@ void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned
     pblock->vtx[0] = MakeTransactionRef(std::move(txCoinbase));
     pblock->hashMerkleRoot = BlockMerkleRoot(*pblock);
 }
+
+std::unique_ptr<CBlockTemplateCache> g_block_template_cache;
+
+CBlockTemplateCache::CBlockTemplateCache(const CChainParams& params, int64_t nRefreshMillisIn, CAmount nNotifyFeeDeltaIn) :
+    chainparams(params),
+    nRefreshMillis(std::max<int64_t>(nRefreshMillisIn, 100)),
+    nNotifyFeeDelta(nNotifyFeeDeltaIn)
+{
+}
+
+CBlockTemplateCache::~CBlockTemplateCache()
+{
+    Interrupt();
+    Stop();
+}
+
+void CBlockTemplateCache::Start()
+{
+    assert(!workerThread.joinable());
+    workerThread = std::thread(&TraceThread<std::function<void()> >, "blktmpl", std::function<void()>(std::bind(&CBlockTemplateCache::ThreadWorker, this)));
+}
+
+void CBlockTemplateCache::Interrupt()
+{
+    {
+        WaitableLock lock(cs);
+        fInterrupt = true;
+    }
+    cond.notify_all();
+    condAnnounced.notify_all();
+}
+
+void CBlockTemplateCache::Stop()
+{
+    if (workerThread.joinable()) {
+        workerThread.join();
+    }
+}
+
+void CBlockTemplateCache::SetAlwaysActive(bool fAlwaysActiveIn)
+{
+    {
+        WaitableLock lock(cs);
+        fAlwaysActive = fAlwaysActiveIn;
+    }
+    cond.notify_all();
+}
+
+void CBlockTemplateCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    {
+        WaitableLock lock(cs);
+        fTipChanged = true;
+    }
+    cond.notify_all();
+}
+
+std::shared_ptr<const CBlockTemplateCache::Entry> CBlockTemplateCache::GetLatest() const
+{
+    WaitableLock lock(cs);
+    return history.empty() ? nullptr : history.back();
+}
+
+bool CBlockTemplateCache::NeedsRebuild(const std::shared_ptr<const Entry>& entry, int64_t nMaxAgeMillis) const
+{
+    AssertLockHeld(cs_main);
+
+    if (!entry || entry->pindexPrev != chainActive.Tip()) {
+        return true;
+    }
+    return entry->nTransactionsUpdated != mempool.GetTransactionsUpdated() && GetTimeMillis() - entry->nTimeBuilt >= nMaxAgeMillis;
+}
+
+std::shared_ptr<const CBlockTemplateCache::Entry> CBlockTemplateCache::Build()
+{
+    AssertLockHeld(cs_main);
+
+    auto entry = std::make_shared<Entry>();
+    entry->pindexPrev = chainActive.Tip();
+    // Read before assembling, so that a transaction added meanwhile triggers another rebuild
+    entry->nTransactionsUpdated = mempool.GetTransactionsUpdated();
+    entry->nTimeBuilt = GetTimeMillis();
+
+    CScript scriptDummy = CScript() << OP_TRUE;
+    try {
+        entry->pblocktemplate = BlockAssembler(chainparams).CreateNewBlock(scriptDummy);
+    } catch (...) {
+        // Wake the longpoll waiters, which would otherwise wait for a template until they time out
+        {
+            WaitableLock lock(cs);
+            nFailedBuilds++;
+        }
+        condAnnounced.notify_all();
+        throw;
+    }
+    // The coinbase entry holds the negated sum of all fees
+    entry->nFees = -entry->pblocktemplate->vTxFees[0];
+
+    bool fAnnounce;
+    {
+        WaitableLock lock(cs);
+        entry->nId = nNextId++;
+        history.emplace_back(entry);
+        while (history.size() > MAX_HISTORY) {
+            history.pop_front();
+        }
+
+        fAnnounce = !lastAnnounced || lastAnnounced->pindexPrev != entry->pindexPrev ||
+                    entry->nFees >= lastAnnounced->nFees + nNotifyFeeDelta;
+        if (fAnnounce) {
+            lastAnnounced = entry;
+        }
+    }
+    if (fAnnounce) {
+        condAnnounced.notify_all();
+        GetMainSignals().NewBlockTemplate(entry->pblocktemplate, entry->nId);
+    }
+    return entry;
+}
+
+std::shared_ptr<const CBlockTemplateCache::Entry> CBlockTemplateCache::Get(int64_t nMaxAgeMillis)
+{
+    AssertLockHeld(cs_main);
+
+    bool fWasIdle;
+    {
+        WaitableLock lock(cs);
+        fWasIdle = GetTime() - nLastRequest > IDLE_TIMEOUT;
+        nLastRequest = GetTime();
+    }
+    if (fWasIdle) {
+        cond.notify_all();
+    }
+
+    auto entry = GetLatest();
+    if (NeedsRebuild(entry, nMaxAgeMillis)) {
+        entry = Build();
+    }
+    return entry;
+}
+
+std::shared_ptr<const CBlockTemplateCache::Entry> CBlockTemplateCache::GetById(uint64_t nId) const
+{
+    WaitableLock lock(cs);
+    for (const auto& entry : history) {
+        if (entry->nId == nId) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+std::shared_ptr<const CBlockTemplateCache::Entry> CBlockTemplateCache::WaitForAnnounced(const uint256& hashPrevBlock, uint64_t nKnownId, std::chrono::steady_clock::time_point deadline)
+{
+    AssertLockNotHeld(cs_main);
+
+    auto isNew = [&]() {
+        return lastAnnounced && (lastAnnounced->pindexPrev->GetBlockHash() != hashPrevBlock || lastAnnounced->nId > nKnownId);
+    };
+
+    WaitableLock lock(cs);
+    const uint64_t nFailedBuildsStart = nFailedBuilds;
+    while (!fInterrupt && !isNew() && nFailedBuilds == nFailedBuildsStart) {
+        // Waiting counts as requesting templates, so that the worker keeps building them
+        bool fWasIdle = GetTime() - nLastRequest > IDLE_TIMEOUT;
+        nLastRequest = GetTime();
+        if (fWasIdle) {
+            cond.notify_all();
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            return nullptr;
+        }
+        condAnnounced.wait_until(lock, std::min(deadline, now + std::chrono::seconds(IDLE_TIMEOUT / 2)));
+    }
+    return (fInterrupt || !isNew()) ? nullptr : lastAnnounced;
+}
+
+uint64_t CBlockTemplateCache::GetFailedBuilds() const
+{
+    WaitableLock lock(cs);
+    return nFailedBuilds;
+}
+
+void CBlockTemplateCache::ThreadWorker()
+{
+    while (true) {
+        {
+            WaitableLock lock(cs);
+            cond.wait_for(lock, std::chrono::milliseconds(nRefreshMillis), [this]() { return fInterrupt || fTipChanged; });
+            if (fInterrupt) {
+                return;
+            }
+            fTipChanged = false;
+            if (!fAlwaysActive && GetTime() - nLastRequest > IDLE_TIMEOUT) {
+                continue;
+            }
+        }
+
+        try {
+            LOCK(cs_main);
+            if (IsInitialBlockDownload()) {
+                continue;
+            }
+            if (NeedsRebuild(GetLatest(), nRefreshMillis)) {
+                Build();
+            }
+        } catch (const std::exception& e) {
+            // Masternode payments may not be known yet, the next request will report the error
+            LogPrint(BCLog::RPC, "CBlockTemplateCache::%s -- failed to build block template: %s\n", __func__, e.what());
+        }
+    }
+}
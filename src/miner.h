@@ -7,11 +7,16 @@
 #define BITCOIN_MINER_H
 
 #include <primitives/block.h>
+#include <sync.h>
 #include <txmempool.h>
 #include <validation.h>
+#include <validationinterface.h>
 
 #include <stdint.h>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <thread>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/ordered_index.hpp>
 
@@ -23,6 +28,10 @@ class CScript;
 namespace Consensus { struct Params; };
 
 static const bool DEFAULT_PRINTPRIORITY = false;
+/** Default for -blocktemplaterefresh, the minimum interval between rebuilds of the cached block template in milliseconds */
+static const int64_t DEFAULT_BLOCK_TEMPLATE_REFRESH = 1000;
+/** Default for -blocktemplatenotifyfee, the fee increase for which a template on the same tip is announced again */
+static const CAmount DEFAULT_BLOCK_TEMPLATE_NOTIFY_FEE = 10000;
 
 struct CBlockTemplate
 {
@@ -195,6 +204,102 @@ private:
     int UpdatePackagesForAdded(const CTxMemPool::setEntries& alreadyAdded, indexed_modified_transaction_set &mapModifiedTx) EXCLUSIVE_LOCKS_REQUIRED(mempool.cs);
 };
 
+/**
+ * Keeps the block template for the current tip up to date in a background thread, so that
+ * getblocktemplate can serve a cached template instead of assembling a block while holding
+ * cs_main and mempool.cs on every call. The template is rebuilt as soon as the tip changes and
+ * at most every nRefreshMillis while the mempool changes. Templates are only maintained while
+ * they are requested, the thread goes idle when nobody asked for one in a while.
+ */
+class CBlockTemplateCache : public CValidationInterface
+{
+public:
+    struct Entry {
+        //! Increases with every template built
+        uint64_t nId;
+        const CBlockIndex* pindexPrev;
+        //! mempool.GetTransactionsUpdated() when the template was built
+        unsigned int nTransactionsUpdated;
+        int64_t nTimeBuilt;
+        //! Sum of the fees of all transactions in the template
+        CAmount nFees;
+        std::shared_ptr<const CBlockTemplate> pblocktemplate;
+    };
+
+private:
+    //! Number of templates kept to compute deltas against
+    static const size_t MAX_HISTORY = 16;
+    //! Stop maintaining templates when none was requested for this long (seconds)
+    static const int64_t IDLE_TIMEOUT = 60;
+
+    const CChainParams& chainparams;
+    const int64_t nRefreshMillis;
+    const CAmount nNotifyFeeDelta;
+
+    mutable CWaitableCriticalSection cs;
+    //! Wakes the worker thread
+    CConditionVariable cond;
+    //! Signaled when a template was announced
+    CConditionVariable condAnnounced;
+    std::deque<std::shared_ptr<const Entry>> history;
+    //! The last template which was built on a new tip or improved the fees by nNotifyFeeDelta
+    std::shared_ptr<const Entry> lastAnnounced;
+    uint64_t nNextId{1};
+    //! Number of times building a template threw
+    uint64_t nFailedBuilds{0};
+    int64_t nLastRequest{0};
+    bool fAlwaysActive{false};
+    bool fTipChanged{false};
+    bool fInterrupt{false};
+
+    std::thread workerThread;
+
+    void ThreadWorker();
+    /** Build a template for the current tip and add it to the history. Requires cs_main. */
+    std::shared_ptr<const Entry> Build();
+    /** Whether the latest template is missing or outdated. Requires cs_main. */
+    bool NeedsRebuild(const std::shared_ptr<const Entry>& entry, int64_t nMaxAgeMillis) const;
+
+protected:
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload) override;
+
+public:
+    CBlockTemplateCache(const CChainParams& params, int64_t nRefreshMillisIn, CAmount nNotifyFeeDeltaIn = DEFAULT_BLOCK_TEMPLATE_NOTIFY_FEE);
+    ~CBlockTemplateCache();
+
+    void Start();
+    void Interrupt();
+    void Stop();
+
+    /** Keep templates up to date even if nobody requests them, for listeners of NewBlockTemplate */
+    void SetAlwaysActive(bool fAlwaysActiveIn);
+
+    /**
+     * Get a template for the current tip. If the cached one was built on another tip, or the
+     * mempool changed and it is older than nMaxAgeMillis, a new one is built right away.
+     */
+    std::shared_ptr<const Entry> Get(int64_t nMaxAgeMillis);
+
+    /** Get the most recently built template, or nullptr if none was built yet */
+    std::shared_ptr<const Entry> GetLatest() const;
+
+    /** Get a recently built template by its id, or nullptr if it is not known anymore */
+    std::shared_ptr<const Entry> GetById(uint64_t nId) const;
+
+    /**
+     * Wait until a template is announced which is built on another block than hashPrevBlock or
+     * has an id above nKnownId, and return it. Returns nullptr on timeout or interruption, and
+     * as soon as building a template failed meanwhile. Must not be called with cs_main held.
+     */
+    std::shared_ptr<const Entry> WaitForAnnounced(const uint256& hashPrevBlock, uint64_t nKnownId, std::chrono::steady_clock::time_point deadline);
+
+    /** Number of times building a template failed, see WaitForAnnounced */
+    uint64_t GetFailedBuilds() const;
+};
+
+/** The global block template cache, may be null */
+extern std::unique_ptr<CBlockTemplateCache> g_block_template_cache;
+
 /** Modify the extranonce in a block */
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
@@ -2869,6 +2869,57 @@ void CConnman::ThreadMessageHandler()
     }
 }
 
+void CConnman::QueueConcurrentMessage(CNode* pnode, CNetMessage&& msg)
+{
+    assert(!messageHandlerWorkers.empty());
+    // Pinning peers to workers keeps their messages in order
+    MessageHandlerWorker& worker = *messageHandlerWorkers[pnode->GetId() % messageHandlerWorkers.size()];
+    pnode->nConcurrentMessages++;
+    {
+        // Queued messages still count towards the receive flood limit until they are processed
+        LOCK(pnode->cs_vProcessMsg);
+        pnode->nProcessQueueSize += msg.vRecv.size() + CMessageHeader::HEADER_SIZE;
+        pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+    }
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.emplace_back(pnode->AddRef(), std::move(msg));
+    }
+    worker.cond.notify_one();
+}
+
+void CConnman::ThreadMessageHandlerWorker(size_t nWorker)
+{
+    MessageHandlerWorker& worker = *messageHandlerWorkers[nWorker];
+
+    while (!flagInterruptMsgProc)
+    {
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.cond.wait(lock, [&] { return !worker.queue.empty() || flagInterruptMsgProc; });
+        if (flagInterruptMsgProc)
+            return;
+        std::pair<CNode*, CNetMessage> item = std::move(worker.queue.front());
+        worker.queue.pop_front();
+        lock.unlock();
+
+        CNode* pnode = item.first;
+        size_t nMessageSize = item.second.vRecv.size() + CMessageHeader::HEADER_SIZE;
+        if (!pnode->fDisconnect) {
+            m_msgproc->ProcessConcurrentMessage(pnode, item.second, flagInterruptMsgProc);
+        }
+        {
+            LOCK(pnode->cs_vProcessMsg);
+            pnode->nProcessQueueSize -= nMessageSize;
+            pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+        }
+        if (--pnode->nConcurrentMessages == 0) {
+            // The main handler holds back the next message of this peer until all concurrent ones are done
+            WakeMessageHandler();
+        }
+        pnode->Release();
+    }
+}
+
 
 
 
@@ -3268,6 +3319,12 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
     threadOpenMasternodeConnections = std::thread(&TraceThread<std::function<void()> >, "mncon", std::function<void()>(std::bind(&CConnman::ThreadOpenMasternodeConnections, this)));
 
     // Process messages
+    for (int i = 0; i < nMessageHandlerWorkers; i++) {
+        messageHandlerWorkers.emplace_back(MakeUnique<MessageHandlerWorker>());
+    }
+    for (size_t i = 0; i < messageHandlerWorkers.size(); i++) {
+        messageHandlerWorkers[i]->thread = std::thread(&TraceThread<std::function<void()> >, strprintf("msghand.%d", i), std::function<void()>(std::bind(&CConnman::ThreadMessageHandlerWorker, this, i)));
+    }
     threadMessageHandler = std::thread(&TraceThread<std::function<void()> >, "msghand", std::function<void()>(std::bind(&CConnman::ThreadMessageHandler, this)));
 
     // Dump network addresses
@@ -3306,6 +3363,10 @@ void CConnman::Interrupt()
         flagInterruptMsgProc = true;
     }
     condMsgProc.notify_all();
+    for (auto& worker : messageHandlerWorkers) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->cond.notify_all();
+    }
 
     interruptNet();
     InterruptSocks5(true);
@@ -3327,6 +3388,15 @@ void CConnman::Stop()
 {
     if (threadMessageHandler.joinable())
         threadMessageHandler.join();
+    for (auto& worker : messageHandlerWorkers) {
+        if (worker->thread.joinable())
+            worker->thread.join();
+        for (auto& item : worker->queue) {
+            item.first->nConcurrentMessages--;
+            item.first->Release();
+        }
+    }
+    messageHandlerWorkers.clear();
     if (threadOpenMasternodeConnections.joinable())
         threadOpenMasternodeConnections.join();
     if (threadOpenConnections.joinable())
@@ -90,6 +90,10 @@ static const uint64_t MAX_UPLOAD_TIMEFRAME = 60 * 60 * 24;
 static const bool DEFAULT_BLOCKSONLY = false;
 /** -peertimeout default */
 static const int64_t DEFAULT_PEER_CONNECT_TIMEOUT = 60;
+/** Default number of -msghandworkers, which process masternode and quorum messages next to the main message handler */
+static const int DEFAULT_MSGHAND_WORKERS = 2;
+/** Maximum number of -msghandworkers */
+static const int MAX_MSGHAND_WORKERS = 16;
 
 static const bool DEFAULT_FORCEDNSSEED = false;
 static const size_t DEFAULT_MAXRECEIVEBUFFER = 5 * 1000;
@@ -134,6 +138,7 @@ struct CSerializedNetMsg
     std::string command;
 };
 
+class CNetMessage;
 class NetEventsInterface;
 class CConnman
 {
@@ -176,6 +181,7 @@ public:
         std::vector<std::string> m_specified_outgoing;
         std::vector<std::string> m_added_nodes;
         SocketEventsMode socketEventsMode = SOCKETEVENTS_SELECT;
+        int nMessageHandlerWorkers = 0;
     };
 
     void Init(const Options& connOptions) {
@@ -202,6 +208,7 @@ public:
             vAddedNodes = connOptions.m_added_nodes;
         }
         socketEventsMode = connOptions.socketEventsMode;
+        nMessageHandlerWorkers = connOptions.nMessageHandlerWorkers;
     }
 
     CConnman(uint64_t seed0, uint64_t seed1);
@@ -468,6 +475,14 @@ public:
     unsigned int GetReceiveFloodSize() const;
 
     void WakeMessageHandler();
+
+    bool HasMessageHandlerWorkers() const { return !messageHandlerWorkers.empty(); }
+    /**
+     * Hand a message of pnode over to a message handler worker, which processes it with
+     * NetEventsInterface::ProcessConcurrentMessage. All messages of a peer go to the same worker and are
+     * processed in the order they were queued.
+     */
+    void QueueConcurrentMessage(CNode* pnode, CNetMessage&& msg);
     void WakeSelect();
 
     /** Attempts to obfuscate tx time through exponentially distributed emitting.
@@ -492,6 +507,7 @@ private:
     void ProcessOneShot();
     void ThreadOpenConnections(std::vector<std::string> connect);
     void ThreadMessageHandler();
+    void ThreadMessageHandlerWorker(size_t nWorker);
     void AcceptConnection(const ListenSocket& hListenSocket);
     void DisconnectNodes();
     void NotifyNumConnectionsChanged();
@@ -620,6 +636,17 @@ private:
     std::mutex mutexMsgProc;
     std::atomic<bool> flagInterruptMsgProc;
 
+    /** A thread processing the concurrent messages of the peers assigned to it */
+    struct MessageHandlerWorker
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::deque<std::pair<CNode*, CNetMessage>> queue;
+        std::thread thread;
+    };
+    int nMessageHandlerWorkers{0};
+    std::vector<std::unique_ptr<MessageHandlerWorker>> messageHandlerWorkers;
+
     CThreadInterrupt interruptNet;
 
 #ifdef USE_WAKEUP_PIPE
@@ -689,6 +716,8 @@ class NetEventsInterface
 {
 public:
     virtual bool ProcessMessages(CNode* pnode, std::atomic<bool>& interrupt) = 0;
+    /** Called from a message handler worker for the messages ProcessMessages passed to CConnman::QueueConcurrentMessage */
+    virtual void ProcessConcurrentMessage(CNode* pnode, CNetMessage& msg, std::atomic<bool>& interrupt) = 0;
     virtual bool SendMessages(CNode* pnode) = 0;
     virtual void InitializeNode(CNode* pnode) = 0;
     virtual void FinalizeNode(NodeId id, bool& update_connection_time) = 0;
@@ -848,6 +877,8 @@ public:
     CCriticalSection cs_vProcessMsg;
     std::list<CNetMessage> vProcessMsg GUARDED_BY(cs_vProcessMsg);
     size_t nProcessQueueSize;
+    // Number of messages queued for or being processed by a message handler worker
+    std::atomic<int> nConcurrentMessages{0};
 
     CCriticalSection cs_sendProcessing;
 
@@ -11,8 +11,10 @@
 #include <chainparams.h>
 #include <consensus/validation.h>
 #include <hash.h>
+#include <index/txindex.h>
 #include <init.h>
 #include <merkleblock.h>
+#include <metrics.h>
 #include <netmessagemaker.h>
 #include <netbase.h>
 #include <policy/fees.h>
@@ -1350,7 +1352,7 @@ bool static AlreadyHave(const CInv& inv) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
                    mempool.exists(inv.hash) ||
                    pcoinsTip->HaveCoinInCache(COutPoint(inv.hash, 0)) || // Best effort: only try output 0 and 1
                    pcoinsTip->HaveCoinInCache(COutPoint(inv.hash, 1)) ||
-                   (fTxIndex && pblocktree->HasTxIndex(inv.hash));
+                   (g_txindex && g_txindex->HasTx(inv.hash));
         }
 
     case MSG_BLOCK:
@@ -1502,6 +1504,14 @@ void static ProcessGetBlockData(CNode* pfrom, const CChainParams& chainparams, c
         std::shared_ptr<const CBlock> pblock;
         if (a_recent_block && a_recent_block->GetHash() == pindex->GetBlockHash()) {
             pblock = a_recent_block;
+        } else if (inv.type == MSG_BLOCK) {
+            // Fast-path: in this case it is possible to serve the block directly from disk,
+            // as the network format matches the format on disk
+            CRawBlockRef rawBlock;
+            if (!ReadRawBlockFromDisk(rawBlock, pindex, chainparams.MessageStart()))
+                assert(!"cannot load block from disk");
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::BLOCK, rawBlock->data()));
+            // Don't set pblock as we've sent the block
         } else {
             // Send block from disk
             std::shared_ptr<CBlock> pblockRead = std::make_shared<CBlock>();
@@ -3511,10 +3521,10 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
         LOCK(cs_main);
 
-        CSimplifiedMNListDiff mnListDiff;
+        std::shared_ptr<const CSimplifiedMNListDiff> mnListDiff;
         std::string strError;
-        if (BuildSimplifiedMNListDiff(cmd.baseBlockHash, cmd.blockHash, mnListDiff, strError)) {
-            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, mnListDiff));
+        if (GetSimplifiedMNListDiff(cmd.baseBlockHash, cmd.blockHash, mnListDiff, strError)) {
+            connman->PushMessage(pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, *mnListDiff));
         } else {
             strError = strprintf("getmnlistdiff failed for baseBlockHash=%s, blockHash=%s. error=%s", cmd.baseBlockHash.ToString(), cmd.blockHash.ToString(), strError);
             Misbehaving(pfrom->GetId(), 1, strError);
@@ -3627,6 +3637,85 @@ static bool SendRejectsAndCheckIfBanned(CNode* pnode, CConnman* connman, bool en
     return false;
 }
 
+/**
+ * Quorum messages which need cs_main for short lookups at most. With -msghandworkers, these are processed on a message
+ * handler worker instead of waiting behind block and transaction processing. Messages of different peers are then
+ * processed concurrently, which is safe for these because their handlers only queue or look up state under the lock
+ * of their manager:
+ * - DKG messages are pushed to the session handler's CDKGPendingMessages under its cs and processed by the DKG thread
+ * - sig share messages only touch CSigSharesManager state under its cs, the shares are verified by its worker thread
+ * - recovered sigs are pushed to CSigningManager::pendingRecoveredSigs under its cs
+ * MNAUTH and governance votes are not in this list. MNAUTH detects duplicate proTxHashes by scanning all other peers,
+ * and governance votes update the sync and object request state of the governance manager. Both rely on being
+ * processed one at a time on the main message handler thread.
+ */
+bool IsConcurrentMessage(const std::string& strCommand)
+{
+    return strCommand == NetMsgType::QCONTRIB ||
+           strCommand == NetMsgType::QCOMPLAINT ||
+           strCommand == NetMsgType::QJUSTIFICATION ||
+           strCommand == NetMsgType::QPCOMMITMENT ||
+           strCommand == NetMsgType::QSIGSESANN ||
+           strCommand == NetMsgType::QSIGSHARESINV ||
+           strCommand == NetMsgType::QGETSIGSHARES ||
+           strCommand == NetMsgType::QBSIGSHARES ||
+           strCommand == NetMsgType::QSIGSHARE ||
+           strCommand == NetMsgType::QSIGREC;
+}
+
+/** Latency histogram of ProcessMessage for the given command, all unknown commands share one */
+static CLatencyHistogram& GetProcessMessageHistogram(const std::string& strCommand)
+{
+    static const std::map<std::string, CLatencyHistogram*> mapHistograms = [] {
+        std::map<std::string, CLatencyHistogram*> result;
+        for (const std::string& msg : getAllNetMessageTypes()) {
+            result.emplace(msg, &g_metrics.GetHistogram("net.processmessage." + msg));
+        }
+        return result;
+    }();
+    static CLatencyHistogram& histUnknown = g_metrics.GetHistogram("net.processmessage.unknown");
+
+    auto it = mapHistograms.find(strCommand);
+    return it != mapHistograms.end() ? *it->second : histUnknown;
+}
+
+static bool ProcessMessageChecked(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, unsigned int nMessageSize, int64_t nTimeReceived, const CChainParams& chainparams, CConnman* connman, const std::atomic<bool>& interruptMsgProc, bool enable_bip61)
+{
+    CLatencyTimer timer(GetProcessMessageHistogram(strCommand));
+    try
+    {
+        return ProcessMessage(pfrom, strCommand, vRecv, nTimeReceived, chainparams, connman, interruptMsgProc, enable_bip61);
+    }
+    catch (const std::ios_base::failure& e)
+    {
+        if (enable_bip61) {
+            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
+        }
+        if (strstr(e.what(), "end of data"))
+        {
+            // Allow exceptions from under-length message on vRecv
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "size too large"))
+        {
+            // Allow exceptions from over-long size
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
+        {
+            // Allow exceptions from non-canonical encoding
+            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
+        }
+        else
+        {
+            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+        }
+    } catch (...) {
+        PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+    }
+    return false;
+}
+
 bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& interruptMsgProc)
 {
     const CChainParams& chainparams = Params();
@@ -3660,10 +3749,16 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return false;
 
     std::list<CNetMessage> msgs;
+    bool fConcurrent;
     {
         LOCK(pfrom->cs_vProcessMsg);
         if (pfrom->vProcessMsg.empty())
             return false;
+        fConcurrent = connman->HasMessageHandlerWorkers() && IsConcurrentMessage(pfrom->vProcessMsg.front().hdr.GetCommand());
+        // Messages handed over to a message handler worker must be processed before the next one is processed here.
+        // The worker wakes us up once it's done.
+        if (!fConcurrent && pfrom->nConcurrentMessages > 0)
+            return false;
         // Just take one message
         msgs.splice(msgs.begin(), pfrom->vProcessMsg, pfrom->vProcessMsg.begin());
         pfrom->nProcessQueueSize -= msgs.front().vRecv.size() + CMessageHeader::HEADER_SIZE;
@@ -3704,44 +3799,18 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
         return fMoreWork;
     }
 
-    // Process message
-    bool fRet = false;
-    try
-    {
-        fRet = ProcessMessage(pfrom, strCommand, vRecv, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
-        if (interruptMsgProc)
-            return false;
-        if (!pfrom->vRecvGetData.empty())
-            fMoreWork = true;
-    }
-    catch (const std::ios_base::failure& e)
-    {
-        if (m_enable_bip61) {
-            connman->PushMessage(pfrom, CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::REJECT, strCommand, REJECT_MALFORMED, std::string("error parsing message")));
-        }
-        if (strstr(e.what(), "end of data"))
-        {
-            // Allow exceptions from under-length message on vRecv
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught, normally caused by a message being shorter than its stated length\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "size too large"))
-        {
-            // Allow exceptions from over-long size
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else if (strstr(e.what(), "non-canonical ReadCompactSize()"))
-        {
-            // Allow exceptions from non-canonical encoding
-            LogPrint(BCLog::NET, "%s(%s, %u bytes): Exception '%s' caught\n", __func__, SanitizeString(strCommand), nMessageSize, e.what());
-        }
-        else
-        {
-            PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
-        }
-    } catch (...) {
-        PrintExceptionContinue(std::current_exception(), "ProcessMessages()");
+    if (fConcurrent) {
+        connman->QueueConcurrentMessage(pfrom, std::move(msg));
+        return fMoreWork;
     }
 
+    // Process message
+    bool fRet = ProcessMessageChecked(pfrom, strCommand, vRecv, nMessageSize, msg.nTime, chainparams, connman, interruptMsgProc, m_enable_bip61);
+    if (interruptMsgProc)
+        return false;
+    if (!pfrom->vRecvGetData.empty())
+        fMoreWork = true;
+
     if (!fRet) {
         LogPrint(BCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), nMessageSize, pfrom->GetId());
     }
@@ -3752,6 +3821,15 @@ bool PeerLogicValidation::ProcessMessages(CNode* pfrom, std::atomic<bool>& inter
     return fMoreWork;
 }
 
+void PeerLogicValidation::ProcessConcurrentMessage(CNode* pfrom, CNetMessage& msg, std::atomic<bool>& interruptMsgProc)
+{
+    const std::string strCommand = msg.hdr.GetCommand();
+    if (!ProcessMessageChecked(pfrom, strCommand, msg.vRecv, msg.hdr.nMessageSize, msg.nTime, Params(), connman, interruptMsgProc, m_enable_bip61)) {
+        LogPrint(BCLog::NET, "%s(%s, %u bytes) FAILED peer=%d\n", __func__, SanitizeString(strCommand), msg.hdr.nMessageSize, pfrom->GetId());
+    }
+    // Rejects and bans are taken care of by SendMessages on the main message handler thread
+}
+
 void PeerLogicValidation::ConsiderEviction(CNode *pto, int64_t time_in_seconds)
 {
     AssertLockHeld(cs_main);
@@ -57,6 +57,14 @@ public:
     */
     bool ProcessMessages(CNode* pfrom, std::atomic<bool>& interrupt) override;
     /**
+    * Process a quorum message which ProcessMessages handed over to a message handler worker
+    *
+    * @param[in]   pfrom           The node which we have received the message from.
+    * @param[in]   msg             The message, with its header and checksum already validated.
+    * @param[in]   interrupt       Interrupt condition for processing threads
+    */
+    void ProcessConcurrentMessage(CNode* pfrom, CNetMessage& msg, std::atomic<bool>& interrupt) override;
+    /**
     * Send queued protocol messages to be sent to a give node.
     *
     * @param[in]   pto             The node which we are sending messages to.
@@ -88,6 +96,8 @@ struct CNodeStateStats {
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 bool IsBanned(NodeId nodeid);
+/** Whether messages of this type are processed on a message handler worker when -msghandworkers is enabled */
+bool IsConcurrentMessage(const std::string& strCommand);
 
 // Upstream moved this into net_processing.cpp (13417), however since we use Misbehaving in a number of dash specific
 // files such as mnauth.cpp and governance.cpp it makes sense to keep it in the header
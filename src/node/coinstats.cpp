@@ -8,58 +8,92 @@
 #include <amount.h>
 #include <coins.h>
 #include <chain.h>
+#include <crypto/muhash.h>
 #include <hash.h>
+#include <init.h>
 #include <serialize.h>
+#include <txdb.h>
 #include <validation.h>
 #include <uint256.h>
 // #include <util/system.h>
 #include <util.h>
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <thread>
 
 #include <boost/thread.hpp>
 
+//! Number of key ranges the coin database is split into for parallel walks, must divide 256
+static const int UTXO_STATS_RANGES = 64;
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+static void ApplyHash(CCoinsStats& stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
-    assert(!outputs.empty());
     ss << hash;
     ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase ? 1u : 0u);
-    stats.nTransactions++;
     for (const auto& output : outputs) {
         ss << VARINT(output.first + 1);
         ss << output.second.out.scriptPubKey;
         ss << VARINT(output.second.out.nValue, VarIntMode::NONNEGATIVE_SIGNED);
+    }
+    ss << VARINT(0u);
+}
+
+static void ApplyHash(CCoinsStats& stats, MuHash3072& muhash, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    for (const auto& output : outputs) {
+        CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+        ss << COutPoint(hash, output.first);
+        ss << (uint32_t)(output.second.nHeight * 2 + output.second.fCoinBase);
+        ss << output.second.out;
+        muhash.Insert(Span<const unsigned char>((const unsigned char*)ss.data(), ss.size()));
+    }
+}
+
+/** Placeholder for CoinStatsHashType::NONE which can be combined like a MuHash3072 */
+struct NoHash {
+    NoHash& operator*=(const NoHash&) { return *this; }
+};
+
+static void ApplyHash(CCoinsStats& stats, NoHash&, const uint256& hash, const std::map<uint32_t, Coin>& outputs) {}
+
+template <typename T>
+static void ApplyStats(CCoinsStats &stats, T& hash_obj, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    ApplyHash(stats, hash_obj, hash, outputs);
+    stats.nTransactions++;
+    for (const auto& output : outputs) {
         stats.nTransactionOutputs++;
         stats.nTotalAmount += output.second.out.nValue;
         stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
                            2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
     }
-    ss << VARINT(0u);
 }
 
-//! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
+/**
+ * Walk the coins from the cursor position until the first byte of the txid reaches nEndByte
+ * (or until the end if nEndByte is 256). The outputs of a transaction are never split, as
+ * they are stored next to each other.
+ */
+template <typename T>
+static bool WalkCoins(CCoinsViewCursor* pcursor, CCoinsStats& stats, T& hash_obj, int nEndByte, const std::function<bool()>& interrupted)
 {
-    std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
-    assert(pcursor);
-
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
-    {
-        LOCK(cs_main);
-        stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
-    }
-    ss << stats.hashBlock;
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
+        if (interrupted()) {
+            return false;
+        }
         COutPoint key;
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+            if (*key.hash.begin() >= nEndByte) {
+                break;
+            }
             if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
+                ApplyStats(stats, hash_obj, prevkey, outputs);
                 outputs.clear();
             }
             prevkey = key.hash;
@@ -70,9 +104,103 @@ bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         pcursor->Next();
     }
     if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+        ApplyStats(stats, hash_obj, prevkey, outputs);
+    }
+    return true;
+}
+
+template <typename T>
+static bool GetUTXOStatsParallel(CCoinsViewDB* view, CCoinsStats& stats, T& hash_obj, int nThreads)
+{
+    // All cursors are created while no block can be flushed to the coin database, so
+    // that they see the same state
+    std::vector<std::unique_ptr<CCoinsViewCursor>> vCursors;
+    {
+        LOCK(cs_main);
+        for (int i = 0; i < UTXO_STATS_RANGES; i++) {
+            uint256 txidStart;
+            *txidStart.begin() = (unsigned char)(i * (256 / UTXO_STATS_RANGES));
+            vCursors.emplace_back(view->Cursor(txidStart));
+        }
+        stats.hashBlock = vCursors[0]->GetBestBlock();
+        stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
+    }
+
+    std::vector<CCoinsStats> vStats(UTXO_STATS_RANGES);
+    std::vector<T> vHashObjs(UTXO_STATS_RANGES);
+    std::atomic<int> nNextRange{0};
+    std::atomic<bool> fFailed{false};
+    auto interrupted = [&fFailed]() { return fFailed || ShutdownRequested(); };
+
+    auto worker = [&]() {
+        for (int i = nNextRange++; i < UTXO_STATS_RANGES && !fFailed; i = nNextRange++) {
+            int nEndByte = (i + 1) * (256 / UTXO_STATS_RANGES);
+            if (!WalkCoins(vCursors[i].get(), vStats[i], vHashObjs[i], nEndByte, interrupted)) {
+                fFailed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < std::min(nThreads, UTXO_STATS_RANGES); i++) {
+        vThreads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : vThreads) {
+        thread.join();
+    }
+    if (fFailed) {
+        return false;
+    }
+
+    for (int i = 0; i < UTXO_STATS_RANGES; i++) {
+        stats.nTransactions += vStats[i].nTransactions;
+        stats.nTransactionOutputs += vStats[i].nTransactionOutputs;
+        stats.nBogoSize += vStats[i].nBogoSize;
+        stats.nTotalAmount += vStats[i].nTotalAmount;
+        hash_obj *= vHashObjs[i];
+    }
+    return true;
+}
+
+//! Calculate statistics about the unspent transaction output set
+bool GetUTXOStats(CCoinsViewDB *view, CCoinsStats &stats, CoinStatsHashType hash_type, int nThreads)
+{
+    switch (hash_type) {
+    case CoinStatsHashType::HASH_SERIALIZED: {
+        std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
+        assert(pcursor);
+
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        stats.hashBlock = pcursor->GetBestBlock();
+        {
+            LOCK(cs_main);
+            stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
+        }
+        ss << stats.hashBlock;
+        auto interrupted = []() { boost::this_thread::interruption_point(); return false; };
+        if (!WalkCoins(pcursor.get(), stats, ss, 256, interrupted)) {
+            return false;
+        }
+        stats.hashSerialized = ss.GetHash();
+        break;
+    }
+    case CoinStatsHashType::MUHASH: {
+        MuHash3072 muhash;
+        if (!GetUTXOStatsParallel(view, stats, muhash, nThreads)) {
+            return false;
+        }
+        muhash.Finalize(stats.hashSerialized);
+        break;
+    }
+    case CoinStatsHashType::NONE: {
+        NoHash nohash;
+        if (!GetUTXOStatsParallel(view, stats, nohash, nThreads)) {
+            return false;
+        }
+        break;
+    }
     }
-    stats.hashSerialized = ss.GetHash();
     stats.nDiskSize = view->EstimateSize();
     return true;
 }
@@ -11,7 +11,15 @@
 
 #include <cstdint>
 
-class CCoinsView;
+class CCoinsViewDB;
+
+enum class CoinStatsHashType {
+    //! Ordered hash of the serialized coins, which requires walking them one by one
+    HASH_SERIALIZED,
+    //! MuHash3072 of the coins, which can be computed in parallel
+    MUHASH,
+    NONE,
+};
 
 struct CCoinsStats
 {
@@ -27,7 +35,11 @@ struct CCoinsStats
     CCoinsStats() : nHeight(0), nTransactions(0), nTransactionOutputs(0), nBogoSize(0), nDiskSize(0), nTotalAmount(0) {}
 };
 
-//! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats);
+/**
+ * Calculate statistics about the unspent transaction output set. Unless HASH_SERIALIZED is
+ * requested, the coin database keyspace is split into ranges which are walked by up to
+ * nThreads threads in parallel. All of them read from the same database snapshot.
+ */
+bool GetUTXOStats(CCoinsViewDB* view, CCoinsStats& stats, CoinStatsHashType hash_type = CoinStatsHashType::HASH_SERIALIZED, int nThreads = 1);
 
 #endif // BITCOIN_NODE_COINSTATS_H
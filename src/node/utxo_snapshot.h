@@ -0,0 +1,45 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2019 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_UTXO_SNAPSHOT_H
+#define BITCOIN_NODE_UTXO_SNAPSHOT_H
+
+#include <serialize.h>
+#include <uint256.h>
+
+/**
+ * Metadata describing a serialized version of a UTXO set.
+ *
+ * The snapshot file written by `dumptxoutset` starts with this metadata, followed
+ * by m_coins_count (COutPoint, Coin) pairs ordered as in the coin database.
+ */
+class SnapshotMetadata
+{
+public:
+    //! The hash of the block that reflects the tip of the chain for the
+    //! UTXO set contained in this snapshot.
+    uint256 m_base_blockhash;
+
+    //! The number of coins in the UTXO set contained in this snapshot.
+    uint64_t m_coins_count = 0;
+
+    SnapshotMetadata() { }
+    SnapshotMetadata(
+        const uint256& base_blockhash,
+        uint64_t coins_count) :
+            m_base_blockhash(base_blockhash),
+            m_coins_count(coins_count) { }
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(m_base_blockhash);
+        READWRITE(m_coins_count);
+    }
+};
+
+#endif // BITCOIN_NODE_UTXO_SNAPSHOT_H
@@ -0,0 +1,192 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rawblock.h>
+
+#include <chain.h>
+#include <clientversion.h>
+#include <crypto/common.h>
+#include <streams.h>
+#include <util.h>
+#include <utilstrencodings.h>
+#include <validation.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <string.h>
+
+CRawBlockReader rawBlockReader;
+
+/** Size of the magic and length which precede every block in the block files */
+static const unsigned int BLOCK_HEADER_META_SIZE = CMessageHeader::MESSAGE_START_SIZE + sizeof(uint32_t);
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+#ifndef WIN32
+    munmap(const_cast<unsigned char*>(data), size);
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CMappedBlockFile::Open(const fs::path& path)
+{
+#ifdef WIN32
+    return nullptr;
+#else
+    int fd = open(path.string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    if (addr == MAP_FAILED) {
+        LogPrintf("%s: mmap failed for %s: %s\n", __func__, path.string(), strerror(errno));
+        return nullptr;
+    }
+    return std::shared_ptr<const CMappedBlockFile>(new CMappedBlockFile((const unsigned char*)addr, st.st_size));
+#endif
+}
+
+std::shared_ptr<const CMappedBlockFile> CRawBlockReader::GetMapping(int nFile)
+{
+    if (nMaxMappings == 0) {
+        return nullptr;
+    }
+
+    LOCK(cs);
+    for (auto it = lruMappings.begin(); it != lruMappings.end(); ++it) {
+        if (it->first == nFile) {
+            lruMappings.splice(lruMappings.begin(), lruMappings, it);
+            return it->second;
+        }
+    }
+
+    auto mapping = CMappedBlockFile::Open(GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk"));
+    if (mapping) {
+        lruMappings.emplace_front(nFile, mapping);
+        if (lruMappings.size() > nMaxMappings) {
+            // Spans handed out earlier keep their mapping alive
+            lruMappings.pop_back();
+        }
+    }
+    return mapping;
+}
+
+CRawBlockRef CRawBlockReader::GetCached(const uint256& hash)
+{
+    LOCK(cs);
+    auto it = mapBlocks.find(hash);
+    if (it == mapBlocks.end()) {
+        return nullptr;
+    }
+    lruBlocks.splice(lruBlocks.begin(), lruBlocks, it->second);
+    return it->second->second;
+}
+
+void CRawBlockReader::AddToCache(const uint256& hash, const CRawBlockRef& block)
+{
+    if (block->size() > nMaxCacheBytes) {
+        return;
+    }
+
+    LOCK(cs);
+    if (mapBlocks.count(hash)) {
+        return;
+    }
+    lruBlocks.emplace_front(hash, block);
+    mapBlocks.emplace(hash, lruBlocks.begin());
+    nCacheBytes += block->size();
+    while (nCacheBytes > nMaxCacheBytes) {
+        nCacheBytes -= lruBlocks.back().second->size();
+        mapBlocks.erase(lruBlocks.back().first);
+        lruBlocks.pop_back();
+    }
+}
+
+CRawBlockRef CRawBlockReader::Read(const uint256& hash, const CDiskBlockPos& pos, bool fFinalized, const CMessageHeader::MessageStartChars& messageStart)
+{
+    if (pos.IsNull() || pos.nPos < BLOCK_HEADER_META_SIZE) {
+        error("%s: invalid position %s", __func__, pos.ToString());
+        return nullptr;
+    }
+
+    if (fFinalized) {
+        auto mapping = GetMapping(pos.nFile);
+        if (mapping && mapping->Size() >= pos.nPos) {
+            const unsigned char* meta = mapping->begin() + pos.nPos - BLOCK_HEADER_META_SIZE;
+            uint32_t nSize = ReadLE32(meta + CMessageHeader::MESSAGE_START_SIZE);
+            if (memcmp(meta, messageStart, CMessageHeader::MESSAGE_START_SIZE) == 0 && nSize <= MAX_SIZE && nSize <= mapping->Size() - pos.nPos) {
+                return std::make_shared<const CRawBlock>(mapping, Span<const unsigned char>(mapping->begin() + pos.nPos, nSize));
+            }
+        }
+        // Let the regular read below report whatever is wrong with the block
+    }
+
+    CRawBlockRef cached = GetCached(hash);
+    if (cached) {
+        return cached;
+    }
+
+    CDiskBlockPos metaPos(pos.nFile, pos.nPos - BLOCK_HEADER_META_SIZE);
+    CAutoFile filein(OpenBlockFile(metaPos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+        return nullptr;
+    }
+
+    std::vector<unsigned char> vData;
+    try {
+        CMessageHeader::MessageStartChars blockStart;
+        uint32_t nSize;
+        filein >> blockStart >> nSize;
+
+        if (memcmp(blockStart, messageStart, CMessageHeader::MESSAGE_START_SIZE) != 0) {
+            error("%s: Block magic mismatch for %s: %s versus expected %s", __func__, pos.ToString(),
+                  HexStr(blockStart, blockStart + CMessageHeader::MESSAGE_START_SIZE),
+                  HexStr(messageStart, messageStart + CMessageHeader::MESSAGE_START_SIZE));
+            return nullptr;
+        }
+        if (nSize > MAX_SIZE) {
+            error("%s: Block data is larger than maximum deserialization size for %s: %u versus %u", __func__, pos.ToString(), nSize, MAX_SIZE);
+            return nullptr;
+        }
+
+        vData.resize(nSize);
+        filein.read((char*)vData.data(), nSize);
+    } catch (const std::exception& e) {
+        error("%s: Read from block file failed: %s for %s", __func__, e.what(), pos.ToString());
+        return nullptr;
+    }
+
+    auto block = std::make_shared<const CRawBlock>(std::move(vData));
+    AddToCache(hash, block);
+    return block;
+}
+
+void CRawBlockReader::ForgetFiles(const std::set<int>& setFiles)
+{
+    LOCK(cs);
+    lruMappings.remove_if([&](const std::pair<int, std::shared_ptr<const CMappedBlockFile>>& p) {
+        return setFiles.count(p.first) != 0;
+    });
+}
+
+void CRawBlockReader::Clear()
+{
+    LOCK(cs);
+    lruMappings.clear();
+    lruBlocks.clear();
+    mapBlocks.clear();
+    nCacheBytes = 0;
+}
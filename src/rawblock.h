@@ -0,0 +1,114 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RAWBLOCK_H
+#define BITCOIN_RAWBLOCK_H
+
+#include <fs.h>
+#include <protocol.h>
+#include <saltedhasher.h>
+#include <span.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+struct CDiskBlockPos;
+
+/** Maximum number of finalized block files kept mapped by the raw block reader */
+static const size_t MAX_MAPPED_BLOCK_FILES = sizeof(void*) >= 8 ? 64 : 0;
+/** Size of the cache for serialized blocks which could not be served from a mapping */
+static const size_t DEFAULT_RAW_BLOCK_CACHE_SIZE = 32 * 1024 * 1024;
+
+/** A read-only memory mapping of a whole blk?????.dat file */
+class CMappedBlockFile
+{
+private:
+    const unsigned char* data{nullptr};
+    size_t size{0};
+
+    CMappedBlockFile(const unsigned char* _data, size_t _size) : data(_data), size(_size) {}
+
+public:
+    ~CMappedBlockFile();
+    CMappedBlockFile(const CMappedBlockFile&) = delete;
+    CMappedBlockFile& operator=(const CMappedBlockFile&) = delete;
+
+    /** Map the file at path. Returns nullptr if the platform or the file does not allow it. */
+    static std::shared_ptr<const CMappedBlockFile> Open(const fs::path& path);
+
+    const unsigned char* begin() const { return data; }
+    size_t Size() const { return size; }
+};
+
+/**
+ * A block in its serialized form, as stored in the block files and sent over the wire.
+ * The data either points into a mapping of its block file, which is kept alive for as
+ * long as the CRawBlock is, or into a buffer owned by the CRawBlock.
+ */
+class CRawBlock
+{
+private:
+    std::shared_ptr<const CMappedBlockFile> mapping;
+    std::vector<unsigned char> buffer;
+    Span<const unsigned char> span;
+
+public:
+    explicit CRawBlock(std::vector<unsigned char>&& _buffer) : buffer(std::move(_buffer)), span(buffer.data(), buffer.size()) {}
+    CRawBlock(std::shared_ptr<const CMappedBlockFile> _mapping, Span<const unsigned char> _span) : mapping(std::move(_mapping)), span(_span) {}
+    CRawBlock(const CRawBlock&) = delete;
+    CRawBlock& operator=(const CRawBlock&) = delete;
+
+    Span<const unsigned char> data() const { return span; }
+    size_t size() const { return span.size(); }
+    bool IsMapped() const { return mapping != nullptr; }
+};
+typedef std::shared_ptr<const CRawBlock> CRawBlockRef;
+
+/**
+ * Serves serialized blocks without deserializing them. Blocks in finalized block files
+ * (which are never written to again) are returned as spans into read-only mappings of
+ * those files. Blocks from the block file currently being appended to, or from any file
+ * on platforms without mmap, are read into memory and kept in a small LRU cache, as
+ * those are usually the recent blocks many peers ask for at once.
+ */
+class CRawBlockReader
+{
+private:
+    mutable CCriticalSection cs;
+
+    size_t nMaxMappings;
+    std::list<std::pair<int, std::shared_ptr<const CMappedBlockFile>>> lruMappings GUARDED_BY(cs);
+
+    size_t nMaxCacheBytes;
+    size_t nCacheBytes GUARDED_BY(cs){0};
+    std::list<std::pair<uint256, CRawBlockRef>> lruBlocks GUARDED_BY(cs);
+    std::unordered_map<uint256, decltype(lruBlocks)::iterator, StaticSaltedHasher> mapBlocks GUARDED_BY(cs);
+
+    std::shared_ptr<const CMappedBlockFile> GetMapping(int nFile);
+    CRawBlockRef GetCached(const uint256& hash);
+    void AddToCache(const uint256& hash, const CRawBlockRef& block);
+
+public:
+    explicit CRawBlockReader(size_t _nMaxMappings = MAX_MAPPED_BLOCK_FILES, size_t _nMaxCacheBytes = DEFAULT_RAW_BLOCK_CACHE_SIZE) :
+        nMaxMappings(_nMaxMappings), nMaxCacheBytes(_nMaxCacheBytes) {}
+
+    /**
+     * Read the serialized block with the given hash stored at pos. fFinalized must only be
+     * set if the block file will not be written to anymore, which allows it to be mapped.
+     */
+    CRawBlockRef Read(const uint256& hash, const CDiskBlockPos& pos, bool fFinalized, const CMessageHeader::MessageStartChars& messageStart);
+
+    /** Drop the mappings of block files which are about to be deleted */
+    void ForgetFiles(const std::set<int>& setFiles);
+    void Clear();
+};
+
+extern CRawBlockReader rawBlockReader;
+
+#endif // BITCOIN_RAWBLOCK_H
@@ -8,6 +8,7 @@
 #include <chainparams.h>
 #include <core_io.h>
 #include <httpserver.h>
+#include <index/txindex.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
@@ -15,6 +16,7 @@
 #include <streams.h>
 #include <sync.h>
 #include <txmempool.h>
+#include <undo.h>
 #include <utilstrencodings.h>
 #include <validation.h>
 #include <version.h>
@@ -24,6 +26,10 @@
 #include <univalue.h>
 
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15; //allow a max of 15 outpoints to be queried at once
+static const long MAX_REST_HEADERS_RESULTS = 100000;
+static const long MAX_REST_BLOCKRANGE_RESULTS = 1000;
+//! Replies which are streamed are sent in pieces of about this size
+static const size_t REST_CHUNK_SIZE = 64 * 1024;
 
 enum class RetFormat {
     UNDEF,
@@ -114,6 +120,82 @@ static bool ParseHashStr(const std::string& strReq, uint256& v)
     return true;
 }
 
+/**
+ * Sends a reply body in pieces with chunked transfer encoding, so that large
+ * replies never have to be held in memory as a whole.
+ */
+class RESTChunkedReply
+{
+private:
+    HTTPRequest* req;
+    const RetFormat rf;
+    std::string strBuffer;
+    bool fOpen{true};
+
+    void Flush()
+    {
+        if (fOpen && !strBuffer.empty()) {
+            fOpen = req->WriteReplyChunk(strBuffer);
+        }
+        strBuffer.clear();
+    }
+
+public:
+    RESTChunkedReply(HTTPRequest* reqIn, RetFormat rfIn) : req(reqIn), rf(rfIn)
+    {
+        const char* contentType = "application/json";
+        if (rf == RetFormat::BINARY) {
+            contentType = "application/octet-stream";
+        } else if (rf == RetFormat::HEX) {
+            contentType = "text/plain";
+        }
+        req->WriteHeader("Content-Type", contentType);
+        req->StartChunkedReply(HTTP_OK);
+    }
+
+    /** Append serialized data, hex encoded for hex replies */
+    void WriteData(const unsigned char* data, size_t size)
+    {
+        for (size_t nPos = 0; nPos < size && fOpen; nPos += REST_CHUNK_SIZE) {
+            const unsigned char* begin = data + nPos;
+            const unsigned char* end = data + std::min(size, nPos + REST_CHUNK_SIZE);
+            if (rf == RetFormat::HEX) {
+                strBuffer += HexStr(begin, end);
+            } else {
+                strBuffer.append((const char*)begin, end - begin);
+            }
+            if (strBuffer.size() >= REST_CHUNK_SIZE) Flush();
+        }
+    }
+
+    /** Append text, e.g. produced by a CJSONStreamWriter */
+    void WriteText(const std::string& str)
+    {
+        strBuffer += str;
+        if (strBuffer.size() >= REST_CHUNK_SIZE) Flush();
+    }
+
+    /** Whether the client is still there to receive the reply */
+    bool IsOpen() const { return fOpen; }
+
+    void Finish()
+    {
+        if (rf == RetFormat::HEX || rf == RetFormat::JSON) {
+            strBuffer += "\n";
+        }
+        Flush();
+        req->EndChunkedReply();
+    }
+
+    /** Close the connection without ending the reply, so the client can tell it is incomplete */
+    void Abort()
+    {
+        fOpen = false;
+        strBuffer.clear();
+        req->AbortChunkedReply();
+    }
+};
+
 static bool CheckWarmup(HTTPRequest* req)
 {
     std::string statusmessage;
@@ -136,7 +218,7 @@ static bool rest_headers(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "No header count specified. Use /rest/headers/<count>/<hash>.<ext>.");
 
     long count = strtol(path[0].c_str(), nullptr, 10);
-    if (count < 1 || count > 2000)
+    if (count < 1 || count > MAX_REST_HEADERS_RESULTS)
         return RESTERR(req, HTTP_BAD_REQUEST, "Header count out of range: " + path[0]);
 
     std::string hashStr = path[1];
@@ -144,55 +226,37 @@ static bool rest_headers(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
-    std::vector<const CBlockIndex *> headers;
-    headers.reserve(count);
-    {
-        LOCK(cs_main);
-        const CBlockIndex* pindex = LookupBlockIndex(hash);
-        while (pindex != nullptr && chainActive.Contains(pindex)) {
-            headers.push_back(pindex);
-            if (headers.size() == (unsigned long)count)
-                break;
-            pindex = chainActive.Next(pindex);
-        }
-    }
-
-    CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
-    for (const CBlockIndex *pindex : headers) {
-        ssHeader << pindex->GetBlockHeader();
-    }
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX && rf != RetFormat::JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
 
-    switch (rf) {
-    case RetFormat::BINARY: {
-        std::string binaryHeader = ssHeader.str();
-        req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryHeader);
-        return true;
+    // Headers of the active chain can be read from its snapshot without cs_main
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    const CBlockIndex* pindexStart = LookupBlockIndexUnlocked(hash);
+    if (pindexStart && !chain->Contains(pindexStart)) {
+        pindexStart = nullptr;
     }
+    const int nEndHeight = pindexStart ? std::min<long>(chain->Height(), pindexStart->nHeight + count - 1) : -1;
 
-    case RetFormat::HEX: {
-        std::string strHex = HexStr(ssHeader.begin(), ssHeader.end()) + "\n";
-        req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
-        return true;
-    }
-    case RetFormat::JSON: {
-        UniValue jsonHeaders(UniValue::VARR);
-        {
-            LOCK(cs_main);
-            for (const CBlockIndex *pindex : headers) {
-                jsonHeaders.push_back(blockheaderToJSON(pindex));
+    RESTChunkedReply reply(req, rf);
+    if (rf == RetFormat::JSON) {
+        CJSONStreamWriter writer([&reply](const std::string& str) { reply.WriteText(str); }, REST_CHUNK_SIZE);
+        writer.BeginArray();
+        for (int nHeight = pindexStart ? pindexStart->nHeight : 0; pindexStart && nHeight <= nEndHeight && reply.IsOpen(); nHeight++) {
+            writer.push_back(blockheaderToJSON(*chain, (*chain)[nHeight]));
+        }
+        writer.EndArray();
+    } else {
+        CDataStream ssHeader(SER_NETWORK, PROTOCOL_VERSION);
+        for (int nHeight = pindexStart ? pindexStart->nHeight : 0; pindexStart && nHeight <= nEndHeight && reply.IsOpen(); nHeight++) {
+            ssHeader << (*chain)[nHeight]->GetBlockHeader();
+            if (ssHeader.size() >= REST_CHUNK_SIZE || nHeight == nEndHeight) {
+                reply.WriteData((const unsigned char*)ssHeader.data(), ssHeader.size());
+                ssHeader.clear();
             }
         }
-        std::string strJSON = jsonHeaders.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
-    }
-    default: {
-        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
-    }
     }
+    reply.Finish();
+    return true;
 }
 
 static bool rest_block(HTTPRequest* req,
@@ -208,56 +272,177 @@ static bool rest_block(HTTPRequest* req,
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX && rf != RetFormat::JSON)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    // Blocks of the active chain can be read and described using the chain snapshot, without
+    // holding cs_main. Everything else (and any block in prune mode) still needs cs_main.
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    const CBlockIndex* pblockindex = LookupBlockIndexUnlocked(hash);
+    if (!pblockindex) {
+        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+    }
+    const bool fActive = !fPruneMode && chain->Contains(pblockindex);
+
     CBlock block;
-    CBlockIndex* pblockindex = nullptr;
+    CRawBlockRef rawBlock;
     {
-        LOCK(cs_main);
-        pblockindex = LookupBlockIndex(hash);
-        if (!pblockindex) {
-            return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-        }
+        LOCK(fActive ? nullptr : &cs_main);
 
-        if (IsBlockPruned(pblockindex))
+        if (!fActive && IsBlockPruned(pblockindex))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
-        if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
+        // The binary and hex formats are the serialized block as stored on disk, so there is
+        // no need to deserialize it
+        if (rf == RetFormat::BINARY || rf == RetFormat::HEX) {
+            if (!ReadRawBlockFromDisk(rawBlock, pblockindex, Params().MessageStart()))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+        } else if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) {
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-    }
-
-    CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-    ssBlock << block;
+        }
 
-    switch (rf) {
-    case RetFormat::BINARY: {
-        std::string binaryBlock = ssBlock.str();
-        req->WriteHeader("Content-Type", "application/octet-stream");
-        req->WriteReply(HTTP_OK, binaryBlock);
-        return true;
+        if (rf == RetFormat::JSON && !fActive) {
+            std::string strJSON = blockToJSON(block, pblockindex, showTxDetails).write() + "\n";
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReply(HTTP_OK, strJSON);
+            return true;
+        }
     }
 
-    case RetFormat::HEX: {
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end()) + "\n";
-        req->WriteHeader("Content-Type", "text/plain");
-        req->WriteReply(HTTP_OK, strHex);
-        return true;
+    RESTChunkedReply reply(req, rf);
+    if (rf == RetFormat::JSON) {
+        CJSONStreamWriter writer([&reply](const std::string& str) { reply.WriteText(str); }, REST_CHUNK_SIZE);
+        blockToJSON(writer, *chain, block, pblockindex, showTxDetails);
+    } else {
+        const Span<const unsigned char> data = rawBlock->data();
+        reply.WriteData(data.data(), data.size());
     }
+    reply.Finish();
+    return true;
+}
 
-    case RetFormat::JSON: {
-        UniValue objBlock;
-        {
-            LOCK(cs_main);
-            objBlock = blockToJSON(block, pblockindex, showTxDetails);
+/**
+ * Parse "<START-HEIGHT>/<COUNT>" of a block range request and check it against the active chain
+ * snapshot. Returns false after sending an error reply.
+ */
+static bool ParseBlockRange(HTTPRequest* req, const std::string& param, const CChainSnapshot& chain, int& nStartHeight, int& nEndHeight)
+{
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid block range. Use /rest/blockrange/<start-height>/<count>.<ext>.");
+
+    int32_t nStart, nCount;
+    if (!ParseInt32(path[0], &nStart) || nStart < 0)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid start height: " + path[0]);
+    if (!ParseInt32(path[1], &nCount) || nCount < 1 || nCount > MAX_REST_BLOCKRANGE_RESULTS)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + path[1]);
+    if (nStart > chain.Height())
+        return RESTERR(req, HTTP_NOT_FOUND, "Start height out of range: " + path[0]);
+
+    nStartHeight = nStart;
+    nEndHeight = std::min<int64_t>(chain.Height(), (int64_t)nStart + nCount - 1);
+
+    if (fPruneMode) {
+        LOCK(cs_main);
+        for (int nHeight = nStartHeight; nHeight <= nEndHeight; nHeight++) {
+            if (IsBlockPruned(chain[nHeight]))
+                return RESTERR(req, HTTP_NOT_FOUND, chain[nHeight]->GetBlockHash().GetHex() + " not available (pruned data)");
         }
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
-        return true;
     }
+    return true;
+}
 
-    default: {
+static bool rest_blockrange(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX && rf != RetFormat::JSON)
         return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    int nStartHeight, nEndHeight;
+    if (!ParseBlockRange(req, param, *chain, nStartHeight, nEndHeight))
+        return false;
+
+    RESTChunkedReply reply(req, rf);
+    if (rf == RetFormat::JSON) {
+        CJSONStreamWriter writer([&reply](const std::string& str) { reply.WriteText(str); }, REST_CHUNK_SIZE);
+        writer.BeginArray();
+        for (int nHeight = nStartHeight; nHeight <= nEndHeight && reply.IsOpen(); nHeight++) {
+            const CBlockIndex* pindex = (*chain)[nHeight];
+            CBlock block;
+            {
+                LOCK(fPruneMode ? &cs_main : nullptr);
+                if (!ReadBlockFromDisk(block, pindex, Params().GetConsensus())) {
+                    reply.Abort();
+                    return false;
+                }
+            }
+            blockToJSON(writer, *chain, block, pindex, true);
+        }
+        writer.EndArray();
+    } else {
+        for (int nHeight = nStartHeight; nHeight <= nEndHeight && reply.IsOpen(); nHeight++) {
+            CRawBlockRef rawBlock;
+            {
+                LOCK(fPruneMode ? &cs_main : nullptr);
+                if (!ReadRawBlockFromDisk(rawBlock, (*chain)[nHeight], Params().MessageStart())) {
+                    reply.Abort();
+                    return false;
+                }
+            }
+            const Span<const unsigned char> data = rawBlock->data();
+            reply.WriteData(data.data(), data.size());
+        }
     }
+    reply.Finish();
+    return true;
+}
+
+static bool rest_blockrange_undo(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+
+    if (rf != RetFormat::BINARY && rf != RetFormat::HEX)
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: .bin, .hex)");
+
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    int nStartHeight, nEndHeight;
+    if (!ParseBlockRange(req, param, *chain, nStartHeight, nEndHeight))
+        return false;
+
+    // Each record is the block as stored on disk followed by its serialized undo data, which
+    // holds the outputs spent by the block's transactions in order. The genesis block has no
+    // undo data and gets an empty one.
+    RESTChunkedReply reply(req, rf);
+    CDataStream ssUndo(SER_NETWORK, PROTOCOL_VERSION);
+    for (int nHeight = nStartHeight; nHeight <= nEndHeight && reply.IsOpen(); nHeight++) {
+        const CBlockIndex* pindex = (*chain)[nHeight];
+        CRawBlockRef rawBlock;
+        CBlockUndo blockUndo;
+        {
+            LOCK(fPruneMode ? &cs_main : nullptr);
+            if (!ReadRawBlockFromDisk(rawBlock, pindex, Params().MessageStart()) ||
+                (pindex->pprev && !UndoReadFromDisk(blockUndo, pindex))) {
+                reply.Abort();
+                return false;
+            }
+        }
+        const Span<const unsigned char> data = rawBlock->data();
+        reply.WriteData(data.data(), data.size());
+        ssUndo << blockUndo;
+        reply.WriteData((const unsigned char*)ssUndo.data(), ssUndo.size());
+        ssUndo.clear();
     }
+    reply.Finish();
+    return true;
 }
 
 static bool rest_block_extended(HTTPRequest* req, const std::string& strURIPart)
@@ -351,6 +536,10 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     if (!ParseHashStr(hashStr, hash))
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
+    if (g_txindex) {
+        g_txindex->BlockUntilSyncedToCurrentChain();
+    }
+
     CTransactionRef tx;
     uint256 hashBlock = uint256();
     if (!GetTransaction(hash, tx, Params().GetConsensus(), hashBlock, true))
@@ -584,6 +773,8 @@ static const struct {
       {"/rest/mempool/info", rest_mempool_info},
       {"/rest/mempool/contents", rest_mempool_contents},
       {"/rest/headers/", rest_headers},
+      {"/rest/blockrange/undo/", rest_blockrange_undo},
+      {"/rest/blockrange/", rest_blockrange},
       {"/rest/getutxos", rest_getutxos},
 };
 
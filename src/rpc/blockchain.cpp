@@ -7,14 +7,20 @@
 #include <rpc/blockchain.h>
 
 #include <amount.h>
+#include <blockfilter.h>
 #include <chainparams.h>
 #include <checkpoints.h>
 #include <coins.h>
 #include <node/coinstats.h>
+#include <node/utxo_snapshot.h>
 #include <core_io.h>
+#include <fs.h>
 #include <consensus/validation.h>
 #include <validation.h>
-// #include <rpc/index/txindex.h>
+#include <index/blockfilterindex.h>
+#include <index/timestampindex.h>
+#include <index/txindex.h>
+#include <init.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <primitives/transaction.h>
@@ -88,12 +94,28 @@ double GetDifficulty(const CBlockIndex* blockindex)
 UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 {
     AssertLockHeld(cs_main);
+    return blockheaderToJSON(*GetChainSnapshot(), blockindex);
+}
+
+/** Number of transactions of blockindex, read from chain if it contains the block and under cs_main otherwise. */
+static unsigned int GetBlockTxCount(const CChainSnapshot& chain, const CBlockIndex* blockindex)
+{
+    const CChainSnapshot::Entry* entry = chain.GetEntry(blockindex);
+    if (entry) {
+        return entry->nTx;
+    }
+    AssertLockHeld(cs_main);
+    return blockindex->nTx;
+}
+
+UniValue blockheaderToJSON(const CChainSnapshot& chain, const CBlockIndex* blockindex)
+{
     UniValue result(UniValue::VOBJ);
     result.pushKV("hash", blockindex->GetBlockHash().GetHex());
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    if (chain.Contains(blockindex))
+        confirmations = chain.Height() - blockindex->nHeight + 1;
     result.pushKV("confirmations", confirmations);
     result.pushKV("height", blockindex->nHeight);
     result.pushKV("version", blockindex->nVersion);
@@ -105,11 +127,11 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     result.pushKV("bits", strprintf("%08x", blockindex->nBits));
     result.pushKV("difficulty", GetDifficulty(blockindex));
     result.pushKV("chainwork", blockindex->nChainWork.GetHex());
-    result.pushKV("nTx", (uint64_t)blockindex->nTx);
+    result.pushKV("nTx", (uint64_t)GetBlockTxCount(chain, blockindex));
 
     if (blockindex->pprev)
         result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
-    CBlockIndex *pnext = chainActive.Next(blockindex);
+    const CBlockIndex *pnext = chain.Next(blockindex);
     if (pnext)
         result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
 
@@ -121,20 +143,34 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
 {
     AssertLockHeld(cs_main);
-    UniValue result(UniValue::VOBJ);
-    result.pushKV("hash", blockindex->GetBlockHash().GetHex());
+    return blockToJSON(*GetChainSnapshot(), block, blockindex, txDetails);
+}
+
+UniValue blockToJSON(const CChainSnapshot& chain, const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    CJSONStreamWriter writer;
+    blockToJSON(writer, chain, block, blockindex, txDetails);
+    return std::move(writer).TakeValue();
+}
+
+void blockToJSON(CJSONStreamWriter& writer, const CChainSnapshot& chain, const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    writer.BeginObject();
+    writer.pushKV("hash", blockindex->GetBlockHash().GetHex());
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
-    result.pushKV("confirmations", confirmations);
-    result.pushKV("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
-    result.pushKV("height", blockindex->nHeight);
-    result.pushKV("version", block.nVersion);
-    result.pushKV("versionHex", strprintf("%08x", block.nVersion));
-    result.pushKV("merkleroot", block.hashMerkleRoot.GetHex());
+    if (chain.Contains(blockindex))
+        confirmations = chain.Height() - blockindex->nHeight + 1;
+    writer.pushKV("confirmations", confirmations);
+    writer.pushKV("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    writer.pushKV("height", blockindex->nHeight);
+    writer.pushKV("version", block.nVersion);
+    writer.pushKV("versionHex", strprintf("%08x", block.nVersion));
+    writer.pushKV("merkleroot", block.hashMerkleRoot.GetHex());
     bool chainLock = llmq::chainLocksHandler->HasChainLock(blockindex->nHeight, blockindex->GetBlockHash());
-    UniValue txs(UniValue::VARR);
+    // Transactions are written one at a time, so only a single one is held as UniValue
+    writer.Key("tx");
+    writer.BeginArray();
     for(const auto& tx : block.vtx)
     {
         if(txDetails)
@@ -144,37 +180,36 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
             bool fLocked = llmq::quorumInstantSendManager->IsLocked(tx->GetHash());
             objTx.pushKV("instantlock", fLocked || chainLock);
             objTx.pushKV("instantlock_internal", fLocked);
-            txs.push_back(objTx);
+            writer.push_back(std::move(objTx));
         }
         else
-            txs.push_back(tx->GetHash().GetHex());
+            writer.push_back(tx->GetHash().GetHex());
     }
-    result.pushKV("tx", txs);
+    writer.EndArray();
     if (!block.vtx[0]->vExtraPayload.empty()) {
         CCbTx cbTx;
         if (GetTxPayload(block.vtx[0]->vExtraPayload, cbTx)) {
             UniValue cbTxObj;
             cbTx.ToJson(cbTxObj);
-            result.pushKV("cbTx", cbTxObj);
+            writer.pushKV("cbTx", std::move(cbTxObj));
         }
     }
-    result.pushKV("time", block.GetBlockTime());
-    result.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
-    result.pushKV("nonce", (uint64_t)block.nNonce);
-    result.pushKV("bits", strprintf("%08x", block.nBits));
-    result.pushKV("difficulty", GetDifficulty(blockindex));
-    result.pushKV("chainwork", blockindex->nChainWork.GetHex());
-    result.pushKV("nTx", (uint64_t)blockindex->nTx);
+    writer.pushKV("time", block.GetBlockTime());
+    writer.pushKV("mediantime", (int64_t)blockindex->GetMedianTimePast());
+    writer.pushKV("nonce", (uint64_t)block.nNonce);
+    writer.pushKV("bits", strprintf("%08x", block.nBits));
+    writer.pushKV("difficulty", GetDifficulty(blockindex));
+    writer.pushKV("chainwork", blockindex->nChainWork.GetHex());
+    writer.pushKV("nTx", (uint64_t)GetBlockTxCount(chain, blockindex));
 
     if (blockindex->pprev)
-        result.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
-    CBlockIndex *pnext = chainActive.Next(blockindex);
+        writer.pushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
+    const CBlockIndex *pnext = chain.Next(blockindex);
     if (pnext)
-        result.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
+        writer.pushKV("nextblockhash", pnext->GetBlockHash().GetHex());
 
-    result.pushKV("chainlock", chainLock);
-
-    return result;
+    writer.pushKV("chainlock", chainLock);
+    writer.EndObject();
 }
 
 UniValue getblockcount(const JSONRPCRequest& request)
@@ -190,8 +225,7 @@ UniValue getblockcount(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockcount", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Height();
+    return GetChainSnapshot()->Height();
 }
 
 UniValue getbestblockhash(const JSONRPCRequest& request)
@@ -207,8 +241,7 @@ UniValue getbestblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getbestblockhash", "")
         );
 
-    LOCK(cs_main);
-    return chainActive.Tip()->GetBlockHash().GetHex();
+    return GetChainSnapshot()->Tip()->GetBlockHash().GetHex();
 }
 
 UniValue getbestchainlock(const JSONRPCRequest& request)
@@ -485,30 +518,36 @@ void entryToJSON(UniValue &info, const CTxMemPoolEntry &e) EXCLUSIVE_LOCKS_REQUI
 }
 
 UniValue mempoolToJSON(bool fVerbose)
+{
+    CJSONStreamWriter writer;
+    mempoolToJSON(writer, fVerbose);
+    return std::move(writer).TakeValue();
+}
+
+void mempoolToJSON(CJSONStreamWriter& writer, bool fVerbose)
 {
     if (fVerbose)
     {
         LOCK(mempool.cs);
-        UniValue o(UniValue::VOBJ);
+        writer.BeginObject();
         for (const CTxMemPoolEntry& e : mempool.mapTx)
         {
             const uint256& hash = e.GetTx().GetHash();
             UniValue info(UniValue::VOBJ);
             entryToJSON(info, e);
-            o.pushKV(hash.ToString(), info);
+            writer.pushKV(hash.ToString(), std::move(info));
         }
-        return o;
+        writer.EndObject();
     }
     else
     {
         std::vector<uint256> vtxid;
         mempool.queryHashes(vtxid);
 
-        UniValue a(UniValue::VARR);
+        writer.BeginArray();
         for (const uint256& hash : vtxid)
-            a.push_back(hash.ToString());
-
-        return a;
+            writer.push_back(hash.ToString());
+        writer.EndArray();
     }
 }
 
@@ -541,7 +580,9 @@ UniValue getrawmempool(const JSONRPCRequest& request)
     if (!request.params[0].isNull())
         fVerbose = request.params[0].get_bool();
 
-    return mempoolToJSON(fVerbose);
+    CJSONStreamWriter treeWriter;
+    mempoolToJSON(request.stream ? *request.stream : treeWriter, fVerbose);
+    return std::move(treeWriter).TakeValue();
 }
 
 UniValue getmempoolancestors(const JSONRPCRequest& request)
@@ -727,6 +768,10 @@ UniValue getblockhashes(const JSONRPCRequest& request)
     unsigned int low = request.params[1].get_int();
     std::vector<uint256> blockHashes;
 
+    if (g_timestampindex) {
+        g_timestampindex->BlockUntilSyncedToCurrentChain();
+    }
+
     if (!GetTimestampIndex(high, low, blockHashes)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for block hashes");
     }
@@ -754,13 +799,13 @@ UniValue getblockhash(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockhash", "1000")
         );
 
-    LOCK(cs_main);
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
 
     int nHeight = request.params[0].get_int();
-    if (nHeight < 0 || nHeight > chainActive.Height())
+    if (nHeight < 0 || nHeight > chain->Height())
         throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range");
 
-    CBlockIndex* pblockindex = chainActive[nHeight];
+    const CBlockIndex* pblockindex = (*chain)[nHeight];
     return pblockindex->GetBlockHash().GetHex();
 }
 
@@ -799,8 +844,6 @@ UniValue getblockheader(const JSONRPCRequest& request)
             + HelpExampleRpc("getblockheader", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\"")
         );
 
-    LOCK(cs_main);
-
     std::string strHash = request.params[0].get_str();
     uint256 hash(uint256S(strHash));
 
@@ -808,7 +851,8 @@ UniValue getblockheader(const JSONRPCRequest& request)
     if (!request.params[1].isNull())
         fVerbose = request.params[1].get_bool();
 
-    const CBlockIndex* pblockindex = LookupBlockIndex(hash);
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    const CBlockIndex* pblockindex = LookupBlockIndexUnlocked(hash);
     if (!pblockindex) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     }
@@ -821,6 +865,12 @@ UniValue getblockheader(const JSONRPCRequest& request)
         return strHex;
     }
 
+    if (chain->Contains(pblockindex)) {
+        return blockheaderToJSON(*chain, pblockindex);
+    }
+
+    // Entries off the active chain may still be updated, e.g. nTx once the block arrives
+    LOCK(cs_main);
     return blockheaderToJSON(pblockindex);
 }
 
@@ -913,10 +963,10 @@ UniValue getblockheaders(const JSONRPCRequest& request)
     return arrHeaders;
 }
 
-static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
+static CBlock GetBlockChecked(const CChainSnapshot& chain, const CBlockIndex* pblockindex)
 {
     CBlock block;
-    if (IsBlockPruned(pblockindex)) {
+    if (IsBlockPruned(chain, pblockindex)) {
         throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
     }
 
@@ -932,6 +982,42 @@ static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
     return block;
 }
 
+static CRawBlockRef GetRawBlockChecked(const CChainSnapshot& chain, const CBlockIndex* pblockindex)
+{
+    CRawBlockRef block;
+    if (IsBlockPruned(chain, pblockindex)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+    }
+
+    if (!ReadRawBlockFromDisk(block, pblockindex, Params().MessageStart())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+
+    return block;
+}
+
+static CBlock GetBlockChecked(const CBlockIndex* pblockindex)
+{
+    AssertLockHeld(cs_main);
+    return GetBlockChecked(*GetChainSnapshot(), pblockindex);
+}
+
+static UniValue GetBlockResult(const JSONRPCRequest& request, const CChainSnapshot& chain, const CBlockIndex* pblockindex, int verbosity)
+{
+    if (verbosity <= 0)
+    {
+        // The hex-encoded block is the block as stored on disk, no need to deserialize it
+        const CRawBlockRef rawBlock = GetRawBlockChecked(chain, pblockindex);
+        const Span<const unsigned char> data = rawBlock->data();
+        return HexStr(data.data(), data.data() + data.size());
+    }
+
+    const CBlock block = GetBlockChecked(chain, pblockindex);
+
+    CJSONStreamWriter treeWriter;
+    blockToJSON(request.stream ? *request.stream : treeWriter, chain, block, pblockindex, verbosity >= 2);
+    return std::move(treeWriter).TakeValue();
+}
 
 UniValue getmerkleblocks(const JSONRPCRequest& request)
 {
@@ -1064,8 +1150,6 @@ UniValue getblock(const JSONRPCRequest& request)
             + HelpExampleRpc("getblock", "\"00000000000fd08c2fb661d2fcb0d49abb3a91e5f27082ce64feed3b4dede2e2\"")
         );
 
-    LOCK(cs_main);
-
     std::string strHash = request.params[0].get_str();
     uint256 hash(uint256S(strHash));
 
@@ -1077,22 +1161,19 @@ UniValue getblock(const JSONRPCRequest& request)
             verbosity = request.params[1].get_bool() ? 1 : 0;
     }
 
-    const CBlockIndex* pblockindex = LookupBlockIndex(hash);
+    std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+    const CBlockIndex* pblockindex = LookupBlockIndexUnlocked(hash);
     if (!pblockindex) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
     }
 
-    const CBlock block = GetBlockChecked(pblockindex);
-
-    if (verbosity <= 0)
-    {
-        CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
-        ssBlock << block;
-        std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+    // Blocks of the active chain are not modified anymore unless their files get pruned,
+    // so only blocks off the chain and pruning nodes need to wait for cs_main.
+    if (fPruneMode || !chain->Contains(pblockindex)) {
+        LOCK(cs_main);
+        return GetBlockResult(request, *GetChainSnapshot(), pblockindex, verbosity);
     }
-
-    return blockToJSON(block, pblockindex, verbosity >= 2);
+    return GetBlockResult(request, *chain, pblockindex, verbosity);
 }
 
 UniValue pruneblockchain(const JSONRPCRequest& request)
@@ -1144,13 +1225,23 @@ UniValue pruneblockchain(const JSONRPCRequest& request)
     return uint64_t(height);
 }
 
+/** Number of threads used to walk the coin database for hash types which can be computed in parallel */
+static int GetUTXOStatsThreads()
+{
+    return std::max(1, std::min(GetNumCores(), 8));
+}
+
 UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
-    if (request.fHelp || request.params.size() != 0)
+    if (request.fHelp || request.params.size() > 1)
         throw std::runtime_error(
-            "gettxoutsetinfo\n"
+            "gettxoutsetinfo ( \"hash_type\" )\n"
             "\nReturns statistics about the unspent transaction output set.\n"
             "Note this call may take some time.\n"
+            "\nArguments:\n"
+            "1. \"hash_type\"    (string, optional, default=\"hash_serialized_2\") Which UTXO set hash should be calculated.\n"
+            "                   Options: 'hash_serialized_2' (the legacy algorithm), 'muhash', 'none'.\n"
+            "                   'muhash' and 'none' walk the UTXO set with multiple threads and are much faster.\n"
             "\nResult:\n"
             "{\n"
             "  \"height\":n,     (numeric) The current block height (index)\n"
@@ -1158,26 +1249,46 @@ UniValue gettxoutsetinfo(const JSONRPCRequest& request)
             "  \"transactions\": n,      (numeric) The number of transactions with unspent outputs\n"
             "  \"txouts\": n,            (numeric) The number of unspent transaction outputs\n"
             "  \"bogosize\": n,          (numeric) A meaningless metric for UTXO set size\n"
-            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash\n"
+            "  \"hash_serialized_2\": \"hash\", (string) The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)\n"
+            "  \"muhash\": \"hash\",     (string) The MuHash of the UTXO set (only present if 'muhash' hash_type is chosen)\n"
             "  \"disk_size\": n,         (numeric) The estimated size of the chainstate on disk\n"
             "  \"total_amount\": x.xxx          (numeric) The total amount\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("gettxoutsetinfo", "")
+            + HelpExampleCli("gettxoutsetinfo", "\"muhash\"")
             + HelpExampleRpc("gettxoutsetinfo", "")
         );
 
     UniValue ret(UniValue::VOBJ);
 
+    CoinStatsHashType hash_type = CoinStatsHashType::HASH_SERIALIZED;
+    if (!request.params[0].isNull()) {
+        const std::string& strHashType = request.params[0].get_str();
+        if (strHashType == "hash_serialized_2") {
+            hash_type = CoinStatsHashType::HASH_SERIALIZED;
+        } else if (strHashType == "muhash") {
+            hash_type = CoinStatsHashType::MUHASH;
+        } else if (strHashType == "none") {
+            hash_type = CoinStatsHashType::NONE;
+        } else {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", strHashType));
+        }
+    }
+
     CCoinsStats stats;
     FlushStateToDisk();
-    if (GetUTXOStats(pcoinsdbview.get(), stats)) {
+    if (GetUTXOStats(pcoinsdbview.get(), stats, hash_type, GetUTXOStatsThreads())) {
         ret.pushKV("height", (int64_t)stats.nHeight);
         ret.pushKV("bestblock", stats.hashBlock.GetHex());
         ret.pushKV("transactions", (int64_t)stats.nTransactions);
         ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
         ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
-        ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+        if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+            ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+        } else if (hash_type == CoinStatsHashType::MUHASH) {
+            ret.pushKV("muhash", stats.hashSerialized.GetHex());
+        }
         ret.pushKV("disk_size", stats.nDiskSize);
         ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
     } else {
@@ -2020,7 +2131,7 @@ static UniValue getblockstats(const JSONRPCRequest& request)
 
         if (loop_inputs) {
 
-            if (!fTxIndex) {
+            if (!g_txindex) {
                 throw JSONRPCError(RPC_INVALID_PARAMETER, "One or more of the selected stats requires -txindex enabled");
             }
             CAmount tx_total_in = 0;
@@ -2221,6 +2332,173 @@ UniValue savemempool(const JSONRPCRequest& request)
     return NullUniValue;
 }
 
+static UniValue dumptxoutset(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        throw std::runtime_error(
+            "dumptxoutset \"path\"\n"
+            "\nWrite the serialized UTXO set to disk.\n"
+            "The coins are streamed from a database snapshot, block processing is only paused while it is taken.\n"
+            "\nArguments:\n"
+            "1. \"path\"    (string, required) Path to the output file. If relative, will be prefixed by datadir.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"coins_written\": n,   (numeric) The number of coins written in the snapshot\n"
+            "  \"base_hash\": \"hex\",   (string) The hash of the block at the tip of the chain of the snapshot\n"
+            "  \"base_height\": n,     (numeric) The height of the block at the tip of the chain of the snapshot\n"
+            "  \"path\": \"path\",       (string) The absolute path that the snapshot was written to\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("dumptxoutset", "\"utxo.dat\"")
+            + HelpExampleRpc("dumptxoutset", "\"utxo.dat\"")
+        );
+    }
+
+    fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    // Write to a temporary path and then move into `path` on completion
+    // to avoid confusion due to an interruption.
+    fs::path temppath = fs::absolute(request.params[0].get_str() + ".incomplete", GetDataDir());
+
+    if (fs::exists(path)) {
+        throw JSONRPCError(
+            RPC_INVALID_PARAMETER,
+            path.string() + " already exists. If you are sure this is what you want, "
+            "move it out of the way first");
+    }
+
+    FILE* file{fsbridge::fopen(temppath, "wb")};
+    CAutoFile afile{file, SER_DISK, CLIENT_VERSION};
+    if (afile.IsNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Couldn't open file " + temppath.string() + " for writing");
+    }
+
+    std::unique_ptr<CCoinsViewCursor> pcursor;
+    const CBlockIndex* tip;
+    {
+        // The cursor reads from an implicit LevelDB snapshot, so cs_main is only held
+        // while the chainstate is flushed and the snapshot is taken.
+        LOCK(cs_main);
+        FlushStateToDisk();
+        pcursor = std::unique_ptr<CCoinsViewCursor>(pcoinsdbview->Cursor());
+        tip = LookupBlockIndex(pcursor->GetBestBlock());
+        assert(tip);
+    }
+
+    // The number of coins is only known once all of them are written, so the
+    // metadata is written again at the start of the file at the end.
+    SnapshotMetadata metadata{tip->GetBlockHash(), 0};
+    afile << metadata;
+
+    COutPoint key;
+    Coin coin;
+    while (pcursor->Valid()) {
+        if (ShutdownRequested()) {
+            afile.fclose();
+            fs::remove(temppath);
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+        }
+        if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
+            afile << key;
+            afile << coin;
+            metadata.m_coins_count++;
+        }
+        pcursor->Next();
+    }
+
+    if (fseek(afile.Get(), 0, SEEK_SET) != 0) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to write snapshot metadata");
+    }
+    afile << metadata;
+    if (!FileCommit(afile.Get())) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Unable to commit snapshot to disk");
+    }
+    afile.fclose();
+    fs::rename(temppath, path);
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_written", (int64_t)metadata.m_coins_count);
+    result.pushKV("base_hash", tip->GetBlockHash().ToString());
+    result.pushKV("base_height", tip->nHeight);
+    result.pushKV("path", path.string());
+    return result;
+}
+
+static UniValue getblockfilter(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 1 || request.params.size() > 2) {
+        throw std::runtime_error(
+            "getblockfilter \"blockhash\" ( \"filtertype\" )\n"
+            "\nRetrieve a BIP 157 content filter for a particular block.\n"
+            "\nArguments:\n"
+            "1. \"blockhash\"  (string, required) The hash of the block\n"
+            "2. \"filtertype\" (string, optional, default=\"basic\") The type name of the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"filter\" : \"hex\",  (string) the hex-encoded filter data\n"
+            "  \"header\" : \"hex\"   (string) the hex-encoded filter header\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\" \"basic\"")
+            + HelpExampleRpc("getblockfilter", "\"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09\", \"basic\"")
+        );
+    }
+
+    uint256 block_hash = ParseHashV(request.params[0], "blockhash");
+    std::string filtertype_name = "basic";
+    if (!request.params[1].isNull()) {
+        filtertype_name = request.params[1].get_str();
+    }
+
+    BlockFilterType filtertype;
+    if (!BlockFilterTypeByName(filtertype_name, filtertype)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown filtertype");
+    }
+
+    BlockFilterIndex* index = GetBlockFilterIndex(filtertype);
+    if (!index) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Index is not enabled for filtertype " + filtertype_name);
+    }
+
+    const CBlockIndex* block_index;
+    bool block_was_connected;
+    {
+        LOCK(cs_main);
+        block_index = LookupBlockIndex(block_hash);
+        if (!block_index) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        block_was_connected = block_index->IsValid(BLOCK_VALID_SCRIPTS);
+    }
+
+    bool index_ready = index->BlockUntilSyncedToCurrentChain();
+
+    BlockFilter filter;
+    uint256 filter_header;
+    if (!index->LookupFilter(block_index, filter) ||
+        !index->LookupFilterHeader(block_index, filter_header)) {
+        int err_code;
+        std::string errmsg = "Filter not found.";
+
+        if (!block_was_connected) {
+            err_code = RPC_INVALID_ADDRESS_OR_KEY;
+            errmsg += " Block was not connected to active chain.";
+        } else if (!index_ready) {
+            err_code = RPC_MISC_ERROR;
+            errmsg += " Block filters are still in the process of being indexed.";
+        } else {
+            err_code = RPC_INTERNAL_ERROR;
+            errmsg += " This error is unexpected and indicates index corruption.";
+        }
+
+        throw JSONRPCError(err_code, errmsg);
+    }
+
+    UniValue ret(UniValue::VOBJ);
+    ret.pushKV("filter", HexStr(filter.GetEncodedFilter()));
+    ret.pushKV("header", filter_header.GetHex());
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         argNames
   //  --------------------- ------------------------  -----------------------  ----------
@@ -2245,9 +2523,11 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "getspecialtxes",         &getspecialtxes,         {"blockhash", "type", "count", "skip", "verbosity"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
+    { "blockchain",         "dumptxoutset",           &dumptxoutset,           {"path"} },
+    { "blockchain",         "getblockfilter",         &getblockfilter,         {"blockhash", "filtertype"} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
 
     { "blockchain",         "preciousblock",          &preciousblock,          {"blockhash"} },
@@ -7,6 +7,8 @@
 
 class CBlock;
 class CBlockIndex;
+class CChainSnapshot;
+class CJSONStreamWriter;
 class UniValue;
 
 /**
@@ -23,14 +25,22 @@ void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 
 /** Block description to JSON */
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+/** Block description to JSON relative to chain; does not require cs_main if chain contains blockindex */
+UniValue blockToJSON(const CChainSnapshot& chain, const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+/** Block description written to writer, one transaction at a time */
+void blockToJSON(CJSONStreamWriter& writer, const CChainSnapshot& chain, const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 
 /** Mempool information to JSON */
 UniValue mempoolInfoToJSON();
 
 /** Mempool to JSON */
 UniValue mempoolToJSON(bool fVerbose = false);
+/** Mempool written to writer, one entry at a time */
+void mempoolToJSON(CJSONStreamWriter& writer, bool fVerbose = false);
 
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex* blockindex);
+/** Block header to JSON relative to chain; does not require cs_main if chain contains blockindex */
+UniValue blockheaderToJSON(const CChainSnapshot& chain, const CBlockIndex* blockindex);
 
 #endif
@@ -671,10 +671,8 @@ UniValue gobject_vote_alias(const JSONRPCRequest& request)
 }
 #endif
 
-UniValue ListObjects(const std::string& strCachedSignal, const std::string& strType, int nStartTime)
+void ListObjects(CJSONStreamWriter& writer, const std::string& strCachedSignal, const std::string& strType, int nStartTime)
 {
-    UniValue objResult(UniValue::VOBJ);
-
     // GET MATCHING GOVERNANCE OBJECTS
 
     LOCK2(cs_main, governance.cs);
@@ -684,6 +682,7 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
 
     // CREATE RESULTS FOR USER
 
+    writer.BeginObject();
     for (const auto& pGovObj : objs) {
         if (strCachedSignal == "valid" && !pGovObj->IsSetCachedValid()) continue;
         if (strCachedSignal == "funding" && !pGovObj->IsSetCachedFunding()) continue;
@@ -720,10 +719,9 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
         bObj.pushKV("fCachedDelete",  pGovObj->IsSetCachedDelete());
         bObj.pushKV("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed());
 
-        objResult.pushKV(pGovObj->GetHash().ToString(), bObj);
+        writer.pushKV(pGovObj->GetHash().ToString(), std::move(bObj));
     }
-
-    return objResult;
+    writer.EndObject();
 }
 
 void gobject_list_help()
@@ -756,7 +754,9 @@ UniValue gobject_list(const JSONRPCRequest& request)
     if (strType != "proposals" && strType != "triggers" && strType != "all")
         return "Invalid type, should be 'proposals', 'triggers' or 'all'";
 
-    return ListObjects(strCachedSignal, strType, 0);
+    CJSONStreamWriter treeWriter;
+    ListObjects(request.stream ? *request.stream : treeWriter, strCachedSignal, strType, 0);
+    return std::move(treeWriter).TakeValue();
 }
 
 void gobject_diff_help()
@@ -789,7 +789,9 @@ UniValue gobject_diff(const JSONRPCRequest& request)
     if (strType != "proposals" && strType != "triggers" && strType != "all")
         return "Invalid type, should be 'proposals', 'triggers' or 'all'";
 
-    return ListObjects(strCachedSignal, strType, governance.GetLastDiffTime());
+    CJSONStreamWriter treeWriter;
+    ListObjects(request.stream ? *request.stream : treeWriter, strCachedSignal, strType, governance.GetLastDiffTime());
+    return std::move(treeWriter).TakeValue();
 }
 
 void gobject_get_help()
@@ -0,0 +1,145 @@
+// Copyright (c) 2014-2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonstream.h>
+
+#include <assert.h>
+
+CJSONStreamWriter::CJSONStreamWriter() : nFlushSize(0)
+{
+}
+
+CJSONStreamWriter::CJSONStreamWriter(Sink sinkIn, size_t nFlushSizeIn) : sink(std::move(sinkIn)), nFlushSize(nFlushSizeIn)
+{
+    assert(sink);
+}
+
+void CJSONStreamWriter::BeginValue()
+{
+    assert(!fComplete);
+    if (IsTree()) {
+        assert(vOpen.empty() || vOpen.back().second.isArray() || fHaveKey);
+        return;
+    }
+
+    if (!vFirst.empty()) {
+        // Keys of objects already wrote their separator
+        if (fHaveKey) {
+            fHaveKey = false;
+        } else {
+            if (!vFirst.back()) {
+                strBuffer += ',';
+            }
+            vFirst.back() = false;
+        }
+    }
+}
+
+void CJSONStreamWriter::AddToTree(UniValue&& value)
+{
+    if (vOpen.empty()) {
+        root = std::move(value);
+        fComplete = true;
+    } else if (vOpen.back().second.isArray()) {
+        vOpen.back().second.push_back(std::move(value));
+    } else {
+        vOpen.back().second.pushKV(strKey, std::move(value));
+        fHaveKey = false;
+    }
+}
+
+void CJSONStreamWriter::Begin(UniValue::VType type)
+{
+    BeginValue();
+    if (IsTree()) {
+        vOpen.emplace_back(fHaveKey ? strKey : std::string(), UniValue(type));
+        fHaveKey = false;
+        return;
+    }
+    strBuffer += (type == UniValue::VOBJ ? '{' : '[');
+    vFirst.push_back(true);
+}
+
+void CJSONStreamWriter::End(UniValue::VType type)
+{
+    assert(!fHaveKey);
+    if (IsTree()) {
+        assert(!vOpen.empty() && vOpen.back().second.getType() == type);
+        std::pair<std::string, UniValue> closed = std::move(vOpen.back());
+        vOpen.pop_back();
+        if (!vOpen.empty() && vOpen.back().second.isObject()) {
+            strKey = std::move(closed.first);
+            fHaveKey = true;
+        }
+        AddToTree(std::move(closed.second));
+        return;
+    }
+
+    assert(!vFirst.empty());
+    vFirst.pop_back();
+    strBuffer += (type == UniValue::VOBJ ? '}' : ']');
+    if (vFirst.empty()) {
+        fComplete = true;
+        Flush();
+    } else if (strBuffer.size() >= nFlushSize) {
+        Flush();
+    }
+}
+
+void CJSONStreamWriter::Key(const std::string& key)
+{
+    assert(!fHaveKey);
+    if (IsTree()) {
+        assert(!vOpen.empty() && vOpen.back().second.isObject());
+        strKey = key;
+        fHaveKey = true;
+        return;
+    }
+
+    assert(!vFirst.empty());
+    if (!vFirst.back()) {
+        strBuffer += ',';
+    }
+    vFirst.back() = false;
+    strBuffer += UniValue(key).write();
+    strBuffer += ':';
+    fHaveKey = true;
+}
+
+void CJSONStreamWriter::Value(const UniValue& value)
+{
+    if (IsTree()) {
+        Value(UniValue(value));
+        return;
+    }
+
+    BeginValue();
+    strBuffer += value.write();
+    if (vFirst.empty()) {
+        fComplete = true;
+        Flush();
+    } else if (strBuffer.size() >= nFlushSize) {
+        Flush();
+    }
+}
+
+void CJSONStreamWriter::Value(UniValue&& value)
+{
+    if (!IsTree()) {
+        Value(static_cast<const UniValue&>(value));
+        return;
+    }
+
+    BeginValue();
+    AddToTree(std::move(value));
+}
+
+void CJSONStreamWriter::Flush()
+{
+    if (IsTree() || strBuffer.empty()) {
+        return;
+    }
+    sink(strBuffer);
+    strBuffer.clear();
+}
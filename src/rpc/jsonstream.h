@@ -0,0 +1,102 @@
+// Copyright (c) 2014-2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONSTREAM_H
+#define BITCOIN_RPC_JSONSTREAM_H
+
+#include <univalue.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Incremental JSON writer for large RPC results.
+ *
+ * A text writer serializes values as they are written and hands the text to
+ * a sink, producing exactly what UniValue::write() would produce for the
+ * equivalent tree. A tree writer builds that UniValue instead, so a result
+ * only has to be described once for both streaming and non-streaming callers:
+ *
+ *     CJSONStreamWriter treeWriter;
+ *     CJSONStreamWriter& writer = request.stream ? *request.stream : treeWriter;
+ *     ... write the result to writer ...
+ *     return std::move(treeWriter).TakeValue();
+ */
+class CJSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string&)> Sink;
+
+    static const size_t DEFAULT_FLUSH_SIZE = 64 * 1024;
+
+private:
+    //! Text writer: the destination of the text, empty for tree writers
+    Sink sink;
+    size_t nFlushSize;
+    std::string strBuffer;
+    //! Text writer: for each open container, whether nothing was written to it yet
+    std::vector<bool> vFirst;
+
+    //! Tree writer: the open containers and the keys they will be stored under
+    std::vector<std::pair<std::string, UniValue>> vOpen;
+    UniValue root;
+
+    //! Key set by Key() for the next value written to an object
+    std::string strKey;
+    bool fHaveKey{false};
+    bool fComplete{false};
+
+    void BeginValue();
+    void AddToTree(UniValue&& value);
+    void Begin(UniValue::VType type);
+    void End(UniValue::VType type);
+
+public:
+    /** Create a tree writer, the result is retrieved with TakeValue(). */
+    CJSONStreamWriter();
+    /** Create a text writer handing about nFlushSize bytes at a time to sink. */
+    explicit CJSONStreamWriter(Sink sinkIn, size_t nFlushSizeIn = DEFAULT_FLUSH_SIZE);
+
+    void BeginObject() { Begin(UniValue::VOBJ); }
+    void EndObject() { End(UniValue::VOBJ); }
+    void BeginArray() { Begin(UniValue::VARR); }
+    void EndArray() { End(UniValue::VARR); }
+
+    /** Set the key of the next value written to the current object. */
+    void Key(const std::string& key);
+    /** Write a complete value, e.g. a single element built as a small UniValue. */
+    void Value(const UniValue& value);
+    /** Same as above, but a tree writer moves the value into the tree instead of copying it. */
+    void Value(UniValue&& value);
+
+    /** Counterparts of UniValue::pushKV and UniValue::push_back. */
+    void pushKV(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+    void pushKV(const std::string& key, UniValue&& value)
+    {
+        Key(key);
+        Value(std::move(value));
+    }
+    void push_back(const UniValue& value) { Value(value); }
+    void push_back(UniValue&& value) { Value(std::move(value)); }
+
+    /** Hand all buffered text to the sink. */
+    void Flush();
+
+    /** Whether a complete top level value has been written. */
+    bool IsComplete() const { return fComplete; }
+    /** Whether this writer builds a UniValue rather than text. */
+    bool IsTree() const { return !sink; }
+    /** The value built by a tree writer, or null if nothing was written. */
+    const UniValue& GetValue() const { return root; }
+    /** Move the value built by a tree writer out of it, avoiding a copy of the whole result. */
+    UniValue TakeValue() && { return std::move(root); }
+};
+
+#endif // BITCOIN_RPC_JSONSTREAM_H
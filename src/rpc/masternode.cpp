@@ -572,7 +572,9 @@ UniValue masternodelist(const JSONRPCRequest& request)
         masternode_list_help();
     }
 
-    UniValue obj(UniValue::VOBJ);
+    // Masternode lists can be long, so the entries are written one at a time
+    CJSONStreamWriter treeWriter;
+    CJSONStreamWriter& writer = request.stream ? *request.stream : treeWriter;
 
     auto mnList = deterministicMNManager->GetListAtChainTip();
     auto dmnToStatus = [&](const CDeterministicMNCPtr& dmn) {
@@ -594,6 +596,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
         return (int)pindex->nTime;
     };
 
+    writer.BeginObject();
     mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
         std::string strOutpoint = dmn->collateralOutpoint.ToStringShort();
         Coin coin;
@@ -616,7 +619,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
             std::string strAddress = dmn->pdmnState->addr.ToString(false);
             if (strFilter !="" && strAddress.find(strFilter) == std::string::npos &&
                 strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, strAddress);
+            writer.pushKV(strOutpoint, strAddress);
         } else if (strMode == "full") {
             std::ostringstream streamFull;
             streamFull << std::setw(18) <<
@@ -628,7 +631,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
             std::string strFull = streamFull.str();
             if (strFilter !="" && strFull.find(strFilter) == std::string::npos &&
                 strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, strFull);
+            writer.pushKV(strOutpoint, strFull);
         } else if (strMode == "info") {
             std::ostringstream streamInfo;
             streamInfo << std::setw(18) <<
@@ -638,7 +641,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
             std::string strInfo = streamInfo.str();
             if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
                 strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, strInfo);
+            writer.pushKV(strOutpoint, strInfo);
         } else if (strMode == "json") {
             std::ostringstream streamInfo;
             streamInfo <<  dmn->proTxHash.ToString() << " " <<
@@ -665,35 +668,36 @@ UniValue masternodelist(const JSONRPCRequest& request)
             objMN.pushKV("votingaddress", EncodeDestination(dmn->pdmnState->keyIDVoting));
             objMN.pushKV("collateraladdress", collateralAddressStr);
             objMN.pushKV("pubkeyoperator", dmn->pdmnState->pubKeyOperator.Get().ToString());
-            obj.pushKV(strOutpoint, objMN);
+            writer.pushKV(strOutpoint, std::move(objMN));
         } else if (strMode == "lastpaidblock") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, dmn->pdmnState->nLastPaidHeight);
+            writer.pushKV(strOutpoint, dmn->pdmnState->nLastPaidHeight);
         } else if (strMode == "lastpaidtime") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, dmnToLastPaidTime(dmn));
+            writer.pushKV(strOutpoint, dmnToLastPaidTime(dmn));
         } else if (strMode == "payee") {
             if (strFilter !="" && payeeStr.find(strFilter) == std::string::npos &&
                 strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, payeeStr);
+            writer.pushKV(strOutpoint, payeeStr);
         } else if (strMode == "owneraddress") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, EncodeDestination(dmn->pdmnState->keyIDOwner));
+            writer.pushKV(strOutpoint, EncodeDestination(dmn->pdmnState->keyIDOwner));
         } else if (strMode == "pubkeyoperator") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, dmn->pdmnState->pubKeyOperator.Get().ToString());
+            writer.pushKV(strOutpoint, dmn->pdmnState->pubKeyOperator.Get().ToString());
         } else if (strMode == "status") {
             std::string strStatus = dmnToStatus(dmn);
             if (strFilter !="" && strStatus.find(strFilter) == std::string::npos &&
                 strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, strStatus);
+            writer.pushKV(strOutpoint, strStatus);
         } else if (strMode == "votingaddress") {
             if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) return;
-            obj.pushKV(strOutpoint, EncodeDestination(dmn->pdmnState->keyIDVoting));
+            writer.pushKV(strOutpoint, EncodeDestination(dmn->pdmnState->keyIDVoting));
         }
     });
+    writer.EndObject();
 
-    return obj;
+    return std::move(treeWriter).TakeValue();
 }
 
 static const CRPCCommand commands[] =
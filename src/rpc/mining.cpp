@@ -297,6 +297,34 @@ std::string gbt_vb_name(const Consensus::DeploymentPos pos) {
     return s;
 }
 
+/** Transactions added to and removed from a block template compared to an older one on the same tip */
+static UniValue GetBlockTemplateDelta(const CBlockTemplateCache::Entry& base, const CBlockTemplateCache::Entry& current)
+{
+    std::set<uint256> setBaseTxids;
+    for (size_t i = 1; i < base.pblocktemplate->block.vtx.size(); i++) {
+        setBaseTxids.emplace(base.pblocktemplate->block.vtx[i]->GetHash());
+    }
+
+    UniValue added(UniValue::VARR);
+    for (size_t i = 1; i < current.pblocktemplate->block.vtx.size(); i++) {
+        const uint256& txid = current.pblocktemplate->block.vtx[i]->GetHash();
+        if (!setBaseTxids.erase(txid)) {
+            added.push_back(txid.GetHex());
+        }
+    }
+    // What is left was not included anymore
+    UniValue removed(UniValue::VARR);
+    for (const auto& txid : setBaseTxids) {
+        removed.push_back(txid.GetHex());
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.pushKV("basetemplateid", base.nId);
+    delta.pushKV("added", added);
+    delta.pushKV("removed", removed);
+    return delta;
+}
+
 UniValue getblocktemplate(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() > 1)
@@ -320,7 +348,8 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
             "       \"rules\":[            (array, optional) A list of strings\n"
             "           \"support\"          (string) client side supported softfork deployment\n"
             "           ,...\n"
-            "       ]\n"
+            "       ],\n"
+            "       \"knowntemplateid\":n  (numeric, optional) The templateid of a previous result, see \"delta\" below\n"
             "     }\n"
             "\n"
 
@@ -386,6 +415,12 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
             "  \"superblocks_started\" : true|false, (boolean) true, if superblock payments started\n"
             "  \"superblocks_enabled\" : true|false, (boolean) true, if superblock payments are enabled\n"
             "  \"coinbase_payload\" : \"xxxxxxxx\"    (string) coinbase transaction payload data encoded in hexadecimal\n"
+            "  \"templateid\" : n                  (numeric) id of the cached template this result was made from\n"
+            "  \"delta\" : {                       (json object, optional) only if knowntemplateid was given and that template was built on the same block\n"
+            "      \"basetemplateid\" : n,         (numeric) the knowntemplateid\n"
+            "      \"added\" : [ \"txid\", ... ],    (array of strings) transactions that are new in this template\n"
+            "      \"removed\" : [ \"txid\", ... ]   (array of strings) transactions of the known template which are not included anymore\n"
+            "  }\n"
             "}\n"
 
             "\nExamples:\n"
@@ -399,6 +434,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     UniValue lpval = NullUniValue;
     std::set<std::string> setClientRules;
     int64_t nMaxVersionPreVB = -1;
+    uint64_t nKnownTemplateId = 0;
     if (!request.params[0].isNull())
     {
         const UniValue& oparam = request.params[0].get_obj();
@@ -412,6 +448,11 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         else
             throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid mode");
         lpval = find_value(oparam, "longpollid");
+        const UniValue& knownval = find_value(oparam, "knowntemplateid");
+        if (knownval.isNum())
+            nKnownTemplateId = knownval.get_int64();
+        else if (!knownval.isNull())
+            throw JSONRPCError(RPC_TYPE_ERROR, "knowntemplateid must be a number");
 
         if (strMode == "proposal")
         {
@@ -475,45 +516,50 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         && CSuperblock::IsValidBlockHeight(chainActive.Height() + 1))
             throw JSONRPCError(RPC_CLIENT_IN_INITIAL_DOWNLOAD, "Dash Core is syncing with network...");
 
-    static unsigned int nTransactionsUpdatedLast;
+    if (!g_block_template_cache)
+        throw JSONRPCError(RPC_INTERNAL_ERROR, "Block template cache not initialized");
+
+    static uint64_t nTemplateIdLast;
 
     if (!lpval.isNull())
     {
-        // Wait to respond until either the best block changes, OR a minute has passed and there are more transactions
+        // Wait to respond until a template is announced because the best block changed or the fees
+        // improved notably, OR a minute has passed and there is any newer template
         uint256 hashWatchedChain;
         std::chrono::steady_clock::time_point checktxtime;
-        unsigned int nTransactionsUpdatedLastLP;
+        uint64_t nTemplateIdLastLP;
 
         if (lpval.isStr())
         {
-            // Format: <hashBestChain><nTransactionsUpdatedLast>
+            // Format: <hashBestChain><templateid>
             std::string lpstr = lpval.get_str();
 
             hashWatchedChain.SetHex(lpstr.substr(0, 64));
-            nTransactionsUpdatedLastLP = atoi64(lpstr.substr(64));
+            nTemplateIdLastLP = atoi64(lpstr.substr(64));
         }
         else
         {
             // NOTE: Spec does not specify behaviour for non-string longpollid, but this makes testing easier
             hashWatchedChain = chainActive.Tip()->GetBlockHash();
-            nTransactionsUpdatedLastLP = nTransactionsUpdatedLast;
+            nTemplateIdLastLP = nTemplateIdLast;
         }
 
         // Release the wallet and main lock while waiting
         LEAVE_CRITICAL_SECTION(cs_main);
         {
             checktxtime = std::chrono::steady_clock::now() + std::chrono::minutes(1);
+            const uint64_t nFailedBuilds = g_block_template_cache->GetFailedBuilds();
 
-            WaitableLock lock(g_best_block_mutex);
-            while (g_best_block == hashWatchedChain && IsRPCRunning())
+            while (IsRPCRunning() && !g_block_template_cache->WaitForAnnounced(hashWatchedChain, nTemplateIdLastLP, checktxtime))
             {
-                if (g_best_block_cv.wait_until(lock, checktxtime) == std::cv_status::timeout)
-                {
-                    // Timeout: Check transactions for update
-                    if (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLastLP)
-                        break;
-                    checktxtime += std::chrono::seconds(10);
-                }
+                // Building a template failed, stop waiting so that the error is reported below
+                if (g_block_template_cache->GetFailedBuilds() != nFailedBuilds)
+                    break;
+                // Timeout: Check transactions for update
+                auto latest = g_block_template_cache->GetLatest();
+                if (latest && latest->nId > nTemplateIdLastLP)
+                    break;
+                checktxtime += std::chrono::seconds(10);
             }
         }
         ENTER_CRITICAL_SECTION(cs_main);
@@ -523,30 +569,16 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
         // TODO: Maybe recheck connections/IBD and (if something wrong) send an expires-immediately template to stop miners?
     }
 
-    // Update block
-    static CBlockIndex* pindexPrev;
-    static int64_t nStart;
-    static std::unique_ptr<CBlockTemplate> pblocktemplate;
-    if (pindexPrev != chainActive.Tip() ||
-        (mempool.GetTransactionsUpdated() != nTransactionsUpdatedLast && GetTime() - nStart > 5))
-    {
-        // Clear pindexPrev so future calls make a new block, despite any failures from here on
-        pindexPrev = nullptr;
-
-        // Store the chainActive.Tip() used before CreateNewBlock, to avoid races
-        nTransactionsUpdatedLast = mempool.GetTransactionsUpdated();
-        CBlockIndex* pindexPrevNew = chainActive.Tip();
-        nStart = GetTime();
-
-        // Create new block
-        CScript scriptDummy = CScript() << OP_TRUE;
-        pblocktemplate = BlockAssembler(Params()).CreateNewBlock(scriptDummy);
-        if (!pblocktemplate)
-            throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
-
-        // Need to update only after we know CreateNewBlock succeeded
-        pindexPrev = pindexPrevNew;
-    }
+    // Get the cached block template, it is rebuilt when the tip changed or when the mempool changed
+    // and the template is older than 5 seconds
+    auto templateEntry = g_block_template_cache->Get(5 * 1000);
+    if (!templateEntry->pblocktemplate)
+        throw JSONRPCError(RPC_OUT_OF_MEMORY, "Out of memory");
+    nTemplateIdLast = templateEntry->nId;
+    const CBlockIndex* pindexPrev = templateEntry->pindexPrev;
+
+    // The cached template is shared, so the fields updated below are set on a copy
+    auto pblocktemplate = MakeUnique<CBlockTemplate>(*templateEntry->pblocktemplate);
     CBlock* pblock = &pblocktemplate->block; // pointer for convenience
     const Consensus::Params& consensusParams = Params().GetConsensus();
 
@@ -660,7 +692,7 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
     result.pushKV("transactions", transactions);
     result.pushKV("coinbaseaux", aux);
     result.pushKV("coinbasevalue", (int64_t)pblock->vtx[0]->GetValueOut());
-    result.pushKV("longpollid", chainActive.Tip()->GetBlockHash().GetHex() + i64tostr(nTransactionsUpdatedLast));
+    result.pushKV("longpollid", pindexPrev->GetBlockHash().GetHex() + i64tostr(templateEntry->nId));
     result.pushKV("target", hashTarget.GetHex());
     result.pushKV("mintime", (int64_t)pindexPrev->GetMedianTimePast()+1);
     result.pushKV("mutable", aMutable);
@@ -706,6 +738,12 @@ UniValue getblocktemplate(const JSONRPCRequest& request)
 
     result.pushKV("coinbase_payload", HexStr(pblock->vtx[0]->vExtraPayload));
 
+    result.pushKV("templateid", templateEntry->nId);
+    auto knownEntry = nKnownTemplateId > 0 ? g_block_template_cache->GetById(nKnownTemplateId) : nullptr;
+    if (knownEntry && knownEntry->pindexPrev == pindexPrev) {
+        result.pushKV("delta", GetBlockTemplateDelta(*knownEntry, *templateEntry));
+    }
+
     return result;
 }
 
@@ -8,15 +8,20 @@
 #include <clientversion.h>
 #include <consensus/consensus.h>
 #include <core_io.h>
+#include <evo/deterministicmns.h>
 #include <evo/mnauth.h>
+#include <index/addressindex.h>
+#include <index/spentindex.h>
 #include <init.h>
 #include <httpserver.h>
 #include <key_io.h>
+#include <metrics.h>
 #include <net.h>
 #include <netbase.h>
 #include <rpc/blockchain.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
+#include <stacktraces.h>
 #include <timedata.h>
 #include <txmempool.h>
 #include <util.h>
@@ -519,6 +524,104 @@ bool getAddressesFromParams(const UniValue& params, std::vector<std::pair<uint16
     return true;
 }
 
+/** Position of an address delta in the chain, serialized as in the address index. Used as pagination cursor. */
+static std::vector<unsigned char> getAddressDeltaPosition(const CAddressIndexKey& key)
+{
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << key;
+    // skip the address type and hash
+    return std::vector<unsigned char>(ss.begin() + 21, ss.end());
+}
+
+static CAddressIndexKey getAddressDeltaCursor(const std::string& strCursor)
+{
+    std::vector<unsigned char> data = ParseHex(strCursor);
+    if (!IsHex(strCursor) || data.size() != 45) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << CAddressIndexIteratorKey();
+    ss.write((const char*)data.data(), data.size());
+    CAddressIndexKey key;
+    ss >> key;
+    return key;
+}
+
+/** Orders deltas as getAddressDeltaPosition() would, comparing the key fields in their serialized byte order. */
+static bool deltaPositionSort(const std::pair<CAddressIndexKey, CAmount>& a,
+                              const std::pair<CAddressIndexKey, CAmount>& b) {
+    const CAddressIndexKey& ka = a.first;
+    const CAddressIndexKey& kb = b.first;
+    // height and txindex are stored big-endian, so their bytes sort like the unsigned values
+    if ((uint32_t)ka.blockHeight != (uint32_t)kb.blockHeight) {
+        return (uint32_t)ka.blockHeight < (uint32_t)kb.blockHeight;
+    }
+    if ((uint32_t)ka.txindex != (uint32_t)kb.txindex) {
+        return (uint32_t)ka.txindex < (uint32_t)kb.txindex;
+    }
+    int cmp = ka.txhash.Compare(kb.txhash);
+    if (cmp != 0) {
+        return cmp < 0;
+    }
+    // the output index is stored little-endian, compare its bytes as written
+    uint32_t indexA = htole32((uint32_t)ka.index);
+    uint32_t indexB = htole32((uint32_t)kb.index);
+    cmp = memcmp(&indexA, &indexB, sizeof(indexA));
+    if (cmp != 0) {
+        return cmp < 0;
+    }
+    return (unsigned char)ka.spending < (unsigned char)kb.spending;
+}
+
+/**
+ * Parse the optional "limit" and "cursor" fields of the addressindex RPCs. Returns whether
+ * a page was requested.
+ */
+static bool getPageFromParams(const UniValue& params, size_t& limit, std::unique_ptr<CAddressIndexKey>& after)
+{
+    if (!params[0].isObject()) {
+        return false;
+    }
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (limitValue.isNull()) {
+        if (!cursorValue.isNull()) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "cursor requires limit to be set");
+        }
+        return false;
+    }
+    if (!limitValue.isNum() || limitValue.get_int() <= 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "limit is expected to be a positive number");
+    }
+    limit = limitValue.get_int();
+    if (!cursorValue.isNull()) {
+        after.reset(new CAddressIndexKey(getAddressDeltaCursor(cursorValue.get_str())));
+    }
+    return true;
+}
+
+/**
+ * Read at most limit deltas of each address after the given position and merge them in chain order.
+ * horizon is set to the position of the last delta read for an address which has more deltas left;
+ * the merged deltas are complete up to it.
+ */
+static void getAddressDeltasPage(const std::vector<std::pair<uint160, int> >& addresses, int start, int end, size_t limit,
+                                 const CAddressIndexKey* after, std::vector<std::pair<CAddressIndexKey, CAmount> >& addressIndex,
+                                 std::unique_ptr<CAddressIndexKey>& horizon)
+{
+    for (const auto& address : addresses) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > deltas;
+        if (!GetAddressIndex(address.first, address.second, deltas, start, end, limit, after)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+        }
+        if (deltas.size() == limit && (!horizon || deltaPositionSort(deltas.back(), std::make_pair(*horizon, 0)))) {
+            horizon.reset(new CAddressIndexKey(deltas.back().first));
+        }
+        addressIndex.insert(addressIndex.end(), deltas.begin(), deltas.end());
+    }
+    std::sort(addressIndex.begin(), addressIndex.end(), deltaPositionSort);
+}
+
 bool heightSort(std::pair<CAddressUnspentKey, CAddressUnspentValue> a,
                 std::pair<CAddressUnspentKey, CAddressUnspentValue> b) {
     return a.second.blockHeight < b.second.blockHeight;
@@ -636,6 +739,10 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -682,6 +789,8 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many deltas, ordered by position in the chain\n"
+            "  \"cursor\" (string, optional) The cursor returned by the previous page\n"
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -694,6 +803,11 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (if limit is set):\n"
+            "{\n"
+            "  \"deltas\": [ ... ],  (array) The deltas as above\n"
+            "  \"cursor\": \"hex\"   (string) Pass as cursor to get the next page, not present on the last page\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -720,16 +834,33 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    size_t limit = 0;
+    std::unique_ptr<CAddressIndexKey> after;
+    bool fPage = getPageFromParams(request.params, limit, after);
+
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::unique_ptr<CAddressIndexKey> horizon;
 
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (start > 0 && end > 0) {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-            }
-        } else {
-            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+    if (fPage) {
+        getAddressDeltasPage(addresses, start, end, limit, after.get(), addressIndex, horizon);
+        if (addressIndex.size() > limit) {
+            addressIndex.resize(limit);
+            horizon.reset(new CAddressIndexKey(addressIndex.back().first));
+        }
+    } else {
+        for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+            if (start > 0 && end > 0) {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            } else {
+                if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
             }
         }
     }
@@ -752,6 +883,15 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         result.push_back(delta);
     }
 
+    if (fPage) {
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("deltas", result);
+        if (horizon) {
+            page.pushKV("cursor", HexStr(getAddressDeltaPosition(addressIndex.back().first)));
+        }
+        return page;
+    }
+
     return result;
 }
 
@@ -774,7 +914,8 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
             "  \"balance\": xxxxx,              (numeric) The current total balance in duffs\n"
             "  \"balance_immature\": xxxxx,     (numeric) The current immature balance in duffs\n"
             "  \"balance_spendable\": xxxxx,    (numeric) The current spendable balance in duffs\n"
-            "  \"received\": xxxxx              (numeric) The total number of duffs received (including change)\n"
+            "  \"received\": xxxxx,             (numeric) The total number of duffs received (including change)\n"
+            "  \"txcount\": xxxxx               (numeric) The number of transactions involving the address(es), counted once per address\n"
             "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressbalance", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
@@ -787,12 +928,8 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
     }
 
     int nHeight;
@@ -802,27 +939,41 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
     }
 
     CAmount balance = 0;
-    CAmount balance_spendable = 0;
     CAmount balance_immature = 0;
     CAmount received = 0;
+    int64_t txcount = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAddressBalanceValue value;
+        if (!GetAddressBalance((*it).first, (*it).second, value)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        if (it->first.txindex == 0 && nHeight - it->first.blockHeight < COINBASE_MATURITY) {
-            balance_immature += it->second;
-        } else {
-            balance_spendable += it->second;
+        balance += value.balance;
+        received += value.received;
+        txcount += value.txCount;
+
+        // Only coinbase outputs of the last COINBASE_MATURITY blocks can be immature
+        if (nHeight > 0) {
+            std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, std::max(1, nHeight - COINBASE_MATURITY + 1), nHeight)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            for (const auto& delta : addressIndex) {
+                if (delta.first.txindex == 0 && nHeight - delta.first.blockHeight < COINBASE_MATURITY) {
+                    balance_immature += delta.second;
+                }
+            }
         }
-        balance += it->second;
     }
 
+    CAmount balance_spendable = balance - balance_immature;
+
     UniValue result(UniValue::VOBJ);
     result.pushKV("balance", balance);
     result.pushKV("balance_immature", balance_immature);
     result.pushKV("balance_spendable", balance_spendable);
     result.pushKV("received", received);
+    result.pushKV("txcount", txcount);
 
     return result;
 
@@ -843,12 +994,19 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            "  \"limit\" (number, optional) Return at most this many txids, ordered by position in the chain\n"
+            "  \"cursor\" (string, optional) The cursor returned by the previous page\n"
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (if limit is set):\n"
+            "{\n"
+            "  \"txids\": [ ... ],   (array) The txids as above\n"
+            "  \"cursor\": \"hex\"   (string) Pass as cursor to get the next page, not present on the last page\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"XwnLY9Tf7Zsef8gMGL2fhWA9ZmMjt4KPwg\"]}")
@@ -871,8 +1029,50 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    size_t limit = 0;
+    std::unique_ptr<CAddressIndexKey> after;
+    bool fPage = getPageFromParams(request.params, limit, after);
+
+    if (g_addressindex) {
+        g_addressindex->BlockUntilSyncedToCurrentChain();
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
+    if (fPage) {
+        std::unique_ptr<CAddressIndexKey> horizon;
+        getAddressDeltasPage(addresses, start, end, limit, after.get(), addressIndex, horizon);
+
+        // The deltas of one transaction are next to each other. Only transactions up to the horizon
+        // are known to be complete, deltas of the transaction at the horizon may be missing but
+        // the cursor skips the whole transaction anyway.
+        UniValue txidsPage(UniValue::VARR);
+        const CAddressIndexKey* last = nullptr;
+        bool fMore = horizon != nullptr;
+        for (const auto& delta : addressIndex) {
+            if (horizon && deltaPositionSort(std::make_pair(*horizon, 0), delta)) {
+                break;
+            }
+            if (!last || delta.first.txhash != last->txhash) {
+                if (txidsPage.size() == limit) {
+                    fMore = true;
+                    break;
+                }
+                txidsPage.push_back(delta.first.txhash.GetHex());
+            }
+            last = &delta.first;
+        }
+
+        UniValue page(UniValue::VOBJ);
+        page.pushKV("txids", txidsPage);
+        if (fMore && last) {
+            CAddressIndexKey cursor(0, uint160(), last->blockHeight, last->txindex, last->txhash,
+                                    std::numeric_limits<uint32_t>::max(), true);
+            page.pushKV("cursor", HexStr(getAddressDeltaPosition(cursor)));
+        }
+        return page;
+    }
+
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
         if (start > 0 && end > 0) {
             if (!GetAddressIndex((*it).first, (*it).second, addressIndex, start, end)) {
@@ -946,6 +1146,10 @@ UniValue getspentinfo(const JSONRPCRequest& request)
     CSpentIndexKey key(txid, outputIndex);
     CSpentIndexValue value;
 
+    if (g_spentindex) {
+        g_spentindex->BlockUntilSyncedToCurrentChain();
+    }
+
     if (!GetSpentIndex(key, value)) {
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unable to get spent info");
     }
@@ -971,6 +1175,23 @@ static UniValue RPCLockedMemoryInfo()
     return obj;
 }
 
+static UniValue RPCMNListCacheInfo()
+{
+    UniValue obj(UniValue::VOBJ);
+    if (!deterministicMNManager) {
+        return obj;
+    }
+    auto stats = deterministicMNManager->GetCacheStats();
+    obj.pushKV("lists", uint64_t(stats.nLists));
+    obj.pushKV("usage", uint64_t(stats.nUsage));
+    obj.pushKV("limit", uint64_t(stats.nLimit));
+    obj.pushKV("hits", stats.nHits);
+    obj.pushKV("misses", stats.nMisses);
+    obj.pushKV("diffs_replayed", stats.nDiffsReplayed);
+    obj.pushKV("max_replay", stats.nMaxReplayLength);
+    return obj;
+}
+
 #ifdef HAVE_MALLOC_INFO
 static std::string RPCMallocInfo()
 {
@@ -1012,6 +1233,15 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
             "    \"locked\": xxxxxx,       (numeric) Amount of bytes that succeeded locking. If this number is smaller than total, locking pages failed at some point and key data could be swapped to disk.\n"
             "    \"chunks_used\": xxxxx,   (numeric) Number allocated chunks\n"
             "    \"chunks_free\": xxxxx,   (numeric) Number unused chunks\n"
+            "  },\n"
+            "  \"mnlistcache\": {          (json object) Information about the masternode list cache\n"
+            "    \"lists\": xxxxx,         (numeric) Number of masternode lists in memory\n"
+            "    \"usage\": xxxxx,         (numeric) Estimated number of bytes used by them, not counting memory shared between lists twice\n"
+            "    \"limit\": xxxxx,         (numeric) Memory budget in bytes (see -mnlistcache)\n"
+            "    \"hits\": xxxxx,          (numeric) Number of lookups served from memory or a disk snapshot without replaying diffs\n"
+            "    \"misses\": xxxxx,        (numeric) Number of lookups which had to replay diffs\n"
+            "    \"diffs_replayed\": xxxxx, (numeric) Total number of diffs replayed\n"
+            "    \"max_replay\": xxxxx,    (numeric) Largest number of diffs replayed by a single lookup\n"
             "  }\n"
             "}\n"
             "\nResult (mode \"mallocinfo\"):\n"
@@ -1025,6 +1255,7 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     if (mode == "stats") {
         UniValue obj(UniValue::VOBJ);
         obj.pushKV("locked", RPCLockedMemoryInfo());
+        obj.pushKV("mnlistcache", RPCMNListCacheInfo());
         return obj;
     } else if (mode == "mallocinfo") {
 #ifdef HAVE_MALLOC_INFO
@@ -1037,6 +1268,151 @@ UniValue getmemoryinfo(const JSONRPCRequest& request)
     }
 }
 
+UniValue getmetrics(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 1)
+        throw std::runtime_error(
+            "getmetrics ( \"prefix\" )\n"
+            "Returns latency histograms of hot code paths, collected since startup. All times are in microseconds\n"
+            "and percentiles have a relative error of at most 12.5%.\n"
+            "\nArguments:\n"
+            "1. \"prefix\"     (string, optional, default: \"\") Only return metrics whose name starts with this prefix.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": {             (json object) A histogram, e.g. \"validation.atmp\" or \"net.processmessage.tx\"\n"
+            "    \"count\": xxxxx,     (numeric) Number of samples\n"
+            "    \"sum\": xxxxx,       (numeric) Sum of all samples\n"
+            "    \"mean\": xxxxx,      (numeric) Mean of all samples\n"
+            "    \"min\": xxxxx,       (numeric) Smallest sample\n"
+            "    \"p50\": xxxxx,       (numeric) Median\n"
+            "    \"p90\": xxxxx,       (numeric) 90th percentile\n"
+            "    \"p99\": xxxxx,       (numeric) 99th percentile\n"
+            "    \"p999\": xxxxx,      (numeric) 99.9th percentile\n"
+            "    \"max\": xxxxx,       (numeric) Largest sample\n"
+            "  },\n"
+            "  ...\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmetrics", "")
+            + HelpExampleCli("getmetrics", "\"validation.\"")
+            + HelpExampleRpc("getmetrics", "\"llmq.\"")
+        );
+
+    const std::string strPrefix = request.params[0].isNull() ? "" : request.params[0].get_str();
+
+    UniValue obj(UniValue::VOBJ);
+    for (const auto& p : g_metrics.GetSnapshots(strPrefix)) {
+        const CLatencyHistogramSnapshot& snapshot = p.second;
+        UniValue histogram(UniValue::VOBJ);
+        histogram.pushKV("count", snapshot.nCount);
+        histogram.pushKV("sum", snapshot.nSum);
+        histogram.pushKV("mean", snapshot.GetMean());
+        histogram.pushKV("min", snapshot.nMin);
+        histogram.pushKV("p50", snapshot.GetPercentile(0.5));
+        histogram.pushKV("p90", snapshot.GetPercentile(0.9));
+        histogram.pushKV("p99", snapshot.GetPercentile(0.99));
+        histogram.pushKV("p999", snapshot.GetPercentile(0.999));
+        histogram.pushKV("max", snapshot.nMax);
+        obj.pushKV(p.first, histogram);
+    }
+    return obj;
+}
+
+UniValue getlockstats(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() > 2)
+        throw std::runtime_error(
+            "getlockstats ( count reset )\n"
+            "Returns the lock call sites which spent the most time waiting for contended locks, as collected by the\n"
+            "lock profiler (see -lockstats). All times are in microseconds.\n"
+            "\nArguments:\n"
+            "1. count     (numeric, optional, default=20) The number of call sites to return\n"
+            "2. reset     (boolean, optional, default=false) Clear the collected statistics afterwards\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"interval\": n,             (numeric) One in this many locks is sampled for its hold time, 0 if disabled\n"
+            "  \"sites\": [\n"
+            "    {\n"
+            "      \"lock\": \"name\",         (string) The locked expression, e.g. \"cs_main\"\n"
+            "      \"location\": \"file:line\", (string) Where the lock is taken\n"
+            "      \"contentions\": n,      (numeric) Number of times the lock had to be waited for\n"
+            "      \"wait_total\": n,       (numeric) Total time spent waiting\n"
+            "      \"wait_max\": n,         (numeric) Longest wait\n"
+            "      \"hold_samples\": n,     (numeric) Number of acquisitions sampled for their hold time\n"
+            "      \"hold_mean\": n,        (numeric) Mean hold time of the samples\n"
+            "      \"hold_max\": n,         (numeric) Longest sampled hold time\n"
+            "      \"wait_stacks\": [       (array) Sampled stacks of threads which had to wait, most frequent first\n"
+            "        {\n"
+            "          \"count\": n,        (numeric) How often this stack was sampled\n"
+            "          \"frames\": [ \"...\" ] (array of string) Innermost frame first\n"
+            "        }, ...\n"
+            "      ]\n"
+            "    }, ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getlockstats", "")
+            + HelpExampleCli("getlockstats", "5 true")
+            + HelpExampleRpc("getlockstats", "10")
+        );
+
+    const int nCount = request.params[0].isNull() ? 20 : request.params[0].get_int();
+    if (nCount < 0) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count must not be negative");
+    }
+    const bool fReset = request.params[1].isNull() ? false : request.params[1].get_bool();
+
+    std::vector<LockSiteStats> vSites = GetLockStats();
+    if (fReset) {
+        ResetLockStats();
+    }
+    std::sort(vSites.begin(), vSites.end(), [](const LockSiteStats& a, const LockSiteStats& b) {
+        return a.nWaitMicros != b.nWaitMicros ? a.nWaitMicros > b.nWaitMicros : a.nHoldMicros > b.nHoldMicros;
+    });
+    if (vSites.size() > (size_t)nCount) {
+        vSites.resize(nCount);
+    }
+
+    UniValue sites(UniValue::VARR);
+    for (const LockSiteStats& site : vSites) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("lock", site.strName);
+        obj.pushKV("location", site.strLocation);
+        obj.pushKV("contentions", site.nContentions);
+        obj.pushKV("wait_total", site.nWaitMicros);
+        obj.pushKV("wait_max", site.nMaxWaitMicros);
+        obj.pushKV("hold_samples", site.nHoldSamples);
+        obj.pushKV("hold_mean", site.nHoldSamples ? site.nHoldMicros / site.nHoldSamples : 0);
+        obj.pushKV("hold_max", site.nMaxHoldMicros);
+
+        std::vector<std::pair<uint64_t, const std::vector<uint64_t>*>> vStacks;
+        for (const auto& p : site.mapWaitStacks) {
+            vStacks.emplace_back(p.second, &p.first);
+        }
+        std::sort(vStacks.begin(), vStacks.end(), [](const std::pair<uint64_t, const std::vector<uint64_t>*>& a, const std::pair<uint64_t, const std::vector<uint64_t>*>& b) {
+            return a.first > b.first;
+        });
+        UniValue stacks(UniValue::VARR);
+        for (const auto& p : vStacks) {
+            UniValue stack(UniValue::VOBJ);
+            UniValue frames(UniValue::VARR);
+            for (const std::string& frame : GetStackFramesStrs(*p.second)) {
+                frames.push_back(frame);
+            }
+            stack.pushKV("count", p.first);
+            stack.pushKV("frames", frames);
+            stacks.push_back(stack);
+        }
+        obj.pushKV("wait_stacks", stacks);
+        sites.push_back(obj);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("interval", g_lock_stats_interval.load());
+    result.pushKV("sites", sites);
+    return result;
+}
+
 uint64_t getCategoryMask(UniValue cats) {
     cats = cats.get_array();
     uint64_t mask = 0;
@@ -1155,6 +1531,8 @@ static const CRPCCommand commands[] =
   //  --------------------- ------------------------  -----------------------  ----------
     { "control",            "debug",                  &debug,                  {} },
     { "control",            "getmemoryinfo",          &getmemoryinfo,          {"mode"} },
+    { "control",            "getlockstats",           &getlockstats,           {"count", "reset"} },
+    { "control",            "getmetrics",             &getmetrics,             {"prefix"} },
     { "control",            "logging",                &logging,                {"include", "exclude"}},
     { "util",               "validateaddress",        &validateaddress,        {"address"} }, /* uses wallet if enabled */
     { "util",               "createmultisig",         &createmultisig,         {"nrequired","keys"} },
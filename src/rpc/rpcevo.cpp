@@ -978,7 +978,9 @@ UniValue protx_list(const JSONRPCRequest& request)
         type = request.params[1].get_str();
     }
 
-    UniValue ret(UniValue::VARR);
+    // Masternode lists can be long, so the entries are written one at a time
+    CJSONStreamWriter treeWriter;
+    CJSONStreamWriter& writer = request.stream ? *request.stream : treeWriter;
 
     LOCK(cs_main);
 
@@ -1008,15 +1010,17 @@ UniValue protx_list(const JSONRPCRequest& request)
         }
 
         CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
+        writer.BeginArray();
         mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
             if (setOutpts.count(dmn->collateralOutpoint) ||
                 CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDOwner) ||
                 CheckWalletOwnsKey(pwallet, dmn->pdmnState->keyIDVoting) ||
                 CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptPayout) ||
                 CheckWalletOwnsScript(pwallet, dmn->pdmnState->scriptOperatorPayout)) {
-                ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+                writer.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
             }
         });
+        writer.EndArray();
 #endif
     } else if (type == "valid" || type == "registered") {
         if (request.params.size() > 4) {
@@ -1034,14 +1038,16 @@ UniValue protx_list(const JSONRPCRequest& request)
 
         CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]);
         bool onlyValid = type == "valid";
+        writer.BeginArray();
         mnList.ForEachMN(onlyValid, [&](const CDeterministicMNCPtr& dmn) {
-            ret.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
+            writer.push_back(BuildDMNListEntry(pwallet, dmn, detailed));
         });
+        writer.EndArray();
     } else {
         throw JSONRPCError(RPC_INVALID_PARAMETER, "invalid type specified");
     }
 
-    return ret;
+    return std::move(treeWriter).TakeValue();
 }
 
 void protx_info_help()
@@ -22,7 +22,10 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory> // for unique_ptr
+#include <mutex>
 #include <unordered_map>
 
 static CCriticalSection cs_rpcWarmup;
@@ -493,11 +496,62 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+/** State of a batch which is executed by several threads */
+struct JSONRPCBatchState
+{
+    JSONRPCBatchState(const JSONRPCRequest& jreqIn, const UniValue& vReqIn) :
+        jreq(jreqIn), vReq(vReqIn), vResults(vReqIn.size()) {}
+
+    const JSONRPCRequest jreq;
+    //! Only accessed while elements are left, which the batch caller waits for
+    const UniValue& vReq;
+    std::vector<UniValue> vResults;
+    std::atomic<size_t> nNext{0};
+
+    std::mutex cs;
+    std::condition_variable cond;
+    size_t nDone{0};
+
+    /** Execute elements until none is left */
+    void Run()
+    {
+        for (size_t i = nNext++; i < vResults.size(); i = nNext++) {
+            vResults[i] = JSONRPCExecOne(jreq, vReq[i]);
+            std::unique_lock<std::mutex> lock(cs);
+            if (++nDone == vResults.size()) {
+                cond.notify_all();
+            }
+        }
+    }
+};
+
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const std::function<bool(std::function<void()>)>& dispatch, int nParallel)
 {
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    if (!dispatch || nParallel <= 1 || vReq.size() <= 1) {
+        for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+
+        return ret.write() + "\n";
+    }
+
+    // Helpers take elements in order, as does this thread. A helper which only gets to run after
+    // all elements were taken returns right away, so a busy or full work queue can't stall the batch.
+    auto state = std::make_shared<JSONRPCBatchState>(jreq, vReq);
+    size_t nHelpers = std::min<size_t>(nParallel - 1, vReq.size() - 1);
+    for (size_t i = 0; i < nHelpers; i++) {
+        if (!dispatch([state]() { state->Run(); })) {
+            break;
+        }
+    }
+    state->Run();
+    {
+        std::unique_lock<std::mutex> lock(state->cs);
+        state->cond.wait(lock, [&state]() { return state->nDone == state->vResults.size(); });
+    }
+
+    for (auto& result : state->vResults)
+        ret.push_back(std::move(result));
 
     return ret.write() + "\n";
 }
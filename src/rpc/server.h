@@ -7,9 +7,11 @@
 #define BITCOIN_RPC_SERVER_H
 
 #include <amount.h>
+#include <rpc/jsonstream.h>
 #include <rpc/protocol.h>
 #include <uint256.h>
 
+#include <functional>
 #include <list>
 #include <map>
 #include <stdint.h>
@@ -44,8 +46,10 @@ public:
     std::string URI;
     std::string authUser;
     std::string peerAddr;
+    /** If set, the handler may write its result to this writer instead of returning it */
+    CJSONStreamWriter* stream;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), stream(nullptr) {}
     void parse(const UniValue& valRequest);
 };
 
@@ -206,6 +210,10 @@ extern std::string HelpExampleRpc(const std::string& methodname, const std::stri
 bool StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+/**
+ * Execute a batch of requests and return the replies in request order. Up to nParallel elements
+ * are executed at the same time, the additional threads are requested through dispatch.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const std::function<bool(std::function<void()>)>& dispatch = nullptr, int nParallel = 1);
 
 #endif // BITCOIN_RPC_SERVER_H
@@ -241,6 +241,42 @@ struct CAddressUnspentValue {
     }
 };
 
+struct CAddressBalanceValue {
+    CAmount balance;
+    CAmount received;
+    int64_t txCount;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(received);
+        READWRITE(txCount);
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        received = 0;
+        txCount = 0;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && received == 0 && txCount == 0;
+    }
+
+    CAddressBalanceValue& operator+=(const CAddressBalanceValue& other) {
+        balance += other.balance;
+        received += other.received;
+        txCount += other.txCount;
+        return *this;
+    }
+};
+
 struct CAddressIndexKey {
     unsigned int type;
     uint160 hashBytes;
@@ -541,6 +541,29 @@ static std::string GetCrashInfoStr(const crash_info& ci, size_t spaces)
     return s;
 }
 
+std::vector<uint64_t> GetCurrentStackFrames(size_t skip, size_t max_frames)
+{
+    return GetStackFrames(skip + 1, max_frames);
+}
+
+std::vector<std::string> GetStackFramesStrs(const std::vector<uint64_t>& stackframes)
+{
+    std::vector<std::string> ret;
+    for (const auto& si : GetStackFrameInfos(stackframes)) {
+        std::string s = si.function.empty() ? "???" : si.function;
+        if (!si.filename.empty()) {
+            s += strprintf(" (%s:%d)", fs::path(si.filename).filename().string(), si.lineno);
+        }
+        ret.emplace_back(s);
+    }
+    if (ret.empty()) {
+        for (uint64_t pc : stackframes) {
+            ret.emplace_back(strprintf("0x%08X", pc));
+        }
+    }
+    return ret;
+}
+
 static void PrintCrashInfo(const crash_info& ci)
 {
     auto str = GetCrashInfoStr(ci);
@@ -8,6 +8,9 @@
 #include <string>
 #include <sstream>
 #include <exception>
+#include <vector>
+
+#include <stdint.h>
 
 #include <cxxabi.h>
 
@@ -36,6 +39,11 @@ inline std::string GetExceptionWhat(const T& e)
     return s.str();
 }
 
+/** Return the program counters of the current thread's stack, skipping the innermost skip frames */
+std::vector<uint64_t> GetCurrentStackFrames(size_t skip, size_t max_frames);
+/** Return a "function (file:line)" description of each frame, or just the addresses if no debug info is available */
+std::vector<std::string> GetStackFramesStrs(const std::vector<uint64_t>& stackframes);
+
 void RegisterPrettyTerminateHander();
 void RegisterPrettySignalHandlers();
 
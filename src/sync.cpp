@@ -5,10 +5,14 @@
 #include <sync.h>
 
 #include <logging.h>
+#include <metrics.h>
+#include <stacktraces.h>
+#include <tinyformat.h>
 #include <utilstrencodings.h>
 
 #include <stdio.h>
 
+#include <algorithm>
 #include <map>
 #include <memory>
 #include <set>
@@ -23,6 +27,131 @@ void PrintLockContention(const char* pszName, const char* pszFile, int nLine)
 }
 #endif /* DEBUG_LOCKCONTENTION */
 
+std::atomic<int> g_lock_stats_interval{0};
+
+//! A stack trace is captured for one in this many contended LOCKs of each thread
+static const int LOCK_STATS_STACK_INTERVAL = 16;
+static const size_t LOCK_STATS_STACK_DEPTH = 16;
+static const size_t LOCK_STATS_MAX_STACKS_PER_SITE = 32;
+
+struct LockStatsData {
+    std::mutex mutex;
+    //! Keyed by the __FILE__ pointer and line of the LOCK
+    std::map<std::pair<const char*, int>, LockSiteStats> mapSites;
+} static lockstats;
+
+static LockSiteStats& GetLockSiteStats(const char* pszName, const char* pszFile, int nLine)
+{
+    LockSiteStats& site = lockstats.mapSites[std::make_pair(pszFile, nLine)];
+    if (site.strLocation.empty()) {
+        site.strName = pszName;
+        site.strLocation = strprintf("%s:%d", pszFile, nLine);
+    }
+    return site;
+}
+
+bool ShouldSampleLockSlow(int nInterval)
+{
+    static thread_local int nCounter = 0;
+    if (++nCounter < nInterval) {
+        return false;
+    }
+    nCounter = 0;
+    return true;
+}
+
+std::vector<uint64_t> GetLockContentionStack()
+{
+    if (g_lock_stats_interval.load(std::memory_order_relaxed) <= 0) {
+        return {};
+    }
+
+    static thread_local int nCounter = 0;
+    if (++nCounter < LOCK_STATS_STACK_INTERVAL) {
+        return {};
+    }
+    nCounter = 0;
+    return GetCurrentStackFrames(1, LOCK_STATS_STACK_DEPTH);
+}
+
+void RecordLockContention(const char* pszName, const char* pszFile, int nLine, int64_t nWaitMicros, std::vector<uint64_t> vStack)
+{
+    static CLatencyHistogram& histLockWait = g_metrics.GetHistogram("lock.wait");
+    histLockWait.Record(nWaitMicros);
+
+    if (g_lock_stats_interval.load(std::memory_order_relaxed) <= 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(lockstats.mutex);
+    LockSiteStats& site = GetLockSiteStats(pszName, pszFile, nLine);
+    site.nContentions++;
+    site.nWaitMicros += nWaitMicros;
+    site.nMaxWaitMicros = std::max<uint64_t>(site.nMaxWaitMicros, nWaitMicros);
+    if (!vStack.empty()) {
+        auto it = site.mapWaitStacks.find(vStack);
+        if (it != site.mapWaitStacks.end()) {
+            it->second++;
+        } else if (site.mapWaitStacks.size() < LOCK_STATS_MAX_STACKS_PER_SITE) {
+            site.mapWaitStacks.emplace(std::move(vStack), 1);
+        }
+    }
+}
+
+void RecordLockHold(const char* pszName, const char* pszFile, int nLine, int64_t nHoldMicros)
+{
+    std::lock_guard<std::mutex> lock(lockstats.mutex);
+    LockSiteStats& site = GetLockSiteStats(pszName, pszFile, nLine);
+    site.nHoldSamples++;
+    site.nHoldMicros += nHoldMicros;
+    site.nMaxHoldMicros = std::max<uint64_t>(site.nMaxHoldMicros, nHoldMicros);
+}
+
+void SetLockStatsInterval(int nInterval)
+{
+    g_lock_stats_interval = std::max(nInterval, 0);
+}
+
+std::vector<LockSiteStats> GetLockStats()
+{
+    // The same file:line may show up with different __FILE__ pointers when LOCK is used in headers
+    std::map<std::string, LockSiteStats> mapMerged;
+    {
+        std::lock_guard<std::mutex> lock(lockstats.mutex);
+        for (const auto& p : lockstats.mapSites) {
+            const LockSiteStats& site = p.second;
+            auto it = mapMerged.find(site.strLocation);
+            if (it == mapMerged.end()) {
+                mapMerged.emplace(site.strLocation, site);
+                continue;
+            }
+            LockSiteStats& merged = it->second;
+            merged.nContentions += site.nContentions;
+            merged.nWaitMicros += site.nWaitMicros;
+            merged.nMaxWaitMicros = std::max(merged.nMaxWaitMicros, site.nMaxWaitMicros);
+            merged.nHoldSamples += site.nHoldSamples;
+            merged.nHoldMicros += site.nHoldMicros;
+            merged.nMaxHoldMicros = std::max(merged.nMaxHoldMicros, site.nMaxHoldMicros);
+            for (const auto& stack : site.mapWaitStacks) {
+                merged.mapWaitStacks[stack.first] += stack.second;
+            }
+        }
+    }
+
+    std::vector<LockSiteStats> result;
+    result.reserve(mapMerged.size());
+    for (auto& p : mapMerged) {
+        result.emplace_back(std::move(p.second));
+    }
+    return result;
+}
+
+void ResetLockStats()
+{
+    std::lock_guard<std::mutex> lock(lockstats.mutex);
+    lockstats.mapSites.clear();
+}
+
 #ifdef DEBUG_LOCKORDER
 //
 // Early deadlock detection.
@@ -0,0 +1,222 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <dbwrapper.h>
+#include <index/addressindex.h>
+#include <index/spentindex.h>
+#include <script/sign.h>
+#include <script/standard.h>
+#include <test/test_dash.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <set>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(addressindex_tests)
+
+template <typename Index>
+static void WaitForSync(Index& index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+}
+
+static bool HasUnspent(const AddressIndex& index, const uint160& hash, int type, const COutPoint& outpoint)
+{
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspent;
+    BOOST_CHECK(index.ReadAddressUnspentIndex(hash, type, unspent));
+    for (const auto& entry : unspent) {
+        if (entry.first.txhash == outpoint.hash && entry.first.index == outpoint.n) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void CheckBalance(const AddressIndex& index, const uint160& hash, int type)
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > deltas;
+    BOOST_CHECK(index.ReadAddressIndex(hash, type, deltas));
+    CAddressBalanceValue expected;
+    std::set<uint256> txids;
+    for (const auto& delta : deltas) {
+        expected.balance += delta.second;
+        if (delta.second > 0) expected.received += delta.second;
+        txids.insert(delta.first.txhash);
+    }
+    expected.txCount = txids.size();
+
+    CAddressBalanceValue balance;
+    BOOST_CHECK(index.ReadAddressBalance(hash, type, balance));
+    BOOST_CHECK_EQUAL(balance.balance, expected.balance);
+    BOOST_CHECK_EQUAL(balance.received, expected.received);
+    BOOST_CHECK_EQUAL(balance.txCount, expected.txCount);
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_connect_disconnect, TestChain100Setup)
+{
+    AddressIndex address_index(1 << 20, true);
+    SpentIndex spent_index(1 << 20, true);
+    address_index.Start();
+    spent_index.Start();
+    WaitForSync(address_index);
+    WaitForSync(spent_index);
+
+    // Coinbase outputs of the test chain are P2PK, which are indexed under the key id.
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    uint160 coinbase_hash;
+    BOOST_CHECK_EQUAL(GetAddressIndexType(coinbase_script, coinbase_hash), 1);
+    BOOST_CHECK(coinbase_hash == uint160(coinbaseKey.GetPubKey().GetID()));
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > deltas;
+    BOOST_CHECK(address_index.ReadAddressIndex(coinbase_hash, 1, deltas));
+    BOOST_CHECK(deltas.size() >= coinbaseTxns.size());
+
+    const COutPoint spent_outpoint(coinbaseTxns[0].GetHash(), 0);
+    BOOST_CHECK(HasUnspent(address_index, coinbase_hash, 1, spent_outpoint));
+    CheckBalance(address_index, coinbase_hash, 1);
+
+    // Reading in pages of 10 deltas returns the same deltas as reading all of them at once.
+    std::vector<std::pair<CAddressIndexKey, CAmount> > paged;
+    while (true) {
+        std::vector<std::pair<CAddressIndexKey, CAmount> > page;
+        BOOST_CHECK(address_index.ReadAddressIndex(coinbase_hash, 1, page, 0, 0, 10, paged.empty() ? nullptr : &paged.back().first));
+        BOOST_CHECK(page.size() <= 10);
+        if (page.empty()) break;
+        paged.insert(paged.end(), page.begin(), page.end());
+    }
+    BOOST_REQUIRE_EQUAL(paged.size(), deltas.size());
+    for (size_t i = 0; i < deltas.size(); i++) {
+        BOOST_CHECK(paged[i].first.txhash == deltas[i].first.txhash);
+        BOOST_CHECK_EQUAL(paged[i].second, deltas[i].second);
+    }
+
+    // Spend the first coinbase to a fresh P2PKH address.
+    CKey dest_key;
+    dest_key.MakeNewKey(true);
+    const uint160 dest_hash = dest_key.GetPubKey().GetID();
+
+    CMutableTransaction spend;
+    spend.nVersion = 1;
+    spend.vin.resize(1);
+    spend.vin[0].prevout = spent_outpoint;
+    spend.vout.resize(1);
+    spend.vout[0].nValue = coinbaseTxns[0].vout[0].nValue - CENT;
+    spend.vout[0].scriptPubKey = GetScriptForDestination(dest_key.GetPubKey().GetID());
+    std::vector<unsigned char> vchSig;
+    uint256 sighash = SignatureHash(coinbase_script, spend, 0, SIGHASH_ALL, 0, SigVersion::BASE);
+    BOOST_CHECK(coinbaseKey.Sign(sighash, vchSig));
+    vchSig.push_back((unsigned char)SIGHASH_ALL);
+    spend.vin[0].scriptSig << vchSig;
+
+    const CBlock block = CreateAndProcessBlock({spend}, coinbase_script);
+    const uint256 spend_hash = spend.GetHash();
+    BOOST_CHECK(address_index.BlockUntilSyncedToCurrentChain());
+    BOOST_CHECK(spent_index.BlockUntilSyncedToCurrentChain());
+
+    deltas.clear();
+    BOOST_CHECK(address_index.ReadAddressIndex(dest_hash, 1, deltas));
+    BOOST_REQUIRE_EQUAL(deltas.size(), 1U);
+    BOOST_CHECK(deltas[0].first.txhash == spend_hash);
+    BOOST_CHECK_EQUAL(deltas[0].second, spend.vout[0].nValue);
+    BOOST_CHECK(HasUnspent(address_index, dest_hash, 1, COutPoint(spend_hash, 0)));
+    BOOST_CHECK(!HasUnspent(address_index, coinbase_hash, 1, spent_outpoint));
+
+    CSpentIndexValue spent_value;
+    BOOST_CHECK(spent_index.ReadSpentIndex(CSpentIndexKey(spent_outpoint.hash, spent_outpoint.n), spent_value));
+    BOOST_CHECK(spent_value.txid == spend_hash);
+    BOOST_CHECK(spent_value.addressHash == coinbase_hash);
+
+    CAddressBalanceValue balance;
+    BOOST_CHECK(address_index.ReadAddressBalance(dest_hash, 1, balance));
+    BOOST_CHECK_EQUAL(balance.balance, spend.vout[0].nValue);
+    BOOST_CHECK_EQUAL(balance.received, spend.vout[0].nValue);
+    BOOST_CHECK_EQUAL(balance.txCount, 1);
+    CheckBalance(address_index, coinbase_hash, 1);
+
+    // Disconnecting the block must unwind both indexes.
+    {
+        LOCK(cs_main);
+        CValidationState state;
+        BOOST_CHECK(InvalidateBlock(state, Params(), LookupBlockIndex(block.GetHash())));
+    }
+    SyncWithValidationInterfaceQueue();
+
+    deltas.clear();
+    BOOST_CHECK(address_index.ReadAddressIndex(dest_hash, 1, deltas));
+    BOOST_CHECK(deltas.empty());
+    BOOST_CHECK(!HasUnspent(address_index, dest_hash, 1, COutPoint(spend_hash, 0)));
+    BOOST_CHECK(HasUnspent(address_index, coinbase_hash, 1, spent_outpoint));
+    BOOST_CHECK(!spent_index.ReadSpentIndex(CSpentIndexKey(spent_outpoint.hash, spent_outpoint.n), spent_value));
+    BOOST_CHECK(address_index.ReadAddressBalance(dest_hash, 1, balance));
+    BOOST_CHECK(balance.IsNull());
+    CheckBalance(address_index, coinbase_hash, 1);
+
+    address_index.Interrupt();
+    spent_index.Interrupt();
+    address_index.Stop();
+    spent_index.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(addressindex_build_balances, TestChain100Setup)
+{
+    const fs::path db_path = GetDataDir() / "indexes" / "addressindex";
+    const CScript coinbase_script = CScript() << ToByteVector(coinbaseKey.GetPubKey()) << OP_CHECKSIG;
+    uint160 coinbase_hash;
+    BOOST_CHECK_EQUAL(GetAddressIndexType(coinbase_script, coinbase_hash), 1);
+
+    {
+        AddressIndex address_index(1 << 20);
+        address_index.Start();
+        WaitForSync(address_index);
+        address_index.Interrupt();
+        address_index.Stop();
+    }
+
+    // Turn the database into one written before the balance aggregates existed: the deltas
+    // and the best block are kept, the aggregates and the flag marking them as built are not.
+    {
+        CDBWrapper db(db_path, 1 << 20);
+        CDBBatch batch(db);
+        std::unique_ptr<CDBIterator> pcursor(db.NewIterator());
+        size_t n_balances = 0;
+        for (pcursor->Seek(std::make_pair('b', CAddressIndexIteratorKey())); pcursor->Valid(); pcursor->Next()) {
+            std::pair<char, CAddressIndexIteratorKey> key;
+            if (!pcursor->GetKey(key) || key.first != 'b') break;
+            batch.Erase(key);
+            n_balances++;
+        }
+        BOOST_CHECK(n_balances > 0);
+        BOOST_CHECK(db.Exists('A'));
+        BOOST_CHECK(db.Exists('B'));
+        batch.Erase('A');
+        BOOST_CHECK(db.WriteBatch(batch, true));
+    }
+
+    AddressIndex address_index(1 << 20);
+    CAddressBalanceValue balance;
+    BOOST_CHECK(address_index.ReadAddressBalance(coinbase_hash, 1, balance));
+    BOOST_CHECK(balance.IsNull());
+
+    // Init must notice the missing aggregates and rebuild them from the deltas.
+    address_index.Start();
+    WaitForSync(address_index);
+    BOOST_CHECK(address_index.ReadAddressBalance(coinbase_hash, 1, balance));
+    BOOST_CHECK(balance.balance > 0);
+    CheckBalance(address_index, coinbase_hash, 1);
+
+    address_index.Interrupt();
+    address_index.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,69 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <blockprefetcher.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <test/test_dash.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(blockprefetcher_tests)
+
+BOOST_FIXTURE_TEST_CASE(blockprefetcher_window, TestChain100Setup)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+
+    // A prefetcher which was never started never hands out blocks
+    CBlockPrefetcher disabled;
+    {
+        LOCK(cs_main);
+        disabled.Prefetch(chainActive[50], chainActive.Tip(), consensusParams);
+    }
+    BOOST_CHECK(!disabled.Take(chainActive[51]));
+
+    CBlockPrefetcher prefetcher;
+    prefetcher.Start(8, 2);
+    {
+        LOCK(cs_main);
+        prefetcher.Prefetch(chainActive[50], chainActive.Tip(), consensusParams);
+    }
+
+    auto pblock = prefetcher.Take(chainActive[51]);
+    BOOST_REQUIRE(pblock);
+    BOOST_CHECK(pblock->GetHash() == chainActive[51]->GetBlockHash());
+    BOOST_CHECK(pblock->fChecked);
+    BOOST_CHECK_EQUAL(prefetcher.GetHits(), 1U);
+
+    // Blocks are handed out only once
+    BOOST_CHECK(!prefetcher.Take(chainActive[51]));
+    // and only within the window
+    BOOST_CHECK(!prefetcher.Take(chainActive[59]));
+    BOOST_CHECK_EQUAL(prefetcher.GetMisses(), 2U);
+
+    // Moving the window drops the blocks behind the new tip and schedules the ones after it
+    {
+        LOCK(cs_main);
+        prefetcher.Prefetch(chainActive[55], chainActive.Tip(), consensusParams);
+    }
+    BOOST_CHECK(!prefetcher.Take(chainActive[53]));
+    for (int nHeight = 56; nHeight <= 63; nHeight++) {
+        pblock = prefetcher.Take(chainActive[nHeight]);
+        BOOST_REQUIRE(pblock);
+        BOOST_CHECK(pblock->GetHash() == chainActive[nHeight]->GetBlockHash());
+    }
+
+    // The window never extends past the last block
+    {
+        LOCK(cs_main);
+        prefetcher.Prefetch(chainActive.Tip()->pprev, chainActive.Tip()->pprev, consensusParams);
+    }
+    BOOST_CHECK(!prefetcher.Take(chainActive.Tip()));
+
+    prefetcher.Stop();
+    BOOST_CHECK(!prefetcher.Take(chainActive[64]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
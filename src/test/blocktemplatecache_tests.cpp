@@ -0,0 +1,120 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <miner.h>
+#include <test/test_dash.h>
+#include <txmempool.h>
+#include <utiltime.h>
+#include <validation.h>
+#include <validationinterface.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(blocktemplatecache_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(block_template_cache_get)
+{
+    CBlockTemplateCache cache(Params(), DEFAULT_BLOCK_TEMPLATE_REFRESH);
+
+    std::shared_ptr<const CBlockTemplateCache::Entry> entry1;
+    {
+        LOCK(cs_main);
+        entry1 = cache.Get(5 * 1000);
+        BOOST_CHECK(entry1->pindexPrev == chainActive.Tip());
+        BOOST_CHECK_EQUAL(entry1->pblocktemplate->block.vtx.size(), 1U);
+
+        // Nothing changed, the same template is served
+        BOOST_CHECK_EQUAL(cache.Get(5 * 1000)->nId, entry1->nId);
+
+        // A mempool change only causes a rebuild once the template is old enough
+        mempool.AddTransactionsUpdated(1);
+        BOOST_CHECK_EQUAL(cache.Get(5 * 1000)->nId, entry1->nId);
+        auto entry2 = cache.Get(0);
+        BOOST_CHECK(entry2->nId > entry1->nId);
+        BOOST_CHECK(entry2->pindexPrev == entry1->pindexPrev);
+
+        // Older templates can still be looked up
+        BOOST_CHECK(cache.GetById(entry1->nId) == entry1);
+        BOOST_CHECK(cache.GetById(entry2->nId + 1) == nullptr);
+    }
+
+    // A new tip always causes a rebuild
+    CreateAndProcessBlock({}, coinbaseKey);
+    {
+        LOCK(cs_main);
+        auto entry3 = cache.Get(5 * 1000);
+        BOOST_CHECK(entry3->pindexPrev == chainActive.Tip());
+        BOOST_CHECK(entry3->pblocktemplate->block.hashPrevBlock == chainActive.Tip()->GetBlockHash());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(block_template_cache_announce)
+{
+    CBlockTemplateCache cache(Params(), DEFAULT_BLOCK_TEMPLATE_REFRESH, DEFAULT_BLOCK_TEMPLATE_NOTIFY_FEE);
+
+    std::shared_ptr<const CBlockTemplateCache::Entry> entry1, entry2;
+    uint256 hashPrevBlock;
+    {
+        LOCK(cs_main);
+        hashPrevBlock = chainActive.Tip()->GetBlockHash();
+        entry1 = cache.Get(5 * 1000);
+        BOOST_CHECK_EQUAL(entry1->nFees, 0);
+        mempool.AddTransactionsUpdated(1);
+        entry2 = cache.Get(0);
+    }
+
+    // The first template is announced, a rebuild without better fees is not
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    BOOST_CHECK(cache.WaitForAnnounced(hashPrevBlock, 0, deadline) == entry1);
+    BOOST_CHECK(cache.WaitForAnnounced(hashPrevBlock, entry1->nId, deadline) == nullptr);
+
+    // A template on a new tip is always announced
+    CreateAndProcessBlock({}, coinbaseKey);
+    std::shared_ptr<const CBlockTemplateCache::Entry> entry3;
+    {
+        LOCK(cs_main);
+        entry3 = cache.Get(5 * 1000);
+    }
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    BOOST_CHECK(cache.WaitForAnnounced(hashPrevBlock, entry1->nId, deadline) == entry3);
+    BOOST_CHECK(cache.WaitForAnnounced(entry3->pindexPrev->GetBlockHash(), entry2->nId, deadline) == entry3);
+    BOOST_CHECK(cache.WaitForAnnounced(entry3->pindexPrev->GetBlockHash(), entry3->nId, deadline) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(block_template_cache_worker)
+{
+    CBlockTemplateCache cache(Params(), 100);
+    RegisterValidationInterface(&cache);
+    cache.Start();
+
+    uint64_t nId;
+    {
+        // Templates are only maintained after they were requested
+        LOCK(cs_main);
+        nId = cache.Get(5 * 1000)->nId;
+    }
+
+    CreateAndProcessBlock({}, coinbaseKey);
+    SyncWithValidationInterfaceQueue();
+
+    // The worker builds the template for the new tip on its own
+    std::shared_ptr<const CBlockTemplateCache::Entry> entry;
+    for (int i = 0; i < 200 && !entry; i++) {
+        MilliSleep(50);
+        entry = cache.GetById(nId + 1);
+    }
+    BOOST_CHECK(entry != nullptr);
+    if (entry) {
+        LOCK(cs_main);
+        BOOST_CHECK(entry->pindexPrev == chainActive.Tip());
+        BOOST_CHECK_EQUAL(cache.Get(5 * 1000)->nId, entry->nId);
+    }
+
+    UnregisterValidationInterface(&cache);
+    cache.Interrupt();
+    cache.Stop();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,8 @@
 
 #include <bls/bls.h>
 #include <bls/bls_batchverifier.h>
+#include <bls/bls_ies.h>
+#include <bls/bls_worker.h>
 #include <test/test_dash.h>
 
 #include <boost/test/unit_test.hpp>
@@ -152,6 +154,123 @@ BOOST_AUTO_TEST_CASE(batch_verifier_tests)
     // last message invalid from one source
     AddMessage(msgs, 1, 7, 1, false);
     Verify(msgs);
+
+    msgs.clear();
+    // many sources with a few invalid messages, found by bisecting the failed batch
+    for (uint32_t i = 0; i < 33; i++) {
+        AddMessage(msgs, i, i * 2, i, i != 5 && i != 32);
+        AddMessage(msgs, i, i * 2 + 1, i + 100, i != 17);
+    }
+    Verify(msgs);
+}
+
+BOOST_AUTO_TEST_CASE(bls_worker_contributions_tests)
+{
+    CBLSWorker blsWorker;
+    blsWorker.Start();
+
+    // More members than fit into a single verification batch of a DKG session
+    const size_t nMembers = 40;
+    const size_t nBatchSize = 32;
+    const int threshold = 24;
+    const size_t myIdx = 1;
+
+    BLSIdVector ids;
+    for (size_t i = 0; i < nMembers; i++) {
+        ids.emplace_back(InsecureRand256());
+    }
+    CBLSSecretKey operatorKey;
+    operatorKey.MakeNewKey();
+
+    // Contributions of all members, some can't be decrypted and some contain a share which doesn't match the vvec
+    const std::set<size_t> undecryptable{3, 35};
+    const std::set<size_t> invalid{7, 33};
+    std::vector<BLSVerificationVectorPtr> vvecs;
+    std::vector<std::shared_ptr<CBLSIESMultiRecipientObjects<CBLSSecretKey>>> encrypted;
+    for (size_t i = 0; i < nMembers; i++) {
+        BLSVerificationVectorPtr vvec;
+        BLSSecretKeyVector skShares;
+        BOOST_CHECK(blsWorker.GenerateContributions(threshold, ids, vvec, skShares));
+        if (invalid.count(i)) {
+            skShares[myIdx].MakeNewKey();
+        }
+        auto contributions = std::make_shared<CBLSIESMultiRecipientObjects<CBLSSecretKey>>();
+        contributions->InitEncrypt(nMembers);
+        BOOST_CHECK(contributions->Encrypt(myIdx, operatorKey.GetPublicKey(), skShares[myIdx], PROTOCOL_VERSION));
+        if (undecryptable.count(i)) {
+            contributions->blobs[myIdx].resize(5);
+        }
+        vvecs.emplace_back(vvec);
+        encrypted.emplace_back(contributions);
+    }
+
+    // The old synchronous path
+    std::vector<bool> syncResults(nMembers, false);
+    {
+        std::vector<size_t> memberIndexes;
+        std::vector<BLSVerificationVectorPtr> batchVvecs;
+        BLSSecretKeyVector batchSkShares;
+        for (size_t i = 0; i < nMembers; i++) {
+            CBLSSecretKey skShare;
+            if (!encrypted[i]->Decrypt(myIdx, operatorKey, skShare, PROTOCOL_VERSION)) {
+                continue;
+            }
+            memberIndexes.emplace_back(i);
+            batchVvecs.emplace_back(vvecs[i]);
+            batchSkShares.emplace_back(skShare);
+        }
+        auto result = blsWorker.VerifyContributionShares(ids[myIdx], batchVvecs, batchSkShares);
+        BOOST_REQUIRE_EQUAL(result.size(), memberIndexes.size());
+        for (size_t i = 0; i < memberIndexes.size(); i++) {
+            syncResults[memberIndexes[i]] = result[i];
+        }
+    }
+
+    // The worker pool path of CDKGSession: decrypt as contributions arrive and verify batches without waiting
+    std::vector<std::future<CBLSSecretKey>> decrypted;
+    for (size_t i = 0; i < nMembers; i++) {
+        decrypted.emplace_back(blsWorker.AsyncDecryptContribution(encrypted[i], myIdx, operatorKey, PROTOCOL_VERSION));
+    }
+    // The worker must not depend on the caller keeping the contributions alive
+    encrypted.clear();
+
+    struct Batch {
+        std::vector<size_t> memberIndexes;
+        std::vector<BLSVerificationVectorPtr> vvecs;
+        BLSSecretKeyVector skShares;
+        std::future<std::vector<bool>> result;
+    };
+    std::list<Batch> batches;
+    std::vector<bool> asyncResults(nMembers, false);
+    for (size_t start = 0; start < nMembers; start += nBatchSize) {
+        batches.emplace_back();
+        auto& batch = batches.back();
+        for (size_t i = start; i < std::min(start + nBatchSize, nMembers); i++) {
+            CBLSSecretKey skShare = decrypted[i].get();
+            if (!skShare.IsValid()) {
+                continue;
+            }
+            batch.memberIndexes.emplace_back(i);
+            batch.vvecs.emplace_back(vvecs[i]);
+            batch.skShares.emplace_back(skShare);
+        }
+        batch.result = blsWorker.AsyncVerifyContributionShares(ids[myIdx], batch.vvecs, batch.skShares, true, true);
+    }
+    for (auto& batch : batches) {
+        auto result = batch.result.get();
+        BOOST_REQUIRE_EQUAL(result.size(), batch.memberIndexes.size());
+        for (size_t i = 0; i < batch.memberIndexes.size(); i++) {
+            asyncResults[batch.memberIndexes[i]] = result[i];
+        }
+    }
+
+    for (size_t i = 0; i < nMembers; i++) {
+        const bool fValid = !undecryptable.count(i) && !invalid.count(i);
+        BOOST_CHECK_EQUAL(syncResults[i], fValid);
+        BOOST_CHECK_EQUAL(asyncResults[i], fValid);
+    }
+
+    blsWorker.Stop();
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,48 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/coinstats.h>
+#include <test/test_dash.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(coinstats_tests, TestChain100Setup)
+
+BOOST_AUTO_TEST_CASE(coinstats_parallel)
+{
+    FlushStateToDisk();
+
+    CCoinsStats statsSerialized;
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview.get(), statsSerialized));
+    BOOST_CHECK_EQUAL(statsSerialized.nHeight, chainActive.Height());
+
+    // Walking the ranges of the coin database in parallel must not lose or duplicate coins
+    CCoinsStats statsMuHash1, statsMuHash4, statsNone;
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview.get(), statsMuHash1, CoinStatsHashType::MUHASH, 1));
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview.get(), statsMuHash4, CoinStatsHashType::MUHASH, 4));
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview.get(), statsNone, CoinStatsHashType::NONE, 4));
+    for (const auto& stats : {statsMuHash1, statsMuHash4, statsNone}) {
+        BOOST_CHECK(stats.hashBlock == statsSerialized.hashBlock);
+        BOOST_CHECK_EQUAL(stats.nHeight, statsSerialized.nHeight);
+        BOOST_CHECK_EQUAL(stats.nTransactions, statsSerialized.nTransactions);
+        BOOST_CHECK_EQUAL(stats.nTransactionOutputs, statsSerialized.nTransactionOutputs);
+        BOOST_CHECK_EQUAL(stats.nBogoSize, statsSerialized.nBogoSize);
+        BOOST_CHECK_EQUAL(stats.nTotalAmount, statsSerialized.nTotalAmount);
+    }
+
+    // MuHash does not depend on the order the coins were combined in
+    BOOST_CHECK(statsMuHash1.hashSerialized == statsMuHash4.hashSerialized);
+    BOOST_CHECK(statsMuHash1.hashSerialized != statsSerialized.hashSerialized);
+
+    CreateAndProcessBlock({}, coinbaseKey);
+    FlushStateToDisk();
+    CCoinsStats statsMuHash2;
+    BOOST_CHECK(GetUTXOStats(pcoinsdbview.get(), statsMuHash2, CoinStatsHashType::MUHASH, 4));
+    BOOST_CHECK_EQUAL(statsMuHash2.nTransactions, statsMuHash1.nTransactions + 1);
+    BOOST_CHECK(statsMuHash2.hashSerialized != statsMuHash1.hashSerialized);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,91 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <llmq/quorums_dkgsessionhandler.h>
+#include <net_processing.h>
+#include <protocol.h>
+#include <streams.h>
+#include <test/test_dash.h>
+#include <version.h>
+
+#include <map>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(concurrent_messages_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(concurrent_message_types)
+{
+    for (const std::string strCommand : {NetMsgType::QCONTRIB, NetMsgType::QCOMPLAINT, NetMsgType::QJUSTIFICATION,
+                                         NetMsgType::QPCOMMITMENT, NetMsgType::QSIGSESANN, NetMsgType::QSIGSHARESINV,
+                                         NetMsgType::QGETSIGSHARES, NetMsgType::QBSIGSHARES, NetMsgType::QSIGSHARE,
+                                         NetMsgType::QSIGREC}) {
+        BOOST_CHECK_MESSAGE(IsConcurrentMessage(strCommand), strCommand);
+    }
+
+    // These rely on being processed one at a time on the main message handler thread
+    for (const std::string strCommand : {NetMsgType::MNAUTH, NetMsgType::MNGOVERNANCEOBJECTVOTE, NetMsgType::MNGOVERNANCEOBJECT,
+                                         NetMsgType::QWATCH, NetMsgType::QFCOMMITMENT, NetMsgType::ISLOCK, NetMsgType::CLSIG,
+                                         NetMsgType::VERSION, NetMsgType::INV, NetMsgType::TX, NetMsgType::BLOCK}) {
+        BOOST_CHECK_MESSAGE(!IsConcurrentMessage(strCommand), strCommand);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dkg_pending_messages_concurrent)
+{
+    // DKG messages of different peers are pushed from different message handler workers at the same time
+    const size_t nMaxMessagesPerNode = 10;
+    llmq::CDKGPendingMessages pendingMessages(nMaxMessagesPerNode, MSG_QUORUM_CONTRIB);
+
+    const NodeId nPeers = 8;
+    const int nMessagesPerPeer = 5;
+    const NodeId nodeFlooding = nPeers;
+    std::vector<std::thread> threads;
+    for (NodeId nodeId = 0; nodeId <= nPeers; nodeId++) {
+        threads.emplace_back([&, nodeId]() {
+            const int nCount = nodeId == nodeFlooding ? (int)nMaxMessagesPerNode * 2 : nMessagesPerPeer;
+            for (int i = 0; i < nCount; i++) {
+                CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+                ds << nodeId << i;
+                pendingMessages.PushPendingMessage(nodeId, ds);
+            }
+            // The same message relayed by every peer
+            CDataStream ds(SER_NETWORK, PROTOCOL_VERSION);
+            ds << std::string("relayed");
+            pendingMessages.PushPendingMessage(nodeId, ds);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto msgs = pendingMessages.PopPendingMessages(1000);
+    BOOST_CHECK(pendingMessages.PopPendingMessages(1000).empty());
+
+    size_t nRelayed = 0;
+    std::map<NodeId, int> mapNext;
+    for (auto& p : msgs) {
+        if (p.second->size() != sizeof(NodeId) + sizeof(int)) {
+            nRelayed++;
+            continue;
+        }
+        NodeId nodeId;
+        int i;
+        *p.second >> nodeId >> i;
+        BOOST_CHECK_EQUAL(nodeId, p.first);
+        // Each peer's messages are queued in the order it sent them
+        BOOST_CHECK_EQUAL(i, mapNext[nodeId]++);
+    }
+
+    // The relayed message is only queued once and the flooding peer is cut off at the limit
+    BOOST_CHECK_EQUAL(nRelayed, 1U);
+    for (NodeId nodeId = 0; nodeId < nPeers; nodeId++) {
+        BOOST_CHECK_EQUAL(mapNext[nodeId], nMessagesPerPeer);
+    }
+    BOOST_CHECK_EQUAL(mapNext[nodeFlooding], (int)nMaxMessagesPerNode);
+    BOOST_CHECK_EQUAL(msgs.size(), nPeers * nMessagesPerPeer + nMaxMessagesPerNode + nRelayed);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -648,4 +648,91 @@ BOOST_FIXTURE_TEST_CASE(dip3_verify_db, TestChainDIP3Setup)
     BOOST_ASSERT(CVerifyDB().VerifyDB(Params(), pcoinsTip.get(), 4, 2));
 }
 
+BOOST_FIXTURE_TEST_CASE(dip3_list_cache, TestChainDIP3Setup)
+{
+    auto utxos = BuildSimpleUtxoMap(coinbaseTxns);
+
+    std::vector<uint256> dmnHashes;
+    for (size_t i = 0; i < 3; i++) {
+        CKey ownerKey;
+        CBLSSecretKey operatorKey;
+        auto tx = CreateProRegTx(utxos, 100 + i, GenerateRandomAddress(), coinbaseKey, ownerKey, operatorKey);
+        dmnHashes.emplace_back(tx.GetHash());
+        CreateAndProcessBlock({tx}, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+    }
+    const CBlockIndex* pindexTip = chainActive.Tip();
+
+    // A manager with (almost) no budget only keeps the list for the tip and the one built last
+    CDeterministicMNManager tinyManager(*evoDb, 1);
+    tinyManager.UpdatedBlockTip(pindexTip);
+
+    BOOST_CHECK(tinyManager.GetListForBlock(pindexTip).HasMN(dmnHashes[2]));
+    auto stats = tinyManager.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.nMisses, 1U);
+    BOOST_CHECK(stats.nMaxReplayLength > 0);
+
+    BOOST_CHECK(tinyManager.GetListForBlock(pindexTip).HasMN(dmnHashes[2]));
+    BOOST_CHECK_EQUAL(tinyManager.GetCacheStats().nHits, 1U);
+
+    auto prevList = tinyManager.GetListForBlock(pindexTip->pprev);
+    BOOST_CHECK(prevList.HasMN(dmnHashes[1]));
+    BOOST_CHECK(!prevList.HasMN(dmnHashes[2]));
+    tinyManager.GetListForBlock(pindexTip->pprev->pprev);
+    stats = tinyManager.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.nMisses, 3U);
+    BOOST_CHECK(stats.nLists <= 2);
+    // The tip list survived the evictions
+    tinyManager.GetListForBlock(pindexTip);
+    BOOST_CHECK_EQUAL(tinyManager.GetCacheStats().nHits, 2U);
+
+    // With a large enough budget every list which was built once is served from memory
+    CDeterministicMNManager largeManager(*evoDb);
+    largeManager.UpdatedBlockTip(pindexTip);
+    for (const CBlockIndex* pindex = pindexTip; pindex != pindexTip->pprev->pprev->pprev; pindex = pindex->pprev) {
+        largeManager.GetListForBlock(pindex);
+    }
+    stats = largeManager.GetCacheStats();
+    const uint64_t nMisses = stats.nMisses;
+    for (const CBlockIndex* pindex = pindexTip; pindex != pindexTip->pprev->pprev->pprev; pindex = pindex->pprev) {
+        largeManager.GetListForBlock(pindex);
+    }
+    stats = largeManager.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.nMisses, nMisses);
+    BOOST_CHECK(stats.nUsage <= stats.nLimit);
+}
+
+BOOST_FIXTURE_TEST_CASE(dip3_list_cache_evicted_base, TestChainDIP3Setup)
+{
+    auto utxos = BuildSimpleUtxoMap(coinbaseTxns);
+
+    for (size_t i = 0; i < 3; i++) {
+        CKey ownerKey;
+        CBLSSecretKey operatorKey;
+        auto tx = CreateProRegTx(utxos, 100 + i, GenerateRandomAddress(), coinbaseKey, ownerKey, operatorKey);
+        CreateAndProcessBlock({tx}, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+    }
+    const CBlockIndex* pindexMNs = chainActive.Tip();
+    for (size_t i = 0; i < 2; i++) {
+        CreateAndProcessBlock({}, coinbaseKey);
+        deterministicMNManager->UpdatedBlockTip(chainActive.Tip());
+    }
+    const CBlockIndex* pindexTip = chainActive.Tip();
+
+    CDeterministicMNManager tinyManager(*evoDb, 1);
+    tinyManager.UpdatedBlockTip(pindexTip);
+
+    // The tip list is replayed from the cached list below it, which is evicted right away. From then
+    // on the tip list is the only one holding the masternodes and must be charged for all of them.
+    BOOST_CHECK_EQUAL(tinyManager.GetListForBlock(pindexMNs).GetAllMNsCount(), 3U);
+    auto tipList = tinyManager.GetListForBlock(pindexTip);
+    BOOST_CHECK_EQUAL(tipList.GetAllMNsCount(), 3U);
+
+    auto stats = tinyManager.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.nLists, 1U);
+    BOOST_CHECK(stats.nUsage >= CDeterministicMNList::EstimateEntriesUsage(tipList.GetAllMNsCount()));
+    BOOST_CHECK(stats.nUsage > CDeterministicMNList::EstimateEntriesUsage(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 #include <test/test_dash.h>
 
 #include <bls/bls.h>
+#include <consensus/merkle.h>
 #include <evo/simplifiedmns.h>
 #include <netbase.h>
 
@@ -67,4 +68,66 @@ BOOST_AUTO_TEST_CASE(simplifiedmns_merkleroots)
 
     BOOST_CHECK(expectedMerkleRoot == calculatedMerkleRoot);
 }
+
+BOOST_AUTO_TEST_CASE(sorted_merkle_tree)
+{
+    CSortedMerkleTree tree;
+    std::map<uint256, uint256> mapExpected;
+
+    BOOST_CHECK(tree.GetRoot().IsNull());
+
+    for (int i = 0; i < 200; i++) {
+        std::map<uint256, uint256> mapLeaves;
+        std::set<uint256> setRemoved;
+
+        // Mostly small changes, like between two blocks, but sometimes big ones
+        const int nChanges = InsecureRandBits(3) == 0 ? InsecureRandRange(100) : InsecureRandRange(4);
+        for (int j = 0; j < nChanges; j++) {
+            const int nOp = InsecureRandRange(3);
+            if (nOp == 0 || mapExpected.empty()) {
+                mapLeaves[InsecureRand256()] = InsecureRand256();
+                continue;
+            }
+            auto it = std::next(mapExpected.begin(), InsecureRandRange(mapExpected.size()));
+            if (nOp == 1) {
+                // sometimes use the hash of another leaf, which makes the tree mutated
+                mapLeaves[it->first] = InsecureRandBits(4) == 0 ? mapExpected.begin()->second : InsecureRand256();
+            } else if (!mapLeaves.count(it->first)) {
+                setRemoved.emplace(it->first);
+            }
+        }
+        for (const auto& p : mapLeaves) {
+            setRemoved.erase(p.first);
+        }
+        // also remove an unknown key, which must be ignored
+        setRemoved.emplace(InsecureRand256());
+
+        tree.Update(mapLeaves, setRemoved);
+        for (const auto& p : mapLeaves) {
+            mapExpected[p.first] = p.second;
+        }
+        for (const auto& h : setRemoved) {
+            mapExpected.erase(h);
+        }
+
+        std::vector<uint256> vLeaves;
+        for (const auto& p : mapExpected) {
+            vLeaves.emplace_back(p.second);
+        }
+        bool fMutated, fMutatedExpected;
+        BOOST_CHECK_EQUAL(tree.size(), mapExpected.size());
+        BOOST_CHECK(tree.GetRoot(&fMutated) == ComputeMerkleRoot(vLeaves, &fMutatedExpected));
+        BOOST_CHECK_EQUAL(fMutated, fMutatedExpected);
+    }
+
+    // Removing everything results in an empty tree again
+    std::set<uint256> setRemoved;
+    for (const auto& p : mapExpected) {
+        setRemoved.emplace(p.first);
+    }
+    tree.Update({}, setRemoved);
+    BOOST_CHECK_EQUAL(tree.size(), 0U);
+    BOOST_CHECK(tree.GetRoot().IsNull());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
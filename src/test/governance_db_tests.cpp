@@ -0,0 +1,79 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <clientversion.h>
+#include <governance/governance-db.h>
+#include <governance/governance-votedb.h>
+#include <streams.h>
+#include <test/test_dash.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(governance_db_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(governance_db_lazy_vote_file)
+{
+    governanceDb.reset(new CGovernanceDB(1 << 20, true));
+
+    const uint256 nParentHash = uint256S("0x1234");
+    std::vector<CGovernanceVote> vecVotes;
+    for (uint32_t i = 0; i < 3; i++) {
+        vecVotes.emplace_back(COutPoint(uint256S("0xabcd"), i), nParentHash, VOTE_SIGNAL_FUNDING, VOTE_OUTCOME_YES);
+    }
+
+    size_t nLoadedBefore = CGovernanceObjectVoteFile::GetLoadedVoteCount();
+    {
+        CGovernanceObjectVoteFile fileVotes;
+        for (const auto& vote : vecVotes) {
+            fileVotes.AddVote(vote);
+        }
+        BOOST_CHECK_EQUAL(fileVotes.GetVoteCount(), 3);
+        BOOST_CHECK_EQUAL(CGovernanceObjectVoteFile::GetLoadedVoteCount(), nLoadedBefore + 3);
+
+        // Votes are written as they are added
+        std::vector<CGovernanceVote> vecRead;
+        BOOST_CHECK(governanceDb->ReadVotes(nParentHash, vecRead));
+        BOOST_CHECK_EQUAL(vecRead.size(), 3U);
+        uint256 nParentHashRead;
+        BOOST_CHECK(governanceDb->ReadVoteParent(vecVotes[1].GetHash(), nParentHashRead));
+        BOOST_CHECK(nParentHashRead == nParentHash);
+
+        // Only the number of votes is serialized, the votes are loaded on first use
+        CDataStream ss(SER_DISK, CLIENT_VERSION);
+        ss << fileVotes;
+        CGovernanceObjectVoteFile fileVotes2;
+        ss >> fileVotes2;
+        fileVotes2.SetParentHash(nParentHash);
+        BOOST_CHECK(!fileVotes2.IsLoaded());
+        BOOST_CHECK_EQUAL(fileVotes2.GetVoteCount(), 3);
+        BOOST_CHECK(fileVotes2.HasVote(vecVotes[2].GetHash()));
+        BOOST_CHECK(fileVotes2.IsLoaded());
+        BOOST_CHECK_EQUAL(fileVotes2.GetVotes().size(), 3U);
+        BOOST_CHECK_EQUAL(CGovernanceObjectVoteFile::GetLoadedVoteCount(), nLoadedBefore + 6);
+
+        fileVotes2.Unload();
+        BOOST_CHECK(!fileVotes2.IsLoaded());
+        BOOST_CHECK_EQUAL(CGovernanceObjectVoteFile::GetLoadedVoteCount(), nLoadedBefore + 3);
+
+        // Removals are written through as well
+        fileVotes2.RemoveVotesFromMasternode(vecVotes[0].GetMasternodeOutpoint());
+        BOOST_CHECK_EQUAL(fileVotes2.GetVoteCount(), 2);
+        BOOST_CHECK(!governanceDb->ReadVoteParent(vecVotes[0].GetHash(), nParentHashRead));
+        vecRead.clear();
+        BOOST_CHECK(governanceDb->ReadVotes(nParentHash, vecRead));
+        BOOST_CHECK_EQUAL(vecRead.size(), 2U);
+
+        // Erasing the object erases its votes and their index entries
+        BOOST_CHECK(governanceDb->EraseObject(nParentHash));
+        vecRead.clear();
+        BOOST_CHECK(governanceDb->ReadVotes(nParentHash, vecRead));
+        BOOST_CHECK(vecRead.empty());
+        BOOST_CHECK(!governanceDb->ReadVoteParent(vecVotes[1].GetHash(), nParentHashRead));
+    }
+    BOOST_CHECK_EQUAL(CGovernanceObjectVoteFile::GetLoadedVoteCount(), nLoadedBefore);
+
+    governanceDb.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,73 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <dbwrapper.h>
+#include <llmq/quorums_instantsend.h>
+#include <test/test_dash.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+static CInstantSendLockPtr MakeInstantSendLock(size_t nInputs)
+{
+    auto islock = std::make_shared<CInstantSendLock>();
+    islock->txid = InsecureRand256();
+    for (size_t i = 0; i < nInputs; i++) {
+        islock->inputs.emplace_back(InsecureRand256(), i);
+    }
+    return islock;
+}
+
+BOOST_FIXTURE_TEST_SUITE(llmq_instantsend_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(islock_batch_commit)
+{
+    fs::path ph = SetDataDir("islock_batch_commit");
+    CDBWrapper dbw(ph, (1 << 20), true, true);
+    CInstantSendDb db(dbw);
+
+    // One round of locks, one of them for a TX which is mined already
+    std::vector<std::pair<uint256, CInstantSendLockPtr>> vecLocks;
+    for (size_t i = 0; i < 3; i++) {
+        auto islock = MakeInstantSendLock(i + 1);
+        vecLocks.emplace_back(::SerializeHash(*islock), islock);
+    }
+
+    CDBBatch batch(dbw);
+    for (const auto& p : vecLocks) {
+        db.WriteNewInstantSendLock(batch, p.first, p.second);
+    }
+    db.WriteInstantSendLockMined(batch, vecLocks[0].first, 100);
+
+    // Nothing is visible before the batch is committed, not even through the caches
+    for (const auto& p : vecLocks) {
+        BOOST_CHECK(!db.KnownInstantSendLock(p.first));
+        BOOST_CHECK(db.GetInstantSendLockByTxid(p.second->txid) == nullptr);
+        BOOST_CHECK(db.GetInstantSendLockByInput(p.second->inputs[0]) == nullptr);
+    }
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), 0U);
+
+    db.CommitNewInstantSendLocks(batch, vecLocks);
+
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), vecLocks.size());
+    for (const auto& p : vecLocks) {
+        BOOST_CHECK(db.KnownInstantSendLock(p.first));
+        BOOST_CHECK(db.GetInstantSendLockHashByTxid(p.second->txid) == p.first);
+        for (const auto& in : p.second->inputs) {
+            BOOST_CHECK(db.GetInstantSendLockByInput(in) == p.second);
+        }
+        // The lock is on disk and not only in the caches
+        auto islock = db.GetInstantSendLockByHash(p.first, false);
+        BOOST_CHECK(islock != nullptr && ::SerializeHash(*islock) == p.first);
+    }
+
+    // The mined height was written in the same batch
+    auto removed = db.RemoveConfirmedInstantSendLocks(100);
+    BOOST_CHECK_EQUAL(removed.size(), 1U);
+    BOOST_CHECK(removed.count(vecLocks[0].first));
+    BOOST_CHECK_EQUAL(db.GetInstantSendLockCount(), vecLocks.size() - 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
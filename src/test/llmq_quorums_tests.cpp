@@ -0,0 +1,253 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <evo/deterministicmns.h>
+#include <llmq/quorums.h>
+#include <llmq/quorums_utils.h>
+#include <test/test_dash.h>
+#include <utiltime.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace llmq;
+
+static CBLSPublicKey MakePubKeyShare()
+{
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    return sk.GetPublicKey();
+}
+
+static CQuorumPtr MakeQuorum(CBLSWorker& blsWorker, const uint256& quorumHash, const std::vector<uint256>& proTxHashes,
+                             const std::vector<bool>& validMembers, const BLSVerificationVector& vvec)
+{
+    std::vector<CDeterministicMNCPtr> members;
+    for (size_t i = 0; i < proTxHashes.size(); i++) {
+        auto dmn = std::make_shared<CDeterministicMN>(i);
+        dmn->proTxHash = proTxHashes[i];
+        members.emplace_back(dmn);
+    }
+
+    CFinalCommitment qc;
+    qc.llmqType = Consensus::LLMQ_50_60;
+    qc.quorumHash = quorumHash;
+    qc.validMembers = validMembers;
+    qc.quorumVvecHash = ::SerializeHash(vvec);
+
+    auto quorum = std::make_shared<CQuorum>(GetLLMQParams(Consensus::LLMQ_50_60), blsWorker);
+    quorum->Init(qc, nullptr, uint256(), members);
+    BOOST_CHECK(quorum->SetVerificationVector(vvec));
+    return quorum;
+}
+
+static BLSVerificationVector MakeVvec(size_t threshold)
+{
+    BLSVerificationVector vvec;
+    for (size_t i = 0; i < threshold; i++) {
+        vvec.emplace_back(MakePubKeyShare());
+    }
+    return vvec;
+}
+
+BOOST_FIXTURE_TEST_SUITE(llmq_quorums_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(pubkeyshare_cache_hits)
+{
+    CQuorumPubKeyShareCache cache(1024 * 1024);
+    const uint256 quorumKey = InsecureRand256();
+    const CBLSPublicKey pubKeyShare = MakePubKeyShare();
+
+    int nBuilds{0};
+    auto builder = [&]() {
+        nBuilds++;
+        return pubKeyShare;
+    };
+
+    CBLSPublicKey pubKeyShareRet;
+    BOOST_CHECK(!cache.Get(quorumKey, 0, pubKeyShareRet));
+    BOOST_CHECK(cache.GetOrBuild(quorumKey, 0, builder) == pubKeyShare);
+    BOOST_CHECK(cache.GetOrBuild(quorumKey, 0, builder) == pubKeyShare);
+    BOOST_CHECK_EQUAL(nBuilds, 1);
+    BOOST_CHECK(cache.Get(quorumKey, 0, pubKeyShareRet));
+    BOOST_CHECK(pubKeyShareRet == pubKeyShare);
+
+    // Other members and other quorums are cached separately
+    BOOST_CHECK(!cache.Get(quorumKey, 1, pubKeyShareRet));
+    BOOST_CHECK(!cache.Get(InsecureRand256(), 0, pubKeyShareRet));
+
+    // Shares inserted in a batch are hits, invalid (not recovered) ones are skipped
+    const uint256 quorumKey2 = InsecureRand256();
+    std::vector<CBLSPublicKey> vecShares{MakePubKeyShare(), CBLSPublicKey(), MakePubKeyShare()};
+    cache.Insert(quorumKey2, vecShares);
+    BOOST_CHECK(cache.GetOrBuild(quorumKey2, 2, builder) == vecShares[2]);
+    BOOST_CHECK_EQUAL(nBuilds, 1);
+    BOOST_CHECK(!cache.Get(quorumKey2, 1, pubKeyShareRet));
+
+    // Failed recoveries are not cached
+    BOOST_CHECK(!cache.GetOrBuild(quorumKey2, 1, []() { return CBLSPublicKey(); }).IsValid());
+    BOOST_CHECK(!cache.Get(quorumKey2, 1, pubKeyShareRet));
+}
+
+BOOST_AUTO_TEST_CASE(pubkeyshare_cache_eviction)
+{
+    // Too small for more than a single entry, so it truncates to one entry once it holds more than two
+    CQuorumPubKeyShareCache cache(1);
+    const uint256 quorumKey = InsecureRand256();
+
+    std::vector<CBLSPublicKey> vecShares;
+    for (size_t i = 0; i < 4; i++) {
+        vecShares.emplace_back(MakePubKeyShare());
+        BOOST_CHECK(cache.GetOrBuild(quorumKey, i, [&]() { return vecShares[i]; }) == vecShares[i]);
+    }
+
+    CBLSPublicKey pubKeyShareRet;
+    BOOST_CHECK(!cache.Get(quorumKey, 0, pubKeyShareRet));
+    BOOST_CHECK(!cache.Get(quorumKey, 1, pubKeyShareRet));
+    BOOST_CHECK(cache.Get(quorumKey, 3, pubKeyShareRet));
+    BOOST_CHECK(pubKeyShareRet == vecShares[3]);
+
+    // An evicted share is recovered again
+    int nBuilds{0};
+    BOOST_CHECK(cache.GetOrBuild(quorumKey, 0, [&]() { nBuilds++; return vecShares[0]; }) == vecShares[0]);
+    BOOST_CHECK_EQUAL(nBuilds, 1);
+}
+
+BOOST_AUTO_TEST_CASE(pubkeyshare_cache_concurrent)
+{
+    CQuorumPubKeyShareCache cache(1024 * 1024);
+    const uint256 quorumKey = InsecureRand256();
+    const CBLSPublicKey pubKeyShare = MakePubKeyShare();
+
+    std::atomic<int> nBuilds{0};
+    std::atomic<bool> fStarted{false};
+    std::atomic<bool> fRelease{false};
+    auto builder = [&]() {
+        nBuilds++;
+        fStarted = true;
+        while (!fRelease) {
+            MilliSleep(1);
+        }
+        return pubKeyShare;
+    };
+
+    std::vector<std::thread> threads;
+    std::vector<CBLSPublicKey> results(8);
+    threads.emplace_back([&]() { results[0] = cache.GetOrBuild(quorumKey, 0, builder); });
+    while (!fStarted) {
+        MilliSleep(1);
+    }
+    // All other lookups start while the share is still being recovered and wait for it
+    for (size_t i = 1; i < results.size(); i++) {
+        threads.emplace_back([&, i]() { results[i] = cache.GetOrBuild(quorumKey, 0, builder); });
+    }
+    MilliSleep(100);
+    fRelease = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    BOOST_CHECK_EQUAL(nBuilds, 1);
+    for (const auto& result : results) {
+        BOOST_CHECK(result == pubKeyShare);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pubkeyshare_cache_builder_throws)
+{
+    CQuorumPubKeyShareCache cache(1024 * 1024);
+    const uint256 quorumKey = InsecureRand256();
+    const CBLSPublicKey pubKeyShare = MakePubKeyShare();
+
+    std::atomic<bool> fStarted{false};
+    std::atomic<bool> fRelease{false};
+    auto throwingBuilder = [&]() -> CBLSPublicKey {
+        fStarted = true;
+        while (!fRelease) {
+            MilliSleep(1);
+        }
+        throw std::runtime_error("recovery failed");
+    };
+
+    std::vector<std::thread> threads;
+    std::atomic<int> nFailed{0};
+    threads.emplace_back([&]() {
+        BOOST_CHECK_THROW(cache.GetOrBuild(quorumKey, 0, throwingBuilder), std::runtime_error);
+        nFailed++;
+    });
+    while (!fStarted) {
+        MilliSleep(1);
+    }
+    // Threads waiting for the failed recovery get its exception
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&]() {
+            BOOST_CHECK_THROW(cache.GetOrBuild(quorumKey, 0, [&]() { return pubKeyShare; }), std::runtime_error);
+            nFailed++;
+        });
+    }
+    MilliSleep(100);
+    fRelease = true;
+    for (auto& t : threads) {
+        t.join();
+    }
+    BOOST_CHECK_EQUAL(nFailed, 5);
+
+    // The failed recovery is not left in flight, so the next lookup builds the share again
+    int nBuilds{0};
+    BOOST_CHECK(cache.GetOrBuild(quorumKey, 0, [&]() { nBuilds++; return pubKeyShare; }) == pubKeyShare);
+    BOOST_CHECK_EQUAL(nBuilds, 1);
+}
+
+BOOST_AUTO_TEST_CASE(pubkeyshares_write_read)
+{
+    CBLSWorker blsWorker;
+    const uint256 quorumHash = InsecureRand256();
+    const std::vector<uint256> proTxHashes{InsecureRand256(), InsecureRand256(), InsecureRand256(), InsecureRand256()};
+    const std::vector<bool> validMembers{true, false, true, true};
+    const auto vvec = MakeVvec(2);
+    auto quorum = MakeQuorum(blsWorker, quorumHash, proTxHashes, validMembers, vvec);
+
+    BOOST_CHECK(!quorum->ReadPubKeyShares(*evoDb));
+    quorum->WritePubKeyShares(*evoDb);
+    BOOST_CHECK(quorum->ReadPubKeyShares(*evoDb));
+
+    // A quorum built again from the same commitment finds the shares on disk
+    auto quorum2 = MakeQuorum(blsWorker, quorumHash, proTxHashes, validMembers, vvec);
+    BOOST_CHECK(quorum2->ReadPubKeyShares(*evoDb));
+    auto vvecPtr = std::make_shared<BLSVerificationVector>(vvec);
+    for (size_t i = 0; i < proTxHashes.size(); i++) {
+        if (validMembers[i]) {
+            BOOST_CHECK(quorum2->GetPubKeyShare(i) == blsWorker.BuildPubKeyShare(vvecPtr, CBLSId(proTxHashes[i])));
+        } else {
+            BOOST_CHECK(!quorum2->GetPubKeyShare(i).IsValid());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(pubkeyshares_read_invalid)
+{
+    CBLSWorker blsWorker;
+    const uint256 quorumHash = InsecureRand256();
+    const std::vector<uint256> proTxHashes{InsecureRand256(), InsecureRand256(), InsecureRand256()};
+    const std::vector<bool> validMembers{true, false, true};
+    const auto vvec = MakeVvec(2);
+    auto quorum = MakeQuorum(blsWorker, quorumHash, proTxHashes, validMembers, vvec);
+    quorum->WritePubKeyShares(*evoDb);
+
+    // Shares which don't match the valid members are rejected and deleted
+    auto quorumOtherMembers = MakeQuorum(blsWorker, quorumHash, proTxHashes, {true, true, true}, vvec);
+    BOOST_CHECK(!quorumOtherMembers->ReadPubKeyShares(*evoDb));
+    BOOST_CHECK(!quorum->ReadPubKeyShares(*evoDb));
+
+    // Shares which don't match the quorum vvec are rejected and deleted
+    quorum->WritePubKeyShares(*evoDb);
+    auto quorumOtherVvec = MakeQuorum(blsWorker, quorumHash, proTxHashes, validMembers, MakeVvec(2));
+    BOOST_CHECK(!quorumOtherVvec->ReadPubKeyShares(*evoDb));
+    BOOST_CHECK(!quorum->ReadPubKeyShares(*evoDb));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -2,6 +2,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <script/standard.h>
 #include <txmempool.h>
 #include <util.h>
 
@@ -751,4 +752,61 @@ BOOST_AUTO_TEST_CASE(MempoolAncestryTests)
     BOOST_CHECK_EQUAL(descendants, 6ULL);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolAddressSpentIndexTest)
+{
+    const CKeyID keyFrom(uint160(std::vector<unsigned char>(20, 0x11)));
+    const CKeyID keyTo(uint160(std::vector<unsigned char>(20, 0x22)));
+
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    const COutPoint prevout(uint256S("0x1234"), 1);
+    coins.AddCoin(prevout, Coin(CTxOut(5 * COIN, GetScriptForDestination(keyFrom)), 1, false), false);
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = prevout;
+    tx.vout.resize(2);
+    tx.vout[0].nValue = 3 * COIN;
+    tx.vout[0].scriptPubKey = GetScriptForDestination(keyTo);
+    tx.vout[1].nValue = 2 * COIN;
+    tx.vout[1].scriptPubKey = CScript() << OP_11 << OP_EQUAL;
+
+    CTxMemPool testPool;
+    TestMemPoolEntryHelper entry;
+    {
+        LOCK(testPool.cs);
+        testPool.addAddressIndex(entry.FromTx(tx), coins);
+        testPool.addSpentIndex(entry.FromTx(tx), coins);
+    }
+
+    // The indexes are read without the mempool lock
+    std::vector<std::pair<uint160, int> > addresses{{keyFrom, 1}, {keyTo, 1}};
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > deltas;
+    BOOST_CHECK(testPool.getAddressIndex(addresses, deltas));
+    BOOST_REQUIRE_EQUAL(deltas.size(), 2U);
+    BOOST_CHECK(deltas[0].first.addressBytes == keyFrom);
+    BOOST_CHECK_EQUAL(deltas[0].second.amount, -5 * COIN);
+    BOOST_CHECK(deltas[0].second.prevhash == prevout.hash);
+    BOOST_CHECK(deltas[1].first.addressBytes == keyTo);
+    BOOST_CHECK_EQUAL(deltas[1].second.amount, 3 * COIN);
+
+    CSpentIndexKey spentKey(prevout.hash, prevout.n);
+    CSpentIndexValue spentValue;
+    BOOST_CHECK(testPool.getSpentIndex(spentKey, spentValue));
+    BOOST_CHECK(spentValue.txid == tx.GetHash());
+    BOOST_CHECK(spentValue.addressHash == keyFrom);
+    CSpentIndexKey otherKey(prevout.hash, 0);
+    BOOST_CHECK(!testPool.getSpentIndex(otherKey, spentValue));
+
+    {
+        LOCK(testPool.cs);
+        testPool.removeAddressIndex(tx.GetHash());
+        testPool.removeSpentIndex(tx.GetHash());
+    }
+    deltas.clear();
+    BOOST_CHECK(testPool.getAddressIndex(addresses, deltas));
+    BOOST_CHECK(deltas.empty());
+    BOOST_CHECK(!testPool.getSpentIndex(spentKey, spentValue));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
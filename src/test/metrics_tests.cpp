@@ -0,0 +1,98 @@
+// Copyright (c) 2022 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <metrics.h>
+
+#include <test/test_dash.h>
+
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(metrics_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(histogram_buckets)
+{
+    // Small values are exact
+    for (int64_t i = 0; i < 2 * CLatencyHistogram::SUB_BUCKETS; i++) {
+        BOOST_CHECK_EQUAL(CLatencyHistogram::GetBucket(i), i);
+        BOOST_CHECK_EQUAL(CLatencyHistogram::GetBucketUpperBound(i), i);
+    }
+    BOOST_CHECK_EQUAL(CLatencyHistogram::GetBucket(-5), 0);
+
+    // Larger values are bucketed with a relative error of at most 1/8
+    for (int64_t v = 2 * CLatencyHistogram::SUB_BUCKETS; v < (int64_t{1} << CLatencyHistogram::MAX_VALUE_BITS); v += v / 97 + 1) {
+        int nBucket = CLatencyHistogram::GetBucket(v);
+        BOOST_CHECK(nBucket < CLatencyHistogram::BUCKETS);
+        BOOST_CHECK(v <= CLatencyHistogram::GetBucketUpperBound(nBucket));
+        BOOST_CHECK(v > CLatencyHistogram::GetBucketUpperBound(nBucket - 1));
+        if (nBucket < CLatencyHistogram::BUCKETS - 1) {
+            BOOST_CHECK(CLatencyHistogram::GetBucketUpperBound(nBucket) - v < v / 8 + 1);
+        }
+    }
+    BOOST_CHECK_EQUAL(CLatencyHistogram::GetBucket(std::numeric_limits<int64_t>::max()), CLatencyHistogram::BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(histogram_percentiles)
+{
+    CLatencyHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.GetSnapshot().nCount, 0U);
+    BOOST_CHECK_EQUAL(histogram.GetSnapshot().GetPercentile(0.99), 0);
+
+    // Record from several threads, so that multiple shards are used
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&histogram] {
+            for (int64_t v = 1; v <= 1000; v++) {
+                histogram.Record(v);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    CLatencyHistogramSnapshot snapshot = histogram.GetSnapshot();
+    BOOST_CHECK_EQUAL(snapshot.nCount, 4000U);
+    BOOST_CHECK_EQUAL(snapshot.nSum, 4 * 500500U);
+    BOOST_CHECK_EQUAL(snapshot.nMin, 1);
+    BOOST_CHECK_EQUAL(snapshot.nMax, 1000);
+    BOOST_CHECK_EQUAL(snapshot.GetMean(), 500.5);
+    BOOST_CHECK(snapshot.GetPercentile(0.5) >= 500 && snapshot.GetPercentile(0.5) <= 500 + 500 / 8);
+    BOOST_CHECK(snapshot.GetPercentile(0.99) >= 990 && snapshot.GetPercentile(0.99) <= 1000);
+    BOOST_CHECK_EQUAL(snapshot.GetPercentile(0), 1);
+    BOOST_CHECK_EQUAL(snapshot.GetPercentile(1), 1000);
+
+    // Only samples recorded after the previous snapshot are part of the interval
+    histogram.Record(5000);
+    CLatencyHistogramSnapshot interval = histogram.GetSnapshot().Since(snapshot);
+    BOOST_CHECK_EQUAL(interval.nCount, 1U);
+    BOOST_CHECK_EQUAL(interval.nSum, 5000U);
+    BOOST_CHECK_EQUAL(interval.nMax, 5000);
+    BOOST_CHECK(interval.nMin > 1000 && interval.nMin <= 5000);
+    BOOST_CHECK_EQUAL(interval.GetPercentile(0.5), 5000);
+}
+
+BOOST_AUTO_TEST_CASE(registry)
+{
+    CMetricsRegistry registry;
+    CLatencyHistogram& a = registry.GetHistogram("test.a");
+    BOOST_CHECK_EQUAL(&a, &registry.GetHistogram("test.a"));
+    registry.GetHistogram("test.b").Record(10);
+    registry.GetHistogram("other").Record(20);
+    a.Record(30);
+
+    auto snapshots = registry.GetSnapshots("test.");
+    BOOST_CHECK_EQUAL(snapshots.size(), 2U);
+    BOOST_CHECK_EQUAL(snapshots.at("test.a").nMax, 30);
+    BOOST_CHECK_EQUAL(snapshots.at("test.b").nMax, 10);
+    BOOST_CHECK_EQUAL(registry.GetSnapshots().size(), 3U);
+
+    {
+        CLatencyTimer timer(registry.GetHistogram("other"));
+    }
+    BOOST_CHECK_EQUAL(registry.GetSnapshots("other").at("other").nCount, 2U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
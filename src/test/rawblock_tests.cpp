@@ -0,0 +1,71 @@
+// Copyright (c) 2021 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <clientversion.h>
+#include <rawblock.h>
+#include <streams.h>
+#include <test/test_dash.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(rawblock_tests)
+
+static std::vector<unsigned char> SerializeBlock(const CBlockIndex* pindex)
+{
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << block;
+    return std::vector<unsigned char>(ss.begin(), ss.end());
+}
+
+static std::vector<unsigned char> ToVector(const CRawBlockRef& block)
+{
+    return std::vector<unsigned char>(block->data().data(), block->data().data() + block->data().size());
+}
+
+BOOST_FIXTURE_TEST_CASE(rawblock_read, TestChain100Setup)
+{
+    const CChainParams& chainparams = Params();
+
+    for (int nHeight : {0, 1, 50, 100}) {
+        const CBlockIndex* pindex;
+        CDiskBlockPos pos;
+        {
+            LOCK(cs_main);
+            pindex = chainActive[nHeight];
+            pos = pindex->GetBlockPos();
+        }
+        const std::vector<unsigned char> expected = SerializeBlock(pindex);
+
+        // The test chain lives in the block file still being written to, so it is read and cached
+        CRawBlockRef raw;
+        BOOST_REQUIRE(ReadRawBlockFromDisk(raw, pindex, chainparams.MessageStart()));
+        BOOST_CHECK(!raw->IsMapped());
+        BOOST_CHECK(ToVector(raw) == expected);
+
+        CRawBlockRef raw2;
+        BOOST_REQUIRE(ReadRawBlockFromDisk(raw2, pindex, chainparams.MessageStart()));
+        BOOST_CHECK(raw2 == raw);
+
+        // Nothing appends to it while the test runs, so it is safe to map here
+        CRawBlockReader reader(4);
+        CRawBlockRef mapped = reader.Read(pindex->GetBlockHash(), pos, true, chainparams.MessageStart());
+        BOOST_REQUIRE(mapped);
+#ifndef WIN32
+        BOOST_CHECK(mapped->IsMapped());
+#endif
+        BOOST_CHECK(ToVector(mapped) == expected);
+
+        // A wrong magic is rejected either way
+        CMessageHeader::MessageStartChars badStart = {0, 0, 0, 0};
+        BOOST_CHECK(!reader.Read(uint256(), pos, true, badStart));
+        BOOST_CHECK(!reader.Read(uint256(), pos, false, badStart));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
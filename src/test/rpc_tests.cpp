@@ -16,6 +16,8 @@
 
 #include <univalue.h>
 
+#include <thread>
+
 UniValue CallRPC(std::string args)
 {
     std::vector<std::string> vArgs;
@@ -311,6 +313,143 @@ BOOST_AUTO_TEST_CASE(rpc_ban)
     BOOST_CHECK_EQUAL(adr.get_str(), "2001:4d48:ac57:400:cacf:e9ff:fe1d:9c63/128");
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch_parallel)
+{
+    UniValue vReq(UniValue::VARR);
+    for (int i = 0; i < 50; i++) {
+        UniValue req(UniValue::VOBJ);
+        req.pushKV("id", i);
+        req.pushKV("method", i == 10 ? "nosuchmethod" : "echo");
+        UniValue params(UniValue::VARR);
+        params.push_back(i);
+        req.pushKV("params", params);
+        vReq.push_back(req);
+    }
+
+    std::vector<std::thread> threads;
+    auto dispatch = [&threads](std::function<void()> func) {
+        threads.emplace_back(std::move(func));
+        return true;
+    };
+    JSONRPCRequest jreq;
+    std::string strParallel = JSONRPCExecBatch(jreq, vReq, dispatch, 4);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    BOOST_CHECK_EQUAL(threads.size(), 3U);
+
+    // Replies are in request order and the same as when executed one by one
+    BOOST_CHECK_EQUAL(strParallel, JSONRPCExecBatch(jreq, vReq));
+    UniValue ret;
+    BOOST_CHECK(ret.read(strParallel));
+    BOOST_CHECK_EQUAL(ret.size(), 50U);
+    for (int i = 0; i < 50; i++) {
+        BOOST_CHECK_EQUAL(find_value(ret[i], "id").get_int(), i);
+        BOOST_CHECK_EQUAL(find_value(ret[i], "error").isNull(), i != 10);
+        if (i != 10) {
+            BOOST_CHECK_EQUAL(find_value(ret[i], "result")[0].get_int(), i);
+        }
+    }
+}
+
+static void WriteStreamTestValue(CJSONStreamWriter& writer, const UniValue& inner)
+{
+    writer.BeginObject();
+    writer.pushKV("hash", "00ff");
+    writer.pushKV("escaped \"key\"\n", "line\nbreak \\ \"quoted\"");
+    writer.pushKV("height", 42);
+    writer.pushKV("negative", -1);
+    writer.pushKV("fee", ValueFromAmount(12345));
+    writer.pushKV("difficulty", 1.5);
+    writer.pushKV("flag", true);
+    writer.pushKV("none", NullUniValue);
+    writer.Key("empty");
+    writer.BeginArray();
+    writer.EndArray();
+    writer.Key("tx");
+    writer.BeginArray();
+    for (int i = 0; i < 10; i++) {
+        writer.push_back(inner);
+    }
+    writer.BeginObject();
+    writer.EndObject();
+    writer.push_back("last");
+    writer.EndArray();
+    writer.pushKV("inner", inner);
+    writer.EndObject();
+}
+
+BOOST_AUTO_TEST_CASE(rpc_json_stream_writer)
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.pushKV("txid", "abcd");
+    UniValue vout(UniValue::VARR);
+    vout.push_back(1);
+    vout.push_back("two");
+    inner.pushKV("vout", vout);
+
+    UniValue expected(UniValue::VOBJ);
+    expected.pushKV("hash", "00ff");
+    expected.pushKV("escaped \"key\"\n", "line\nbreak \\ \"quoted\"");
+    expected.pushKV("height", 42);
+    expected.pushKV("negative", -1);
+    expected.pushKV("fee", ValueFromAmount(12345));
+    expected.pushKV("difficulty", 1.5);
+    expected.pushKV("flag", true);
+    expected.pushKV("none", NullUniValue);
+    expected.pushKV("empty", UniValue(UniValue::VARR));
+    UniValue tx(UniValue::VARR);
+    for (int i = 0; i < 10; i++) {
+        tx.push_back(inner);
+    }
+    tx.push_back(UniValue(UniValue::VOBJ));
+    tx.push_back("last");
+    expected.pushKV("tx", tx);
+    expected.pushKV("inner", inner);
+
+    // A tree writer builds the same UniValue
+    CJSONStreamWriter treeWriter;
+    WriteStreamTestValue(treeWriter, inner);
+    BOOST_CHECK(treeWriter.IsComplete());
+    BOOST_CHECK_EQUAL(treeWriter.GetValue().write(), expected.write());
+    const UniValue taken = std::move(treeWriter).TakeValue();
+    BOOST_CHECK_EQUAL(taken.write(), expected.write());
+
+    // A text writer produces the same text, in several pieces
+    std::vector<std::string> vPieces;
+    CJSONStreamWriter textWriter([&vPieces](const std::string& data) { vPieces.push_back(data); }, 16);
+    WriteStreamTestValue(textWriter, inner);
+    BOOST_CHECK(textWriter.IsComplete());
+    BOOST_CHECK(textWriter.GetValue().isNull());
+    BOOST_CHECK(vPieces.size() > 1);
+    BOOST_CHECK_EQUAL(boost::algorithm::join(vPieces, ""), expected.write());
+
+    // Scalar results are complete after a single value
+    std::string strText;
+    CJSONStreamWriter scalarWriter([&strText](const std::string& data) { strText += data; });
+    BOOST_CHECK(!scalarWriter.IsComplete());
+    scalarWriter.Value("abc");
+    BOOST_CHECK(scalarWriter.IsComplete());
+    BOOST_CHECK_EQUAL(strText, "\"abc\"");
+}
+
+BOOST_AUTO_TEST_CASE(rpc_json_stream_getrawmempool)
+{
+    JSONRPCRequest request;
+    request.strMethod = "getrawmempool";
+    request.params = RPCConvertValues("getrawmempool", {"true"});
+    request.fHelp = false;
+    UniValue tree = tableRPC["getrawmempool"]->actor(request);
+
+    std::string strText;
+    CJSONStreamWriter writer([&strText](const std::string& data) { strText += data; });
+    request.stream = &writer;
+    UniValue result = tableRPC["getrawmempool"]->actor(request);
+    BOOST_CHECK(result.isNull());
+    BOOST_CHECK(writer.IsComplete());
+    BOOST_CHECK_EQUAL(strText, tree.write());
+}
+
 #if ENABLE_MINER
 BOOST_AUTO_TEST_CASE(rpc_convert_values_generatetoaddress)
 {
@@ -177,4 +177,119 @@ BOOST_AUTO_TEST_CASE(findearliestatleast_edge_test)
     BOOST_CHECK(!chain.FindEarliestAtLeast(int64_t(std::numeric_limits<unsigned int>::max()) + 1));
 }
 
+BOOST_AUTO_TEST_CASE(chainsnapshot_test)
+{
+    // A main chain spanning a few chunks and a fork off it in the second chunk.
+    const int nMainLength = CChainSnapshot::CHUNK_SIZE * 3 + 100;
+    const int nForkHeight = CChainSnapshot::CHUNK_SIZE + 10;
+    std::vector<CBlockIndex> vBlocksMain(nMainLength);
+    for (int i = 0; i < nMainLength; i++) {
+        vBlocksMain[i].nHeight = i;
+        vBlocksMain[i].pprev = i ? &vBlocksMain[i - 1] : nullptr;
+        vBlocksMain[i].BuildSkip();
+        vBlocksMain[i].nTx = i + 1;
+        vBlocksMain[i].nStatus = BLOCK_VALID_SCRIPTS | BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO;
+        vBlocksMain[i].nFile = i / 100;
+        vBlocksMain[i].nDataPos = i * 8;
+        vBlocksMain[i].nUndoPos = i * 4;
+    }
+    std::vector<CBlockIndex> vBlocksFork(CChainSnapshot::CHUNK_SIZE * 3);
+    for (unsigned int i = 0; i < vBlocksFork.size(); i++) {
+        vBlocksFork[i].nHeight = nForkHeight + i;
+        vBlocksFork[i].pprev = i ? &vBlocksFork[i - 1] : &vBlocksMain[nForkHeight - 1];
+        vBlocksFork[i].BuildSkip();
+    }
+
+    CChainSnapshot empty;
+    BOOST_CHECK_EQUAL(empty.Height(), -1);
+    BOOST_CHECK(empty.Tip() == nullptr);
+    BOOST_CHECK(empty.Genesis() == nullptr);
+
+    CChain chain;
+    chain.SetTip(&vBlocksMain.back());
+    CChainSnapshot snapshot(chain, &empty);
+    BOOST_CHECK_EQUAL(snapshot.Height(), chain.Height());
+    BOOST_CHECK(snapshot.Tip() == chain.Tip());
+    BOOST_CHECK(snapshot.Genesis() == chain.Genesis());
+    for (int i = 0; i < nMainLength; i++) {
+        BOOST_CHECK(snapshot[i] == &vBlocksMain[i]);
+        BOOST_CHECK(snapshot.Contains(&vBlocksMain[i]));
+        BOOST_CHECK(snapshot.Next(&vBlocksMain[i]) == chain.Next(&vBlocksMain[i]));
+    }
+    BOOST_CHECK(snapshot[-1] == nullptr);
+    BOOST_CHECK(snapshot.GetEntry(-1) == nullptr);
+    BOOST_CHECK(snapshot.GetEntry(&vBlocksFork[0]) == nullptr);
+    BOOST_CHECK(snapshot[nMainLength] == nullptr);
+    BOOST_CHECK(!snapshot.Contains(&vBlocksFork[0]));
+
+    // Extending the chain only replaces the last chunk.
+    chain.SetTip(&vBlocksMain[nMainLength - 1]);
+    CChainSnapshot same(chain, &snapshot);
+    for (size_t i = 0; i < 4; i++) {
+        BOOST_CHECK(same.SharesChunk(snapshot, i));
+    }
+    chain.SetTip(&vBlocksMain[nMainLength - 2]);
+    CChainSnapshot shorter(chain, &snapshot);
+    BOOST_CHECK(shorter.SharesChunk(snapshot, 2));
+    BOOST_CHECK(!shorter.SharesChunk(snapshot, 3));
+    BOOST_CHECK(shorter.Tip() == &vBlocksMain[nMainLength - 2]);
+    BOOST_CHECK(!shorter.Contains(&vBlocksMain[nMainLength - 1]));
+
+    // A reorg keeps the chunks below the fork point and replaces the others.
+    chain.SetTip(&vBlocksFork.back());
+    CChainSnapshot reorged(chain, &snapshot);
+    BOOST_CHECK(reorged.SharesChunk(snapshot, 0));
+    BOOST_CHECK(!reorged.SharesChunk(snapshot, 1));
+    BOOST_CHECK(!reorged.SharesChunk(snapshot, 2));
+    BOOST_CHECK_EQUAL(reorged.Height(), chain.Height());
+    for (int i = 0; i <= chain.Height(); i++) {
+        BOOST_CHECK(reorged[i] == chain[i]);
+    }
+    BOOST_CHECK(reorged.Contains(&vBlocksMain[nForkHeight - 1]));
+    BOOST_CHECK(!reorged.Contains(&vBlocksMain[nForkHeight]));
+    BOOST_CHECK(reorged.Next(&vBlocksMain[nForkHeight - 1]) == &vBlocksFork[0]);
+
+    // The old snapshot is unaffected by the newer ones.
+    BOOST_CHECK(snapshot.Tip() == &vBlocksMain.back());
+    BOOST_CHECK(snapshot.Contains(&vBlocksMain[nForkHeight]));
+
+    // The mutable index fields are copied, so later changes (here as if pruned) do not race with readers.
+    const CBlockIndex& block = vBlocksMain[nForkHeight];
+    const CDiskBlockPos blockPos = block.GetBlockPos();
+    const CDiskBlockPos undoPos = block.GetUndoPos();
+    vBlocksMain[nForkHeight].nStatus &= ~(BLOCK_HAVE_DATA | BLOCK_HAVE_UNDO);
+    vBlocksMain[nForkHeight].nFile = 0;
+    const CChainSnapshot::Entry* entry = snapshot.GetEntry(&block);
+    BOOST_REQUIRE(entry != nullptr);
+    BOOST_CHECK(entry->pindex == &block);
+    BOOST_CHECK_EQUAL(entry->nTx, (unsigned int)nForkHeight + 1);
+    BOOST_CHECK(entry->nStatus & BLOCK_HAVE_DATA);
+    BOOST_CHECK(entry->GetBlockPos() == blockPos);
+    BOOST_CHECK(entry->GetUndoPos() == undoPos);
+    BOOST_CHECK(block.GetBlockPos().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(chainsnapshot_owner_test)
+{
+    std::vector<CBlockIndex> vBlocks(10);
+    for (unsigned int i = 0; i < vBlocks.size(); i++) {
+        vBlocks[i].nHeight = i;
+        vBlocks[i].pprev = i ? &vBlocks[i - 1] : nullptr;
+    }
+    CChain chain;
+    chain.SetTip(&vBlocks.back());
+
+    // The owner of the index entries lives as long as any snapshot pointing into them.
+    auto owner = std::make_shared<int>(0);
+    std::weak_ptr<int> weakOwner = owner;
+    auto snapshot = std::make_shared<const CChainSnapshot>(chain, nullptr, owner);
+    auto extended = std::make_shared<const CChainSnapshot>(chain, snapshot.get(), owner);
+    owner.reset();
+    snapshot.reset();
+    BOOST_CHECK(!weakOwner.expired());
+    BOOST_CHECK(extended->Tip() == &vBlocks.back());
+    extended.reset();
+    BOOST_CHECK(weakOwner.expired());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
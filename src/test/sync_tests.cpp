@@ -0,0 +1,60 @@
+// Copyright (c) 2022 The Dash Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <sync.h>
+#include <test/test_dash.h>
+#include <tinyformat.h>
+#include <utiltime.h>
+
+#include <thread>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(sync_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lockstats)
+{
+    CCriticalSection cs;
+    ResetLockStats();
+    SetLockStatsInterval(1);
+
+    // Hold the lock for a while so that another thread has to wait for it
+    std::string strLocation;
+    std::thread t;
+    {
+        LOCK(cs); strLocation = strprintf("%s:%d", __FILE__, __LINE__);
+        t = std::thread([&cs] {
+            LOCK(cs);
+        });
+        MilliSleep(100);
+    }
+    t.join();
+    SetLockStatsInterval(0);
+
+    uint64_t nContentions = 0;
+    bool fFoundHolder = false;
+    for (const LockSiteStats& site : GetLockStats()) {
+        if (site.strName != "cs") continue;
+        nContentions += site.nContentions;
+        if (site.strLocation == strLocation) {
+            fFoundHolder = true;
+            BOOST_CHECK_EQUAL(site.nContentions, 0U);
+            BOOST_CHECK_EQUAL(site.nHoldSamples, 1U);
+            BOOST_CHECK(site.nMaxHoldMicros >= 100000);
+        }
+    }
+    BOOST_CHECK(fFoundHolder);
+    BOOST_CHECK_EQUAL(nContentions, 1U);
+
+    // Nothing is recorded while the profiler is disabled
+    ResetLockStats();
+    {
+        LOCK(cs);
+    }
+    for (const LockSiteStats& site : GetLockStats()) {
+        BOOST_CHECK(site.strName != "cs");
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
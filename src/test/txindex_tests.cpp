@@ -0,0 +1,204 @@
+// Copyright (c) 2017-2018 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <index/txindex.h>
+#include <script/standard.h>
+#include <test/test_dash.h>
+#include <txdb.h>
+#include <util.h>
+#include <utilmemory.h>
+#include <utiltime.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_AUTO_TEST_SUITE(txindex_tests)
+
+BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
+{
+    TxIndex txindex(1 << 20, true);
+
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+
+    // Transaction should not be found in the index before it is started.
+    for (const auto& txn : coinbaseTxns) {
+        BOOST_CHECK(!txindex.FindTx(txn.GetHash(), block_hash, tx_disk));
+        BOOST_CHECK(!txindex.HasTx(txn.GetHash()));
+    }
+
+    // BlockUntilSyncedToCurrentChain should return false before txindex is started.
+    BOOST_CHECK(!txindex.BlockUntilSyncedToCurrentChain());
+
+    txindex.Start();
+
+    // Allow tx index to catch up with the block index.
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // Check that txindex excludes genesis block transactions.
+    const CBlock& genesis_block = Params().GenesisBlock();
+    for (const auto& txn : genesis_block.vtx) {
+        BOOST_CHECK(!txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+    }
+
+    // Check that txindex has all txs that were in the chain before it started,
+    // including the ones whose negative lookups were cached above.
+    for (const auto& txn : coinbaseTxns) {
+        BOOST_CHECK(txindex.HasTx(txn.GetHash()));
+        if (!txindex.FindTx(txn.GetHash(), block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else if (tx_disk->GetHash() != txn.GetHash()) {
+            BOOST_ERROR("Read incorrect tx");
+        }
+    }
+
+    // Check that new transactions in new blocks make it into the index.
+    for (int i = 0; i < 10; i++) {
+        CScript coinbase_script_pub_key = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+        std::vector<CMutableTransaction> no_txns;
+        const CBlock& block = CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+        const CTransaction& txn = *block.vtx[0];
+
+        BOOST_CHECK(txindex.BlockUntilSyncedToCurrentChain());
+        if (!txindex.FindTx(txn.GetHash(), block_hash, tx_disk)) {
+            BOOST_ERROR("FindTx failed");
+        } else if (tx_disk->GetHash() != txn.GetHash()) {
+            BOOST_ERROR("Read incorrect tx");
+        } else {
+            BOOST_CHECK(block_hash == block.GetHash());
+        }
+    }
+
+    txindex.Interrupt();
+    txindex.Stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_gettransaction_not_yet_indexed, TestChain100Setup)
+{
+    g_txindex = MakeUnique<TxIndex>(1 << 20, true);
+    g_txindex->Start();
+
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!g_txindex->BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+
+    // Stopping the index keeps it marked as synced but stops it from processing new blocks,
+    // just like an index that has not caught up with the latest block notifications yet.
+    g_txindex->Stop();
+    const CBlockIndex* pindexIndexed = g_txindex->GetBestBlockIndex();
+
+    CScript coinbase_script_pub_key = GetScriptForDestination(coinbaseKey.GetPubKey().GetID());
+    std::vector<CMutableTransaction> no_txns;
+    const CBlock block1 = CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+    const CBlock block2 = CreateAndProcessBlock(no_txns, coinbase_script_pub_key);
+    BOOST_CHECK(g_txindex->GetBestBlockIndex() == pindexIndexed);
+
+    CTransactionRef tx;
+    uint256 block_hash;
+    BOOST_CHECK(!g_txindex->HasTx(block1.vtx[0]->GetHash()));
+    BOOST_REQUIRE(GetTransaction(block1.vtx[0]->GetHash(), tx, Params().GetConsensus(), block_hash));
+    BOOST_CHECK(tx->GetHash() == block1.vtx[0]->GetHash());
+    BOOST_CHECK(block_hash == block1.GetHash());
+    BOOST_REQUIRE(GetTransaction(block2.vtx[0]->GetHash(), tx, Params().GetConsensus(), block_hash));
+    BOOST_CHECK(block_hash == block2.GetHash());
+
+    // Transactions that are in neither the index nor the unindexed blocks are still not found
+    BOOST_CHECK(!GetTransaction(InsecureRand256(), tx, Params().GetConsensus(), block_hash));
+
+    g_txindex.reset();
+}
+
+BOOST_FIXTURE_TEST_CASE(txindex_legacy_entries, TestChain100Setup)
+{
+    // Record the first coinbase in the legacy transaction index of the block index database.
+    const CBlockIndex* pindex;
+    {
+        LOCK(cs_main);
+        pindex = chainActive[1];
+    }
+    CBlock block;
+    BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+    const uint256 legacy_hash = block.vtx[0]->GetHash();
+    const CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
+    BOOST_CHECK(pblocktree->Write(std::make_pair('t', legacy_hash), pos));
+
+    // Until the index is synced, it falls back to the legacy entries.
+    TxIndex txindex(1 << 20, true);
+    CTransactionRef tx_disk;
+    uint256 block_hash;
+    BOOST_CHECK(txindex.FindTx(legacy_hash, block_hash, tx_disk));
+    BOOST_CHECK(tx_disk->GetHash() == legacy_hash);
+    BOOST_CHECK(block_hash == block.GetHash());
+    BOOST_CHECK(txindex.HasTx(legacy_hash));
+    BOOST_CHECK(!txindex.FindTx(coinbaseTxns[1].GetHash(), block_hash, tx_disk));
+
+    txindex.Start();
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        MilliSleep(100);
+    }
+    // The legacy entries are erased by the sync thread once it has caught up.
+    txindex.Interrupt();
+    txindex.Stop();
+
+    CDiskTxPos legacy_pos;
+    BOOST_CHECK(!pblocktree->ReadLegacyTxIndex(legacy_hash, legacy_pos));
+    BOOST_CHECK(txindex.FindTx(legacy_hash, block_hash, tx_disk));
+    BOOST_CHECK(block_hash == block.GetHash());
+    BOOST_CHECK(txindex.FindTx(coinbaseTxns[1].GetHash(), block_hash, tx_disk));
+}
+
+BOOST_FIXTURE_TEST_CASE(legacy_index_entries_erased, BasicTestingSetup)
+{
+    CBlockTreeDB blocktree(1 << 20, true);
+    const uint256 hash = InsecureRand256();
+    for (const char prefix : {'t', 'a', 'u', 's', 'p'}) {
+        for (int i = 0; i < 10; i++) {
+            BOOST_CHECK(blocktree.Write(std::make_pair(prefix, InsecureRand256()), i));
+        }
+    }
+    BOOST_CHECK(blocktree.Write(std::make_pair('b', hash), 1));
+    BOOST_CHECK(blocktree.WriteFlag("txindex", true));
+
+    BOOST_CHECK(blocktree.EraseLegacyIndexes());
+
+    for (const char prefix : {'a', 'u', 's', 'p'}) {
+        std::unique_ptr<CDBIterator> pcursor(blocktree.NewIterator());
+        pcursor->Seek(prefix);
+        BOOST_CHECK(!pcursor->Valid() || pcursor->GetKey()[0] != prefix);
+    }
+    // The transaction index entries are kept until they are erased separately
+    {
+        std::unique_ptr<CDBIterator> pcursor(blocktree.NewIterator());
+        pcursor->Seek('t');
+        BOOST_CHECK(pcursor->Valid() && pcursor->GetKey()[0] == 't');
+    }
+    BOOST_CHECK(blocktree.EraseLegacyTxIndex());
+    {
+        std::unique_ptr<CDBIterator> pcursor(blocktree.NewIterator());
+        pcursor->Seek('t');
+        BOOST_CHECK(!pcursor->Valid() || pcursor->GetKey()[0] != 't');
+    }
+    // Other entries of the block index database are kept
+    BOOST_CHECK(blocktree.Exists(std::make_pair('b', hash)));
+    bool fTxIndexFlag = false;
+    BOOST_CHECK(blocktree.ReadFlag("txindex", fTxIndexFlag));
+    BOOST_CHECK(fTxIndexFlag);
+
+    // Erasing again is a no-op
+    BOOST_CHECK(blocktree.EraseLegacyIndexes());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -21,13 +21,15 @@
 static const char DB_COIN = 'C';
 static const char DB_COINS = 'c';
 static const char DB_BLOCK_FILES = 'f';
-static const char DB_TXINDEX = 't';
-static const char DB_ADDRESSINDEX = 'a';
-static const char DB_ADDRESSUNSPENTINDEX = 'u';
-static const char DB_TIMESTAMPINDEX = 's';
-static const char DB_SPENTINDEX = 'p';
 static const char DB_BLOCK_INDEX = 'b';
 
+// Index entries written to the block tree database before the indexes moved to indexes/
+static const char DB_LEGACY_TXINDEX = 't';
+static const char DB_LEGACY_ADDRESSINDEX = 'a';
+static const char DB_LEGACY_ADDRESSUNSPENTINDEX = 'u';
+static const char DB_LEGACY_TIMESTAMPINDEX = 's';
+static const char DB_LEGACY_SPENTINDEX = 'p';
+
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_HEAD_BLOCKS = 'H';
 static const char DB_FLAG = 'F';
@@ -151,7 +153,7 @@ size_t CCoinsViewDB::EstimateSize() const
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.IsArgSet("-blocksdir") ? GetDataDir() / "blocks" / "index" : GetBlocksDir() / "index", nCacheSize, fMemory, fWipe), mapHasTxIndexCache(10000, 20000) {
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(gArgs.IsArgSet("-blocksdir") ? GetDataDir() / "blocks" / "index" : GetBlocksDir() / "index", nCacheSize, fMemory, fWipe) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -175,12 +177,17 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
 }
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
+{
+    return Cursor(uint256());
+}
+
+CCoinsViewCursor *CCoinsViewDB::Cursor(const uint256 &txidStart) const
 {
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper&>(db).NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
        that restriction.  */
-    i->pcursor->Seek(DB_COIN);
+    i->pcursor->Seek(std::make_pair(DB_COIN, txidStart));
     // Cache key of first record
     if (i->pcursor->Valid()) {
         CoinEntry entry(&i->keyTmp.second);
@@ -240,177 +247,84 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
     return WriteBatch(batch, true);
 }
 
-bool CBlockTreeDB::HasTxIndex(const uint256& txid) {
-    {
-        LOCK(cs);
-        auto it = mapHasTxIndexCache.find(txid);
-        if (it != mapHasTxIndexCache.end()) {
-            return it->second;
-        }
-    }
-    bool r = Exists(std::make_pair(DB_TXINDEX, txid));
-    LOCK(cs);
-    mapHasTxIndexCache.insert(std::make_pair(txid, r));
-    return r;
+bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
+    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
 }
 
-bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
-    bool r = Read(std::make_pair(DB_TXINDEX, txid), pos);
-    LOCK(cs);
-    mapHasTxIndexCache.insert_or_update(std::make_pair(txid, r));
-    return r;
+bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
+    char ch;
+    if (!Read(std::make_pair(DB_FLAG, name), ch))
+        return false;
+    fValue = ch == '1';
+    return true;
 }
 
-bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<uint256,CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Write(std::make_pair(DB_TXINDEX, it->first), it->second);
-    bool ret = WriteBatch(batch);
-    LOCK(cs);
-    for (auto& p : vect) {
-        mapHasTxIndexCache.insert_or_update(std::make_pair(p.first, true));
-    }
-    return ret;
+bool CBlockTreeDB::ReadLegacyTxIndex(const uint256 &txid, CDiskTxPos &pos) {
+    return Read(std::make_pair(DB_LEGACY_TXINDEX, txid), pos);
 }
 
-bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
-    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+bool CBlockTreeDB::HasLegacyTxIndex(const uint256 &txid) {
+    return Exists(std::make_pair(DB_LEGACY_TXINDEX, txid));
 }
 
-bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_SPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_SPENTINDEX, it->first), it->second);
-        }
+/** Erase all entries with the given prefix in batches and compact their range. */
+bool CBlockTreeDB::EraseLegacyIndex(const char prefix) {
+    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    pcursor->Seek(prefix);
+    if (!pcursor->Valid() || pcursor->GetKeySize() == 0 || pcursor->GetKey()[0] != prefix) {
+        return true;
     }
-    return WriteBatch(batch);
-}
 
-bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
+    int64_t count = 0;
+    LogPrintf("Erasing legacy index entries with prefix '%c' from the block index database...\n", prefix);
+    uiInterface.ShowProgress(_("Erasing legacy index entries..."), 0, false);
     CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
-        if (it->second.IsNull()) {
-            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
-        } else {
-            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
-        }
-    }
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
-                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
-
     while (pcursor->Valid()) {
         boost::this_thread::interruption_point();
-        std::pair<char,CAddressUnspentKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
-            CAddressUnspentValue nValue;
-            if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address unspent value");
-            }
-        } else {
+        if (ShutdownRequested()) {
             break;
         }
-    }
-
-    return true;
-}
-
-bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
-        batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
-}
-
-bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
-                                    std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                                    int start, int end) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    if (start > 0 && end > 0) {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
-    } else {
-        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
-    }
-
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char,CAddressIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.hashBytes == addressHash) {
-            if (end > 0 && key.second.blockHeight > end) {
-                break;
-            }
-            CAmount nValue;
-            if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
-                pcursor->Next();
-            } else {
-                return error("failed to get address index value");
-            }
-        } else {
+        CDataStream key = pcursor->GetKey();
+        if (key.empty() || key[0] != prefix) {
             break;
         }
+        batch.Erase(key);
+        count++;
+        if (batch.SizeEstimate() > (size_t)nDefaultDbBatchSize) {
+            if (!WriteBatch(batch)) {
+                return error("%s: failed to erase legacy index entries", __func__);
+            }
+            batch.Clear();
+        }
+        pcursor->Next();
     }
-
-    return true;
-}
-
-bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
-    CDBBatch batch(*this);
-    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
+    if (!WriteBatch(batch)) {
+        return error("%s: failed to erase legacy index entries", __func__);
+    }
+    CompactRange(prefix, (char)(prefix + 1));
+    uiInterface.ShowProgress("", 100, false);
+    LogPrintf("Erased %d legacy index entries with prefix '%c'%s\n", count, prefix, ShutdownRequested() ? " (CANCELLED)" : "");
+    return !ShutdownRequested();
 }
 
-bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
-
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
-
-    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
-
-    while (pcursor->Valid()) {
-        boost::this_thread::interruption_point();
-        std::pair<char, CTimestampIndexKey> key;
-        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp <= high) {
-            hashes.push_back(key.second.blockHash);
-            pcursor->Next();
-        } else {
-            break;
+/** Erase the entries of the legacy address, spent and timestamp indexes.
+ *
+ * These indexes are kept in their own databases in indexes/ now, which are built from the
+ * block files, so the old entries are no longer read. The legacy transaction index entries
+ * are kept until the new transaction index has caught up, see EraseLegacyTxIndex.
+ */
+bool CBlockTreeDB::EraseLegacyIndexes() {
+    for (const char prefix : {DB_LEGACY_ADDRESSINDEX, DB_LEGACY_ADDRESSUNSPENTINDEX, DB_LEGACY_TIMESTAMPINDEX, DB_LEGACY_SPENTINDEX}) {
+        if (!EraseLegacyIndex(prefix)) {
+            return false;
         }
     }
-
     return true;
 }
 
-bool CBlockTreeDB::WriteFlag(const std::string &name, bool fValue) {
-    return Write(std::make_pair(DB_FLAG, name), fValue ? '1' : '0');
-}
-
-bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
-    char ch;
-    if (!Read(std::make_pair(DB_FLAG, name), ch))
-        return false;
-    fValue = ch == '1';
-    return true;
+/** Erase the entries of the legacy transaction index. Only call once g_txindex is synced. */
+bool CBlockTreeDB::EraseLegacyTxIndex() {
+    return EraseLegacyIndex(DB_LEGACY_TXINDEX);
 }
 
 bool CBlockTreeDB::LoadBlockIndexGuts(const Consensus::Params& consensusParams, std::function<CBlockIndex*(const uint256&)> insertBlockIndex)
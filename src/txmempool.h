@@ -6,6 +6,7 @@
 #ifndef BITCOIN_TXMEMPOOL_H
 #define BITCOIN_TXMEMPOOL_H
 
+#include <array>
 #include <memory>
 #include <set>
 #include <map>
@@ -372,6 +373,80 @@ public:
     }
 };
 
+/**
+ * A secondary mempool index split into shards, each an ordered map with its own lock. The shard
+ * of an entry is picked by the caller from the part of the key that is looked up (the address
+ * or the spent txid), so that lookups only lock a single shard. Writers hold the mempool lock
+ * while they update the shards, readers only need the shard locks and therefore neither wait
+ * for the mempool lock nor block transactions being accepted into other shards.
+ */
+template <typename K, typename V, typename Compare>
+class CMempoolIndexShards
+{
+public:
+    static const size_t SHARDS = 16;
+
+private:
+    struct Shard {
+        mutable CCriticalSection cs;
+        std::map<K, V, Compare> map GUARDED_BY(cs);
+    };
+    std::array<Shard, SHARDS> shards;
+
+    Shard& GetShard(uint64_t nShardHash) { return shards[nShardHash % SHARDS]; }
+    const Shard& GetShard(uint64_t nShardHash) const { return shards[nShardHash % SHARDS]; }
+
+public:
+    void Insert(uint64_t nShardHash, const K& key, const V& value)
+    {
+        Shard& shard = GetShard(nShardHash);
+        LOCK(shard.cs);
+        shard.map.emplace(key, value);
+    }
+
+    void Erase(uint64_t nShardHash, const K& key)
+    {
+        Shard& shard = GetShard(nShardHash);
+        LOCK(shard.cs);
+        shard.map.erase(key);
+    }
+
+    bool Find(uint64_t nShardHash, const K& key, V& valueRet) const
+    {
+        const Shard& shard = GetShard(nShardHash);
+        LOCK(shard.cs);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end()) {
+            return false;
+        }
+        valueRet = it->second;
+        return true;
+    }
+
+    /** Call func for the entries starting at the first key not ordered before start, until it returns false */
+    template <typename Callback>
+    void ForEachFrom(uint64_t nShardHash, const K& start, Callback&& func) const
+    {
+        const Shard& shard = GetShard(nShardHash);
+        LOCK(shard.cs);
+        for (auto it = shard.map.lower_bound(start); it != shard.map.end(); ++it) {
+            if (!func(it->first, it->second)) {
+                break;
+            }
+        }
+    }
+
+    size_t Size() const
+    {
+        size_t nSize = 0;
+        for (const auto& shard : shards) {
+            LOCK(shard.cs);
+            nSize += shard.map.size();
+        }
+        return nSize;
+    }
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain transactions
  * that may be included in the next block.
@@ -516,17 +591,19 @@ private:
     typedef std::map<txiter, TxLinks, CompareIteratorByHash> txlinksMap;
     txlinksMap mapLinks;
 
-    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
+    // The address and spent indexes are sharded by address and by spent txid respectively, and
+    // can be read without holding cs. The maps of inserted keys are only used by writers.
+    typedef CMempoolIndexShards<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
     addressDeltaMap mapAddress;
 
     typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
-    addressDeltaMapInserted mapAddressInserted;
+    addressDeltaMapInserted mapAddressInserted GUARDED_BY(cs);
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
+    typedef CMempoolIndexShards<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
     mapSpentIndex mapSpent;
 
     typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
-    mapSpentIndexInserted mapSpentInserted;
+    mapSpentIndexInserted mapSpentInserted GUARDED_BY(cs);
 
     std::multimap<uint256, uint256> mapProTxRefs; // proTxHash -> transaction (all TXs that refer to an existing proTx)
     std::map<CService, uint256> mapProTxAddresses;
@@ -567,12 +644,14 @@ public:
     bool addUnchecked(const uint256& hash, const CTxMemPoolEntry& entry, setEntries& setAncestors, bool validFeeEstimate = true) EXCLUSIVE_LOCKS_REQUIRED(cs);
 
     void addAddressIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
+    /** Doesn't take cs, only the locks of the shards of the addresses */
     bool getAddressIndex(std::vector<std::pair<uint160, int> > &addresses,
-                         std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results);
+                         std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > &results) const;
     bool removeAddressIndex(const uint256 txhash);
 
     void addSpentIndex(const CTxMemPoolEntry &entry, const CCoinsViewCache &view);
-    bool getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
+    /** Doesn't take cs, only the lock of the shard of the spent txid */
+    bool getSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) const;
     bool removeSpentIndex(const uint256 txhash);
 
     void removeRecursive(const CTransaction &tx, MemPoolRemovalReason reason = MemPoolRemovalReason::UNKNOWN);
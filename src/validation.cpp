@@ -7,6 +7,7 @@
 #include <validation.h>
 
 #include <arith_uint256.h>
+#include <blockprefetcher.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <checkpoints.h>
@@ -17,7 +18,12 @@
 #include <consensus/validation.h>
 #include <cuckoocache.h>
 #include <hash.h>
+#include <index/addressindex.h>
+#include <index/spentindex.h>
+#include <index/timestampindex.h>
+#include <index/txindex.h>
 #include <init.h>
+#include <metrics.h>
 #include <policy/fees.h>
 #include <policy/policy.h>
 #include <pow.h>
@@ -225,6 +231,25 @@ CBlockIndex *pindexBestHeader = nullptr;
 CWaitableCriticalSection g_best_block_mutex;
 CConditionVariable g_best_block_cv;
 uint256 g_best_block;
+/** Guards mapBlockIndex insertions against LookupBlockIndexUnlocked; writers also hold cs_main. */
+static CCriticalSection cs_block_index_lookup;
+/** Latest snapshot of chainActive, accessed with std::atomic_load/std::atomic_store only. */
+static std::shared_ptr<const CChainSnapshot> g_chain_snapshot = std::make_shared<const CChainSnapshot>();
+
+/**
+ * Takes over the entries of mapBlockIndex in UnloadBlockIndex and frees them once the last
+ * chain snapshot pointing into them is gone, as snapshots are used without cs_main.
+ */
+struct CRetiredBlockIndex {
+    BlockMap mapRetired;
+    ~CRetiredBlockIndex() {
+        for (BlockMap::value_type& entry : mapRetired) {
+            delete entry.second;
+        }
+    }
+};
+/** Owner of the current mapBlockIndex entries once they are unloaded, shared by all snapshots of them. */
+static std::shared_ptr<CRetiredBlockIndex> g_block_index_owner = std::make_shared<CRetiredBlockIndex>();
 int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 std::atomic_bool fReindex(false);
@@ -303,6 +328,26 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
     return chain.Genesis();
 }
 
+CBlockIndex* LookupBlockIndexUnlocked(const uint256& hash)
+{
+    LOCK(cs_block_index_lookup);
+    BlockMap::const_iterator it = mapBlockIndex.find(hash);
+    return it == mapBlockIndex.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const CChainSnapshot> GetChainSnapshot()
+{
+    return std::atomic_load(&g_chain_snapshot);
+}
+
+/** Publish a snapshot of chainActive, sharing the unchanged chunks with the previous one. */
+static void PublishChainSnapshot()
+{
+    AssertLockHeld(cs_main);
+    std::shared_ptr<const CChainSnapshot> prev = std::atomic_load(&g_chain_snapshot);
+    std::atomic_store(&g_chain_snapshot, std::make_shared<const CChainSnapshot>(chainActive, prev.get(), g_block_index_owner));
+}
+
 std::unique_ptr<CCoinsViewDB> pcoinsdbview;
 std::unique_ptr<CCoinsViewCache> pcoinsTip;
 std::unique_ptr<CBlockTreeDB> pblocktree;
@@ -897,6 +942,9 @@ static bool AcceptToMemoryPoolWithTime(const CChainParams& chainparams, CTxMemPo
                         bool* pfMissingInputs, int64_t nAcceptTime, bool bypass_limits,
                         const CAmount nAbsurdFee, bool fDryRun)
 {
+    static CLatencyHistogram& histAcceptToMemoryPool = g_metrics.GetHistogram("validation.atmp");
+    CLatencyTimer timer(histAcceptToMemoryPool);
+
     std::vector<COutPoint> coins_to_uncache;
     bool res = AcceptToMemoryPoolWorker(chainparams, pool, state, tx, pfMissingInputs, nAcceptTime, bypass_limits, nAbsurdFee, coins_to_uncache, fDryRun);
     if (!res || fDryRun) {
@@ -919,10 +967,10 @@ bool AcceptToMemoryPool(CTxMemPool& pool, CValidationState &state, const CTransa
 
 bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes)
 {
-    if (!fTimestampIndex)
+    if (!g_timestampindex)
         return error("Timestamp index not enabled");
 
-    if (!pblocktree->ReadTimestampIndex(high, low, hashes))
+    if (!g_timestampindex->ReadTimestampIndex(high, low, hashes))
         return error("Unable to get hashes for timestamps");
 
     return true;
@@ -930,37 +978,49 @@ bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::v
 
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value)
 {
-    if (!fSpentIndex)
+    if (!g_spentindex)
         return false;
 
     if (mempool.getSpentIndex(key, value))
         return true;
 
-    if (!pblocktree->ReadSpentIndex(key, value))
+    if (!g_spentindex->ReadSpentIndex(key, value))
         return false;
 
     return true;
 }
 
 bool GetAddressIndex(uint160 addressHash, int type,
-                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end)
+                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, int start, int end,
+                     size_t limit, const CAddressIndexKey* after)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!g_addressindex->ReadAddressIndex(addressHash, type, addressIndex, start, end, limit, after))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressBalance(uint160 addressHash, int type, CAddressBalanceValue &balance)
+{
+    if (!g_addressindex)
+        return error("address index not enabled");
+
+    if (!g_addressindex->ReadAddressBalance(addressHash, type, balance))
+        return error("unable to get balance for address");
+
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!g_addressindex->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
         return error("unable to get txids for address");
 
     return true;
@@ -974,8 +1034,6 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
 {
     CBlockIndex* pindexSlow = blockIndex;
 
-    LOCK(cs_main);
-
     if (!blockIndex) {
         CTransactionRef ptx = mempool.get(hash);
         if (ptx) {
@@ -983,34 +1041,25 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
             return true;
         }
 
-        if (fTxIndex) {
-            CDiskTxPos postx;
-            if (pblocktree->ReadTxIndex(hash, postx)) {
-                CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
-                if (file.IsNull())
-                    return error("%s: OpenBlockFile failed", __func__);
-                CBlockHeader header;
-                try {
-                    file >> header;
-                    fseek(file.Get(), postx.nTxOffset, SEEK_CUR);
-                    file >> txOut;
-                } catch (const std::exception& e) {
-                    return error("%s: Deserialize or I/O error - %s", __func__, e.what());
-                }
-                hashBlock = header.GetHash();
-                if (txOut->GetHash() != hash)
-                    return error("%s: txid mismatch", __func__);
-                if (!mapBlockIndex.count(hashBlock)) {
+        if (g_txindex) {
+            if (g_txindex->FindTx(hash, hashBlock, txOut)) {
+                if (!LookupBlockIndexUnlocked(hashBlock)) {
                     return error("%s: hashBlock %s not in mapBlockIndex", __func__, hashBlock.ToString());
                 }
                 return true;
             }
 
-            // transaction not found in index, nothing more can be done
-            return false;
+            // Transaction not found in index. The index processes connected blocks
+            // asynchronously, so if it is behind the tip the transaction may be in a block it has
+            // not reached yet. Locate that block through the coin database then.
+            if (g_txindex->GetBestBlockIndex() == GetChainSnapshot()->Tip()) {
+                return false;
+            }
+            fAllowSlow = true;
         }
 
         if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+            LOCK(cs_main);
             const Coin& coin = AccessByTxid(*pcoinsTip, hash);
             if (!coin.IsSpent()) pindexSlow = chainActive[coin.nHeight];
         }
@@ -1018,13 +1067,14 @@ bool GetTransaction(const uint256& hash, CTransactionRef& txOut, const Consensus
 
     if (pindexSlow) {
         CBlock block;
-        if (ReadBlockFromDisk(block, pindexSlow, consensusParams)) {
-            for (const auto& tx : block.vtx) {
-                if (tx->GetHash() == hash) {
-                    txOut = tx;
-                    hashBlock = pindexSlow->GetBlockHash();
-                    return true;
-                }
+        if (!ReadBlockFromDisk(block, pindexSlow, consensusParams)) {
+            return error("%s: failed to read block %s from disk", __func__, pindexSlow->GetBlockHash().ToString());
+        }
+        for (const auto& tx : block.vtx) {
+            if (tx->GetHash() == hash) {
+                txOut = tx;
+                hashBlock = pindexSlow->GetBlockHash();
+                return true;
             }
         }
     }
@@ -1087,22 +1137,74 @@ bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus:
     return true;
 }
 
-bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+/** Get the position of a block's data, avoiding cs_main for blocks of the active chain where possible. */
+static CDiskBlockPos GetBlockPosForRead(const CBlockIndex* pindex)
 {
-    CDiskBlockPos blockPos;
-    {
-        LOCK(cs_main);
-        blockPos = pindex->GetBlockPos();
+    // The data of an active chain block never moves unless its file is pruned, and it was
+    // written before the snapshot containing the block was published.
+    if (!fPruneMode) {
+        std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+        const CChainSnapshot::Entry* entry = chain->GetEntry(pindex);
+        if (entry) {
+            return entry->GetBlockPos();
+        }
+    }
+    LOCK(cs_main);
+    return pindex->GetBlockPos();
+}
+
+/** Get the position of a block's undo data, avoiding cs_main for blocks of the active chain where possible. */
+static CDiskBlockPos GetUndoPosForRead(const CBlockIndex* pindex)
+{
+    // Same as for the block data: the undo data is written before the block is connected
+    if (!fPruneMode) {
+        std::shared_ptr<const CChainSnapshot> chain = GetChainSnapshot();
+        const CChainSnapshot::Entry* entry = chain->GetEntry(pindex);
+        if (entry) {
+            return entry->GetUndoPos();
+        }
     }
+    LOCK(cs_main);
+    return pindex->GetUndoPos();
+}
+
+bool IsBlockPruned(const CChainSnapshot& chain, const CBlockIndex* pblockindex)
+{
+    const CChainSnapshot::Entry* entry = fPruneMode ? nullptr : chain.GetEntry(pblockindex);
+    if (!entry) {
+        AssertLockHeld(cs_main);
+        return IsBlockPruned(pblockindex);
+    }
+    return (fHavePruned && !(entry->nStatus & BLOCK_HAVE_DATA) && entry->nTx > 0);
+}
+
+bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams)
+{
+    CDiskBlockPos blockPos = GetBlockPosForRead(pindex);
 
     if (!ReadBlockFromDisk(block, blockPos, consensusParams))
         return false;
     if (block.GetHash() != pindex->GetBlockHash())
         return error("ReadBlockFromDisk(CBlock&, CBlockIndex*): GetHash() doesn't match index for %s at %s",
-                pindex->ToString(), pindex->GetBlockPos().ToString());
+                pindex->ToString(), blockPos.ToString());
     return true;
 }
 
+bool ReadRawBlockFromDisk(CRawBlockRef& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart)
+{
+    CDiskBlockPos blockPos = GetBlockPosForRead(pindex);
+    // Only files we moved on from are complete; the last one is still appended to and
+    // truncated once it is full, so it must not be mapped.
+    bool fFinalized;
+    {
+        LOCK(cs_LastBlockFile);
+        fFinalized = blockPos.nFile < nLastBlockFile;
+    }
+
+    block = rawBlockReader.Read(pindex->GetBlockHash(), blockPos, fFinalized, messageStart);
+    return block != nullptr;
+}
+
 double ConvertBitsToDouble(unsigned int nBits)
 {
     int nShift = (nBits >> 24) & 0xff;
@@ -1590,9 +1692,29 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
-static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+/** Abort with a message */
+bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
+{
+    SetMiscWarning(strMessage);
+    LogPrintf("*** %s\n", strMessage);
+    uiInterface.ThreadSafeMessageBox(
+        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
+        "", CClientUIInterface::MSG_ERROR);
+    StartShutdown();
+    return false;
+}
+
+bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
 {
-    CDiskBlockPos pos = pindex->GetUndoPos();
+    AbortNode(strMessage, userMessage);
+    return state.Error(strMessage);
+}
+
+} // namespace
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
+{
+    CDiskBlockPos pos = GetUndoPosForRead(pindex);
     if (pos.IsNull()) {
         return error("%s: no undo data available", __func__);
     }
@@ -1621,26 +1743,6 @@ static bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex *pindex)
     return true;
 }
 
-/** Abort with a message */
-bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
-{
-    SetMiscWarning(strMessage);
-    LogPrintf("*** %s\n", strMessage);
-    uiInterface.ThreadSafeMessageBox(
-        userMessage.empty() ? _("Error: A fatal internal error occurred, see debug.log for details") : userMessage,
-        "", CClientUIInterface::MSG_ERROR);
-    StartShutdown();
-    return false;
-}
-
-bool AbortNode(CValidationState& state, const std::string& strMessage, const std::string& userMessage="")
-{
-    AbortNode(strMessage, userMessage);
-    return state.Error(strMessage);
-}
-
-} // namespace
-
 /**
  * Restore the UTXO in a Coin at a given COutPoint
  * @param undo The Coin to be restored.
@@ -1701,10 +1803,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
-
     if (!UndoSpecialTxsInBlock(block, pindex)) {
         return DISCONNECT_FAILED;
     }
@@ -1715,41 +1813,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         uint256 hash = tx.GetHash();
         bool is_coinbase = tx.IsCoinBase();
 
-        if (fAddressIndex) {
-
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), hash, k), CAddressUnspentValue()));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, k), CAddressUnspentValue()));
-                } else {
-                    continue;
-                }
-
-            }
-
-        }
-
         // Check that all outputs are available and match the outputs in the block itself
         // exactly.
         for (size_t o = 0; o < tx.vout.size(); o++) {
@@ -1772,73 +1835,14 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
             }
             for (unsigned int j = tx.vin.size(); j-- > 0;) {
                 const COutPoint &out = tx.vin[j].prevout;
-                int undoHeight = txundo.vprevout[j].nHeight;
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const CTxIn input = tx.vin[j];
-
-                if (fSpentIndex) {
-                    // undo and delete the spent index
-                    spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue()));
-                }
-
-                if (fAddressIndex) {
-                    const Coin &coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        std::vector<unsigned char> hashBytes(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23);
-
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
-
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
-                    } else {
-                        continue;
-                    }
-                }
-
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
     }
 
-
-    if (fSpentIndex) {
-        if (!pblocktree->UpdateSpentIndex(spentIndex)) {
-            AbortNode("Failed to delete spent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
-    if (fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            AbortNode("Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            AbortNode("Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
     evoDb->WriteBestBlock(pindex->pprev->GetBlockHash());
@@ -1899,26 +1903,6 @@ static bool WriteUndoDataForBlock(const CBlockUndo& blockundo, CValidationState&
     return true;
 }
 
-static bool WriteTxIndexDataForBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex)
-{
-    if (!fTxIndex) return true;
-
-    CDiskTxPos pos(pindex->GetBlockPos(), GetSizeOfCompactSize(block.vtx.size()));
-    std::vector<std::pair<uint256, CDiskTxPos> > vPos;
-    vPos.reserve(block.vtx.size());
-    for (const CTransactionRef& tx : block.vtx)
-    {
-        vPos.push_back(std::make_pair(tx->GetHash(), pos));
-        pos.nTxOffset += ::GetSerializeSize(*tx, SER_DISK, CLIENT_VERSION);
-    }
-
-    if (!pblocktree->WriteTxIndex(vPos)) {
-        return AbortNode(state, "Failed to write transaction index");
-    }
-
-    return true;
-}
-
 static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
@@ -2129,6 +2113,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime1 = GetTimeMicros(); nTimeCheck += nTime1 - nTimeStart;
     LogPrint(BCLog::BENCHMARK, "    - Sanity checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime1 - nTimeStart), nTimeCheck * MICRO, nTimeCheck * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockCheck = g_metrics.GetHistogram("validation.connectblock.check");
+    histConnectBlockCheck.Record(nTime1 - nTimeStart);
 
     // Do not allow blocks that contain transactions which 'overwrite' older transactions,
     // unless those are already completely spent.
@@ -2189,6 +2175,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime2 = GetTimeMicros(); nTimeForks += nTime2 - nTime1;
     LogPrint(BCLog::BENCHMARK, "    - Fork checks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2 - nTime1), nTimeForks * MICRO, nTimeForks * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockForks = g_metrics.GetHistogram("validation.connectblock.forks");
+    histConnectBlockForks.Record(nTime2 - nTime1);
 
     CBlockUndo blockundo;
 
@@ -2199,9 +2187,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     int nInputs = 0;
     unsigned int nSigOps = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
     std::vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
@@ -2216,11 +2201,12 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime2_1 = GetTimeMicros(); nTimeProcessSpecial += nTime2_1 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - ProcessSpecialTxsInBlock: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime2_1 - nTime2), nTimeProcessSpecial * MICRO, nTimeProcessSpecial * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockSpecialTxs = g_metrics.GetHistogram("validation.connectblock.specialtxs");
+    histConnectBlockSpecialTxs.Record(nTime2_1 - nTime2);
 
     for (unsigned int i = 0; i < block.vtx.size(); i++)
     {
         const CTransaction &tx = *(block.vtx[i]);
-        const uint256 txhash = tx.GetHash();
 
         nInputs += tx.vin.size();
 
@@ -2248,47 +2234,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
                 return state.DoS(100, error("%s: contains a non-BIP68-final transaction", __func__),
                                  REJECT_INVALID, "bad-txns-nonfinal");
             }
-
-            if (fAddressIndex || fSpentIndex)
-            {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const Coin& coin = view.AccessCoin(tx.vin[j].prevout);
-                    const CTxOut &prevout = coin.out;
-                    uint160 hashBytes;
-                    int addressType;
-
-                    if (prevout.scriptPubKey.IsPayToScriptHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+2, prevout.scriptPubKey.begin()+22));
-                        addressType = 2;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKeyHash()) {
-                        hashBytes = uint160(std::vector<unsigned char>(prevout.scriptPubKey.begin()+3, prevout.scriptPubKey.begin()+23));
-                        addressType = 1;
-                    } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
-                        hashBytes = Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1);
-                        addressType = 1;
-                    } else {
-                        hashBytes.SetNull();
-                        addressType = 0;
-                    }
-
-                    if (fAddressIndex && addressType > 0) {
-                        // record spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                    }
-
-                    if (fSpentIndex) {
-                        // add the spent index to determine the txid and input that spent an output
-                        // and to find the amount and address from an input
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, hashBytes)));
-                    }
-                }
-
-            }
-
         }
 
         // GetTransactionSigOpCount counts 2 types of sigops:
@@ -2311,39 +2256,6 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut &out = tx.vout[k];
-
-                if (out.scriptPubKey.IsPayToScriptHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+2, out.scriptPubKey.begin()+22);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(2, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(2, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKeyHash()) {
-                    std::vector<unsigned char> hashBytes(out.scriptPubKey.begin()+3, out.scriptPubKey.begin()+23);
-
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, uint160(hashBytes), pindex->nHeight, i, txhash, k, false), out.nValue));
-
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, uint160(hashBytes), txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-
-                } else if (out.scriptPubKey.IsPayToPublicKey()) {
-                    uint160 hashBytes(Hash160(out.scriptPubKey.begin()+1, out.scriptPubKey.end()-1));
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, txhash, k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
-                } else {
-                    continue;
-                }
-
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2352,11 +2264,15 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
     }
     int64_t nTime3 = GetTimeMicros(); nTimeConnect += nTime3 - nTime2;
     LogPrint(BCLog::BENCHMARK, "      - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs (%.2fms/blk)]\n", (unsigned)block.vtx.size(), MILLI * (nTime3 - nTime2), MILLI * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : MILLI * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * MICRO, nTimeConnect * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockConnect = g_metrics.GetHistogram("validation.connectblock.connect");
+    histConnectBlockConnect.Record(nTime3 - nTime2);
 
     if (!control.Wait())
         return state.DoS(100, error("%s: CheckQueue failed", __func__), REJECT_INVALID, "block-validation-failed");
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint(BCLog::BENCHMARK, "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs (%.2fms/blk)]\n", nInputs - 1, MILLI * (nTime4 - nTime2), nInputs <= 1 ? 0 : MILLI * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * MICRO, nTimeVerify * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockVerify = g_metrics.GetHistogram("validation.connectblock.verify");
+    histConnectBlockVerify.Record(nTime4 - nTime2);
 
 
     // DASH
@@ -2422,6 +2338,8 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
 
     int64_t nTime5 = GetTimeMicros(); nTimeDashSpecific += nTime5 - nTime4;
     LogPrint(BCLog::BENCHMARK, "    - Dash specific: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime5 - nTime4), nTimeDashSpecific * MICRO, nTimeDashSpecific * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockDashSpecific = g_metrics.GetHistogram("validation.connectblock.dashspecific");
+    histConnectBlockDashSpecific.Record(nTime5 - nTime4);
 
     // END DASH
 
@@ -2436,38 +2354,21 @@ bool CChainState::ConnectBlock(const CBlock& block, CValidationState& state, CBl
         setDirtyBlockIndex.insert(pindex);
     }
 
-    if (!WriteTxIndexDataForBlock(block, state, pindex))
-        return false;
-
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
-    }
-
-    if (fSpentIndex)
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-    if (fTimestampIndex)
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
     assert(pindex->phashBlock);
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
     int64_t nTime6 = GetTimeMicros(); nTimeIndex += nTime6 - nTime5;
     LogPrint(BCLog::BENCHMARK, "    - Index writing: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime6 - nTime5), nTimeIndex * MICRO, nTimeIndex * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockIndex = g_metrics.GetHistogram("validation.connectblock.index");
+    histConnectBlockIndex.Record(nTime6 - nTime5);
 
     evoDb->WriteBestBlock(pindex->GetBlockHash());
 
     int64_t nTime7 = GetTimeMicros(); nTimeCallbacks += nTime7 - nTime6;
     LogPrint(BCLog::BENCHMARK, "    - Callbacks: %.2fms [%.2fs (%.2fms/blk)]\n", MILLI * (nTime7 - nTime6), nTimeCallbacks * MICRO, nTimeCallbacks * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectBlockCallbacks = g_metrics.GetHistogram("validation.connectblock.callbacks");
+    histConnectBlockCallbacks.Record(nTime7 - nTime6);
 
     boost::posix_time::ptime finish = boost::posix_time::microsec_clock::local_time();
     boost::posix_time::time_duration diff = finish - start;
@@ -2641,6 +2542,8 @@ void static UpdateTip(const CBlockIndex *pindexNew, const CChainParams& chainPar
     // New best block
     mempool.AddTransactionsUpdated(1);
 
+    PublishChainSnapshot();
+
     {
         WaitableLock lock(g_best_block_mutex);
         g_best_block = pindexNew->GetBlockHash();
@@ -2836,10 +2739,13 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime1 = GetTimeMicros();
     std::shared_ptr<const CBlock> pthisBlock;
     if (!pblock) {
-        std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
-        if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
-            return AbortNode(state, "Failed to read block");
-        pthisBlock = pblockNew;
+        pthisBlock = blockPrefetcher.Take(pindexNew);
+        if (!pthisBlock) {
+            std::shared_ptr<CBlock> pblockNew = std::make_shared<CBlock>();
+            if (!ReadBlockFromDisk(*pblockNew, pindexNew, chainparams.GetConsensus()))
+                return AbortNode(state, "Failed to read block");
+            pthisBlock = pblockNew;
+        }
     } else {
         pthisBlock = pblock;
     }
@@ -2848,6 +2754,8 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
     int64_t nTime2 = GetTimeMicros(); nTimeReadFromDisk += nTime2 - nTime1;
     int64_t nTime3;
     LogPrint(BCLog::BENCHMARK, "  - Load block from disk: %.2fms [%.2fs]\n", (nTime2 - nTime1) * MILLI, nTimeReadFromDisk * MICRO);
+    static CLatencyHistogram& histConnectTipReadFromDisk = g_metrics.GetHistogram("validation.connecttip.readfromdisk");
+    histConnectTipReadFromDisk.Record(nTime2 - nTime1);
     {
         auto dbTx = evoDb->BeginTransaction();
 
@@ -2861,17 +2769,23 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
         }
         nTime3 = GetTimeMicros(); nTimeConnectTotal += nTime3 - nTime2;
         LogPrint(BCLog::BENCHMARK, "  - Connect total: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime3 - nTime2) * MILLI, nTimeConnectTotal * MICRO, nTimeConnectTotal * MILLI / nBlocksTotal);
+        static CLatencyHistogram& histConnectTipConnectBlock = g_metrics.GetHistogram("validation.connecttip.connectblock");
+        histConnectTipConnectBlock.Record(nTime3 - nTime2);
         bool flushed = view.Flush();
         assert(flushed);
         dbTx->Commit();
     }
     int64_t nTime4 = GetTimeMicros(); nTimeFlush += nTime4 - nTime3;
     LogPrint(BCLog::BENCHMARK, "  - Flush: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime4 - nTime3) * MILLI, nTimeFlush * MICRO, nTimeFlush * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectTipFlush = g_metrics.GetHistogram("validation.connecttip.flush");
+    histConnectTipFlush.Record(nTime4 - nTime3);
     // Write the chain state to disk, if necessary.
     if (!FlushStateToDisk(chainparams, state, FlushStateMode::IF_NEEDED))
         return false;
     int64_t nTime5 = GetTimeMicros(); nTimeChainState += nTime5 - nTime4;
     LogPrint(BCLog::BENCHMARK, "  - Writing chainstate: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime5 - nTime4) * MILLI, nTimeChainState * MICRO, nTimeChainState * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectTipChainState = g_metrics.GetHistogram("validation.connecttip.chainstate");
+    histConnectTipChainState.Record(nTime5 - nTime4);
     // Remove conflicting transactions from the mempool.;
     mempool.removeForBlock(blockConnecting.vtx, pindexNew->nHeight);
     disconnectpool.removeForBlock(blockConnecting.vtx);
@@ -2881,7 +2795,11 @@ bool CChainState::ConnectTip(CValidationState& state, const CChainParams& chainp
 
     int64_t nTime6 = GetTimeMicros(); nTimePostConnect += nTime6 - nTime5; nTimeTotal += nTime6 - nTime1;
     LogPrint(BCLog::BENCHMARK, "  - Connect postprocess: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime5) * MILLI, nTimePostConnect * MICRO, nTimePostConnect * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectTipPostConnect = g_metrics.GetHistogram("validation.connecttip.postconnect");
+    histConnectTipPostConnect.Record(nTime6 - nTime5);
     LogPrint(BCLog::BENCHMARK, "- Connect block: %.2fms [%.2fs (%.2fms/blk)]\n", (nTime6 - nTime1) * MILLI, nTimeTotal * MICRO, nTimeTotal * MILLI / nBlocksTotal);
+    static CLatencyHistogram& histConnectTipTotal = g_metrics.GetHistogram("validation.connecttip.total");
+    histConnectTipTotal.Record(nTime6 - nTime1);
 
     boost::posix_time::ptime finish = boost::posix_time::microsec_clock::local_time();
     boost::posix_time::time_duration diff = finish - start;
@@ -3005,6 +2923,10 @@ bool CChainState::ActivateBestChainStep(CValidationState& state, const CChainPar
         }
         nHeight = nTargetHeight;
 
+        // Keep the blocks following the current tip being read and checked in the background
+        // while this batch is connected. pblock is already in memory and is not read again.
+        blockPrefetcher.Prefetch(chainActive.Tip(), pblock ? pindexMostWork->pprev : pindexMostWork, chainparams.GetConsensus());
+
         // Connect new blocks.
         for (CBlockIndex *pindexConnect : reverse_iterate(vpindexToConnect)) {
             if (!ConnectTip(state, chainparams, pindexConnect, pindexConnect == pindexMostWork ? pblock : std::shared_ptr<const CBlock>(), connectTrace, disconnectpool)) {
@@ -3444,8 +3366,6 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block, enum BlockS
     // to avoid miners withholding blocks but broadcasting headers, to get a
     // competitive advantage.
     pindexNew->nSequenceId = 0;
-    BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(hash, pindexNew)).first;
-    pindexNew->phashBlock = &((*mi).first);
     BlockMap::iterator miPrev = mapBlockIndex.find(block.hashPrevBlock);
     if (miPrev != mapBlockIndex.end())
     {
@@ -3455,6 +3375,12 @@ CBlockIndex* CChainState::AddToBlockIndex(const CBlockHeader& block, enum BlockS
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     pindexNew->nChainWork = (pindexNew->pprev ? pindexNew->pprev->nChainWork : 0) + GetBlockProof(*pindexNew);
+    {
+        // Only make the entry visible to LookupBlockIndexUnlocked once its tree fields are set
+        LOCK(cs_block_index_lookup);
+        BlockMap::iterator mi = mapBlockIndex.insert(std::make_pair(hash, pindexNew)).first;
+        pindexNew->phashBlock = &((*mi).first);
+    }
     if (nStatus & BLOCK_VALID_MASK) {
         pindexNew->RaiseValidity(nStatus);
         if (pindexBestHeader == nullptr || pindexBestHeader->nChainWork < pindexNew->nChainWork)
@@ -4148,6 +4074,7 @@ void PruneOneBlockFile(const int fileNumber)
 
 void UnlinkPrunedFiles(const std::set<int>& setFilesToPrune)
 {
+    rawBlockReader.ForgetFiles(setFilesToPrune);
     for (std::set<int>::iterator it = setFilesToPrune.begin(); it != setFilesToPrune.end(); ++it) {
         CDiskBlockPos pos(*it, 0);
         fs::remove(GetBlockPosFilename(pos, "blk"));
@@ -4321,6 +4248,7 @@ CBlockIndex * CChainState::InsertBlockIndex(const uint256& hash)
 
     // Create new
     CBlockIndex* pindexNew = new CBlockIndex();
+    LOCK(cs_block_index_lookup);
     mi = mapBlockIndex.insert(std::make_pair(hash, pindexNew)).first;
     pindexNew->phashBlock = &((*mi).first);
 
@@ -4476,6 +4404,7 @@ bool LoadChainTip(const CChainParams& chainparams)
         return false;
     }
     chainActive.SetTip(pindex);
+    PublishChainSnapshot();
 
     g_chainstate.PruneBlockIndexCandidates();
 
@@ -4718,6 +4647,7 @@ void UnloadBlockIndex()
     mapBlocksUnlinked.clear();
     vinfoBlockFile.clear();
     nLastBlockFile = 0;
+    rawBlockReader.Clear();
     setDirtyBlockIndex.clear();
     setDirtyFileInfo.clear();
     versionbitscache.Clear();
@@ -4725,10 +4655,16 @@ void UnloadBlockIndex()
         warningcache[b].clear();
     }
 
-    for (BlockMap::value_type& entry : mapBlockIndex) {
-        delete entry.second;
+    // Readers may still hold snapshots of the unloaded chain (and entries they looked up while
+    // holding one), so the entries are only freed along with the last of those snapshots.
+    {
+        LOCK(cs_block_index_lookup);
+        g_block_index_owner->mapRetired.swap(mapBlockIndex);
     }
-    mapBlockIndex.clear();
+    std::shared_ptr<CRetiredBlockIndex> retired = std::move(g_block_index_owner);
+    g_block_index_owner = std::make_shared<CRetiredBlockIndex>();
+    PublishChainSnapshot();
+    retired.reset();
     fHavePruned = false;
 
     g_chainstate.UnloadBlockIndex();
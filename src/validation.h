@@ -16,6 +16,7 @@
 #include <fs.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
 #include <policy/feerate.h>
+#include <rawblock.h>
 #include <script/script_error.h>
 #include <sync.h>
 #include <versionbits.h>
@@ -35,7 +36,9 @@
 
 class CBlockIndex;
 class CBlockTreeDB;
+class CBlockUndo;
 class CChainParams;
+class CChainSnapshot;
 class CCoinsViewDB;
 class CInv;
 class CConnman;
@@ -123,6 +126,7 @@ static const bool DEFAULT_TXINDEX = true;
 static const bool DEFAULT_ADDRESSINDEX = false;
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const bool DEFAULT_SPENTINDEX = false;
+static const char* const DEFAULT_BLOCKFILTERINDEX = "0";
 static const unsigned int DEFAULT_BANSCORE_THRESHOLD = 100;
 /** Default for -persistmempool */
 static const bool DEFAULT_PERSIST_MEMPOOL = true;
@@ -411,7 +415,8 @@ bool GetTimestampIndex(const unsigned int &high, const unsigned int &low, std::v
 bool GetSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value);
 bool GetAddressIndex(uint160 addressHash, int type,
                      std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
-                     int start = 0, int end = 0);
+                     int start = 0, int end = 0, size_t limit = 0, const CAddressIndexKey* after = nullptr);
+bool GetAddressBalance(uint160 addressHash, int type, CAddressBalanceValue &balance);
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs);
 /** Initializes the script-execution cache */
@@ -421,6 +426,10 @@ void InitScriptExecutionCache();
 /** Functions for disk access for blocks */
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos, const Consensus::Params& consensusParams);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex, const Consensus::Params& consensusParams);
+/** Read the serialized block without deserializing it, e.g. to send it to a peer as is */
+bool ReadRawBlockFromDisk(CRawBlockRef& block, const CBlockIndex* pindex, const CMessageHeader::MessageStartChars& messageStart);
+
+bool UndoReadFromDisk(CBlockUndo& blockundo, const CBlockIndex* pindex);
 
 /** Functions for validating blocks and updating the block tree */
 
@@ -448,6 +457,21 @@ inline CBlockIndex* LookupBlockIndex(const uint256& hash)
     return it == mapBlockIndex.end() ? nullptr : it->second;
 }
 
+/**
+ * Look up a block index entry without holding cs_main. Only the header fields, pprev,
+ * nHeight and nChainWork of the result may be read without cs_main; the other fields of
+ * entries contained in a snapshot returned by GetChainSnapshot() are copied into it.
+ * The caller must hold such a snapshot from before the lookup for as long as it uses the
+ * result, as that keeps the entry from being freed by UnloadBlockIndex.
+ */
+CBlockIndex* LookupBlockIndexUnlocked(const uint256& hash);
+
+/**
+ * Return the latest published snapshot of chainActive. It is updated on every tip change
+ * and can be used by readers that must not wait for cs_main. Never returns nullptr.
+ */
+std::shared_ptr<const CChainSnapshot> GetChainSnapshot();
+
 /** Find the last common block between the parameter chain and a locator. */
 CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& locator);
 
@@ -522,4 +546,7 @@ inline bool IsBlockPruned(const CBlockIndex* pblockindex)
     return (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0);
 }
 
+//! Same as IsBlockPruned, but only requires cs_main if chain does not contain the block.
+bool IsBlockPruned(const CChainSnapshot& chain, const CBlockIndex* pblockindex);
+
 #endif // BITCOIN_VALIDATION_H
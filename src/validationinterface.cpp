@@ -44,6 +44,7 @@ struct MainSignalsInstance {
     boost::signals2::signal<void (const CTransactionRef& currentTx, const CTransactionRef& previousTx)>NotifyInstantSendDoubleSpendAttempt;
     boost::signals2::signal<void (bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff)>NotifyMasternodeListChanged;
     boost::signals2::signal<void (const std::shared_ptr<const llmq::CRecoveredSig>& sig)>NotifyRecoveredSig;
+    boost::signals2::signal<void (const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId)>NewBlockTemplate;
     // We are not allowed to assume the scheduler only runs in one thread,
     // but must ensure all callbacks happen in-order, so we end up creating
     // our own queue here :(
@@ -107,6 +108,7 @@ void RegisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.connect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
     g_signals.m_internals->NotifyRecoveredSig.connect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
     g_signals.m_internals->NotifyMasternodeListChanged.connect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
+    g_signals.m_internals->NewBlockTemplate.connect(boost::bind(&CValidationInterface::NewBlockTemplate, pwalletIn, _1, _2));
 }
 
 void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
@@ -129,6 +131,7 @@ void UnregisterValidationInterface(CValidationInterface* pwalletIn) {
     g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.disconnect(boost::bind(&CValidationInterface::NotifyInstantSendDoubleSpendAttempt, pwalletIn, _1, _2));
     g_signals.m_internals->NotifyRecoveredSig.disconnect(boost::bind(&CValidationInterface::NotifyRecoveredSig, pwalletIn, _1));
     g_signals.m_internals->NotifyMasternodeListChanged.disconnect(boost::bind(&CValidationInterface::NotifyMasternodeListChanged, pwalletIn, _1, _2, _3));
+    g_signals.m_internals->NewBlockTemplate.disconnect(boost::bind(&CValidationInterface::NewBlockTemplate, pwalletIn, _1, _2));
 }
 
 void UnregisterAllValidationInterfaces() {
@@ -154,6 +157,7 @@ void UnregisterAllValidationInterfaces() {
     g_signals.m_internals->NotifyInstantSendDoubleSpendAttempt.disconnect_all_slots();
     g_signals.m_internals->NotifyRecoveredSig.disconnect_all_slots();
     g_signals.m_internals->NotifyMasternodeListChanged.disconnect_all_slots();
+    g_signals.m_internals->NewBlockTemplate.disconnect_all_slots();
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void ()> func) {
@@ -274,4 +278,10 @@ void CMainSignals::NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecover
 
 void CMainSignals::NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff) {
     m_internals->NotifyMasternodeListChanged(undo, oldMNList, diff);
-}
\ No newline at end of file
+}
+
+void CMainSignals::NewBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId) {
+    m_internals->m_schedulerClient.AddToProcessQueue([pblocktemplate, nTemplateId, this] {
+        m_internals->NewBlockTemplate(pblocktemplate, nTemplateId);
+    });
+}
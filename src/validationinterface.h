@@ -14,6 +14,7 @@
 class CBlock;
 class CBlockIndex;
 struct CBlockLocator;
+struct CBlockTemplate;
 class CConnman;
 class CReserveScript;
 class CValidationInterface;
@@ -133,6 +134,13 @@ protected:
     virtual void NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx) {}
     virtual void NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig) {}
     virtual void NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff) {}
+    /**
+     * Notifies listeners of a block template which is built on a new tip or pays notably more fees
+     * than the previously announced one.
+     *
+     * Called on a background thread.
+     */
+    virtual void NewBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId) {}
     /**
      * Notifies listeners of the new active block chain on-disk.
      *
@@ -198,6 +206,7 @@ public:
     void NotifyInstantSendDoubleSpendAttempt(const CTransactionRef &currentTx, const CTransactionRef &previousTx);
     void NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig> &sig);
     void NotifyMasternodeListChanged(bool undo, const CDeterministicMNList& oldMNList, const CDeterministicMNListDiff& diff);
+    void NewBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId);
     void SetBestChain(const CBlockLocator &);
     void Broadcast(int64_t nBestBlockTime, CConnman* connman);
     void BlockChecked(const CBlock&, const CValidationState&);
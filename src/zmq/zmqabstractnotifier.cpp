@@ -50,3 +50,8 @@ bool CZMQAbstractNotifier::NotifyRecoveredSig(const std::shared_ptr<const llmq::
 {
     return true;
 }
+
+bool CZMQAbstractNotifier::NotifyBlockTemplate(const std::shared_ptr<const CBlockTemplate> & /*pblocktemplate*/, uint64_t /*nTemplateId*/)
+{
+    return true;
+}
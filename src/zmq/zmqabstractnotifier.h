@@ -8,6 +8,7 @@
 #include <zmq/zmqconfig.h>
 
 class CBlockIndex;
+struct CBlockTemplate;
 class CGovernanceObject;
 class CGovernanceVote;
 class CZMQAbstractNotifier;
@@ -48,6 +49,7 @@ public:
     virtual bool NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& object);
     virtual bool NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx);
     virtual bool NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig);
+    virtual bool NotifyBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId);
 
 protected:
     void *psocket;
@@ -38,12 +38,23 @@ std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetActiveNotif
     return result;
 }
 
+bool CZMQNotificationInterface::HasNotifier(const std::string& type) const
+{
+    for (const auto* n : notifiers) {
+        if (n->GetType() == type) {
+            return true;
+        }
+    }
+    return false;
+}
+
 CZMQNotificationInterface* CZMQNotificationInterface::Create()
 {
     CZMQNotificationInterface* notificationInterface = nullptr;
     std::map<std::string, CZMQNotifierFactory> factories;
     std::list<CZMQAbstractNotifier*> notifiers;
 
+    factories["pubblocktemplate"] = CZMQAbstractNotifier::Create<CZMQPublishBlockTemplateNotifier>;
     factories["pubhashblock"] = CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashchainlock"] = CZMQAbstractNotifier::Create<CZMQPublishHashChainLockNotifier>;
     factories["pubhashtx"] = CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
@@ -298,4 +309,17 @@ void CZMQNotificationInterface::NotifyRecoveredSig(const std::shared_ptr<const l
     }
 }
 
+void CZMQNotificationInterface::NewBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId)
+{
+    for (auto it = notifiers.begin(); it != notifiers.end();) {
+        CZMQAbstractNotifier *notifier = *it;
+        if (notifier->NotifyBlockTemplate(pblocktemplate, nTemplateId)) {
+            ++it;
+        } else {
+            notifier->Shutdown();
+            it = notifiers.erase(it);
+        }
+    }
+}
+
 CZMQNotificationInterface* g_zmq_notification_interface = nullptr;
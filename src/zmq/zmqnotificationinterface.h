@@ -19,6 +19,7 @@ public:
     virtual ~CZMQNotificationInterface();
 
     std::list<const CZMQAbstractNotifier*> GetActiveNotifiers() const;
+    bool HasNotifier(const std::string& type) const;
 
     static CZMQNotificationInterface* Create();
 
@@ -37,6 +38,7 @@ protected:
     void NotifyGovernanceObject(const std::shared_ptr<const CGovernanceObject>& object) override;
     void NotifyInstantSendDoubleSpendAttempt(const CTransactionRef& currentTx, const CTransactionRef& previousTx) override;
     void NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig>& sig) override;
+    void NewBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId) override;
 
 private:
     CZMQNotificationInterface();
@@ -4,6 +4,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <miner.h>
 #include <streams.h>
 #include <zmq/zmqpublishnotifier.h>
 #include <validation.h>
@@ -29,6 +30,7 @@ static const char *MSG_RAWGVOTE      = "rawgovernancevote";
 static const char *MSG_RAWGOBJ       = "rawgovernanceobject";
 static const char *MSG_RAWISCON      = "rawinstantsenddoublespend";
 static const char *MSG_RAWRECSIG     = "rawrecoveredsig";
+static const char *MSG_BLOCKTEMPLATE = "blocktemplate";
 
 // Internal function to send multipart message
 static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
@@ -371,3 +373,23 @@ bool CZMQPublishRawRecoveredSigNotifier::NotifyRecoveredSig(const std::shared_pt
     return SendMessage(MSG_RAWRECSIG, &(*ss.begin()), ss.size());
 }
 
+bool CZMQPublishBlockTemplateNotifier::NotifyBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId)
+{
+    const CBlock& block = pblocktemplate->block;
+    LogPrint(BCLog::ZMQ, "zmq: Publish blocktemplate %d on %s\n", nTemplateId, block.hashPrevBlock.ToString());
+
+    // Only the txids are sent, the transactions themselves are known from rawtx or the mempool
+    std::vector<uint256> vTxids;
+    vTxids.reserve(block.vtx.size() - 1);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        vTxids.emplace_back(block.vtx[i]->GetHash());
+    }
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << nTemplateId;
+    ss << block.GetBlockHeader();
+    ss << *block.vtx[0];
+    ss << vTxids;
+
+    return SendMessage(MSG_BLOCKTEMPLATE, &(*ss.begin()), ss.size());
+}
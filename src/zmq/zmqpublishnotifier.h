@@ -137,4 +137,10 @@ class CZMQPublishRawRecoveredSigNotifier : public CZMQAbstractPublishNotifier
 public:
     bool NotifyRecoveredSig(const std::shared_ptr<const llmq::CRecoveredSig> &sig) override;
 };
+
+class CZMQPublishBlockTemplateNotifier : public CZMQAbstractPublishNotifier
+{
+public:
+    bool NotifyBlockTemplate(const std::shared_ptr<const CBlockTemplate>& pblocktemplate, uint64_t nTemplateId) override;
+};
 #endif // BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
@@ -40,6 +40,10 @@ def http_post_call(host, port, path, requestdata = '', response_object = 0):
 
     return conn.getresponse().read()
 
+def assert_chunked(response):
+    assert_equal(response.getheader('transfer-encoding'), 'chunked')
+    assert_equal(response.getheader('content-length'), None)
+
 class RESTTest (BitcoinTestFramework):
     FORMAT_SEPARATOR = "."
 
@@ -230,28 +234,34 @@ class RESTTest (BitcoinTestFramework):
         # check binary format
         response = http_get_call(url.hostname, url.port, '/rest/block/'+bb_hash+self.FORMAT_SEPARATOR+"bin", True)
         assert_equal(response.status, 200)
-        assert_greater_than(int(response.getheader('content-length')), 80)
+        # blocks of the active chain are streamed with chunked transfer encoding, without a content-length
+        assert_chunked(response)
         response_str = response.read()
+        assert_greater_than(len(response_str), 80)
 
         # compare with block header
         response_header = http_get_call(url.hostname, url.port, '/rest/headers/1/'+bb_hash+self.FORMAT_SEPARATOR+"bin", True)
         assert_equal(response_header.status, 200)
-        assert_equal(int(response_header.getheader('content-length')), 80)
+        assert_chunked(response_header)
         response_header_str = response_header.read()
+        assert_equal(len(response_header_str), 80)
         assert_equal(response_str[0:80], response_header_str)
 
         # check block hex format
         response_hex = http_get_call(url.hostname, url.port, '/rest/block/'+bb_hash+self.FORMAT_SEPARATOR+"hex", True)
         assert_equal(response_hex.status, 200)
-        assert_greater_than(int(response_hex.getheader('content-length')), 160)
+        assert_chunked(response_hex)
         response_hex_str = response_hex.read()
+        assert_greater_than(len(response_hex_str), 160)
+        assert_equal(response_hex_str, encode(response_str, "hex_codec") + b"\n")
         assert_equal(encode(response_str, "hex_codec")[0:160], response_hex_str[0:160])
 
         # compare with hex block header
         response_header_hex = http_get_call(url.hostname, url.port, '/rest/headers/1/'+bb_hash+self.FORMAT_SEPARATOR+"hex", True)
         assert_equal(response_header_hex.status, 200)
-        assert_greater_than(int(response_header_hex.getheader('content-length')), 160)
+        assert_chunked(response_header_hex)
         response_header_hex_str = response_header_hex.read()
+        assert_equal(len(response_header_hex_str), 161)
         assert_equal(response_hex_str[0:160], response_header_hex_str[0:160])
         assert_equal(encode(response_header_str, "hex_codec")[0:160], response_header_hex_str[0:160])
 
@@ -263,6 +273,7 @@ class RESTTest (BitcoinTestFramework):
         # compare with json block header
         response_header_json = http_get_call(url.hostname, url.port, '/rest/headers/1/'+bb_hash+self.FORMAT_SEPARATOR+"json", True)
         assert_equal(response_header_json.status, 200)
+        assert_chunked(response_header_json)
         response_header_json_str = response_header_json.read().decode('utf-8')
         json_obj = json.loads(response_header_json_str, parse_float=Decimal)
         assert_equal(len(json_obj), 1) #ensure that there is one header in the json response
@@ -291,6 +302,81 @@ class RESTTest (BitcoinTestFramework):
         json_obj = json.loads(response_header_json_str)
         assert_equal(len(json_obj), 5) #now we should have 5 header objects
 
+        # a longer range of binary headers, starting at the genesis block
+        response_headers_bin = http_get_call(url.hostname, url.port, '/rest/headers/200/'+self.nodes[0].getblockhash(0)+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response_headers_bin.status, 200)
+        assert_chunked(response_headers_bin)
+        response_headers_bin_str = response_headers_bin.read()
+        assert_equal(len(response_headers_bin_str), 80 * (self.nodes[0].getblockcount() + 1))
+        for height in [0, 1, self.nodes[0].getblockcount()]:
+            header_hex = self.nodes[0].getblockheader(self.nodes[0].getblockhash(height), False)
+            assert_equal(response_headers_bin_str[80 * height:80 * (height + 1)], hex_str_to_bytes(header_hex))
+
+        #####################
+        # /rest/blockrange/ #
+        #####################
+
+        tip_height = self.nodes[0].getblockcount()
+        block_hexes = [self.nodes[0].getblock(self.nodes[0].getblockhash(height), 0) for height in range(tip_height + 1)]
+
+        # binary and hex replies are the serialized blocks one after another
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/0/3'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        assert_chunked(response)
+        assert_equal(response.read(), hex_str_to_bytes(''.join(block_hexes[0:3])))
+
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/1/2'+self.FORMAT_SEPARATOR+'hex', True)
+        assert_equal(response.status, 200)
+        assert_chunked(response)
+        assert_equal(response.read().decode('utf-8'), ''.join(block_hexes[1:3]) + '\n')
+
+        # the range is cut off at the tip
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/' + str(tip_height - 1) + '/10'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        assert_equal(response.read(), hex_str_to_bytes(''.join(block_hexes[tip_height - 1:])))
+
+        # json replies are an array of blocks with transaction details
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/100/3'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 200)
+        assert_chunked(response)
+        json_obj = json.loads(response.read().decode('utf-8'))
+        assert_equal(len(json_obj), 3)
+        for i, block in enumerate(json_obj):
+            assert_equal(block['hash'], self.nodes[0].getblockhash(100 + i))
+            assert_equal(block['height'], 100 + i)
+            assert_equal(block['tx'][0]['txid'], self.nodes[0].getblock(block['hash'])['tx'][0])
+
+        # invalid ranges
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/0/0'+self.FORMAT_SEPARATOR+'bin', True).status, 400)
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/0/1001'+self.FORMAT_SEPARATOR+'bin', True).status, 400)
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/-1/1'+self.FORMAT_SEPARATOR+'bin', True).status, 400)
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/0'+self.FORMAT_SEPARATOR+'bin', True).status, 400)
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/' + str(tip_height + 1) + '/1'+self.FORMAT_SEPARATOR+'bin', True).status, 404)
+
+        ##########################
+        # /rest/blockrange/undo/ #
+        ##########################
+
+        # each block is followed by its undo data; the genesis block and coinbase-only blocks have
+        # empty undo data, which is serialized as a zero length vector
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/undo/0/2'+self.FORMAT_SEPARATOR+'hex', True)
+        assert_equal(response.status, 200)
+        assert_chunked(response)
+        assert_equal(response.read().decode('utf-8'), block_hexes[0] + '00' + block_hexes[1] + '00' + '\n')
+
+        # the block with the 0.1 payment spends one non-coinbase transaction's inputs
+        bb_height = self.nodes[0].getblock(bb_hash)['height']
+        response = http_get_call(url.hostname, url.port, '/rest/blockrange/undo/' + str(bb_height) + '/1'+self.FORMAT_SEPARATOR+'bin', True)
+        assert_equal(response.status, 200)
+        undo_str = response.read()
+        bb_bytes = hex_str_to_bytes(block_hexes[bb_height])
+        assert_equal(undo_str[0:len(bb_bytes)], bb_bytes)
+        assert_equal(undo_str[len(bb_bytes)], 1)
+        assert_greater_than(len(undo_str), len(bb_bytes) + 2)
+
+        # there is no json format for undo data
+        assert_equal(http_get_call(url.hostname, url.port, '/rest/blockrange/undo/0/1'+self.FORMAT_SEPARATOR+'json', True).status, 404)
+
         # do tx test
         tx_hash = block_json_obj['tx'][0]['txid']
         json_string = http_get_call(url.hostname, url.port, '/rest/tx/'+tx_hash+self.FORMAT_SEPARATOR+"json")
@@ -300,7 +386,7 @@ class RESTTest (BitcoinTestFramework):
         # check hex format response
         hex_string = http_get_call(url.hostname, url.port, '/rest/tx/'+tx_hash+self.FORMAT_SEPARATOR+"hex", True)
         assert_equal(hex_string.status, 200)
-        assert_greater_than(int(response.getheader('content-length')), 10)
+        assert_greater_than(int(hex_string.getheader('content-length')), 10)
 
 
         # check block tx details
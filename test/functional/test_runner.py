@@ -120,6 +120,7 @@ BASE_SCRIPTS= [
     'feature_spentindex.py',
     'rpc_decodescript.py',
     'rpc_blockchain.py',
+    'rpc_getblockfilter.py',
     'rpc_deprecated.py',
     'wallet_disable.py',
     'rpc_net.py',